@@ -0,0 +1,770 @@
+#include "Allocator.h"
+#include "AllocatorPlatform.h"
+#include <stdio.h>
+#include <string.h>
+#include "EAStdC/EAHashCRC.h"
+#include "EAStdC/EAStopwatch.h"
+#include "EASTL/algorithm.h"
+#include "EASTL/sort.h"
+#include "EAThread/eathread_atomic.h"
+#include "EAThread/eathread_callstack.h"
+#include "EAThread/eathread_spinlock.h"
+
+
+static const uint64_t kArenaSize = 4ull << 30;
+static const uint32_t kSpanShift = 16;
+static const uint32_t kSpanSize = 1u << kSpanShift;
+static const uint32_t kNumSpans = (uint32_t)(kArenaSize >> kSpanShift);
+static const uint32_t kBatchBytes = 16 * 1024;
+
+// A free block holds the next free block of its list.
+struct FFreeList
+{
+	void* Head;
+	uint32_t Count;
+};
+
+struct alignas(64) FCentralList
+{
+	EA::Thread::SpinLock Lock;
+	FFreeList List;
+};
+
+struct FThreadCache
+{
+	FFreeList Lists[kNumSizeClasses];
+	bool bIsDestroyed;
+
+	~FThreadCache();
+};
+
+static uint8_t* GArena; // Reserved on the first small allocation.
+static EA::Thread::AtomicUint64 GArenaCommitted;
+static uint8_t GSpanClasses[kNumSpans];
+static FCentralList GCentralLists[kNumSizeClasses];
+static EA::Thread::AtomicUint64 GNumLargeAllocations;
+static EA::Thread::AtomicUint64 GNumBatchTransfers;
+static thread_local FThreadCache GThreadCache;
+
+// Blocks moved between a thread cache and the shared list at once, a thread caches at most twice as many.
+static uint32_t GetBatchCount(uint32_t SizeClass)
+{
+	return eastl::min(eastl::max(kBatchBytes / GetClassSize(SizeClass), 2u), 64u);
+}
+
+static void PushBlock(FFreeList& List, void* Block)
+{
+	*(void**)Block = List.Head;
+	List.Head = Block;
+	List.Count++;
+}
+
+static void* PopBlock(FFreeList& List)
+{
+	void* Block = List.Head;
+	List.Head = *(void**)Block;
+	List.Count--;
+	return Block;
+}
+
+static void MoveBlocks(FFreeList& From, FFreeList& To, uint32_t Count)
+{
+	for (uint32_t Idx = 0; Idx < Count && From.Head; ++Idx)
+	{
+		PushBlock(To, PopBlock(From));
+	}
+}
+
+static uint8_t* ReserveArena()
+{
+	// Function static so that allocations made by static constructors of other translation units are safe.
+	static uint8_t* Arena = (uint8_t*)ReserveAddressSpace(kArenaSize);
+	GArena = Arena;
+	return Arena;
+}
+
+// Commits a new span for the size class and splits it into blocks. Returns false when the arena is full.
+static bool AllocateSpan(uint32_t SizeClass, FFreeList& OutList)
+{
+	uint8_t* Arena = ReserveArena();
+	if (!Arena)
+	{
+		return false;
+	}
+	const uint64_t Offset = GArenaCommitted.Add(kSpanSize) - kSpanSize;
+	if (Offset + kSpanSize > kArenaSize || !CommitAddressSpace(Arena + Offset, kSpanSize))
+	{
+		return false;
+	}
+	GSpanClasses[Offset >> kSpanShift] = (uint8_t)SizeClass;
+
+	const uint32_t ClassSize = GetClassSize(SizeClass);
+	for (uint32_t BlockOffset = kSpanSize / ClassSize * ClassSize; BlockOffset > 0; BlockOffset -= ClassSize)
+	{
+		PushBlock(OutList, Arena + Offset + BlockOffset - ClassSize);
+	}
+	return true;
+}
+
+static bool RefillThreadCache(FFreeList& List, uint32_t SizeClass)
+{
+	FCentralList& Central = GCentralLists[SizeClass];
+	Central.Lock.Lock();
+	MoveBlocks(Central.List, List, GetBatchCount(SizeClass));
+	Central.Lock.Unlock();
+	GNumBatchTransfers.Increment();
+
+	return List.Head || AllocateSpan(SizeClass, List);
+}
+
+static void ReleaseToCentral(FFreeList& List, uint32_t SizeClass, uint32_t Count)
+{
+	FCentralList& Central = GCentralLists[SizeClass];
+	Central.Lock.Lock();
+	MoveBlocks(List, Central.List, Count);
+	Central.Lock.Unlock();
+	GNumBatchTransfers.Increment();
+}
+
+FThreadCache::~FThreadCache()
+{
+	for (uint32_t SizeClass = 0; SizeClass < kNumSizeClasses; ++SizeClass)
+	{
+		if (Lists[SizeClass].Count > 0)
+		{
+			ReleaseToCentral(Lists[SizeClass], SizeClass, Lists[SizeClass].Count);
+		}
+	}
+	bIsDestroyed = true;
+}
+
+static void* AllocateLargeMemory(size_t Size, size_t Alignment, size_t AlignmentOffset)
+{
+	GNumLargeAllocations.Increment();
+	return AllocateCRTMemory(Size, Alignment, AlignmentOffset);
+}
+
+void* AllocateMemory(size_t Size)
+{
+	if (Size > kMaxSmallObjectSize)
+	{
+		return AllocateLargeMemory(Size, 16, 0);
+	}
+
+	const uint32_t SizeClass = GetSizeClass(Size);
+	FThreadCache& Cache = GThreadCache;
+	if (Cache.bIsDestroyed)
+	{
+		// Thread is exiting, its cache is gone.
+		return AllocateLargeMemory(Size, 16, 0);
+	}
+
+	FFreeList& List = Cache.Lists[SizeClass];
+	if (!List.Head && !RefillThreadCache(List, SizeClass))
+	{
+		return AllocateLargeMemory(Size, 16, 0);
+	}
+	return PopBlock(List);
+}
+
+// Blocks are 16 byte aligned, anything stricter goes to the CRT.
+void* AllocateAlignedMemory(size_t Size, size_t Alignment, size_t AlignmentOffset)
+{
+	if (Alignment <= 16 && AlignmentOffset % 16 == 0)
+	{
+		return AllocateMemory(Size);
+	}
+	return AllocateLargeMemory(Size, Alignment, AlignmentOffset);
+}
+
+void FreeMemory(void* Pointer)
+{
+	if (!Pointer)
+	{
+		return;
+	}
+
+	uint8_t* Arena = GArena;
+	if (!Arena || (uint8_t*)Pointer < Arena || (uint8_t*)Pointer >= Arena + kArenaSize)
+	{
+		FreeCRTMemory(Pointer);
+		return;
+	}
+
+	const uint32_t SizeClass = GSpanClasses[((uint8_t*)Pointer - Arena) >> kSpanShift];
+	FThreadCache& Cache = GThreadCache;
+	if (Cache.bIsDestroyed)
+	{
+		FFreeList List = {};
+		PushBlock(List, Pointer);
+		ReleaseToCentral(List, SizeClass, 1);
+		return;
+	}
+
+	FFreeList& List = Cache.Lists[SizeClass];
+	PushBlock(List, Pointer);
+
+	const uint32_t BatchCount = GetBatchCount(SizeClass);
+	if (List.Count > 2 * BatchCount)
+	{
+		ReleaseToCentral(List, SizeClass, BatchCount);
+	}
+}
+
+void GetAllocatorStats(FAllocatorStats& OutStats)
+{
+	OutStats.CommittedBytes = eastl::min(GArenaCommitted.GetValue(), kArenaSize);
+	OutStats.NumLargeAllocations = GNumLargeAllocations.GetValue();
+	OutStats.NumBatchTransfers = GNumBatchTransfers.GetValue();
+}
+
+struct FFrameArenaBlock
+{
+	FFrameArenaBlock* Next;
+	uint64_t Capacity; // Bytes after the header.
+};
+
+struct FFrameArena
+{
+	FFrameArenaBlock* First;
+	FFrameArenaBlock* Current;
+	uint64_t Used; // Offset into Current.
+	uint64_t FrameBytes;
+	uint64_t LastFrameBytes;
+	uint64_t NumOverflows;
+	uint32_t Generation;
+
+	~FFrameArena();
+};
+
+static EA::Thread::AtomicUint32 GFrameArenaGeneration;
+static thread_local FFrameArena GFrameArena;
+
+FFrameArena::~FFrameArena()
+{
+	while (First)
+	{
+		FFrameArenaBlock* Next = First->Next;
+		FreeCRTMemory(First);
+		First = Next;
+	}
+}
+
+static void RewindFrameArena(FFrameArena& Arena)
+{
+#ifdef _DEBUG
+	for (FFrameArenaBlock* Block = Arena.First; Block; Block = Block->Next)
+	{
+		memset(Block + 1, 0xDD, (size_t)(Block == Arena.Current ? Arena.Used : Block->Capacity));
+		if (Block == Arena.Current)
+		{
+			break;
+		}
+	}
+#endif
+	Arena.Current = Arena.First;
+	Arena.Used = 0;
+	Arena.LastFrameBytes = Arena.FrameBytes;
+	Arena.FrameBytes = 0;
+}
+
+void* AllocateFrameMemory(size_t Size, size_t Alignment)
+{
+	FFrameArena& Arena = GFrameArena;
+	const uint32_t Generation = (uint32_t)GFrameArenaGeneration.GetValue();
+	if (Arena.Generation != Generation)
+	{
+		RewindFrameArena(Arena);
+		Arena.Generation = Generation;
+	}
+	Arena.FrameBytes += Size;
+
+	for (;;)
+	{
+		if (FFrameArenaBlock* Block = Arena.Current)
+		{
+			const uintptr_t Base = (uintptr_t)(Block + 1);
+			const uintptr_t Address = (Base + Arena.Used + Alignment - 1) & ~(uintptr_t)(Alignment - 1);
+			if (Address + Size <= Base + Block->Capacity)
+			{
+				Arena.Used = Address + Size - Base;
+				return (void*)Address;
+			}
+			if (Block->Next)
+			{
+				Arena.Current = Block->Next;
+				Arena.Used = 0;
+				continue;
+			}
+		}
+
+		// Chain a block that fits the request even when it is larger than the default.
+		const uint64_t Capacity = eastl::max((uint64_t)kFrameArenaBlockSize, (uint64_t)(Size + Alignment));
+		FFrameArenaBlock* Block = (FFrameArenaBlock*)AllocateLargeMemory(sizeof(FFrameArenaBlock) + (size_t)Capacity, 16, 0);
+		Block->Next = nullptr;
+		Block->Capacity = Capacity;
+		if (Arena.Current)
+		{
+			Arena.Current->Next = Block;
+			Arena.NumOverflows++;
+		}
+		else
+		{
+			Arena.First = Block;
+		}
+		Arena.Current = Block;
+		Arena.Used = 0;
+	}
+}
+
+static void UpdateAllocationPeaks();
+
+// Threads notice the new frame on their next allocation, memory handed out before this call must not be used anymore.
+void ResetFrameMemory()
+{
+	FFrameArena& Arena = GFrameArena;
+	RewindFrameArena(Arena);
+	Arena.Generation = (uint32_t)GFrameArenaGeneration.Increment();
+
+	UpdateAllocationPeaks();
+}
+
+void GetFrameArenaStats(FFrameArenaStats& OutStats)
+{
+	const FFrameArena& Arena = GFrameArena;
+	OutStats = {};
+	OutStats.LastFrameBytes = Arena.LastFrameBytes;
+	OutStats.NumOverflows = Arena.NumOverflows;
+	for (const FFrameArenaBlock* Block = Arena.First; Block; Block = Block->Next)
+	{
+		OutStats.CapacityBytes += Block->Capacity;
+		OutStats.NumBlocks++;
+	}
+}
+
+struct FAllocationHeader
+{
+	uint32_t Tag;
+	uint32_t Stack; // Index + 1 into GAllocationStacks, zero when not sampled.
+	uint64_t Size;
+};
+static_assert(sizeof(FAllocationHeader) == 16, "Header has to keep 16 byte alignment.");
+
+struct FAllocationStack
+{
+	uint64_t Hash;
+	void* Frames[kAllocationStackDepth];
+	uint32_t NumFrames;
+	uint64_t Bytes;
+	uint64_t NumLive;
+};
+
+static const uint32_t kMaxAllocationThreads = 64;
+static const uint32_t kAllocationTagCacheSize = 64;
+
+// Running totals of one thread per tag. Only the owning thread writes them and they only grow, readers sum them over
+// all threads (aligned 64-bit loads and stores do not tear). An exiting thread adds its set to the retired totals and
+// hands it to the next new thread, so only more than kMaxAllocationThreads live threads share the last set and update
+// it under GAllocationLock.
+struct FAllocationThreadCounters
+{
+	uint64_t AllocatedBytes[kMaxAllocationTags];
+	uint64_t FreedBytes[kMaxAllocationTags];
+	uint64_t NumAllocations[kMaxAllocationTags];
+	uint64_t NumFrees[kMaxAllocationTags];
+};
+
+// Tag indices of the names this thread used, open addressing on the hashed pointer. Names are string literals, so
+// after the first allocation with a name its lookups never take the lock. Literals sit a few bytes apart, a table
+// indexed by the low address bits made neighbouring names evict each other on every allocation.
+struct FAllocationThreadState
+{
+	FAllocationThreadCounters* Counters;
+	bool bIsShared;
+	uint32_t SampleCounter;
+	const char* CachedNames[kAllocationTagCacheSize];
+	uint32_t CachedTags[kAllocationTagCacheSize];
+
+	~FAllocationThreadState();
+};
+
+static EA::Thread::SpinLock GAllocationLock; // Tag and stack tables, shared counters and the folds.
+static FAllocationTagStats GAllocationTags[kMaxAllocationTags]; // Totals as of the last FoldAllocationCounters.
+static uint32_t GNumAllocationTags;
+static FAllocationStack GAllocationStacks[kMaxAllocationStacks];
+static FAllocationThreadCounters GAllocationCounters[kMaxAllocationThreads];
+static uint32_t GNumAllocationCounters;
+static FAllocationThreadCounters GRetiredAllocationCounters; // Of the threads that exited.
+static uint32_t GFreeAllocationCounters[kMaxAllocationThreads]; // Indices of the sets the exited threads left.
+static uint32_t GNumFreeAllocationCounters;
+static thread_local FAllocationThreadState GAllocationThread;
+
+bool IsAllocationTrackingEnabled()
+{
+	static const bool bIsEnabled = IsEnvironmentFlagSet("DXRTEST_TRACK_ALLOCATIONS");
+	return bIsEnabled;
+}
+
+// Tags are usually string literals, the pointer compare catches almost all lookups. The last slot collects the rest.
+static uint32_t FindAllocationTag(const char* Name)
+{
+	for (uint32_t Idx = 0; Idx < GNumAllocationTags; ++Idx)
+	{
+		if (GAllocationTags[Idx].Name == Name)
+		{
+			return Idx;
+		}
+	}
+	for (uint32_t Idx = 0; Idx < GNumAllocationTags; ++Idx)
+	{
+		if (strcmp(GAllocationTags[Idx].Name, Name) == 0)
+		{
+			return Idx;
+		}
+	}
+	if (GNumAllocationTags == kMaxAllocationTags - 1)
+	{
+		GAllocationTags[GNumAllocationTags].Name = "(other)";
+		return GNumAllocationTags++;
+	}
+	if (GNumAllocationTags == kMaxAllocationTags)
+	{
+		return kMaxAllocationTags - 1;
+	}
+	GAllocationTags[GNumAllocationTags].Name = Name;
+	return GNumAllocationTags++;
+}
+
+// Counters of the calling thread, handed out on its first tracked allocation or free.
+static FAllocationThreadCounters& GetAllocationCounters(FAllocationThreadState& Thread)
+{
+	if (!Thread.Counters)
+	{
+		GAllocationLock.Lock();
+		uint32_t Index;
+		if (GNumFreeAllocationCounters > 0)
+		{
+			Index = GFreeAllocationCounters[--GNumFreeAllocationCounters];
+		}
+		else
+		{
+			Index = eastl::min(GNumAllocationCounters, kMaxAllocationThreads - 1);
+			GNumAllocationCounters = Index + 1;
+		}
+		Thread.Counters = &GAllocationCounters[Index];
+		Thread.bIsShared = Index == kMaxAllocationThreads - 1;
+		GAllocationLock.Unlock();
+	}
+	return *Thread.Counters;
+}
+
+FAllocationThreadState::~FAllocationThreadState()
+{
+	if (!Counters || bIsShared)
+	{
+		return;
+	}
+
+	GAllocationLock.Lock();
+	for (uint32_t Tag = 0; Tag < kMaxAllocationTags; ++Tag)
+	{
+		GRetiredAllocationCounters.AllocatedBytes[Tag] += Counters->AllocatedBytes[Tag];
+		GRetiredAllocationCounters.FreedBytes[Tag] += Counters->FreedBytes[Tag];
+		GRetiredAllocationCounters.NumAllocations[Tag] += Counters->NumAllocations[Tag];
+		GRetiredAllocationCounters.NumFrees[Tag] += Counters->NumFrees[Tag];
+	}
+	memset(Counters, 0, sizeof(FAllocationThreadCounters));
+	GFreeAllocationCounters[GNumFreeAllocationCounters++] = (uint32_t)(Counters - GAllocationCounters);
+
+	// Tracked frees from later thread exit destructors go straight to the retired totals, under the lock.
+	Counters = &GRetiredAllocationCounters;
+	bIsShared = true;
+	GAllocationLock.Unlock();
+}
+
+// Tag index of Name for the calling thread, takes the lock only for a name the thread has not used yet, or for every
+// name past the first kAllocationTagCacheSize.
+static uint32_t GetAllocationTag(FAllocationThreadState& Thread, const char* Name)
+{
+	Name = Name ? Name : "(unnamed)";
+	const uint32_t Hash = (uint32_t)(((uint64_t)(uintptr_t)Name * 0x9e3779b97f4a7c15ull) >> 32);
+	uint32_t Slot = 0;
+	for (uint32_t Probe = 0; Probe < kAllocationTagCacheSize; ++Probe)
+	{
+		Slot = (Hash + Probe) % kAllocationTagCacheSize;
+		if (Thread.CachedNames[Slot] == Name)
+		{
+			return Thread.CachedTags[Slot];
+		}
+		if (!Thread.CachedNames[Slot])
+		{
+			break;
+		}
+	}
+
+	GAllocationLock.Lock();
+	const uint32_t Tag = FindAllocationTag(Name);
+	GAllocationLock.Unlock();
+
+	if (!Thread.CachedNames[Slot])
+	{
+		Thread.CachedNames[Slot] = Name;
+		Thread.CachedTags[Slot] = Tag;
+	}
+	return Tag;
+}
+
+// Sums the per-thread counters into GAllocationTags. Peaks are the highest totals seen by the folds, which happen once
+// per frame (ResetFrameMemory) and whenever the stats are read. Caller holds GAllocationLock.
+static void FoldAllocationCounters()
+{
+	for (uint32_t Tag = 0; Tag < GNumAllocationTags; ++Tag)
+	{
+		uint64_t AllocatedBytes = GRetiredAllocationCounters.AllocatedBytes[Tag];
+		uint64_t FreedBytes = GRetiredAllocationCounters.FreedBytes[Tag];
+		uint64_t NumAllocations = GRetiredAllocationCounters.NumAllocations[Tag];
+		uint64_t NumFrees = GRetiredAllocationCounters.NumFrees[Tag];
+		for (uint32_t Idx = 0; Idx < GNumAllocationCounters; ++Idx)
+		{
+			const FAllocationThreadCounters& Counters = GAllocationCounters[Idx];
+			AllocatedBytes += Counters.AllocatedBytes[Tag];
+			FreedBytes += Counters.FreedBytes[Tag];
+			NumAllocations += Counters.NumAllocations[Tag];
+			NumFrees += Counters.NumFrees[Tag];
+		}
+
+		// A free on another thread can be seen before the allocation it releases.
+		FAllocationTagStats& Stats = GAllocationTags[Tag];
+		Stats.Bytes = AllocatedBytes > FreedBytes ? AllocatedBytes - FreedBytes : 0;
+		Stats.NumLive = NumAllocations > NumFrees ? NumAllocations - NumFrees : 0;
+		Stats.NumAllocations = NumAllocations;
+		Stats.PeakBytes = eastl::max(Stats.PeakBytes, Stats.Bytes);
+	}
+}
+
+static void UpdateAllocationPeaks()
+{
+	if (IsAllocationTrackingEnabled())
+	{
+		GAllocationLock.Lock();
+		FoldAllocationCounters();
+		GAllocationLock.Unlock();
+	}
+}
+
+// Returns index + 1, or zero when the table is full.
+static uint32_t FindAllocationStack(void* const* Frames, uint32_t NumFrames)
+{
+	const uint64_t Hash = EA::StdC::CRC64(Frames, NumFrames * sizeof(void*)) | 1;
+	for (uint32_t Probe = 0; Probe < kMaxAllocationStacks; ++Probe)
+	{
+		const uint32_t Idx = (uint32_t)(Hash + Probe) & (kMaxAllocationStacks - 1);
+		FAllocationStack& Stack = GAllocationStacks[Idx];
+		if (Stack.Hash == 0)
+		{
+			Stack.Hash = Hash;
+			memcpy(Stack.Frames, Frames, NumFrames * sizeof(void*));
+			Stack.NumFrames = NumFrames;
+			return Idx + 1;
+		}
+		if (Stack.Hash == Hash && Stack.NumFrames == NumFrames && memcmp(Stack.Frames, Frames, NumFrames * sizeof(void*)) == 0)
+		{
+			return Idx + 1;
+		}
+	}
+	return 0;
+}
+
+void* AllocateTaggedMemory(size_t Size, size_t Alignment, size_t AlignmentOffset, const char* Tag)
+{
+	if (!IsAllocationTrackingEnabled())
+	{
+		return AllocateAlignedMemory(Size, Alignment, AlignmentOffset);
+	}
+
+	// Header goes in front, the offset keeps the alignment of the memory handed out.
+	FAllocationHeader* Header = (FAllocationHeader*)AllocateAlignedMemory(Size + sizeof(FAllocationHeader), Alignment, AlignmentOffset + sizeof(FAllocationHeader));
+	if (!Header)
+	{
+		return nullptr;
+	}
+
+	FAllocationThreadState& Thread = GAllocationThread;
+	Header->Tag = GetAllocationTag(Thread, Tag);
+	Header->Stack = 0;
+	Header->Size = Size;
+
+	FAllocationThreadCounters& Counters = GetAllocationCounters(Thread);
+	if (Thread.bIsShared)
+	{
+		GAllocationLock.Lock();
+	}
+	Counters.AllocatedBytes[Header->Tag] += Size;
+	Counters.NumAllocations[Header->Tag] += 1;
+	if (Thread.bIsShared)
+	{
+		GAllocationLock.Unlock();
+	}
+
+	// Only sampled allocations (and their frees) touch the stack table and its lock.
+	if (++Thread.SampleCounter % kAllocationStackSampleRate == 0)
+	{
+		void* Frames[kAllocationStackDepth];
+		const uint32_t NumFrames = (uint32_t)EA::Thread::GetCallstack(Frames, kAllocationStackDepth);
+
+		GAllocationLock.Lock();
+		Header->Stack = NumFrames ? FindAllocationStack(Frames, NumFrames) : 0;
+		if (Header->Stack)
+		{
+			FAllocationStack& Stack = GAllocationStacks[Header->Stack - 1];
+			Stack.Bytes += Size;
+			Stack.NumLive++;
+		}
+		GAllocationLock.Unlock();
+	}
+
+	return Header + 1;
+}
+
+void FreeTaggedMemory(void* Pointer)
+{
+	if (!Pointer || !IsAllocationTrackingEnabled())
+	{
+		FreeMemory(Pointer);
+		return;
+	}
+
+	FAllocationHeader* Header = (FAllocationHeader*)Pointer - 1;
+
+	// Counted on the freeing thread, the sums over all threads come out right wherever the block was allocated.
+	FAllocationThreadState& Thread = GAllocationThread;
+	FAllocationThreadCounters& Counters = GetAllocationCounters(Thread);
+	if (Thread.bIsShared)
+	{
+		GAllocationLock.Lock();
+	}
+	Counters.FreedBytes[Header->Tag] += Header->Size;
+	Counters.NumFrees[Header->Tag] += 1;
+	if (Thread.bIsShared)
+	{
+		GAllocationLock.Unlock();
+	}
+
+	if (Header->Stack)
+	{
+		GAllocationLock.Lock();
+		FAllocationStack& Stack = GAllocationStacks[Header->Stack - 1];
+		Stack.Bytes -= Header->Size;
+		Stack.NumLive--;
+		GAllocationLock.Unlock();
+	}
+
+	FreeMemory(Header);
+}
+
+uint32_t GetAllocationTagStats(FAllocationTagStats* OutStats, uint32_t MaxCount)
+{
+	GAllocationLock.Lock();
+	FoldAllocationCounters();
+	const uint32_t Count = eastl::min(GNumAllocationTags, MaxCount);
+	memcpy(OutStats, GAllocationTags, Count * sizeof(FAllocationTagStats));
+	GAllocationLock.Unlock();
+	return Count;
+}
+
+void MarkAllocationBaseline()
+{
+	GAllocationLock.Lock();
+	FoldAllocationCounters();
+	for (uint32_t Idx = 0; Idx < GNumAllocationTags; ++Idx)
+	{
+		GAllocationTags[Idx].BaselineBytes = GAllocationTags[Idx].Bytes;
+	}
+	GAllocationLock.Unlock();
+}
+
+// Nanoseconds per allocate and free pair of a small block, through AllocateTaggedMemory (tracked when tracking is on)
+// and straight from the heap. The difference is the per-allocation cost of tracking.
+void MeasureAllocationTrackingOverhead(float& OutTaggedNs, float& OutUntaggedNs)
+{
+	const uint32_t NumAllocations = 64 * 1024;
+	const double CyclesToNs = 1.0e9 / EA::StdC::Stopwatch::GetCPUFrequency();
+
+	uint64_t BeginCycle = EA::StdC::Stopwatch::GetCPUCycle();
+	for (uint32_t Idx = 0; Idx < NumAllocations; ++Idx)
+	{
+		FreeTaggedMemory(AllocateTaggedMemory(64, 16, 0, "(tracking overhead)"));
+	}
+	uint64_t EndCycle = EA::StdC::Stopwatch::GetCPUCycle();
+	OutTaggedNs = (float)((EndCycle - BeginCycle) * CyclesToNs / NumAllocations);
+
+	BeginCycle = EA::StdC::Stopwatch::GetCPUCycle();
+	for (uint32_t Idx = 0; Idx < NumAllocations; ++Idx)
+	{
+		FreeMemory(AllocateAlignedMemory(64, 16, 0));
+	}
+	EndCycle = EA::StdC::Stopwatch::GetCPUCycle();
+	OutUntaggedNs = (float)((EndCycle - BeginCycle) * CyclesToNs / NumAllocations);
+}
+
+// JSON with every tag and the sampled call stacks that are still live, largest first. Frames are module+offset so they
+// can be resolved against the PDB later. Works on copies, nothing here allocates.
+bool WriteAllocationReport(const char* FileName)
+{
+	if (!IsAllocationTrackingEnabled())
+	{
+		return false;
+	}
+	FILE* File = fopen(FileName, "w");
+	if (!File)
+	{
+		return false;
+	}
+
+	static FAllocationTagStats Tags[kMaxAllocationTags];
+	static FAllocationStack Stacks[kMaxAllocationStacks];
+	static uint32_t Order[kMaxAllocationStacks];
+
+	GAllocationLock.Lock();
+	FoldAllocationCounters();
+	const uint32_t NumTags = GNumAllocationTags;
+	memcpy(Tags, GAllocationTags, sizeof(Tags));
+	memcpy(Stacks, GAllocationStacks, sizeof(Stacks));
+	GAllocationLock.Unlock();
+
+	uint32_t NumStacks = 0;
+	for (uint32_t Idx = 0; Idx < kMaxAllocationStacks; ++Idx)
+	{
+		if (Stacks[Idx].NumLive > 0)
+		{
+			Order[NumStacks++] = Idx;
+		}
+	}
+	eastl::sort(Order, Order + NumStacks, [](uint32_t A, uint32_t B) { return Stacks[A].Bytes > Stacks[B].Bytes; });
+
+	fprintf(File, "{\n\t\"tags\": [");
+	for (uint32_t Idx = 0; Idx < NumTags; ++Idx)
+	{
+		const FAllocationTagStats& Tag = Tags[Idx];
+		fprintf(File, "%s\n\t\t{ \"name\": \"%s\", \"bytes\": %llu, \"peak\": %llu, \"growth\": %lld, \"live\": %llu, \"allocations\": %llu }", Idx ? "," : "", Tag.Name, (unsigned long long)Tag.Bytes, (unsigned long long)Tag.PeakBytes, (long long)(Tag.Bytes - Tag.BaselineBytes), (unsigned long long)Tag.NumLive, (unsigned long long)Tag.NumAllocations);
+	}
+	fprintf(File, "\n\t],\n\t\"stackSampleRate\": %u,\n\t\"liveStacks\": [", kAllocationStackSampleRate);
+	for (uint32_t Idx = 0; Idx < NumStacks; ++Idx)
+	{
+		const FAllocationStack& Stack = Stacks[Order[Idx]];
+		fprintf(File, "%s\n\t\t{ \"bytes\": %llu, \"live\": %llu, \"frames\": [", Idx ? "," : "", (unsigned long long)Stack.Bytes, (unsigned long long)Stack.NumLive);
+		for (uint32_t Frame = 0; Frame < Stack.NumFrames; ++Frame)
+		{
+			char ModulePath[512] = {};
+			EA::Thread::GetModuleFromAddress(Stack.Frames[Frame], ModulePath, sizeof(ModulePath));
+			const char* Separator = strrchr(ModulePath, '\\') ? strrchr(ModulePath, '\\') : strrchr(ModulePath, '/');
+			const char* ModuleName = Separator ? Separator + 1 : ModulePath;
+			const uint64_t Offset = (uint64_t)((uintptr_t)Stack.Frames[Frame] - (uintptr_t)EA::Thread::GetModuleHandleFromAddress(Stack.Frames[Frame]));
+			fprintf(File, "%s\"%s+0x%llx\"", Frame ? ", " : "", ModuleName, (unsigned long long)Offset);
+		}
+		fprintf(File, "] }");
+	}
+	fprintf(File, "\n\t]\n}\n");
+	fclose(File);
+	return true;
+}
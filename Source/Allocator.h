@@ -0,0 +1,112 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "EAStdC/EABitTricks.h"
+
+// Size-class heap for small objects with a per-thread cache, behind the EASTL operator new[] overrides and the global
+// operator new[]/delete[] (Library.cpp). Blocks come from 64 KB spans carved out of one reserved address range, every
+// span serves a single size class. Threads allocate from and free to their own free lists without locking and only
+// move batches of blocks to or from the shared lists when a list runs empty or grows too long, so a block freed on
+// another thread simply joins that thread's cache. Larger or over-aligned requests go to the CRT.
+
+static const uint32_t kMaxSmallObjectSize = 32 * 1024;
+static const uint32_t kNumSizeClasses = 40;
+
+// 16 byte steps up to 128 bytes, then four classes per power of two up to kMaxSmallObjectSize. Worst case waste is 25%.
+inline uint32_t GetSizeClass(size_t Size)
+{
+	if (Size <= 128)
+	{
+		return Size == 0 ? 0 : (uint32_t)(Size - 1) / 16;
+	}
+	const uint32_t Log = EA::StdC::Log2((uint32_t)Size - 1);
+	return 8 + (Log - 7) * 4 + (((uint32_t)Size - 1) >> (Log - 2)) - 4;
+}
+
+inline uint32_t GetClassSize(uint32_t SizeClass)
+{
+	if (SizeClass < 8)
+	{
+		return (SizeClass + 1) * 16;
+	}
+	const uint32_t Log = 7 + (SizeClass - 8) / 4;
+	return ((SizeClass - 8) % 4 + 5) << (Log - 2);
+}
+
+struct FAllocatorStats
+{
+	uint64_t CommittedBytes; // Spans are never decommitted.
+	uint64_t NumLargeAllocations;
+	uint64_t NumBatchTransfers; // Between thread caches and the shared lists.
+};
+
+void* AllocateMemory(size_t Size);
+void* AllocateAlignedMemory(size_t Size, size_t Alignment, size_t AlignmentOffset);
+void FreeMemory(void* Pointer);
+void GetAllocatorStats(FAllocatorStats& OutStats);
+
+// Per-thread bump arena for data that lives until the end of the frame. ResetFrameMemory (PresentFrame) starts a new
+// frame for all threads, every thread rewinds its own arena on its first allocation of the new frame. Blocks are kept
+// across frames and chained when a frame needs more, so steady state frames allocate nothing. Debug builds fill the
+// memory of the finished frame with 0xDD.
+static const uint32_t kFrameArenaBlockSize = 256 * 1024;
+
+struct FFrameArenaStats
+{
+	uint64_t LastFrameBytes; // Requested by the calling thread during its last completed frame.
+	uint64_t CapacityBytes;
+	uint32_t NumBlocks;
+	uint64_t NumOverflows; // Blocks chained because the existing ones were full.
+};
+
+void* AllocateFrameMemory(size_t Size, size_t Alignment);
+void ResetFrameMemory();
+void GetFrameArenaStats(FFrameArenaStats& OutStats);
+
+// EASTL allocator on the frame arena. Containers using it must not outlive the frame, deallocate does nothing.
+class FFrameAllocator
+{
+public:
+	explicit FFrameAllocator(const char* /*Name*/ = nullptr) {}
+	FFrameAllocator(const FFrameAllocator& /*Other*/, const char* /*Name*/) {}
+
+	void* allocate(size_t Size, int /*Flags*/ = 0) { return AllocateFrameMemory(Size, 16); }
+	void* allocate(size_t Size, size_t Alignment, size_t /*AlignmentOffset*/, int /*Flags*/ = 0) { return AllocateFrameMemory(Size, Alignment); }
+	void deallocate(void* /*Pointer*/, size_t /*Size*/) {}
+
+	const char* get_name() const { return "FFrameAllocator"; }
+	void set_name(const char* /*Name*/) {}
+};
+
+inline bool operator==(const FFrameAllocator&, const FFrameAllocator&) { return true; }
+inline bool operator!=(const FFrameAllocator&, const FFrameAllocator&) { return false; }
+
+// Optional tracking of everything that goes through the operator new[] overrides: live bytes, counts and peaks per tag
+// (the EASTL allocator name) and the call stacks of every kAllocationStackSampleRate-th allocation. The choice has to
+// be made before the first allocation, so it is taken from the environment (DXRTEST_TRACK_ALLOCATIONS=1) and holds for
+// the whole process. Tracked allocations carry a 16 byte header and add to per-thread counters without locking, the
+// counters are summed per tag when the stats are read and once per frame for the peaks. Only the tag lookup on a
+// thread's first use of a name and the sampled call stacks take the lock.
+static const uint32_t kMaxAllocationTags = 128;
+static const uint32_t kMaxAllocationStacks = 4096;
+static const uint32_t kAllocationStackDepth = 12;
+static const uint32_t kAllocationStackSampleRate = 1024;
+
+struct FAllocationTagStats
+{
+	const char* Name;
+	uint64_t Bytes;
+	uint64_t PeakBytes;
+	uint64_t BaselineBytes; // Bytes at the last MarkAllocationBaseline, for heap growth.
+	uint64_t NumLive;
+	uint64_t NumAllocations;
+};
+
+bool IsAllocationTrackingEnabled();
+void* AllocateTaggedMemory(size_t Size, size_t Alignment, size_t AlignmentOffset, const char* Tag);
+void FreeTaggedMemory(void* Pointer);
+uint32_t GetAllocationTagStats(FAllocationTagStats* OutStats, uint32_t MaxCount);
+void MarkAllocationBaseline();
+bool WriteAllocationReport(const char* FileName);
+void MeasureAllocationTrackingOverhead(float& OutTaggedNs, float& OutUntaggedNs);
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef _WIN32
+#include <malloc.h>
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+// Operating system calls of the allocator (Allocator.cpp): Win32 in the application, POSIX in the headless tests.
+
+// Address range without backing memory, nullptr when the address space is exhausted.
+inline void* ReserveAddressSpace(uint64_t Size)
+{
+#ifdef _WIN32
+	return VirtualAlloc(nullptr, (SIZE_T)Size, MEM_RESERVE, PAGE_READWRITE);
+#else
+	void* Address = mmap(nullptr, (size_t)Size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	return Address == MAP_FAILED ? nullptr : Address;
+#endif
+}
+
+// Makes part of a reserved range usable, zero-filled.
+inline bool CommitAddressSpace(void* Address, uint64_t Size)
+{
+#ifdef _WIN32
+	return VirtualAlloc(Address, (SIZE_T)Size, MEM_COMMIT, PAGE_READWRITE) != nullptr;
+#else
+	return mprotect(Address, (size_t)Size, PROT_READ | PROT_WRITE) == 0;
+#endif
+}
+
+// CRT heap with _aligned_offset_malloc semantics (Pointer + AlignmentOffset is aligned), freed with FreeCRTMemory. The
+// POSIX version keeps the malloc block in front of the memory it returns.
+inline void* AllocateCRTMemory(size_t Size, size_t Alignment, size_t AlignmentOffset)
+{
+#ifdef _WIN32
+	return _aligned_offset_malloc(Size, Alignment, AlignmentOffset);
+#else
+	uint8_t* Block = (uint8_t*)malloc(Size + Alignment - 1 + sizeof(void*));
+	if (!Block)
+	{
+		return nullptr;
+	}
+	const uintptr_t Aligned = ((uintptr_t)Block + sizeof(void*) + AlignmentOffset + Alignment - 1) & ~(uintptr_t)(Alignment - 1);
+	uint8_t* Pointer = (uint8_t*)(Aligned - AlignmentOffset);
+	memcpy(Pointer - sizeof(void*), &Block, sizeof(void*));
+	return Pointer;
+#endif
+}
+
+inline void FreeCRTMemory(void* Pointer)
+{
+#ifdef _WIN32
+	_aligned_free(Pointer);
+#else
+	if (Pointer)
+	{
+		void* Block;
+		memcpy(&Block, (uint8_t*)Pointer - sizeof(void*), sizeof(void*));
+		free(Block);
+	}
+#endif
+}
+
+// Environment variable set to "1". Does not allocate.
+inline bool IsEnvironmentFlagSet(const char* Name)
+{
+#ifdef _WIN32
+	char Value[8];
+	return GetEnvironmentVariableA(Name, Value, sizeof(Value)) > 0 && Value[0] == '1';
+#else
+	const char* Value = getenv(Name);
+	return Value && Value[0] == '1';
+#endif
+}
@@ -1,32 +1,214 @@
 #pragma once
 
 #ifdef __cplusplus
+#include <stdint.h>
 #include "DirectXMath/DirectXMath.h"
 typedef XMFLOAT4X4 float4x4;
 typedef XMFLOAT4X3 float4x3;
 typedef XMFLOAT2 float2;
 typedef XMFLOAT3 float3;
 typedef XMFLOAT4 float4;
+typedef XMUINT2 uint2;
+typedef uint32_t uint;
 #endif
 
 #ifdef __cplusplus
 #define SALIGN alignas(256)
+#define SINLINE inline
 #else
 #define SALIGN
+#define SINLINE
 #endif
 
+// Ray types select the hit group record of an instance (RayContributionToHitGroupIndex), RAY_TYPE_COUNT is the
+// geometry multiplier of every TraceRay. Ray counters (GRayCounters) keep RAY_COUNTER_COUNT running uint totals per ray
+// type.
+#define RAY_TYPE_PRIMARY 0
+#define RAY_TYPE_COUNT 1
+#define RAY_COUNTER_RAYS 0
+#define RAY_COUNTER_HITS 1
+#define RAY_COUNTER_MISSES 2
+#define RAY_COUNTER_COUNT 3
+
+// Sizes of FPayload in Raytracing.hlsl: the hit distance with an RGBA8 packed color (RT_PACKED_PAYLOAD) or a float4
+// color.
+#define RT_PACKED_PAYLOAD_SIZE 8
+#define RT_FLOAT_PAYLOAD_SIZE 20
+
 struct SALIGN FPerFrameConstantData
 {
 	float4x4 ProjectionToWorld;
+	float4x4 PrevWorldToProjection; // Camera of the previous frame, for the temporal pass.
 	float4 CameraPosition;
+	uint InlineRayFlags; // Ray query path only, RT pipelines have culling and shading compiled in (RT_* macros).
+	uint InlineLambertShading;
+	uint RayCounters; // Non-zero to update GRayCounters.
+	uint TraceWidth; // Rays traced, at most the RTOutput size (dynamic resolution traces into its top-left corner).
+	uint TraceHeight;
+	uint PrevTraceWidth;
+	uint PrevTraceHeight;
+	uint HasTemporalHistory; // Zero when the temporal pass has to start over.
+	float2 Jitter; // Sub-pixel offset of the camera rays in pixels.
+	float HistoryMinBlendFactor; // Weight of the current frame once enough frames are accumulated.
+	float DisocclusionTolerance; // Relative to the distance from the camera.
+	uint TraceInterleave; // 1, 2 or 4, see GetInterleavedPixel.
+	uint InterleavePhase;
+	uint HasReconstructionHistory;
+	uint HasDenoiseHistory;
 };
 
+// Interleaved tracing: with Interleave 2 rays are dispatched for half of the columns and every frame traces the other
+// color of a checkerboard, with Interleave 4 for half of the columns and rows and every frame traces another pixel of
+// each 2x2 block, alternating diagonals like the checkerboard. Phase goes from 0 to Interleave - 1.
+SINLINE uint2 GetInterleaveOffset(uint Phase)
+{
+	return uint2((Phase == 1 || Phase == 2) ? 1 : 0, Phase & 1);
+}
+
+SINLINE uint2 GetInterleavedPixel(uint2 DispatchIndex, uint Interleave, uint Phase)
+{
+	if (Interleave == 2)
+	{
+		return uint2(DispatchIndex.x * 2 + ((DispatchIndex.y + Phase) & 1), DispatchIndex.y);
+	}
+	if (Interleave == 4)
+	{
+		const uint2 Offset = GetInterleaveOffset(Phase);
+		return uint2(DispatchIndex.x * 2 + Offset.x, DispatchIndex.y * 2 + Offset.y);
+	}
+	return DispatchIndex;
+}
+
+// Size of the ray dispatch of one phase for a Dimensions trace, it can be a pixel larger than the image when the size is
+// odd.
+SINLINE uint2 GetInterleavedDispatchSize(uint Interleave, uint2 Dimensions)
+{
+	return uint2(Interleave > 1 ? (Dimensions.x + 1) / 2 : Dimensions.x, Interleave > 2 ? (Dimensions.y + 1) / 2 : Dimensions.y);
+}
+
+SINLINE bool IsTracedPixel(uint2 Pixel, uint Interleave, uint Phase)
+{
+	if (Interleave == 2)
+	{
+		return ((Pixel.x + Pixel.y + Phase) & 1) == 0;
+	}
+	if (Interleave == 4)
+	{
+		const uint2 Offset = GetInterleaveOffset(Phase);
+		return (Pixel.x & 1) == Offset.x && (Pixel.y & 1) == Offset.y;
+	}
+	return true;
+}
+
+// Reprojection for the temporal pass (Temporal.hlsl). Written with scalar math so that it compiles as C++ as well,
+// matrices are the row vector ones that the shaders see (not the transposed copies in constant buffers).
+
+// Pixel position (pixel centers at +0.5) of a world space position in the previous frame, negative when the position
+// was behind the previous camera.
+SINLINE float2 GetReprojectedPixel(float3 Position, float4x4 PrevWorldToProjection, float2 PrevDimensions)
+{
+	const float X = Position.x * PrevWorldToProjection._11 + Position.y * PrevWorldToProjection._21 + Position.z * PrevWorldToProjection._31 + PrevWorldToProjection._41;
+	const float Y = Position.x * PrevWorldToProjection._12 + Position.y * PrevWorldToProjection._22 + Position.z * PrevWorldToProjection._32 + PrevWorldToProjection._42;
+	const float W = Position.x * PrevWorldToProjection._14 + Position.y * PrevWorldToProjection._24 + Position.z * PrevWorldToProjection._34 + PrevWorldToProjection._44;
+	if (W <= 0.0f)
+	{
+		return float2(-1.0f, -1.0f);
+	}
+	return float2((X / W * 0.5f + 0.5f) * PrevDimensions.x, (0.5f - Y / W * 0.5f) * PrevDimensions.y);
+}
+
+// History hit a different surface when it is further from the current hit than Tolerance times the view distance.
+SINLINE bool IsDisoccluded(float3 Position, float3 HistoryPosition, float3 CameraPosition, float Tolerance)
+{
+	const float DX = Position.x - HistoryPosition.x;
+	const float DY = Position.y - HistoryPosition.y;
+	const float DZ = Position.z - HistoryPosition.z;
+	const float VX = Position.x - CameraPosition.x;
+	const float VY = Position.y - CameraPosition.y;
+	const float VZ = Position.z - CameraPosition.z;
+	return DX * DX + DY * DY + DZ * DZ > Tolerance * Tolerance * (VX * VX + VY * VY + VZ * VZ);
+}
+
+// Weight of the current frame, a running average until it drops to MinBlendFactor.
+SINLINE float GetHistoryBlendFactor(float NumFrames, float MinBlendFactor)
+{
+	const float Average = 1.0f / NumFrames;
+	return Average > MinBlendFactor ? Average : MinBlendFactor;
+}
+
+// Root constants of Upscale.hlsl.
+#define UPSCALE_FILTER_BILINEAR 0
+#define UPSCALE_FILTER_EDGE_ADAPTIVE 1
+#define UPSCALE_FILTER_COUNT 2
+
+struct FUpscaleConstants
+{
+	float2 InputSize; // Traced rectangle in pixels.
+	float2 InvInputTextureSize;
+	uint Filter; // UPSCALE_FILTER_*
+	float Sharpness; // Edge adaptive filter only, 0 disables sharpening.
+};
+
+// Lanczos2 approximated by polynomials for the edge adaptive filter, X2 is the squared distance. Lobe is 1/4 for the full
+// negative lobe and 1/2 for none, Clip = 1/Lobe keeps the window from rising again.
+SINLINE float GetLanczos2Weight(float X2, float Lobe, float Clip)
+{
+	X2 = X2 < Clip ? X2 : Clip;
+	float Base = (2.0f / 5.0f) * X2 - 1.0f;
+	float Window = Lobe * X2 - 1.0f;
+	Base *= Base;
+	Window *= Window;
+	return (25.0f / 16.0f * Base - (25.0f / 16.0f - 1.0f)) * Window;
+}
+
+// Accumulation limits of DenoiseTemporal.hlsl. While fewer than DENOISE_MIN_TEMPORAL_VARIANCE_FRAMES frames are
+// accumulated the variance is estimated spatially.
+#define DENOISE_MAX_FRAMES 256.0f
+#define DENOISE_COLOR_MIN_BLEND_FACTOR 0.2f
+#define DENOISE_MOMENTS_MIN_BLEND_FACTOR 0.2f
+#define DENOISE_MIN_TEMPORAL_VARIANCE_FRAMES 4.0f
+
+// Most a-trous iterations the application runs and its edge-stopping parameters (FDenoiseConstants) until changed in
+// the UI.
+#define DENOISE_MAX_ITERATIONS 5
+#define DENOISE_DEFAULT_LUMINANCE_PHI 4.0f
+#define DENOISE_DEFAULT_NORMAL_PHI 128.0f
+#define DENOISE_DEFAULT_DEPTH_PHI 0.01f
+
+// Root constants of DenoiseFilter.hlsl, one dispatch per a-trous iteration.
+struct FDenoiseConstants
+{
+	uint StepSize; // Spacing of the 5x5 taps, doubles every iteration.
+	uint WritesHistory; // Non-zero for the iteration whose result is the next frame's color history.
+	uint IsLastIteration; // Non-zero when writing RTOutput, alpha is 1 instead of the variance.
+	float LuminancePhi;
+	float NormalPhi;
+	float DepthPhi;
+};
+
+// Edge-stopping weight of an a-trous tap: LuminanceDelta is taken relative to the standard deviation of the center's
+// luminance, NormalDot is the dot product of the normals and PlaneDistance (distance of the tap from the center's
+// tangent plane) is taken relative to the view distance of the center. Arguments are non-negative except NormalDot.
+SINLINE float GetDenoiseEdgeWeight(float LuminanceDelta, float LuminanceSigma, float NormalDot, float PlaneDistance, float ViewDistance, float LuminancePhi, float NormalPhi, float DepthPhi)
+{
+	const float Normal = pow(NormalDot > 0.0f ? NormalDot : 0.0f, NormalPhi);
+	const float Luminance = LuminanceDelta / (LuminancePhi * LuminanceSigma + 1.0e-4f);
+	const float Depth = PlaneDistance / (DepthPhi * ViewDistance + 1.0e-4f);
+	return Normal * exp(-Luminance - Depth);
+}
+
 struct FVertex
 {
 	float3 Position;
 	float3 Normal;
 };
 
+struct FStaticMeshInfo
+{
+	uint BaseVertex;
+	uint BaseIndex;
+};
+
 #ifdef __cplusplus
 #undef SALIGN
 #endif
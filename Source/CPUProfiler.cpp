@@ -0,0 +1,162 @@
+#include "CPUProfiler.h"
+#include <stdio.h>
+#include "EAStdC/EASprintf.h"
+#include "EAStdC/EAString.h"
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+static uint32_t GetProfilerThreadId()
+{
+#ifdef _WIN32
+	return GetCurrentThreadId();
+#else
+	return (uint32_t)syscall(SYS_gettid);
+#endif
+}
+
+static FCPUProfilerThread* GCPUProfilerThreads[kMaxCPUProfilerThreads];
+static EA::Thread::AtomicInt32 GNumCPUProfilerThreads;
+static thread_local FCPUProfilerThread* GCPUProfilerThread;
+static thread_local bool GIsCPUProfilerThreadRejected; // Came after kMaxCPUProfilerThreads, its zones are dropped.
+
+FCPUProfilerThread* GetCPUProfilerThread()
+{
+	if (!GCPUProfilerThread)
+	{
+		if (GIsCPUProfilerThreadRejected)
+		{
+			return nullptr;
+		}
+
+		// Slots are only taken while there are any left, the count never goes past kMaxCPUProfilerThreads.
+		int32_t Index = GNumCPUProfilerThreads.GetValue();
+		while (Index < (int32_t)kMaxCPUProfilerThreads && !GNumCPUProfilerThreads.SetValueConditional(Index + 1, Index))
+		{
+			Index = GNumCPUProfilerThreads.GetValue();
+		}
+		if (Index >= (int32_t)kMaxCPUProfilerThreads)
+		{
+			GIsCPUProfilerThreadRejected = true;
+			return nullptr;
+		}
+		auto* Thread = new FCPUProfilerThread();
+		Thread->ThreadId = GetProfilerThreadId();
+		EA::StdC::Snprintf(Thread->Name, sizeof(Thread->Name), "Thread %u", Thread->ThreadId);
+		GCPUProfilerThreads[Index] = Thread;
+		GCPUProfilerThread = Thread;
+	}
+	return GCPUProfilerThread;
+}
+
+void AddCPUZoneEvent(const char* Name, uint64_t BeginCycle, uint64_t EndCycle)
+{
+	FCPUProfilerThread* Thread = GetCPUProfilerThread();
+	if (Thread)
+	{
+		const uint32_t Index = Thread->NumEvents;
+		Thread->Events[Index & (kCPUZoneBufferSize - 1)] = { Name, BeginCycle, EndCycle };
+		// x86 keeps stores in order, keeping the compiler from reordering is enough there.
+#if defined(EA_PROCESSOR_X86) || defined(EA_PROCESSOR_X86_64)
+		EACompilerMemoryBarrier();
+#else
+		EAWriteBarrier();
+#endif
+		Thread->NumEvents = Index + 1;
+	}
+}
+
+void SetCPUProfilerThreadName(const char* Name)
+{
+	if (FCPUProfilerThread* Thread = GetCPUProfilerThread())
+	{
+		EA::StdC::Strlcpy(Thread->Name, Name, sizeof(Thread->Name));
+	}
+}
+
+// Threads that recorded zones must have finished.
+void DestroyCPUProfiler()
+{
+	const uint32_t NumThreads = (uint32_t)GNumCPUProfilerThreads.GetValue();
+	for (uint32_t Idx = 0; Idx < NumThreads; ++Idx)
+	{
+		delete GCPUProfilerThreads[Idx];
+		GCPUProfilerThreads[Idx] = nullptr;
+	}
+	GNumCPUProfilerThreads.SetValue(0);
+	GCPUProfilerThread = nullptr;
+	GIsCPUProfilerThreadRejected = false;
+}
+
+// Average cost of an empty CPU_ZONE in nanoseconds. Measurement events are dropped from the calling thread's buffer.
+float MeasureCPUZoneOverhead()
+{
+	FCPUProfilerThread* Thread = GetCPUProfilerThread();
+	if (!Thread)
+	{
+		return 0.0f;
+	}
+
+	const uint32_t NumZones = 4096;
+	const uint32_t NumEvents = Thread->NumEvents;
+	const uint64_t BeginCycle = EA::StdC::Stopwatch::GetCPUCycle();
+	for (uint32_t Idx = 0; Idx < NumZones; ++Idx)
+	{
+		CPU_ZONE("Overhead");
+	}
+	const uint64_t EndCycle = EA::StdC::Stopwatch::GetCPUCycle();
+	Thread->NumEvents = NumEvents;
+
+	return (float)((EndCycle - BeginCycle) * 1.0e9 / EA::StdC::Stopwatch::GetCPUFrequency() / NumZones);
+}
+
+// Chrome trace event format (chrome://tracing, Perfetto), one complete ("X") event per zone.
+bool WriteCPUProfilerTrace(const char* FileName)
+{
+	FILE* File = fopen(FileName, "w");
+	if (!File)
+	{
+		return false;
+	}
+
+	const double CyclesToUs = 1.0e6 / EA::StdC::Stopwatch::GetCPUFrequency();
+	const uint32_t NumThreads = (uint32_t)GNumCPUProfilerThreads.GetValue();
+
+	eastl::vector<eastl::vector<FCPUZoneEvent>> ThreadEvents(NumThreads);
+	uint64_t FirstCycle = ~0ull;
+	for (uint32_t Idx = 0; Idx < NumThreads; ++Idx)
+	{
+		if (GCPUProfilerThreads[Idx])
+		{
+			GetCPUZoneEvents(*GCPUProfilerThreads[Idx], ThreadEvents[Idx]);
+			for (const FCPUZoneEvent& Event : ThreadEvents[Idx])
+			{
+				FirstCycle = eastl::min(FirstCycle, Event.BeginCycle);
+			}
+		}
+	}
+
+	fprintf(File, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	bool bIsFirst = true;
+	for (uint32_t Idx = 0; Idx < NumThreads; ++Idx)
+	{
+		if (!GCPUProfilerThreads[Idx])
+		{
+			continue;
+		}
+		const FCPUProfilerThread& Thread = *GCPUProfilerThreads[Idx];
+		fprintf(File, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}}", bIsFirst ? "" : ",\n", Thread.ThreadId, Thread.Name);
+		bIsFirst = false;
+
+		for (const FCPUZoneEvent& Event : ThreadEvents[Idx])
+		{
+			fprintf(File, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}", Event.Name, Thread.ThreadId, (Event.BeginCycle - FirstCycle) * CyclesToUs, (Event.EndCycle - Event.BeginCycle) * CyclesToUs);
+		}
+	}
+	fprintf(File, "\n]}\n");
+	fclose(File);
+	return true;
+}
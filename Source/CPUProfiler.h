@@ -0,0 +1,74 @@
+#pragma once
+
+#include <stdint.h>
+#include "EASTL/algorithm.h"
+#include "EASTL/vector.h"
+#include "EAStdC/EAStopwatch.h"
+#include "EAThread/eathread_atomic.h"
+#include "EAThread/eathread_sync.h"
+
+// CPU zone profiler. It needs neither the device nor Win32 (the ImGui window is in Library.cpp), the headless tests
+// (Tests/) build CPUProfiler.cpp and check the zone overhead.
+
+// Times the rest of the enclosing scope on the CPU profiler. Name has to be a string literal, events keep the pointer.
+#define CPU_ZONE(Name) FCPUZone EA_PREPROCESSOR_JOIN(CPUZone, __LINE__)(Name)
+
+static const uint32_t kCPUZoneBufferSize = 64 * 1024; // Events per thread, power of two. Oldest are overwritten.
+static const uint32_t kMaxCPUProfilerThreads = 64;
+
+struct FCPUZoneEvent
+{
+	const char* Name;
+	uint64_t BeginCycle;
+	uint64_t EndCycle;
+};
+
+// Events of one thread. Only the owning thread writes and NumEvents is published after the event with a plain store,
+// an interlocked one would cost more than the rest of the zone; readers on other threads never block it. A reader can still see an event being overwritten when the ring wraps, the newest
+// kCPUZoneBufferSize / 2 events are safe to read. NumEvents wraps around after 2^32 zones, which the ring indexing and
+// the readers' unsigned arithmetic handle.
+struct FCPUProfilerThread
+{
+	uint32_t ThreadId;
+	char Name[32];
+	volatile uint32_t NumEvents;
+	FCPUZoneEvent Events[kCPUZoneBufferSize];
+};
+
+void AddCPUZoneEvent(const char* Name, uint64_t BeginCycle, uint64_t EndCycle);
+
+// See CPU_ZONE. Both timestamps are raw TSC reads, everything else happens in AddCPUZoneEvent when the zone ends.
+struct FCPUZone
+{
+	const char* Name;
+	uint64_t BeginCycle;
+
+	explicit FCPUZone(const char* InName) : Name(InName), BeginCycle(EA::StdC::Stopwatch::GetCPUCycle()) {}
+	~FCPUZone() { AddCPUZoneEvent(Name, BeginCycle, EA::StdC::Stopwatch::GetCPUCycle()); }
+};
+
+FCPUProfilerThread* GetCPUProfilerThread();
+void SetCPUProfilerThreadName(const char* Name);
+void DestroyCPUProfiler();
+float MeasureCPUZoneOverhead();
+bool WriteCPUProfilerTrace(const char* FileName);
+
+// Copies the newest readable events of a thread.
+template<typename TAllocator>
+inline void GetCPUZoneEvents(FCPUProfilerThread& Thread, eastl::vector<FCPUZoneEvent, TAllocator>& OutEvents)
+{
+	const uint32_t NumEvents = Thread.NumEvents;
+	EAReadBarrier();
+	const uint32_t Count = eastl::min(NumEvents, kCPUZoneBufferSize / 2);
+
+	OutEvents.clear();
+	OutEvents.reserve(Count);
+	for (uint32_t Idx = NumEvents - Count; Idx != NumEvents; ++Idx)
+	{
+		const FCPUZoneEvent& Event = Thread.Events[Idx & (kCPUZoneBufferSize - 1)];
+		if (Event.Name && Event.EndCycle >= Event.BeginCycle)
+		{
+			OutEvents.push_back(Event);
+		}
+	}
+}
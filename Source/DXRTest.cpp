@@ -1,366 +1,2263 @@
 #include "Library.h"
+#include "Allocator.h"
 #include "CPUAndGPUCommon.h"
+#include "DynamicResolution.h"
+#include "GLTF.h"
+#include "NullCommandList.h"
+#include "PLY.h"
+#include "RTPermutation.h"
+#include "Reference.h"
+#include "ShaderTable.h"
 #include "d3dx12.h"
 #include "imgui/imgui.h"
+#include "DirectXMath/DirectXPackedVector.h"
 #include "EAStdC/EAStdC.h"
+#include "EAStdC/EAString.h"
 #include "EAStdC/EASprintf.h"
 #include "EAStdC/EABitTricks.h"
+#include "EAThread/eathread_thread.h"
 #include "stb_image.h"
 
-enum
+// Ray types traced by RT pipelines, each instance has this many consecutive hit group records. TraceRay calls in
+// Raytracing.hlsl pass the ray type as RayContributionToHitGroupIndex and this as the geometry multiplier.
+static const uint32_t kNumRayTypes = RAY_TYPE_COUNT;
+static const char* const kRayTypeNames[kNumRayTypes] = { "Primary" };
+
+typedef TShaderRecord<void> FRayGenRecord;
+typedef TShaderRecord<void> FMissRecord;
+typedef TShaderRecord<FStaticMeshInfo> FHitGroupRecord; // Local root constants, see MeshSignature in Raytracing.hlsl.
+
+// How primary rays are traced. Both paths use the same root bindings (GRaytracingRootSignature) and produce the same
+// image.
+enum ETracePath
+{
+	TracePath_Pipeline, // DispatchRays with RTPipelines[RTPermutation] and the shader table.
+	TracePath_RayQuery, // Compute shader with inline ray queries (RayQuery.hlsl).
+	TracePath_Count,
+};
+
+static const char* const kTracePathNames[TracePath_Count] = { "DispatchRays", "Ray query" };
+
+// A/B benchmark: each path renders the same camera path (kBenchmarkFrames frames around the scene) after a warm-up.
+static const uint32_t kBenchmarkWarmupFrames = 30;
+static const uint32_t kBenchmarkFrames = 300;
+
+// Trace pass GPU time comes from the "Trace" profiler scope. Profiler results arrive when the frame slot is reused, so
+// each slot remembers which path it sampled.
+struct FTraceBenchmark
+{
+	bool bIsRunning;
+	uint32_t Frame;
+	uint32_t SavedTracePath;
+	int32_t SamplePath; // Path sampled by the frame being recorded, -1 during warm-up.
+	int32_t SlotSamplePaths[2]; // Path sampled in each frame slot, -1 when the slot is not a benchmark sample.
+	double TotalMs[TracePath_Count];
+	uint32_t NumSamples[TracePath_Count];
+	float ResultMs[TracePath_Count]; // Average of the last completed run.
+};
+
+// Opt-in ray counters (AddRayCounter in RaytracingCommon.hlsli). GPU keeps running totals which are copied to this
+// frame slot's part of the readback buffer after tracing. Results are read when the slot is reused, together with the
+// "Trace" timestamps of the same frame, so nothing ever waits.
+struct FRayCounters
+{
+	bool bIsEnabled;
+	ID3D12Resource* Buffer;
+	ID3D12Resource* ReadbackBuffer;
+	const uint32_t* ReadbackData; // Persistently mapped.
+	bool bSlotHasData[2];
+	bool bHasPrevious;
+	uint32_t Previous[kNumRayCounters]; // Totals read last frame.
+	uint64_t LastCounts[kNumRayCounters]; // Counts of the last frame read back.
+	double RaysPerSecond; // Last frame, all ray types.
+	uint64_t TotalCounts[kNumRayCounters]; // Sums since ResetRayCounterTotals.
+	double TotalTraceMs;
+	uint32_t NumFrames;
+};
+
+// --benchmark: the camera follows its orbit with a fixed time step instead of wall-clock time and the UI is off. After
+// the warm-up, kBenchmarkModeFrames frames are measured, the report is written and the application quits, with exit
+// code 1 when any measured frame allocated memory or the upscaled output does not match the CPU version of the filter
+// (CheckUpscaleOutput).
+// --null-gpu (with --benchmark) records frames into the null command list to measure CPU cost of frame building, UI is
+// on in that case as it is part of that cost. --ray-counters enables ray counters, --upscale=<factor> traces at the
+// closest of kUpscaleFactors, --interleave=<2|4> traces one pixel out of 2 or 4 per frame, --temporal enables temporal
+// accumulation, --dump-gbuffer=<file> writes the denoiser input of the last measured frame (FGBufferCapture).
+static const uint32_t kBenchmarkModeWarmupFrames = 60;
+static const uint32_t kBenchmarkModeFrames = 600;
+static const double kBenchmarkModeTimeStep = 1.0 / 60.0;
+static_assert(kBenchmarkModeFrames <= kFrameStatsHistorySize, "Measured frames have to fit frame stats history.");
+
+struct FBenchmarkMode
+{
+	bool bIsEnabled;
+	uint32_t Frame;
+	bool bUsesNullCommandList;
+	double TraceMs; // "Trace" GPU scope summed over measured frames.
+	double UpscaleMs;
+	double ReconstructMs;
+	double DenoiseMs;
+	double TemporalMs;
+	uint32_t NumTraceSamples;
+	uint64_t FirstNumAllocations; // Allocation count and null command list stats when measurement started.
+	uint32_t MaxFrameAllocations; // Measured frames should not allocate at all, per-frame data uses the frame arena.
+	uint32_t NumAllocatingFrames;
+	FNullCommandStats FirstNullCommandStats;
+	bool bHasUpscaleCheck;
+	float UpscaleCheckPSNR; // Last upscaled frame against the CPU version, dB.
+	float UpscaleCheckMaxError;
+	const char* ReportFileName;
+};
+
+// Output is 8 bit UNORM like RTOutput, differences beyond rounding and the sub-texel precision of the linear sampler fail
+// the upscale check.
+static const float kUpscaleCheckMaxError = 3.0f / 255.0f;
+
+// Copy of a texture in a readback buffer, recorded into a command list (CopyToTextureReadback) and read on the CPU once
+// the GPU has executed it.
+struct FTextureReadback
+{
+	ID3D12Resource* Buffer;
+	D3D12_PLACED_SUBRESOURCE_FOOTPRINT Footprint;
+	DXGI_FORMAT Format;
+};
+
+// --dump-gbuffer=<file>: color and hit positions of the traced rectangle as the denoiser gets them, with the camera, for
+// running the CPU denoiser on the scene (DXRTEST_GBUFFER_DUMP=<file> Tests --benchmark DenoiseBenchmark). Readback
+// buffers are created up front so that the measured frame that records the copies does not allocate.
+struct FGBufferCapture
+{
+	char FileName[MAX_PATH]; // Empty when not capturing.
+	bool bIsRecorded;
+	FTextureReadback Color;
+	FTextureReadback HitPosition;
+	uint32_t TraceResolution[2];
+	XMFLOAT4X4 WorldToProjection; // Not transposed.
+	XMFLOAT4 CameraPosition;
+};
+
+// Output size over trace size, per axis, for a fixed trace resolution.
+static const uint32_t kNumUpscaleFactors = 5;
+static const float kUpscaleFactors[kNumUpscaleFactors] = { 1.0f, 1.3f, 1.5f, 1.7f, 2.0f };
+static const char* const kUpscaleFactorNames[kNumUpscaleFactors] = { "Native", "1.3x", "1.5x", "1.7x", "2x" };
+static const char* const kUpscaleFilterNames[UPSCALE_FILTER_COUNT] = { "Bilinear", "Edge adaptive" };
+
+// Rays are traced into a rectangle in the top-left corner of RTOutput which is upscaled (Upscale.hlsl) when it is
+// smaller than the output. Its size either follows UpscaleFactor or, with dynamic resolution, keeps the "Frame" GPU
+// scope near TargetGPUMs (GetDynamicResolutionScale). Scale applies to both axes.
+struct FDynamicResolution
+{
+	bool bIsEnabled;
+	float TargetGPUMs;
+	float Scale;
+	uint32_t UpscaleFactor; // Index to kUpscaleFactors, used when dynamic resolution is off.
+	uint32_t UpscaleFilter;
+	float Sharpness;
+	uint32_t TraceResolution[2];
+	ID3D12PipelineState* UpscalePipeline;
+	ID3D12RootSignature* UpscaleSignature;
+	ID3D12Resource* UpscaleOutput;
+	D3D12_CPU_DESCRIPTOR_HANDLE UpscaleOutputUAV;
+	D3D12_CPU_DESCRIPTOR_HANDLE RTOutputSRV;
+};
+
+// Trace results kept for the next frame: world space hit positions and the camera they were traced with, used by the
+// reconstruction, denoising and temporal passes. Double buffered resources of these passes are indexed with Index for the ones
+// written this frame and Index ^ 1 for the previous frame.
+struct FTraceHistory
+{
+	uint32_t Index;
+	uint32_t ShadingKey; // RTPermutation of the previous frame.
+	XMFLOAT4X4 PrevWorldToProjection; // Not transposed, see GetReprojectedPixel.
+	uint32_t PrevTraceResolution[2];
+	ID3D12Resource* HitPositions[2];
+	D3D12_CPU_DESCRIPTOR_HANDLE HitPositionSRVs[2];
+	D3D12_CPU_DESCRIPTOR_HANDLE HitPositionUAVs[2];
+};
+
+// Interleaved tracing (Reconstruct.hlsl): each frame only one pixel out of kInterleaveModes[Mode] gets a ray, in a
+// pattern that rotates every frame (GetInterleavedPixel). The other pixels are reprojected from the previous
+// reconstructed image or interpolated.
+static const uint32_t kNumInterleaveModes = 3;
+static const uint32_t kInterleaveModes[kNumInterleaveModes] = { 1, 2, 4 };
+static const char* const kInterleaveModeNames[kNumInterleaveModes] = { "Off", "Checkerboard", "1 of 4" };
+
+struct FInterleavedTrace
+{
+	uint32_t Mode;
+	uint32_t Phase;
+	bool bHasHistory;
+	ID3D12PipelineState* Pipeline;
+	ID3D12RootSignature* Signature;
+	ID3D12Resource* Colors[2]; // Reconstructed images.
+	D3D12_CPU_DESCRIPTOR_HANDLE ColorSRVs[2];
+	D3D12_CPU_DESCRIPTOR_HANDLE ColorUAVs[2];
+};
+
+// SVGF-style denoiser: temporal accumulation with a per-pixel luminance variance estimate (DenoiseTemporal.hlsl)
+// followed by NumIterations edge-aware a-trous wavelet iterations (DenoiseFilter.hlsl) that double their tap spacing
+// every time. The first iteration's result is the color history of the next frame. Runs before temporal accumulation.
+static const uint32_t kDenoiseMaxIterations = DENOISE_MAX_ITERATIONS;
+
+struct FDenoiser
+{
+	bool bIsEnabled;
+	bool bHasHistory;
+	uint32_t NumIterations;
+	float LuminancePhi;
+	float NormalPhi;
+	float DepthPhi;
+	ID3D12PipelineState* TemporalPipeline;
+	ID3D12RootSignature* TemporalSignature;
+	ID3D12PipelineState* FilterPipeline;
+	ID3D12RootSignature* FilterSignature;
+	ID3D12Resource* HistoryColors[2];
+	D3D12_CPU_DESCRIPTOR_HANDLE HistoryColorSRVs[2];
+	D3D12_CPU_DESCRIPTOR_HANDLE HistoryColorUAVs[2];
+	ID3D12Resource* HistoryMoments[2]; // Luminance, squared luminance and number of accumulated frames.
+	D3D12_CPU_DESCRIPTOR_HANDLE HistoryMomentSRVs[2];
+	D3D12_CPU_DESCRIPTOR_HANDLE HistoryMomentUAVs[2];
+	ID3D12Resource* Filtered[2]; // Color and variance, ping-ponged by the a-trous iterations.
+	D3D12_CPU_DESCRIPTOR_HANDLE FilteredSRVs[2];
+	D3D12_CPU_DESCRIPTOR_HANDLE FilteredUAVs[2];
+	ID3D12Resource* Normals;
+	D3D12_CPU_DESCRIPTOR_HANDLE NormalsUAV;
+};
+
+// Temporal accumulation (Temporal.hlsl) of the traced rectangle, history colors are double buffered (FTraceHistory).
+// While enabled, camera rays follow a Halton(2, 3) jitter sequence.
+static const uint32_t kNumJitterPhases = 8;
+
+struct FTemporalAccumulation
+{
+	bool bIsEnabled;
+	bool bHasHistory;
+	uint32_t JitterPhase;
+	float MinBlendFactor;
+	float DisocclusionTolerance; // Reconstruction and the denoiser use it as well.
+	ID3D12PipelineState* Pipeline;
+	ID3D12RootSignature* Signature;
+	ID3D12Resource* HistoryColors[2];
+	D3D12_CPU_DESCRIPTOR_HANDLE HistoryColorSRVs[2];
+	D3D12_CPU_DESCRIPTOR_HANDLE HistoryColorUAVs[2];
+};
+
+// Stack sizes are reported by the driver for the compiled pipeline (DXR does not expose register counts, stack size is
+// what limits occupancy of a ray tracing pipeline).
+struct FRTPipeline
+{
+	ID3D12StateObject* RTPipeline;
+	ID3D12RootSignature* RTGlobalSignature;
+	uint32_t PayloadSize;
+	uint64_t RayGenStackSize;
+	uint64_t MissStackSize;
+	uint64_t ClosestHitStackSize;
+	uint64_t PipelineStackSize;
+};
+
+// Range of the static geometry buffers that belongs to one mesh. Indices are relative to BaseVertex.
+struct FStaticMesh
+{
+	uint32_t BaseVertex;
+	uint32_t NumVertices;
+	uint32_t BaseIndex;
+	uint32_t NumIndices;
+};
+
+struct FMeshInstance
+{
+	uint32_t MeshIndex;
+	XMFLOAT4X4 Transform;
+};
+
+// One entry of the startup timeline, times are in seconds from GetTime().
+struct FStartupTask
+{
+	const char* Name;
+	uint32_t ThreadId;
+	double BeginTime;
+	double EndTime;
+};
+
+// RT pipeline compiled on its own worker thread during startup.
+struct FRTPipelineBuild
+{
+	FGraphicsContext* Gfx;
+	uint32_t Permutation;
+	char LibraryName[32];
+	FRTPipeline Pipeline;
+	FStartupTask Task;
+	EA::Thread::Thread Thread;
+};
+
+// Mesh data is streamed in windows of this many elements.
+static const uint32_t kStreamWindowSize = 64 * 1024;
+
+struct FDemoRoot
+{
+	FGraphicsContext Gfx;
+	FUIContext UI;
+	FAssetCache AssetCache;
+	eastl::vector<FRTPipeline> RTPipelines;
+	FRTSettings RTSettings;
+	uint32_t RTPermutation; // Pipeline used for drawing, follows RTSettings.
+	ID3D12Resource* VertexBuffer;
+	ID3D12Resource* IndexBuffer;
+	D3D12_CPU_DESCRIPTOR_HANDLE VertexBufferSRV;
+	D3D12_CPU_DESCRIPTOR_HANDLE IndexBufferSRV;
+	eastl::vector<FStaticMesh> StaticMeshes;
+	eastl::vector<FMeshInstance> MeshInstances;
+	ID3D12Resource* MeshInfoBuffer;
+	D3D12_CPU_DESCRIPTOR_HANDLE MeshInfoSRV;
+	eastl::vector<ID3D12Resource*> BLASResultBuffers;
+	ID3D12Resource* TLASInstanceBuffer;
+	ID3D12Resource* TLASResultBuffer;
+	FShaderTable ShaderTable;
+	ID3D12PipelineState* RayQueryPipeline; // Null when the device does not support DXR 1.1.
+	ID3D12RootSignature* RayQuerySignature;
+	uint32_t TracePath;
+	FTraceBenchmark Benchmark;
+	FBenchmarkMode BenchmarkMode;
+	FGBufferCapture GBufferCapture;
+	FRayCounters RayCounters;
+	FDynamicResolution DynamicResolution;
+	FTraceHistory TraceHistory;
+	FInterleavedTrace Interleaved;
+	FDenoiser Denoiser;
+	FTemporalAccumulation Temporal;
+	ID3D12Resource* RTOutput;
+	D3D12_CPU_DESCRIPTOR_HANDLE RTOutputUAV;
+	XMFLOAT3 CameraPosition;
+	XMFLOAT3 CameraFocusPosition;
+};
+
+static void GetRTPermutationLibraryName(uint32_t Key, char* OutName, uint32_t NameSize)
+{
+	EA::StdC::Snprintf(OutName, NameSize, "Raytracing_P%u.lib.cso", Key);
+}
+
+template<typename TAllocator>
+static void WriteRTShaderRecords(FDemoRoot& Root, const FRTPipeline& Pipeline, eastl::vector<uint32_t, TAllocator>& OutHitGroupIndices);
+
+static void CreateRayCounters(FGraphicsContext& Gfx, FRayCounters& OutCounters)
+{
+	const uint64_t Size = kNumRayCounters * sizeof(uint32_t);
+	OutCounters.Buffer = CreateGPUResource(Gfx, GPUMemory_Other, D3D12_HEAP_TYPE_DEFAULT, CD3DX12_RESOURCE_DESC::Buffer(Size, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS), D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+	OutCounters.ReadbackBuffer = CreateGPUResource(Gfx, GPUMemory_Readback, D3D12_HEAP_TYPE_READBACK, CD3DX12_RESOURCE_DESC::Buffer(2 * Size), D3D12_RESOURCE_STATE_COPY_DEST);
+	VHR(OutCounters.ReadbackBuffer->Map(0, &CD3DX12_RANGE(0, 2 * Size), (void**)&OutCounters.ReadbackData));
+}
+
+static void DestroyRayCounters(FRayCounters& Counters)
+{
+	SAFE_RELEASE(Counters.Buffer);
+	SAFE_RELEASE(Counters.ReadbackBuffer);
+	Counters = {};
+}
+
+static void ResetRayCounterTotals(FRayCounters& Counters)
+{
+	memset(Counters.TotalCounts, 0, sizeof(Counters.TotalCounts));
+	Counters.TotalTraceMs = 0.0;
+	Counters.NumFrames = 0;
+}
+
+// Call after BeginGPUProfilerFrame. A frame only gets counts when the frame before it was counted too.
+static void ReadRayCounters(FGraphicsContext& Gfx, FRayCounters& Counters)
+{
+	const uint32_t Slot = Gfx.FrameIndex;
+	if (!Counters.bSlotHasData[Slot])
+	{
+		Counters.bHasPrevious = false;
+		Counters.RaysPerSecond = 0.0;
+		Gfx.FrameStats.RaysPerSecond = 0.0;
+		return;
+	}
+	Counters.bSlotHasData[Slot] = false;
+
+	const uint32_t* Current = Counters.ReadbackData + Slot * kNumRayCounters;
+	if (Counters.bHasPrevious)
+	{
+		GetRayCounterDeltas(Counters.Previous, Current, Counters.LastCounts);
+
+		const FGPUScopeStats* Trace = FindGPUScopeStats(Gfx.GPUProfiler, "Trace");
+		const double TraceMs = Trace ? Trace->LastMs : 0.0;
+		uint64_t NumRays = 0;
+		for (uint32_t Idx = 0; Idx < kNumRayCounters; ++Idx)
+		{
+			Counters.TotalCounts[Idx] += Counters.LastCounts[Idx];
+		}
+		for (uint32_t RayType = 0; RayType < kNumRayTypes; ++RayType)
+		{
+			NumRays += Counters.LastCounts[RayType * RAY_COUNTER_COUNT + RAY_COUNTER_RAYS];
+		}
+		Counters.RaysPerSecond = TraceMs > 0.0 ? NumRays * 1000.0 / TraceMs : 0.0;
+		Counters.TotalTraceMs += TraceMs;
+		Counters.NumFrames += 1;
+		Gfx.FrameStats.RaysPerSecond = Counters.RaysPerSecond;
+	}
+	memcpy(Counters.Previous, Current, sizeof(Counters.Previous));
+	Counters.bHasPrevious = true;
+}
+
+// Records copy of the running totals to the readback buffer, call after tracing.
+static void CopyRayCounters(FGraphicsContext& Gfx, FRayCounters& Counters)
+{
+	const uint32_t Slot = Gfx.FrameIndex;
+	const uint64_t Size = kNumRayCounters * sizeof(uint32_t);
+
+	Gfx.CmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(Counters.Buffer, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_COPY_SOURCE));
+	Gfx.CmdList->CopyBufferRegion(Counters.ReadbackBuffer, Slot * Size, Counters.Buffer, 0, Size);
+	Gfx.CmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(Counters.Buffer, D3D12_RESOURCE_STATE_COPY_SOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS));
+	Counters.bSlotHasData[Slot] = true;
+}
+
+static uint32_t FindUpscaleFactor(float Factor)
+{
+	uint32_t Closest = 0;
+	for (uint32_t Idx = 1; Idx < kNumUpscaleFactors; ++Idx)
+	{
+		if (fabsf(kUpscaleFactors[Idx] - Factor) < fabsf(kUpscaleFactors[Closest] - Factor))
+		{
+			Closest = Idx;
+		}
+	}
+	return Closest;
+}
+
+// Call after BeginGPUProfilerFrame. Trace size is rounded to the 8x8 ray query groups.
+static void UpdateDynamicResolution(FGraphicsContext& Gfx, FDynamicResolution& Res, bool bCanAdapt)
+{
+	if (Res.bIsEnabled && bCanAdapt)
+	{
+		if (const FGPUScopeStats* Stats = FindGPUScopeStats(Gfx.GPUProfiler, "Frame"))
+		{
+			Res.Scale = GetDynamicResolutionScale(Res.Scale, Res.TargetGPUMs, (float)Stats->LastMs);
+		}
+	}
+	else
+	{
+		Res.Scale = 1.0f / kUpscaleFactors[Res.UpscaleFactor];
+	}
+	for (uint32_t Idx = 0; Idx < 2; ++Idx)
+	{
+		const uint32_t Size = ((uint32_t)(Gfx.Resolution[Idx] * Res.Scale) + 7) & ~7u;
+		Res.TraceResolution[Idx] = eastl::min(Size, Gfx.Resolution[Idx]);
+	}
+}
+
+// Compute pipeline and root signature of a shader that has its root signature in HLSL (goes through the pipeline
+// cache).
+static void CreateComputeShader(FGraphicsContext& Gfx, const char* FileName, ID3D12PipelineState*& OutPipeline, ID3D12RootSignature*& OutSignature)
+{
+	FFileView CSBytecode;
+	if (!OpenFileView(FileName, CSBytecode))
+	{
+		EA_ASSERT(0);
+	}
+
+	D3D12_COMPUTE_PIPELINE_STATE_DESC PSODesc = {};
+	PSODesc.CS = { CSBytecode.Data, CSBytecode.Size };
+
+	OutPipeline = CreateComputePipeline(Gfx, PSODesc);
+	VHR(Gfx.Device->CreateRootSignature(0, CSBytecode.Data, CSBytecode.Size, IID_PPV_ARGS(&OutSignature)));
+	CloseFileView(CSBytecode);
+}
+
+static void CreateDynamicResolution(FGraphicsContext& Gfx, ID3D12Resource* RTOutput, FDynamicResolution& OutRes)
+{
+	CreateComputeShader(Gfx, "Data/Shaders/Upscale.cs.cso", OutRes.UpscalePipeline, OutRes.UpscaleSignature);
+
+	OutRes.UpscaleOutput = CreateGPUResource(Gfx, GPUMemory_RenderTarget, D3D12_HEAP_TYPE_DEFAULT, RTOutput->GetDesc(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+	OutRes.UpscaleOutputUAV = AllocateDescriptors(Gfx, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, 1);
+	Gfx.Device->CreateUnorderedAccessView(OutRes.UpscaleOutput, nullptr, nullptr, OutRes.UpscaleOutputUAV);
+
+	OutRes.RTOutputSRV = AllocateDescriptors(Gfx, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, 1);
+	Gfx.Device->CreateShaderResourceView(RTOutput, nullptr, OutRes.RTOutputSRV);
+
+	OutRes.TargetGPUMs = 8.0f;
+	OutRes.Scale = 1.0f;
+	OutRes.UpscaleFilter = UPSCALE_FILTER_EDGE_ADAPTIVE;
+	OutRes.Sharpness = 0.25f;
+	OutRes.TraceResolution[0] = Gfx.Resolution[0];
+	OutRes.TraceResolution[1] = Gfx.Resolution[1];
+}
+
+static void DestroyDynamicResolution(FDynamicResolution& Res)
+{
+	SAFE_RELEASE(Res.UpscalePipeline);
+	SAFE_RELEASE(Res.UpscaleSignature);
+	SAFE_RELEASE(Res.UpscaleOutput);
+	Res = {};
+}
+
+static bool IsUpscaling(const FGraphicsContext& Gfx, const FDynamicResolution& Res)
+{
+	return Res.TraceResolution[0] != Gfx.Resolution[0] || Res.TraceResolution[1] != Gfx.Resolution[1];
+}
+
+// Upscales the traced rectangle of RTOutput into UpscaleOutput, both are left in UNORDERED_ACCESS state.
+static void UpscaleRTOutput(FGraphicsContext& Gfx, ID3D12Resource* RTOutput, const FDynamicResolution& Res)
+{
+	ID3D12GraphicsCommandList5* CmdList = Gfx.CmdList;
+	CmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(RTOutput, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE));
+
+	const uint32_t UpscaleScope = BeginGPUScope(Gfx, "Upscale");
+	FUpscaleConstants Constants;
+	Constants.InputSize = XMFLOAT2((float)Res.TraceResolution[0], (float)Res.TraceResolution[1]);
+	Constants.InvInputTextureSize = XMFLOAT2(1.0f / Gfx.Resolution[0], 1.0f / Gfx.Resolution[1]);
+	Constants.Filter = Res.UpscaleFilter;
+	Constants.Sharpness = Res.Sharpness;
+
+	CmdList->SetPipelineState(Res.UpscalePipeline);
+	CmdList->SetComputeRootSignature(Res.UpscaleSignature);
+	CmdList->SetComputeRoot32BitConstants(0, sizeof(Constants) / sizeof(uint32_t), &Constants, 0);
+	{
+		const D3D12_GPU_DESCRIPTOR_HANDLE TableBase = CopyDescriptorsToGPUHeap(Gfx, 1, Res.RTOutputSRV);
+		CopyDescriptorsToGPUHeap(Gfx, 1, Res.UpscaleOutputUAV);
+		CmdList->SetComputeRootDescriptorTable(1, TableBase);
+	}
+	CmdList->Dispatch((Gfx.Resolution[0] + 7) / 8, (Gfx.Resolution[1] + 7) / 8, 1);
+	EndGPUScope(Gfx, UpscaleScope);
+
+	CmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(RTOutput, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS));
+}
+
+// Textures sized like RTOutput in UNORDERED_ACCESS state, with SRVs and UAVs.
+static void CreateHistoryTextures(FGraphicsContext& Gfx, ID3D12Resource* RTOutput, DXGI_FORMAT Format, ID3D12Resource* (&OutTextures)[2], D3D12_CPU_DESCRIPTOR_HANDLE (&OutSRVs)[2], D3D12_CPU_DESCRIPTOR_HANDLE (&OutUAVs)[2])
+{
+	D3D12_RESOURCE_DESC Desc = RTOutput->GetDesc();
+	Desc.Format = Format;
+	for (uint32_t Idx = 0; Idx < 2; ++Idx)
+	{
+		OutTextures[Idx] = CreateGPUResource(Gfx, GPUMemory_RenderTarget, D3D12_HEAP_TYPE_DEFAULT, Desc, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+		OutSRVs[Idx] = AllocateDescriptors(Gfx, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, 1);
+		OutUAVs[Idx] = AllocateDescriptors(Gfx, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, 1);
+		Gfx.Device->CreateShaderResourceView(OutTextures[Idx], nullptr, OutSRVs[Idx]);
+		Gfx.Device->CreateUnorderedAccessView(OutTextures[Idx], nullptr, nullptr, OutUAVs[Idx]);
+	}
+}
+
+static void CreateTraceHistory(FGraphicsContext& Gfx, ID3D12Resource* RTOutput, FTraceHistory& OutHistory)
+{
+	CreateHistoryTextures(Gfx, RTOutput, DXGI_FORMAT_R32G32B32A32_FLOAT, OutHistory.HitPositions, OutHistory.HitPositionSRVs, OutHistory.HitPositionUAVs);
+}
+
+static void DestroyTraceHistory(FTraceHistory& History)
+{
+	for (uint32_t Idx = 0; Idx < 2; ++Idx)
+	{
+		SAFE_RELEASE(History.HitPositions[Idx]);
+	}
+	History = {};
+}
+
+static void CreateInterleavedTrace(FGraphicsContext& Gfx, ID3D12Resource* RTOutput, FInterleavedTrace& OutInterleaved)
+{
+	CreateComputeShader(Gfx, "Data/Shaders/Reconstruct.cs.cso", OutInterleaved.Pipeline, OutInterleaved.Signature);
+	CreateHistoryTextures(Gfx, RTOutput, RTOutput->GetDesc().Format, OutInterleaved.Colors, OutInterleaved.ColorSRVs, OutInterleaved.ColorUAVs);
+}
+
+static void DestroyInterleavedTrace(FInterleavedTrace& Interleaved)
+{
+	SAFE_RELEASE(Interleaved.Pipeline);
+	SAFE_RELEASE(Interleaved.Signature);
+	for (uint32_t Idx = 0; Idx < 2; ++Idx)
+	{
+		SAFE_RELEASE(Interleaved.Colors[Idx]);
+	}
+	Interleaved = {};
+}
+
+static void CreateDenoiser(FGraphicsContext& Gfx, ID3D12Resource* RTOutput, FDenoiser& OutDenoiser)
+{
+	CreateComputeShader(Gfx, "Data/Shaders/DenoiseTemporal.cs.cso", OutDenoiser.TemporalPipeline, OutDenoiser.TemporalSignature);
+	CreateComputeShader(Gfx, "Data/Shaders/DenoiseFilter.cs.cso", OutDenoiser.FilterPipeline, OutDenoiser.FilterSignature);
+
+	CreateHistoryTextures(Gfx, RTOutput, DXGI_FORMAT_R16G16B16A16_FLOAT, OutDenoiser.HistoryColors, OutDenoiser.HistoryColorSRVs, OutDenoiser.HistoryColorUAVs);
+	CreateHistoryTextures(Gfx, RTOutput, DXGI_FORMAT_R16G16B16A16_FLOAT, OutDenoiser.HistoryMoments, OutDenoiser.HistoryMomentSRVs, OutDenoiser.HistoryMomentUAVs);
+	CreateHistoryTextures(Gfx, RTOutput, DXGI_FORMAT_R16G16B16A16_FLOAT, OutDenoiser.Filtered, OutDenoiser.FilteredSRVs, OutDenoiser.FilteredUAVs);
+
+	D3D12_RESOURCE_DESC Desc = RTOutput->GetDesc();
+	Desc.Format = DXGI_FORMAT_R16G16B16A16_FLOAT;
+	OutDenoiser.Normals = CreateGPUResource(Gfx, GPUMemory_RenderTarget, D3D12_HEAP_TYPE_DEFAULT, Desc, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+	OutDenoiser.NormalsUAV = AllocateDescriptors(Gfx, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, 1);
+	Gfx.Device->CreateUnorderedAccessView(OutDenoiser.Normals, nullptr, nullptr, OutDenoiser.NormalsUAV);
+
+	if (OutDenoiser.NumIterations == 0) // --denoise=<iterations> sets it before.
+	{
+		OutDenoiser.NumIterations = kDenoiseMaxIterations;
+	}
+	OutDenoiser.LuminancePhi = DENOISE_DEFAULT_LUMINANCE_PHI;
+	OutDenoiser.NormalPhi = DENOISE_DEFAULT_NORMAL_PHI;
+	OutDenoiser.DepthPhi = DENOISE_DEFAULT_DEPTH_PHI;
+}
+
+static void DestroyDenoiser(FDenoiser& Denoiser)
+{
+	SAFE_RELEASE(Denoiser.TemporalPipeline);
+	SAFE_RELEASE(Denoiser.TemporalSignature);
+	SAFE_RELEASE(Denoiser.FilterPipeline);
+	SAFE_RELEASE(Denoiser.FilterSignature);
+	for (uint32_t Idx = 0; Idx < 2; ++Idx)
+	{
+		SAFE_RELEASE(Denoiser.HistoryColors[Idx]);
+		SAFE_RELEASE(Denoiser.HistoryMoments[Idx]);
+		SAFE_RELEASE(Denoiser.Filtered[Idx]);
+	}
+	SAFE_RELEASE(Denoiser.Normals);
+	Denoiser = {};
+}
+
+static void CreateTemporalAccumulation(FGraphicsContext& Gfx, ID3D12Resource* RTOutput, FTemporalAccumulation& OutTemporal)
+{
+	CreateComputeShader(Gfx, "Data/Shaders/Temporal.cs.cso", OutTemporal.Pipeline, OutTemporal.Signature);
+
+	// Colors keep the number of accumulated frames in alpha.
+	CreateHistoryTextures(Gfx, RTOutput, DXGI_FORMAT_R16G16B16A16_FLOAT, OutTemporal.HistoryColors, OutTemporal.HistoryColorSRVs, OutTemporal.HistoryColorUAVs);
+
+	OutTemporal.MinBlendFactor = 0.1f;
+	OutTemporal.DisocclusionTolerance = 0.02f;
+}
+
+static void DestroyTemporalAccumulation(FTemporalAccumulation& Temporal)
+{
+	SAFE_RELEASE(Temporal.Pipeline);
+	SAFE_RELEASE(Temporal.Signature);
+	for (uint32_t Idx = 0; Idx < 2; ++Idx)
+	{
+		SAFE_RELEASE(Temporal.HistoryColors[Idx]);
+	}
+	Temporal = {};
+}
+
+static float GetHaltonSequence(uint32_t Index, uint32_t Base)
+{
+	float Result = 0.0f;
+	float Fraction = 1.0f;
+	for (; Index > 0; Index /= Base)
+	{
+		Fraction /= Base;
+		Result += Fraction * (Index % Base);
+	}
+	return Result;
+}
+
+// Sub-pixel offset of the camera rays in [-0.5, 0.5) pixels.
+static XMFLOAT2 GetTemporalJitter(const FTemporalAccumulation& Temporal)
+{
+	if (!Temporal.bIsEnabled)
+	{
+		return XMFLOAT2(0.0f, 0.0f);
+	}
+	const uint32_t Phase = Temporal.JitterPhase % kNumJitterPhases + 1;
+	return XMFLOAT2(GetHaltonSequence(Phase, 2) - 0.5f, GetHaltonSequence(Phase, 3) - 0.5f);
+}
+
+// Runs a full screen pass over the traced rectangle that reads the previous frame's HistoryColors and hit positions
+// and writes RTOutput, this frame's hit positions and HistoryColors. Textures are left in UNORDERED_ACCESS state.
+static void DispatchHistoryPass(FDemoRoot& Root, const char* ScopeName, ID3D12PipelineState* Pipeline, ID3D12RootSignature* Signature, ID3D12Resource* const (&HistoryColors)[2], const D3D12_CPU_DESCRIPTOR_HANDLE (&HistoryColorSRVs)[2], const D3D12_CPU_DESCRIPTOR_HANDLE (&HistoryColorUAVs)[2], D3D12_GPU_VIRTUAL_ADDRESS PerFrameCB)
+{
+	FGraphicsContext& Gfx = Root.Gfx;
+	const FTraceHistory& History = Root.TraceHistory;
+	ID3D12GraphicsCommandList5* CmdList = Gfx.CmdList;
+	const uint32_t Current = History.Index;
+	const uint32_t Previous = History.Index ^ 1;
+
+	{
+		const CD3DX12_RESOURCE_BARRIER Barriers[] =
+		{
+			CD3DX12_RESOURCE_BARRIER::UAV(Root.RTOutput),
+			CD3DX12_RESOURCE_BARRIER::UAV(History.HitPositions[Current]),
+			CD3DX12_RESOURCE_BARRIER::Transition(HistoryColors[Previous], D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE),
+			CD3DX12_RESOURCE_BARRIER::Transition(History.HitPositions[Previous], D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE),
+		};
+		CmdList->ResourceBarrier((uint32_t)eastl::size(Barriers), Barriers);
+	}
+
+	const uint32_t Scope = BeginGPUScope(Gfx, ScopeName);
+	CmdList->SetPipelineState(Pipeline);
+	CmdList->SetComputeRootSignature(Signature);
+	CmdList->SetComputeRootConstantBufferView(0, PerFrameCB);
+	{
+		const D3D12_GPU_DESCRIPTOR_HANDLE TableBase = CopyDescriptorsToGPUHeap(Gfx, 1, HistoryColorSRVs[Previous]);
+		CopyDescriptorsToGPUHeap(Gfx, 1, History.HitPositionSRVs[Previous]);
+		CopyDescriptorsToGPUHeap(Gfx, 1, Root.RTOutputUAV);
+		CopyDescriptorsToGPUHeap(Gfx, 1, History.HitPositionUAVs[Current]);
+		CopyDescriptorsToGPUHeap(Gfx, 1, HistoryColorUAVs[Current]);
+		CmdList->SetComputeRootDescriptorTable(1, TableBase);
+	}
+	const uint32_t* TraceResolution = Root.DynamicResolution.TraceResolution;
+	CmdList->Dispatch((TraceResolution[0] + 7) / 8, (TraceResolution[1] + 7) / 8, 1);
+	EndGPUScope(Gfx, Scope);
+
+	{
+		const CD3DX12_RESOURCE_BARRIER Barriers[] =
+		{
+			CD3DX12_RESOURCE_BARRIER::Transition(HistoryColors[Previous], D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS),
+			CD3DX12_RESOURCE_BARRIER::Transition(History.HitPositions[Previous], D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS),
+		};
+		CmdList->ResourceBarrier((uint32_t)eastl::size(Barriers), Barriers);
+	}
+}
+
+// Fills the pixels that were not traced this frame, also writes their hit positions.
+static void ReconstructRTOutput(FDemoRoot& Root, D3D12_GPU_VIRTUAL_ADDRESS PerFrameCB)
+{
+	const FInterleavedTrace& Interleaved = Root.Interleaved;
+	DispatchHistoryPass(Root, "Reconstruct", Interleaved.Pipeline, Interleaved.Signature, Interleaved.Colors, Interleaved.ColorSRVs, Interleaved.ColorUAVs, PerFrameCB);
+}
+
+// Denoises the traced rectangle of RTOutput in place. Iteration I of the a-trous filter reads Filtered[I & 1] and
+// writes Filtered[(I + 1) & 1], the last one writes RTOutput. Textures are left in UNORDERED_ACCESS state.
+static void DenoiseRTOutput(FDemoRoot& Root, D3D12_GPU_VIRTUAL_ADDRESS PerFrameCB)
+{
+	FGraphicsContext& Gfx = Root.Gfx;
+	const FTraceHistory& History = Root.TraceHistory;
+	const FDenoiser& Denoiser = Root.Denoiser;
+	ID3D12GraphicsCommandList5* CmdList = Gfx.CmdList;
+	const uint32_t Current = History.Index;
+	const uint32_t Previous = History.Index ^ 1;
+	const uint32_t* TraceResolution = Root.DynamicResolution.TraceResolution;
+
+	{
+		const CD3DX12_RESOURCE_BARRIER Barriers[] =
+		{
+			CD3DX12_RESOURCE_BARRIER::UAV(Root.RTOutput),
+			CD3DX12_RESOURCE_BARRIER::UAV(History.HitPositions[Current]),
+			CD3DX12_RESOURCE_BARRIER::Transition(Denoiser.HistoryColors[Previous], D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE),
+			CD3DX12_RESOURCE_BARRIER::Transition(Denoiser.HistoryMoments[Previous], D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE),
+			CD3DX12_RESOURCE_BARRIER::Transition(History.HitPositions[Previous], D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE),
+		};
+		CmdList->ResourceBarrier((uint32_t)eastl::size(Barriers), Barriers);
+	}
+
+	const uint32_t Scope = BeginGPUScope(Gfx, "Denoise");
+	CmdList->SetPipelineState(Denoiser.TemporalPipeline);
+	CmdList->SetComputeRootSignature(Denoiser.TemporalSignature);
+	CmdList->SetComputeRootConstantBufferView(0, PerFrameCB);
+	{
+		const D3D12_GPU_DESCRIPTOR_HANDLE TableBase = CopyDescriptorsToGPUHeap(Gfx, 1, Denoiser.HistoryColorSRVs[Previous]);
+		CopyDescriptorsToGPUHeap(Gfx, 1, Denoiser.HistoryMomentSRVs[Previous]);
+		CopyDescriptorsToGPUHeap(Gfx, 1, History.HitPositionSRVs[Previous]);
+		CopyDescriptorsToGPUHeap(Gfx, 1, Root.RTOutputUAV);
+		CopyDescriptorsToGPUHeap(Gfx, 1, History.HitPositionUAVs[Current]);
+		CopyDescriptorsToGPUHeap(Gfx, 1, Denoiser.NormalsUAV);
+		CopyDescriptorsToGPUHeap(Gfx, 1, Denoiser.HistoryMomentUAVs[Current]);
+		CopyDescriptorsToGPUHeap(Gfx, 1, Denoiser.FilteredUAVs[0]);
+		CmdList->SetComputeRootDescriptorTable(1, TableBase);
+	}
+	CmdList->Dispatch((TraceResolution[0] + 7) / 8, (TraceResolution[1] + 7) / 8, 1);
+
+	{
+		const CD3DX12_RESOURCE_BARRIER Barriers[] =
+		{
+			CD3DX12_RESOURCE_BARRIER::Transition(Denoiser.HistoryColors[Previous], D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS),
+			CD3DX12_RESOURCE_BARRIER::Transition(Denoiser.HistoryMoments[Previous], D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS),
+			CD3DX12_RESOURCE_BARRIER::Transition(History.HitPositions[Previous], D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS),
+			CD3DX12_RESOURCE_BARRIER::UAV(Denoiser.Normals),
+			CD3DX12_RESOURCE_BARRIER::UAV(Denoiser.Filtered[0]),
+		};
+		CmdList->ResourceBarrier((uint32_t)eastl::size(Barriers), Barriers);
+	}
+
+	CmdList->SetPipelineState(Denoiser.FilterPipeline);
+	CmdList->SetComputeRootSignature(Denoiser.FilterSignature);
+	CmdList->SetComputeRootConstantBufferView(0, PerFrameCB);
+	for (uint32_t Iteration = 0; Iteration < Denoiser.NumIterations; ++Iteration)
+	{
+		const bool bIsLastIteration = Iteration + 1 == Denoiser.NumIterations;
+		ID3D12Resource* Output = bIsLastIteration ? Root.RTOutput : Denoiser.Filtered[(Iteration + 1) & 1];
+
+		FDenoiseConstants Constants;
+		Constants.StepSize = 1u << Iteration;
+		Constants.WritesHistory = Iteration == 0 ? 1 : 0;
+		Constants.IsLastIteration = bIsLastIteration ? 1 : 0;
+		Constants.LuminancePhi = Denoiser.LuminancePhi;
+		Constants.NormalPhi = Denoiser.NormalPhi;
+		Constants.DepthPhi = Denoiser.DepthPhi;
+		CmdList->SetComputeRoot32BitConstants(1, sizeof(Constants) / sizeof(uint32_t), &Constants, 0);
+		{
+			const D3D12_GPU_DESCRIPTOR_HANDLE TableBase = CopyDescriptorsToGPUHeap(Gfx, 1, Denoiser.FilteredUAVs[Iteration & 1]);
+			CopyDescriptorsToGPUHeap(Gfx, 1, bIsLastIteration ? Root.RTOutputUAV : Denoiser.FilteredUAVs[(Iteration + 1) & 1]);
+			CopyDescriptorsToGPUHeap(Gfx, 1, History.HitPositionUAVs[Current]);
+			CopyDescriptorsToGPUHeap(Gfx, 1, Denoiser.NormalsUAV);
+			CopyDescriptorsToGPUHeap(Gfx, 1, Denoiser.HistoryColorUAVs[Current]);
+			CmdList->SetComputeRootDescriptorTable(2, TableBase);
+		}
+		CmdList->Dispatch((TraceResolution[0] + 7) / 8, (TraceResolution[1] + 7) / 8, 1);
+		CmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::UAV(Output));
+	}
+	EndGPUScope(Gfx, Scope);
+}
+
+// Blends the traced rectangle of RTOutput with the reprojected history, RTOutput gets the result.
+static void AccumulateRTOutput(FDemoRoot& Root, D3D12_GPU_VIRTUAL_ADDRESS PerFrameCB)
+{
+	const FTemporalAccumulation& Temporal = Root.Temporal;
+	DispatchHistoryPass(Root, "Temporal", Temporal.Pipeline, Temporal.Signature, Temporal.HistoryColors, Temporal.HistoryColorSRVs, Temporal.HistoryColorUAVs, PerFrameCB);
+}
+
+static void SetOrbitCamera(FDemoRoot& Root, float Angle)
+{
+	XMVECTOR Position = XMVectorSet(2.5f * cosf(Angle), 2.0f, 2.5f * sinf(Angle), 1.0f);
+	XMStoreFloat3(&Root.CameraPosition, Position);
+}
+
+static void CreateTextureReadback(FGraphicsContext& Gfx, ID3D12Resource* Texture, FTextureReadback& OutReadback)
+{
+	const D3D12_RESOURCE_DESC Desc = Texture->GetDesc();
+	uint64_t Size;
+	Gfx.Device->GetCopyableFootprints(&Desc, 0, 1, 0, &OutReadback.Footprint, nullptr, nullptr, &Size);
+	OutReadback.Buffer = CreateGPUResource(Gfx, GPUMemory_Readback, D3D12_HEAP_TYPE_READBACK, CD3DX12_RESOURCE_DESC::Buffer(Size), D3D12_RESOURCE_STATE_COPY_DEST);
+	OutReadback.Format = Desc.Format;
+}
+
+static void DestroyTextureReadback(FTextureReadback& Readback)
+{
+	SAFE_RELEASE(Readback.Buffer);
+}
+
+// Texture is in UNORDERED_ACCESS state before and after the copy.
+static void CopyToTextureReadback(ID3D12GraphicsCommandList5* CmdList, ID3D12Resource* Texture, const FTextureReadback& Readback)
+{
+	CmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(Texture, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_COPY_SOURCE));
+	CmdList->CopyTextureRegion(&CD3DX12_TEXTURE_COPY_LOCATION(Readback.Buffer, Readback.Footprint), 0, 0, 0, &CD3DX12_TEXTURE_COPY_LOCATION(Texture, 0), nullptr);
+	CmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(Texture, D3D12_RESOURCE_STATE_COPY_SOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS));
+}
+
+// Converts the top-left Width x Height texels of the copy, the GPU has to be done with it.
+static void ReadTextureReadback(const FTextureReadback& Readback, uint32_t Width, uint32_t Height, FImage& OutImage)
+{
+	const D3D12_SUBRESOURCE_FOOTPRINT& Footprint = Readback.Footprint.Footprint;
+	EA_ASSERT(Width <= Footprint.Width && Height <= Footprint.Height);
+	const uint8_t* Data;
+	VHR(Readback.Buffer->Map(0, &CD3DX12_RANGE(0, (SIZE_T)(Readback.Footprint.Offset + (uint64_t)Height * Footprint.RowPitch)), (void**)&Data));
+	InitImage(Width, Height, OutImage);
+	for (uint32_t Y = 0; Y < Height; ++Y)
+	{
+		const uint8_t* Row = Data + Readback.Footprint.Offset + (uint64_t)Y * Footprint.RowPitch;
+		XMFLOAT4* Texels = &OutImage.Texels[(size_t)Y * OutImage.Width];
+		for (uint32_t X = 0; X < Width; ++X)
+		{
+			switch (Readback.Format)
+			{
+			case DXGI_FORMAT_R8G8B8A8_UNORM:
+				XMStoreFloat4(&Texels[X], DirectX::PackedVector::XMLoadUByteN4((const DirectX::PackedVector::XMUBYTEN4*)Row + X));
+				break;
+			case DXGI_FORMAT_R16G16B16A16_FLOAT:
+				XMStoreFloat4(&Texels[X], DirectX::PackedVector::XMLoadHalf4((const DirectX::PackedVector::XMHALF4*)Row + X));
+				break;
+			case DXGI_FORMAT_R32G32B32A32_FLOAT:
+				Texels[X] = ((const XMFLOAT4*)Row)[X];
+				break;
+			default:
+				EA_ASSERT_MSG(0, "Unsupported readback format.");
+			}
+		}
+	}
+	Readback.Buffer->Unmap(0, &CD3DX12_RANGE(0, 0));
+}
+
+// Copies Texture (in UNORDERED_ACCESS state) to the CPU. Waits for the GPU twice, for use outside of the frame only.
+static void ReadbackTexture(FGraphicsContext& Gfx, ID3D12Resource* Texture, FImage& OutImage)
+{
+	FTextureReadback Readback;
+	CreateTextureReadback(Gfx, Texture, Readback);
+	WaitForGPU(Gfx);
+	CopyToTextureReadback(GetAndInitCommandList(Gfx), Texture, Readback);
+	ExecuteCommandList(Gfx);
+	WaitForGPU(Gfx);
+	ReadTextureReadback(Readback, Readback.Footprint.Footprint.Width, Readback.Footprint.Footprint.Height, OutImage);
+	DestroyTextureReadback(Readback);
+}
+
+static void CreateGBufferCapture(FGraphicsContext& Gfx, ID3D12Resource* RTOutput, const FTraceHistory& History, FGBufferCapture& OutCapture)
+{
+	if (OutCapture.FileName[0])
+	{
+		CreateTextureReadback(Gfx, RTOutput, OutCapture.Color);
+		CreateTextureReadback(Gfx, History.HitPositions[0], OutCapture.HitPosition);
+	}
+}
+
+static void DestroyGBufferCapture(FGBufferCapture& Capture)
+{
+	DestroyTextureReadback(Capture.Color);
+	DestroyTextureReadback(Capture.HitPosition);
+}
+
+// Records the copies into the frame after the trace and reconstruction, before the denoiser runs.
+static void RecordGBufferCapture(FDemoRoot& Root, ID3D12GraphicsCommandList5* CmdList, FXMMATRIX WorldToProjection)
+{
+	FGBufferCapture& Capture = Root.GBufferCapture;
+	const FTraceHistory& History = Root.TraceHistory;
+	CopyToTextureReadback(CmdList, Root.RTOutput, Capture.Color);
+	CopyToTextureReadback(CmdList, History.HitPositions[History.Index], Capture.HitPosition);
+	Capture.TraceResolution[0] = Root.DynamicResolution.TraceResolution[0];
+	Capture.TraceResolution[1] = Root.DynamicResolution.TraceResolution[1];
+	XMStoreFloat4x4(&Capture.WorldToProjection, WorldToProjection);
+	Capture.CameraPosition = XMFLOAT4(Root.CameraPosition.x, Root.CameraPosition.y, Root.CameraPosition.z, 1.0f);
+	Capture.bIsRecorded = true;
+}
+
+// Waits for the frame that recorded the copies.
+static bool WriteGBufferCapture(FDemoRoot& Root)
+{
+	const FGBufferCapture& Capture = Root.GBufferCapture;
+	WaitForGPU(Root.Gfx);
+	FGBufferDump Dump;
+	Dump.WorldToProjection = Capture.WorldToProjection;
+	Dump.CameraPosition = Capture.CameraPosition;
+	ReadTextureReadback(Capture.Color, Capture.TraceResolution[0], Capture.TraceResolution[1], Dump.Color);
+	ReadTextureReadback(Capture.HitPosition, Capture.TraceResolution[0], Capture.TraceResolution[1], Dump.HitPosition);
+	return WriteGBufferDump(Capture.FileName, Dump);
+}
+
+// Runs the CPU version of Upscale.hlsl (Reference.h) on the RTOutput of the last frame and compares it with the
+// UpscaleOutput of that frame.
+static void CheckUpscaleOutput(FDemoRoot& Root)
+{
+	FBenchmarkMode& Mode = Root.BenchmarkMode;
+	const FDynamicResolution& Res = Root.DynamicResolution;
+	FImage Input, GPUOutput, CPUOutput;
+	ReadbackTexture(Root.Gfx, Root.RTOutput, Input);
+	ReadbackTexture(Root.Gfx, Res.UpscaleOutput, GPUOutput);
+	InitImage(GPUOutput.Width, GPUOutput.Height, CPUOutput);
+	UpscaleImage(Input, Res.TraceResolution[0], Res.TraceResolution[1], Res.UpscaleFilter, Res.Sharpness, CPUOutput);
+
+	Mode.bHasUpscaleCheck = true;
+	Mode.UpscaleCheckPSNR = GetImagePSNR(GPUOutput, CPUOutput);
+	Mode.UpscaleCheckMaxError = GetImageMaxError(GPUOutput, CPUOutput);
+}
+
+// Report for automated comparison against a stored baseline (Tools/CompareBenchmark.py). Rays are primary rays, one
+// per traced pixel: the trace resolution divided by the interleave.
+static bool WriteBenchmarkReport(FDemoRoot& Root, const char* FileName)
+{
+	FILE* File = fopen(FileName, "w");
+	if (!File)
+	{
+		return false;
+	}
+
+	const FGraphicsContext& Gfx = Root.Gfx;
+	const FBenchmarkMode& Mode = Root.BenchmarkMode;
+
+	FFrameStatsSummary Summary;
+	GetFrameStatsSummary(Gfx.FrameStats, Summary);
+	FMemoryUsage Memory;
+	GetMemoryUsage(Gfx, Memory);
+
+	const FDynamicResolution& Res = Root.DynamicResolution;
+	const double TraceMs = Mode.NumTraceSamples ? Mode.TraceMs / Mode.NumTraceSamples : 0.0;
+	const double UpscaleMs = Mode.NumTraceSamples ? Mode.UpscaleMs / Mode.NumTraceSamples : 0.0;
+	const double TemporalMs = Mode.NumTraceSamples ? Mode.TemporalMs / Mode.NumTraceSamples : 0.0;
+	const double ReconstructMs = Mode.NumTraceSamples ? Mode.ReconstructMs / Mode.NumTraceSamples : 0.0;
+	const double DenoiseMs = Mode.NumTraceSamples ? Mode.DenoiseMs / Mode.NumTraceSamples : 0.0;
+	const uint32_t Interleave = kInterleaveModes[Root.Interleaved.Mode];
+	const double RaysPerFrame = (double)Res.TraceResolution[0] * Res.TraceResolution[1] / Interleave;
+
+	fprintf(File, "{\n");
+	fprintf(File, "\t\"resolution\": [%u, %u],\n", Gfx.Resolution[0], Gfx.Resolution[1]);
+	fprintf(File, "\t\"traceResolution\": [%u, %u],\n", Res.TraceResolution[0], Res.TraceResolution[1]);
+	fprintf(File, "\t\"upscaleFilter\": \"%s\",\n", IsUpscaling(Gfx, Res) ? kUpscaleFilterNames[Res.UpscaleFilter] : "None");
+	fprintf(File, "\t\"traceInterleave\": %u,\n", Interleave);
+	fprintf(File, "\t\"denoiseIterations\": %u,\n", Root.Denoiser.bIsEnabled ? Root.Denoiser.NumIterations : 0);
+	fprintf(File, "\t\"temporal\": %s,\n", Root.Temporal.bIsEnabled ? "true" : "false");
+	fprintf(File, "\t\"tracePath\": \"%s\",\n", kTracePathNames[Root.TracePath]);
+	fprintf(File, "\t\"permutation\": %u,\n", Root.RTPermutation);
+	fprintf(File, "\t\"warmupFrames\": %u,\n", kBenchmarkModeWarmupFrames);
+	fprintf(File, "\t\"frames\": %u,\n", Summary.NumFrames);
+	fprintf(File, "\t\"timeStep\": %.6f,\n", kBenchmarkModeTimeStep);
+	fprintf(File, "\t\"frameTime\": {\n");
+	for (uint32_t Metric = 0; Metric < FrameMetric_Count; ++Metric)
+	{
+		const FFrameMetricSummary& Metrics = Summary.Metrics[Metric];
+		fprintf(File, "\t\t\"%s\": { \"avg\": %.4f, \"p50\": %.4f, \"p95\": %.4f, \"p99\": %.4f, \"max\": %.4f }%s\n", kFrameMetricNames[Metric], Metrics.AvgMs, Metrics.P50Ms, Metrics.P95Ms, Metrics.P99Ms, Metrics.MaxMs, Metric + 1 < FrameMetric_Count ? "," : "");
+	}
+	fprintf(File, "\t},\n");
+	fprintf(File, "\t\"hitches\": %u,\n", Summary.NumHitches);
+	fprintf(File, "\t\"trace\": { \"avgMs\": %.4f, \"raysPerFrame\": %.0f, \"raysPerSecond\": %.0f },\n", TraceMs, RaysPerFrame, TraceMs > 0.0 ? RaysPerFrame * 1000.0 / TraceMs : 0.0);
+	fprintf(File, "\t\"upscale\": { \"factor\": %.2f, \"sharpness\": %.2f, \"avgMs\": %.4f },\n", kUpscaleFactors[Res.UpscaleFactor], Res.Sharpness, UpscaleMs);
+	if (Mode.bHasUpscaleCheck)
+	{
+		fprintf(File, "\t\"upscaleCheck\": { \"psnr\": %.2f, \"maxError\": %.5f, \"passed\": %s },\n", Mode.UpscaleCheckPSNR, Mode.UpscaleCheckMaxError, Mode.UpscaleCheckMaxError <= kUpscaleCheckMaxError ? "true" : "false");
+	}
+	else
+	{
+		fprintf(File, "\t\"upscaleCheck\": null,\n");
+	}
+	fprintf(File, "\t\"reconstructPass\": { \"avgMs\": %.4f },\n", ReconstructMs);
+	fprintf(File, "\t\"denoisePass\": { \"avgMs\": %.4f },\n", DenoiseMs);
+	fprintf(File, "\t\"temporalPass\": { \"avgMs\": %.4f },\n", TemporalMs);
+	fprintf(File, "\t\"memory\": { \"workingSet\": %llu, \"peakWorkingSet\": %llu, \"private\": %llu, \"gpuLocal\": %llu, \"gpuNonLocal\": %llu },\n", (unsigned long long)Memory.WorkingSetBytes, (unsigned long long)Memory.PeakWorkingSetBytes, (unsigned long long)Memory.PrivateBytes, (unsigned long long)Memory.GPULocalBytes, (unsigned long long)Memory.GPUNonLocalBytes);
+	DXGI_QUERY_VIDEO_MEMORY_INFO LocalBudget, NonLocalBudget;
+	GetGPUMemoryBudget(Gfx, LocalBudget, NonLocalBudget);
+	fprintf(File, "\t\"gpuMemory\": {\n\t\t\"localBudget\": %llu,\n\t\t\"nonLocalBudget\": %llu,\n\t\t\"tracked\": %llu,\n\t\t\"trackedPeak\": %llu,\n", (unsigned long long)LocalBudget.Budget, (unsigned long long)NonLocalBudget.Budget, (unsigned long long)Gfx.GPUMemory.Bytes, (unsigned long long)Gfx.GPUMemory.HighWaterBytes);
+	for (uint32_t Category = 0; Category < GPUMemory_Count; ++Category)
+	{
+		const FGPUMemoryCategoryStats& Stats = Gfx.GPUMemory.Categories[Category];
+		fprintf(File, "\t\t\"%s\": { \"bytes\": %llu, \"peak\": %llu, \"resources\": %u, \"created\": %u }%s\n", kGPUMemoryCategoryNames[Category], (unsigned long long)Stats.Bytes, (unsigned long long)Stats.HighWaterBytes, Stats.NumResources, Stats.NumCreated, Category + 1 < GPUMemory_Count ? "," : "");
+	}
+	fprintf(File, "\t},\n");
+	const FRayCounters& Counters = Root.RayCounters;
+	fprintf(File, "\t\"rayCounters\": %s", Counters.NumFrames ? "{\n" : "null,\n");
+	if (Counters.NumFrames)
+	{
+		fprintf(File, "\t\t\"frames\": %u,\n", Counters.NumFrames);
+		uint64_t NumRays = 0;
+		for (uint32_t RayType = 0; RayType < kNumRayTypes; ++RayType)
+		{
+			const uint64_t* Counts = &Counters.TotalCounts[RayType * RAY_COUNTER_COUNT];
+			fprintf(File, "\t\t\"%s\": { \"raysPerFrame\": %.1f, \"hitsPerFrame\": %.1f, \"missesPerFrame\": %.1f },\n", kRayTypeNames[RayType], (double)Counts[RAY_COUNTER_RAYS] / Counters.NumFrames, (double)Counts[RAY_COUNTER_HITS] / Counters.NumFrames, (double)Counts[RAY_COUNTER_MISSES] / Counters.NumFrames);
+			NumRays += Counts[RAY_COUNTER_RAYS];
+		}
+		fprintf(File, "\t\t\"raysPerSecond\": %.0f\n\t},\n", Counters.TotalTraceMs > 0.0 ? NumRays * 1000.0 / Counters.TotalTraceMs : 0.0);
+	}
+	fprintf(File, "\t\"allocationsPerFrame\": %.2f,\n", (double)(GetNumAllocations() - Mode.FirstNumAllocations) / kBenchmarkModeFrames);
+	fprintf(File, "\t\"maxFrameAllocations\": %u,\n", Mode.MaxFrameAllocations);
+	fprintf(File, "\t\"allocatingFrames\": %u,\n", Mode.NumAllocatingFrames);
+	float TaggedNs, UntaggedNs;
+	MeasureAllocationTrackingOverhead(TaggedNs, UntaggedNs);
+	fprintf(File, "\t\"allocationTracking\": { \"enabled\": %s, \"nsPerAllocation\": %.1f, \"untrackedNsPerAllocation\": %.1f },\n", IsAllocationTrackingEnabled() ? "true" : "false", TaggedNs, UntaggedNs);
+	FAllocatorStats AllocatorStats;
+	GetAllocatorStats(AllocatorStats);
+	fprintf(File, "\t\"allocator\": { \"committed\": %llu, \"largeAllocations\": %llu, \"batchTransfers\": %llu },\n", (unsigned long long)AllocatorStats.CommittedBytes, (unsigned long long)AllocatorStats.NumLargeAllocations, (unsigned long long)AllocatorStats.NumBatchTransfers);
+	FFrameArenaStats Arena;
+	GetFrameArenaStats(Arena);
+	fprintf(File, "\t\"frameArena\": { \"lastFrameBytes\": %llu, \"capacity\": %llu, \"blocks\": %u, \"overflows\": %llu },\n", (unsigned long long)Arena.LastFrameBytes, (unsigned long long)Arena.CapacityBytes, Arena.NumBlocks, (unsigned long long)Arena.NumOverflows);
+	fprintf(File, "\t\"nullCommandList\": %s", Gfx.bHasNullCommandList ? "{\n" : "null\n");
+	if (Gfx.bHasNullCommandList)
+	{
+		FNullCommandStats Stats;
+		GetNullCommandStats(Gfx.CmdList, Stats);
+
+		uint64_t NumCalls = 0;
+		for (uint32_t Command = 0; Command < NullCommand_Count; ++Command)
+		{
+			Stats.NumCalls[Command] -= Mode.FirstNullCommandStats.NumCalls[Command];
+			NumCalls += Stats.NumCalls[Command];
+		}
+		fprintf(File, "\t\t\"callsPerFrame\": %.2f,\n", (double)NumCalls / kBenchmarkModeFrames);
+		fprintf(File, "\t\t\"streamBytesPerFrame\": %.2f,\n", (double)(Stats.NumStreamWords - Mode.FirstNullCommandStats.NumStreamWords) * sizeof(uint32_t) / kBenchmarkModeFrames);
+		fprintf(File, "\t\t\"calls\": {");
+		const char* Separator = "\n";
+		for (uint32_t Command = 0; Command < NullCommand_Count; ++Command)
+		{
+			if (Stats.NumCalls[Command] > 0)
+			{
+				fprintf(File, "%s\t\t\t\"%s\": %.2f", Separator, GetNullCommandName(Command), (double)Stats.NumCalls[Command] / kBenchmarkModeFrames);
+				Separator = ",\n";
+			}
+		}
+		fprintf(File, "\n\t\t}\n\t}\n");
+	}
+	fprintf(File, "}\n");
+	fclose(File);
+	return true;
+}
+
+// Frame F records timings of frame F - 1 (UpdateFrameStats), so stats are reset on the first measured frame and the
+// report is written one frame after the last one. GPU timings arrive two frames late, the workload does not change
+// between frames so this only shifts the window.
+static void UpdateBenchmarkMode(FDemoRoot& Root)
+{
+	FBenchmarkMode& Mode = Root.BenchmarkMode;
+
+	if (Mode.Frame == kBenchmarkModeWarmupFrames)
+	{
+		Root.Gfx.FrameStats.NumFrames = 0;
+		ResetRayCounterTotals(Root.RayCounters);
+		Mode.FirstNumAllocations = GetNumAllocations();
+		if (Root.Gfx.bHasNullCommandList)
+		{
+			GetNullCommandStats(Root.Gfx.CmdList, Mode.FirstNullCommandStats);
+		}
+	}
+	else if (Mode.Frame > kBenchmarkModeWarmupFrames)
+	{
+		const uint32_t NumAllocations = Root.Gfx.FrameStats.LastFrameAllocations;
+		Mode.MaxFrameAllocations = eastl::max(Mode.MaxFrameAllocations, NumAllocations);
+		Mode.NumAllocatingFrames += NumAllocations > 0 ? 1 : 0;
+
+		if (const FGPUScopeStats* Stats = FindGPUScopeStats(Root.Gfx.GPUProfiler, "Trace"))
+		{
+			Mode.TraceMs += Stats->LastMs;
+			Mode.NumTraceSamples += 1;
+		}
+		if (const FGPUScopeStats* Stats = FindGPUScopeStats(Root.Gfx.GPUProfiler, "Upscale"))
+		{
+			Mode.UpscaleMs += Stats->LastMs;
+		}
+		if (const FGPUScopeStats* Stats = FindGPUScopeStats(Root.Gfx.GPUProfiler, "Reconstruct"))
+		{
+			Mode.ReconstructMs += Stats->LastMs;
+		}
+		if (const FGPUScopeStats* Stats = FindGPUScopeStats(Root.Gfx.GPUProfiler, "Denoise"))
+		{
+			Mode.DenoiseMs += Stats->LastMs;
+		}
+		if (const FGPUScopeStats* Stats = FindGPUScopeStats(Root.Gfx.GPUProfiler, "Temporal"))
+		{
+			Mode.TemporalMs += Stats->LastMs;
+		}
+	}
+
+	if (Mode.Frame == kBenchmarkModeWarmupFrames + kBenchmarkModeFrames)
+	{
+		if (Root.GBufferCapture.bIsRecorded && !WriteGBufferCapture(Root))
+		{
+			EA_ASSERT_MSG(0, "Cannot write the G-buffer dump.");
+		}
+		if (!Mode.bUsesNullCommandList && IsUpscaling(Root.Gfx, Root.DynamicResolution))
+		{
+			CheckUpscaleOutput(Root);
+		}
+		if (!WriteBenchmarkReport(Root, Mode.ReportFileName))
+		{
+			EA_ASSERT(0);
+		}
+
+		// Allocating in steady state is a failure of the run, the exit code tells scripts about it.
+		if (Mode.NumAllocatingFrames > 0)
+		{
+			char Text[160];
+			EA::StdC::Snprintf(Text, sizeof(Text), "Benchmark: %u of %u measured frames allocated (at most %u allocations).\n", Mode.NumAllocatingFrames, kBenchmarkModeFrames, Mode.MaxFrameAllocations);
+			OutputDebugString(Text);
+		}
+		const bool bHasUpscaleMismatch = Mode.bHasUpscaleCheck && Mode.UpscaleCheckMaxError > kUpscaleCheckMaxError;
+		if (bHasUpscaleMismatch)
+		{
+			char Text[160];
+			EA::StdC::Snprintf(Text, sizeof(Text), "Benchmark: upscaled output differs from the CPU version by up to %.4f (%.2f dB).\n", Mode.UpscaleCheckMaxError, Mode.UpscaleCheckPSNR);
+			OutputDebugString(Text);
+		}
+		PostQuitMessage(Mode.NumAllocatingFrames > 0 || bHasUpscaleMismatch ? 1 : 0);
+	}
+
+	const uint32_t PathFrame = Mode.Frame > kBenchmarkModeWarmupFrames ? Mode.Frame - kBenchmarkModeWarmupFrames : 0;
+	SetOrbitCamera(Root, XMScalarModAngle(0.25f * (float)(PathFrame * kBenchmarkModeTimeStep)));
+	++Mode.Frame;
+}
+
+static void Update(FDemoRoot& Root)
+{
+	CPU_ZONE("Update");
+	double Time;
+	float DeltaTime;
+	UpdateFrameStats(Root.Gfx, "DXRTest", Time, DeltaTime);
+
+	if (Root.BenchmarkMode.bIsEnabled)
+	{
+		UpdateBenchmarkMode(Root);
+		if (Root.BenchmarkMode.bUsesNullCommandList)
+		{
+			UpdateUI(DeltaTime);
+			ImGui::ShowDemoWindow();
+			ShowFrameStatsWindow(Root.Gfx.FrameStats, "FrameStats.json");
+		}
+		return;
+	}
+
+	UpdateUI(DeltaTime);
+
+	// Benchmark drives the camera by frame number so both paths see exactly the same views.
+	FTraceBenchmark& Benchmark = Root.Benchmark;
+	float BenchmarkAngle = -1.0f;
+	if (Benchmark.bIsRunning)
+	{
+		const uint32_t NumPassFrames = kBenchmarkWarmupFrames + kBenchmarkFrames;
+		Benchmark.SamplePath = -1;
+		if (Benchmark.Frame < TracePath_Count * NumPassFrames)
+		{
+			const uint32_t PassFrame = Benchmark.Frame % NumPassFrames;
+			Root.TracePath = Benchmark.Frame / NumPassFrames;
+			if (PassFrame >= kBenchmarkWarmupFrames)
+			{
+				Benchmark.SamplePath = (int32_t)Root.TracePath;
+			}
+			BenchmarkAngle = XM_2PI * (PassFrame < kBenchmarkWarmupFrames ? 0 : PassFrame - kBenchmarkWarmupFrames) / kBenchmarkFrames;
+			++Benchmark.Frame;
+		}
+		else if (Benchmark.NumSamples[TracePath_Pipeline] == kBenchmarkFrames && Benchmark.NumSamples[TracePath_RayQuery] == kBenchmarkFrames)
+		{
+			for (uint32_t Idx = 0; Idx < TracePath_Count; ++Idx)
+			{
+				Benchmark.ResultMs[Idx] = (float)(Benchmark.TotalMs[Idx] / Benchmark.NumSamples[Idx]);
+			}
+			Benchmark.bIsRunning = false;
+			Root.TracePath = Benchmark.SavedTracePath;
+
+			char Text[256];
+			EA::StdC::Snprintf(Text, sizeof(Text), "Trace benchmark (%ux%u, permutation %u, %u frames): %s %.3f ms, %s %.3f ms\n", Root.Gfx.Resolution[0], Root.Gfx.Resolution[1], Root.RTPermutation, kBenchmarkFrames, kTracePathNames[TracePath_Pipeline], Benchmark.ResultMs[TracePath_Pipeline], kTracePathNames[TracePath_RayQuery], Benchmark.ResultMs[TracePath_RayQuery]);
+			OutputDebugString(Text);
+		}
+	}
+
+	SetOrbitCamera(Root, BenchmarkAngle >= 0.0f ? BenchmarkAngle : XMScalarModAngle(0.25f * (float)Time));
+
+	ImGui::ShowDemoWindow();
+
+	// Switching permutation only rewrites shader identifiers in the shader table. Records are added in the same order
+	// so hit group indices stored in the TLAS stay valid.
+	if (ImGui::Begin("Ray tracing"))
+	{
+		ImGui::Checkbox("Lambert shading", &Root.RTSettings.bLambertShading);
+		ImGui::Checkbox("Cull back faces", &Root.RTSettings.bCullBackFaces);
+		ImGui::Checkbox("Float payload", &Root.RTSettings.bNeedsFloatPayload);
+
+		const uint32_t Permutation = SelectRTPermutation(Root.RTSettings);
+		if (Permutation != Root.RTPermutation)
+		{
+			Root.RTPermutation = Permutation;
+			eastl::vector<uint32_t, FFrameAllocator> HitGroupIndices;
+			WriteRTShaderRecords(Root, Root.RTPipelines[Permutation], HitGroupIndices);
+		}
+
+		ImGui::Separator();
+		for (uint32_t Idx = 0; Idx < TracePath_Count && Root.RayQueryPipeline; ++Idx)
+		{
+			if (ImGui::RadioButton(kTracePathNames[Idx], Root.TracePath == Idx) && !Benchmark.bIsRunning)
+			{
+				Root.TracePath = Idx;
+			}
+		}
+		if (const FGPUScopeStats* Stats = FindGPUScopeStats(Root.Gfx.GPUProfiler, "Trace"))
+		{
+			ImGui::Text("Trace: %.3f ms", Stats->LastMs);
+		}
+		ImGui::Checkbox("Ray counters", &Root.RayCounters.bIsEnabled);
+		if (Root.RayCounters.bIsEnabled)
+		{
+			const FRayCounters& Counters = Root.RayCounters;
+			for (uint32_t RayType = 0; RayType < kNumRayTypes; ++RayType)
+			{
+				const uint64_t* Counts = &Counters.LastCounts[RayType * RAY_COUNTER_COUNT];
+				ImGui::Text("%s: %llu rays, %llu hits, %llu misses", kRayTypeNames[RayType], (unsigned long long)Counts[RAY_COUNTER_RAYS], (unsigned long long)Counts[RAY_COUNTER_HITS], (unsigned long long)Counts[RAY_COUNTER_MISSES]);
+			}
+			ImGui::Text("%.3f Grays/s", Counters.RaysPerSecond * 1.0e-9);
+		}
+		{
+			FDynamicResolution& Res = Root.DynamicResolution;
+			ImGui::Separator();
+			ImGui::Checkbox("Dynamic resolution", &Res.bIsEnabled);
+			if (Res.bIsEnabled)
+			{
+				ImGui::SliderFloat("Target GPU ms", &Res.TargetGPUMs, 1.0f, 33.0f, "%.1f");
+			}
+			else
+			{
+				int32_t Factor = (int32_t)Res.UpscaleFactor;
+				ImGui::Combo("Upscale", &Factor, kUpscaleFactorNames, (int32_t)kNumUpscaleFactors);
+				Res.UpscaleFactor = (uint32_t)Factor;
+			}
+			int32_t Filter = (int32_t)Res.UpscaleFilter;
+			ImGui::Combo("Upscale filter", &Filter, kUpscaleFilterNames, UPSCALE_FILTER_COUNT);
+			Res.UpscaleFilter = (uint32_t)Filter;
+			if (Res.UpscaleFilter == UPSCALE_FILTER_EDGE_ADAPTIVE)
+			{
+				ImGui::SliderFloat("Sharpness", &Res.Sharpness, 0.0f, 1.0f, "%.2f");
+			}
+			ImGui::Text("Trace resolution: %ux%u (%.0f%%)", Res.TraceResolution[0], Res.TraceResolution[1], Res.Scale * 100.0f);
+			const FGPUScopeStats* Stats = FindGPUScopeStats(Root.Gfx.GPUProfiler, "Upscale");
+			if (Stats && IsUpscaling(Root.Gfx, Res))
+			{
+				ImGui::Text("Upscale: %.3f ms", Stats->LastMs);
+			}
+		}
+		{
+			FInterleavedTrace& Interleaved = Root.Interleaved;
+			ImGui::Separator();
+			int32_t Mode = (int32_t)Interleaved.Mode;
+			ImGui::Combo("Interleaved tracing", &Mode, kInterleaveModeNames, (int32_t)kNumInterleaveModes);
+			Interleaved.Mode = (uint32_t)Mode;
+			const FGPUScopeStats* Stats = FindGPUScopeStats(Root.Gfx.GPUProfiler, "Reconstruct");
+			if (Stats && Interleaved.Mode > 0)
+			{
+				ImGui::Text("Reconstruct: %.3f ms", Stats->LastMs);
+			}
+		}
+		{
+			FDenoiser& Denoiser = Root.Denoiser;
+			ImGui::Separator();
+			ImGui::Checkbox("Denoiser", &Denoiser.bIsEnabled);
+			if (Denoiser.bIsEnabled)
+			{
+				int32_t NumIterations = (int32_t)Denoiser.NumIterations;
+				ImGui::SliderInt("Filter iterations", &NumIterations, 1, (int32_t)kDenoiseMaxIterations);
+				Denoiser.NumIterations = (uint32_t)NumIterations;
+				ImGui::SliderFloat("Luminance phi", &Denoiser.LuminancePhi, 0.5f, 16.0f, "%.1f");
+				ImGui::SliderFloat("Normal phi", &Denoiser.NormalPhi, 1.0f, 256.0f, "%.0f");
+				ImGui::SliderFloat("Depth phi", &Denoiser.DepthPhi, 0.001f, 0.1f, "%.3f");
+				if (const FGPUScopeStats* Stats = FindGPUScopeStats(Root.Gfx.GPUProfiler, "Denoise"))
+				{
+					ImGui::Text("Denoise: %.3f ms", Stats->LastMs);
+				}
+			}
+		}
+		{
+			FTemporalAccumulation& Temporal = Root.Temporal;
+			ImGui::Separator();
+			ImGui::Checkbox("Temporal accumulation", &Temporal.bIsEnabled);
+			if (Temporal.bIsEnabled)
+			{
+				ImGui::SliderFloat("Min blend factor", &Temporal.MinBlendFactor, 0.02f, 1.0f, "%.2f");
+				ImGui::SliderFloat("Disocclusion tolerance", &Temporal.DisocclusionTolerance, 0.001f, 0.2f, "%.3f");
+				if (const FGPUScopeStats* Stats = FindGPUScopeStats(Root.Gfx.GPUProfiler, "Temporal"))
+				{
+					ImGui::Text("Temporal: %.3f ms", Stats->LastMs);
+				}
+			}
+		}
+		if (!Root.RayQueryPipeline)
+		{
+			ImGui::Text("Ray query path requires DXR 1.1.");
+		}
+		else if (Benchmark.bIsRunning)
+		{
+			ImGui::Text("Benchmark: frame %u / %u", Benchmark.Frame, TracePath_Count * (kBenchmarkWarmupFrames + kBenchmarkFrames));
+		}
+		else if (ImGui::Button("Run A/B benchmark"))
+		{
+			const FTraceBenchmark Last = Benchmark;
+			Benchmark = {};
+			Benchmark.bIsRunning = true;
+			Benchmark.SavedTracePath = Root.TracePath;
+			Benchmark.SamplePath = -1;
+			Benchmark.SlotSamplePaths[0] = Benchmark.SlotSamplePaths[1] = -1;
+			memcpy(Benchmark.ResultMs, Last.ResultMs, sizeof(Last.ResultMs));
+		}
+		if (Benchmark.ResultMs[TracePath_Pipeline] > 0.0f)
+		{
+			ImGui::Text("%s %.3f ms, %s %.3f ms", kTracePathNames[TracePath_Pipeline], Benchmark.ResultMs[TracePath_Pipeline], kTracePathNames[TracePath_RayQuery], Benchmark.ResultMs[TracePath_RayQuery]);
+		}
+
+		ImGui::Separator();
+		const FRTPipeline& Pipeline = Root.RTPipelines[Root.RTPermutation];
+		ImGui::Text("Permutation: %u", Root.RTPermutation);
+		ImGui::Text("Payload: %u bytes", Pipeline.PayloadSize);
+		ImGui::Text("Stack: %llu bytes (RGS %llu, MS %llu, CHS %llu)", (unsigned long long)Pipeline.PipelineStackSize, (unsigned long long)Pipeline.RayGenStackSize, (unsigned long long)Pipeline.MissStackSize, (unsigned long long)Pipeline.ClosestHitStackSize);
+	}
+	ImGui::End();
+
+	ShowGPUProfilerWindow(Root.Gfx.GPUProfiler, "GPUProfile.csv");
+	ShowCPUProfilerWindow("Frame", "CPUTrace.json");
+	ShowFrameStatsWindow(Root.Gfx.FrameStats, "FrameStats.json");
+	ShowGPUMemoryWindow(Root.Gfx);
+	ShowCPUMemoryWindow("AllocationReport.json");
+}
+
+static void Draw(FDemoRoot& Root)
+{
+	CPU_ZONE("Draw");
+	FGraphicsContext& Gfx = Root.Gfx;
+	ID3D12GraphicsCommandList5* CmdList = GetAndInitCommandList(Gfx);
+
+	ID3D12Resource* BackBuffer;
+	D3D12_CPU_DESCRIPTOR_HANDLE BackBufferRTV;
+	GetBackBuffer(Gfx, BackBuffer, BackBufferRTV);
+
+	BeginGPUProfilerFrame(Gfx);
+	const uint32_t FrameScope = BeginGPUScope(Gfx, "Frame");
+
+	ReadRayCounters(Gfx, Root.RayCounters);
+
+	// Trace path comparisons and benchmark mode do not adapt the resolution, fixed upscale factors still apply.
+	UpdateDynamicResolution(Gfx, Root.DynamicResolution, !Root.Benchmark.bIsRunning && !Root.BenchmarkMode.bIsEnabled);
+	const uint32_t TraceWidth = Root.DynamicResolution.TraceResolution[0];
+	const uint32_t TraceHeight = Root.DynamicResolution.TraceResolution[1];
+
+	// Reconstruction, denoising and accumulation history is dropped when the pass did not run last frame or shading
+	// changed.
+	FTraceHistory& History = Root.TraceHistory;
+	FInterleavedTrace& Interleaved = Root.Interleaved;
+	FDenoiser& Denoiser = Root.Denoiser;
+	FTemporalAccumulation& Temporal = Root.Temporal;
+	const uint32_t Interleave = kInterleaveModes[Interleaved.Mode];
+	const bool bShadingChanged = History.ShadingKey != Root.RTPermutation;
+	History.Index ^= 1;
+	History.ShadingKey = Root.RTPermutation;
+	if (Interleave == 1 || bShadingChanged)
+	{
+		Interleaved.bHasHistory = false;
+	}
+	if (!Denoiser.bIsEnabled || bShadingChanged)
+	{
+		Denoiser.bHasHistory = false;
+	}
+	if (!Temporal.bIsEnabled || bShadingChanged)
+	{
+		Temporal.bHasHistory = false;
+	}
+	// Rays are dispatched for the pixels of one interleave phase only, see GetInterleavedPixel.
+	const XMUINT2 DispatchSize = GetInterleavedDispatchSize(Interleave, XMUINT2(TraceWidth, TraceHeight));
+	const uint32_t DispatchWidth = DispatchSize.x;
+	const uint32_t DispatchHeight = DispatchSize.y;
+
+	// Profiler now has the trace time of the frame that last used this slot.
+	if (Root.Benchmark.bIsRunning)
+	{
+		FTraceBenchmark& Benchmark = Root.Benchmark;
+		const int32_t SamplePath = Benchmark.SlotSamplePaths[Gfx.FrameIndex];
+		const FGPUScopeStats* Stats = FindGPUScopeStats(Gfx.GPUProfiler, "Trace");
+		if (SamplePath >= 0 && Stats)
+		{
+			Benchmark.TotalMs[SamplePath] += Stats->LastMs;
+			Benchmark.NumSamples[SamplePath] += 1;
+		}
+		Benchmark.SlotSamplePaths[Gfx.FrameIndex] = Benchmark.SamplePath;
+	}
+
+	// Raytrace and copy result to the back buffer.
+	{
+		const XMMATRIX ViewTransform = XMMatrixLookAtLH(XMLoadFloat3(&Root.CameraPosition), XMLoadFloat3(&Root.CameraFocusPosition), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+		const XMMATRIX ProjectionTransform = XMMatrixPerspectiveFovLH(XM_PI / 3, 1.777f, 0.1f, 100.0f);
+		const XMMATRIX WorldToProjection = ViewTransform * ProjectionTransform;
+		const XMMATRIX ProjectionToWorld = XMMatrixTranspose(XMMatrixInverse(nullptr, WorldToProjection));
+
+		D3D12_GPU_VIRTUAL_ADDRESS GPUAddress;
+		auto* CPUAddress = (FPerFrameConstantData*)AllocateGPUMemory(Gfx, sizeof(FPerFrameConstantData), GPUAddress);
+		XMStoreFloat4x4(&CPUAddress->ProjectionToWorld, ProjectionToWorld);
+		{
+			const XMFLOAT3 P = Root.CameraPosition;
+			CPUAddress->CameraPosition = XMFLOAT4(P.x, P.y, P.z, 1.0f);
+		}
+		CPUAddress->InlineRayFlags = Root.RTSettings.bCullBackFaces ? D3D12_RAY_FLAG_CULL_BACK_FACING_TRIANGLES : D3D12_RAY_FLAG_NONE;
+		CPUAddress->InlineLambertShading = Root.RTSettings.bLambertShading ? 1 : 0;
+		CPUAddress->RayCounters = Root.RayCounters.bIsEnabled ? 1 : 0;
+		CPUAddress->TraceWidth = TraceWidth;
+		CPUAddress->TraceHeight = TraceHeight;
+		XMStoreFloat4x4(&CPUAddress->PrevWorldToProjection, XMMatrixTranspose(XMLoadFloat4x4(&History.PrevWorldToProjection)));
+		CPUAddress->PrevTraceWidth = History.PrevTraceResolution[0];
+		CPUAddress->PrevTraceHeight = History.PrevTraceResolution[1];
+		CPUAddress->HasTemporalHistory = Temporal.bHasHistory ? 1 : 0;
+		CPUAddress->Jitter = GetTemporalJitter(Temporal);
+		CPUAddress->HistoryMinBlendFactor = Temporal.MinBlendFactor;
+		CPUAddress->DisocclusionTolerance = Temporal.DisocclusionTolerance;
+		CPUAddress->TraceInterleave = Interleave;
+		CPUAddress->InterleavePhase = Interleaved.Phase;
+		CPUAddress->HasReconstructionHistory = Interleaved.bHasHistory ? 1 : 0;
+		CPUAddress->HasDenoiseHistory = Denoiser.bHasHistory ? 1 : 0;
+
+		UpdateShaderTable(Gfx, Root.ShaderTable);
+
+		if (Root.TracePath == TracePath_RayQuery)
+		{
+			CmdList->SetPipelineState(Root.RayQueryPipeline);
+			CmdList->SetComputeRootSignature(Root.RayQuerySignature);
+		}
+		else
+		{
+			CmdList->SetPipelineState1(Root.RTPipelines[Root.RTPermutation].RTPipeline);
+			CmdList->SetComputeRootSignature(Root.RTPipelines[Root.RTPermutation].RTGlobalSignature);
+		}
+		{
+			const D3D12_GPU_DESCRIPTOR_HANDLE TableBase = CopyDescriptorsToGPUHeap(Gfx, 1, Root.RTOutputUAV);
+			CopyDescriptorsToGPUHeap(Gfx, 1, History.HitPositionUAVs[History.Index]);
+			CmdList->SetComputeRootDescriptorTable(0, TableBase);
+		}
+		CmdList->SetComputeRootShaderResourceView(1, Root.TLASResultBuffer->GetGPUVirtualAddress());
+		CmdList->SetComputeRootConstantBufferView(2, GPUAddress);
+		{
+			const D3D12_GPU_DESCRIPTOR_HANDLE TableBase = CopyDescriptorsToGPUHeap(Gfx, 1, Root.VertexBufferSRV);
+			CopyDescriptorsToGPUHeap(Gfx, 1, Root.IndexBufferSRV);
+			CopyDescriptorsToGPUHeap(Gfx, 1, Root.MeshInfoSRV);
+			CmdList->SetComputeRootDescriptorTable(3, TableBase);
+		}
+		CmdList->SetComputeRootUnorderedAccessView(4, Root.RayCounters.Buffer->GetGPUVirtualAddress());
+
+		const uint32_t TraceScope = BeginGPUScope(Gfx, "Trace");
+
+		if (Root.TracePath == TracePath_RayQuery)
+		{
+			CmdList->Dispatch((DispatchWidth + 7) / 8, (DispatchHeight + 7) / 8, 1);
+		}
+		else
+		{
+			D3D12_DISPATCH_RAYS_DESC DispatchDesc = {};
+			GetShaderTableRanges(Root.ShaderTable, DispatchDesc);
+			DispatchDesc.Width = DispatchWidth;
+			DispatchDesc.Height = DispatchHeight;
+			DispatchDesc.Depth = 1;
+			CmdList->DispatchRays(&DispatchDesc);
+		}
+
+		EndGPUScope(Gfx, TraceScope);
+
+		if (Root.RayCounters.bIsEnabled)
+		{
+			CopyRayCounters(Gfx, Root.RayCounters);
+		}
+
+		if (Interleave > 1)
+		{
+			ReconstructRTOutput(Root, GPUAddress);
+			Interleaved.bHasHistory = true;
+			Interleaved.Phase = (Interleaved.Phase + 1) % Interleave;
+		}
+		// Last measured frame of --benchmark, see UpdateBenchmarkMode.
+		if (Root.GBufferCapture.FileName[0] && Root.BenchmarkMode.Frame == kBenchmarkModeWarmupFrames + kBenchmarkModeFrames)
+		{
+			RecordGBufferCapture(Root, CmdList, WorldToProjection);
+		}
+		if (Denoiser.bIsEnabled)
+		{
+			DenoiseRTOutput(Root, GPUAddress);
+			Denoiser.bHasHistory = true;
+		}
+		if (Temporal.bIsEnabled)
+		{
+			AccumulateRTOutput(Root, GPUAddress);
+			Temporal.bHasHistory = true;
+			Temporal.JitterPhase += 1;
+		}
+		XMStoreFloat4x4(&History.PrevWorldToProjection, WorldToProjection);
+		History.PrevTraceResolution[0] = TraceWidth;
+		History.PrevTraceResolution[1] = TraceHeight;
+
+		ID3D12Resource* Output = Root.RTOutput;
+		if (IsUpscaling(Gfx, Root.DynamicResolution))
+		{
+			UpscaleRTOutput(Gfx, Root.RTOutput, Root.DynamicResolution);
+			Output = Root.DynamicResolution.UpscaleOutput;
+		}
+
+		{
+			const CD3DX12_RESOURCE_BARRIER Barriers[] =
+			{
+				CD3DX12_RESOURCE_BARRIER::Transition(BackBuffer, D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_COPY_DEST),
+				CD3DX12_RESOURCE_BARRIER::Transition(Output, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_COPY_SOURCE),
+			};
+			CmdList->ResourceBarrier((uint32_t)eastl::size(Barriers), Barriers);
+		}
+
+		const uint32_t CopyScope = BeginGPUScope(Gfx, "Copy");
+		CmdList->CopyResource(BackBuffer, Output);
+		EndGPUScope(Gfx, CopyScope);
+
+		{
+			const CD3DX12_RESOURCE_BARRIER Barriers[] =
+			{
+				CD3DX12_RESOURCE_BARRIER::Transition(BackBuffer, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_RENDER_TARGET),
+				CD3DX12_RESOURCE_BARRIER::Transition(Output, D3D12_RESOURCE_STATE_COPY_SOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS),
+			};
+			CmdList->ResourceBarrier((uint32_t)eastl::size(Barriers), Barriers);
+		}
+	}
+
+	// Draw UI.
+	{
+		CmdList->RSSetViewports(1, &CD3DX12_VIEWPORT(0.0f, 0.0f, (float)Gfx.Resolution[0], (float)Gfx.Resolution[1]));
+		CmdList->RSSetScissorRects(1, &CD3DX12_RECT(0, 0, (LONG)Gfx.Resolution[0], (LONG)Gfx.Resolution[1]));
+
+		CmdList->OMSetRenderTargets(1, &BackBufferRTV, TRUE, nullptr);
+
+		if (!Root.BenchmarkMode.bIsEnabled || Root.BenchmarkMode.bUsesNullCommandList)
+		{
+			const uint32_t UIScope = BeginGPUScope(Gfx, "UI");
+			DrawUI(Gfx, Root.UI);
+			EndGPUScope(Gfx, UIScope);
+		}
+
+		CmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(BackBuffer, D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT));
+	}
+
+	EndGPUScope(Gfx, FrameScope);
+	EndGPUProfilerFrame(Gfx);
+	ExecuteCommandList(Gfx);
+}
+
+static FStartupTask BeginStartupTask(const char* Name)
+{
+	return { Name, GetCurrentThreadId(), GetTime(), 0.0 };
+}
+
+static void EndStartupTask(FStartupTask& Task)
+{
+	Task.EndTime = GetTime();
+}
+
+// Writes startup timeline as CSV (one row per task, milliseconds since StartTime).
+static void WriteStartupTimeline(const eastl::vector<FStartupTask>& Tasks, double StartTime, const char* FileName)
+{
+	FILE* File = fopen(FileName, "w");
+	if (!File)
+	{
+		return;
+	}
+	fprintf(File, "Task,ThreadId,BeginMs,EndMs,DurationMs\n");
+	for (const FStartupTask& Task : Tasks)
+	{
+		fprintf(File, "%s,%u,%.3f,%.3f,%.3f\n", Task.Name, Task.ThreadId, (Task.BeginTime - StartTime) * 1000.0, (Task.EndTime - StartTime) * 1000.0, (Task.EndTime - Task.BeginTime) * 1000.0);
+	}
+	fclose(File);
+}
+
+static void CreateRTPipeline(FGraphicsContext& Gfx, const char* LibraryName, FRTPipeline& OutPipeline)
+{
+	CPU_ZONE("CreateRTPipeline");
+	char Path[MAX_PATH];
+	EA::StdC::Snprintf(Path, sizeof(Path), "Data/Shaders/%s", LibraryName);
+	FFileView DXIL;
+	if (!OpenFileView(Path, DXIL))
+	{
+		EA_ASSERT(0);
+	}
+
+	CD3DX12_STATE_OBJECT_DESC PipelineDesc{ D3D12_STATE_OBJECT_TYPE_RAYTRACING_PIPELINE };
+	auto DXILLibrary = PipelineDesc.CreateSubobject<CD3DX12_DXIL_LIBRARY_SUBOBJECT>();
+
+	DXILLibrary->SetDXILLibrary(&CD3DX12_SHADER_BYTECODE(DXIL.Data, DXIL.Size));
+
+	OutPipeline = {};
+	VHR(Gfx.Device->CreateStateObject(PipelineDesc, IID_PPV_ARGS(&OutPipeline.RTPipeline)));
+	VHR(Gfx.Device->CreateRootSignature(0, DXIL.Data, DXIL.Size, IID_PPV_ARGS(&OutPipeline.RTGlobalSignature)));
+	CloseFileView(DXIL);
+
+	ID3D12StateObjectProperties* Props;
+	VHR(OutPipeline.RTPipeline->QueryInterface(IID_PPV_ARGS(&Props)));
+	OutPipeline.RayGenStackSize = Props->GetShaderStackSize(L"MainRGS");
+	OutPipeline.MissStackSize = Props->GetShaderStackSize(L"MainMS");
+	OutPipeline.ClosestHitStackSize = Props->GetShaderStackSize(L"HitGroup::closesthit");
+	OutPipeline.PipelineStackSize = Props->GetPipelineStackSize();
+	SAFE_RELEASE(Props);
+}
+
+// Starts compiling all RT pipelines, one worker thread each. Device object creation is free-threaded so this overlaps
+// with everything else done at startup that does not need the pipelines.
+static void BeginRTPipelines(FGraphicsContext& Gfx, FRTPipelineBuild (&Builds)[RTPermutation_Count])
 {
-	RTPSO_Raytracing,
-};
+	for (uint32_t Idx = 0; Idx < RTPermutation_Count; ++Idx)
+	{
+		FRTPipelineBuild& Build = Builds[Idx];
+		Build.Gfx = &Gfx;
+		Build.Permutation = Idx;
+		GetRTPermutationLibraryName(Idx, Build.LibraryName, sizeof(Build.LibraryName));
+		Build.Thread.Begin([](void* Context) -> intptr_t
+		{
+			auto& Build = *(FRTPipelineBuild*)Context;
+			SetCPUProfilerThreadName(Build.LibraryName);
+			Build.Task = BeginStartupTask(Build.LibraryName);
+			CreateRTPipeline(*Build.Gfx, Build.LibraryName, Build.Pipeline);
+			Build.Pipeline.PayloadSize = GetRTPermutationPayloadSize(Build.Permutation);
+			EndStartupTask(Build.Task);
+			return 0;
+		}, &Build);
+	}
+}
 
-struct FRTPipeline
+// Waits for all RT pipelines started by BeginRTPipelines and logs metadata of each permutation.
+static void EndRTPipelines(FRTPipelineBuild (&Builds)[RTPermutation_Count], eastl::vector<FRTPipeline>& OutRTPipelines, eastl::vector<FStartupTask>& InOutTasks)
 {
-	ID3D12StateObject* RTPipeline;
-	ID3D12RootSignature* RTGlobalSignature;
+	OutRTPipelines.clear();
+	for (FRTPipelineBuild& Build : Builds)
+	{
+		Build.Thread.WaitForEnd();
+		OutRTPipelines.push_back(Build.Pipeline);
+		InOutTasks.push_back(Build.Task);
+
+		const FRTPipeline& Pipeline = Build.Pipeline;
+		char Text[256];
+		EA::StdC::Snprintf(Text, sizeof(Text), "%s: payload %u bytes, stack %llu bytes (RGS %llu, MS %llu, CHS %llu)\n", Build.LibraryName, Pipeline.PayloadSize, (unsigned long long)Pipeline.PipelineStackSize, (unsigned long long)Pipeline.RayGenStackSize, (unsigned long long)Pipeline.MissStackSize, (unsigned long long)Pipeline.ClosestHitStackSize);
+		OutputDebugString(Text);
+	}
+}
+
+// Cooked static geometry stored in the asset cache: header followed by vertex data, index data, FStaticMesh array and
+// FMeshInstance array. Bump the version whenever the layout or any of the loaders change.
+struct FCookedGeometryHeader
+{
+	uint32_t Version;
+	uint32_t NumVertices;
+	uint32_t NumIndices;
+	uint32_t NumMeshes;
+	uint32_t NumInstances;
 };
 
-struct FDemoRoot
+static const uint32_t kCookedGeometryVersion = 1;
+
+// State shared by geometry loaders while they fill static geometry buffers.
+struct FGeometryUpload
 {
-	FGraphicsContext Gfx;
-	FUIContext UI;
-	eastl::vector<FRTPipeline> RTPipelines;
-	ID3D12Resource* VertexBuffer;
-	ID3D12Resource* IndexBuffer;
-	D3D12_CPU_DESCRIPTOR_HANDLE VertexBufferSRV;
-	D3D12_CPU_DESCRIPTOR_HANDLE IndexBufferSRV;
-	ID3D12Resource* BLASResultBuffer;
-	ID3D12Resource* TLASInstanceBuffer;
-	ID3D12Resource* TLASResultBuffer;
-	ID3D12Resource* ShaderTable;
-	ID3D12Resource* RTOutput;
-	D3D12_CPU_DESCRIPTOR_HANDLE RTOutputUAV;
-	XMFLOAT3 CameraPosition;
-	XMFLOAT3 CameraFocusPosition;
+	FStagingChunk Staging;
+	FILE* CookedFile; // Not null when loaded data is also written to the asset cache.
+	uint64_t CookedIndicesOffset;
 };
 
-static void Update(FDemoRoot& Root)
+// Creates static geometry vertex and index buffers (single buffers for all static meshes).
+static void CreateStaticGeometryBuffers(FDemoRoot& Root, FGeometryUpload& Upload, uint32_t NumVertices, uint32_t NumIndices)
 {
-	double Time;
-	float DeltaTime;
-	UpdateFrameStats(Root.Gfx.Window, "DXRTest", Time, DeltaTime);
-	UpdateUI(DeltaTime);
+	FGraphicsContext& Gfx = Root.Gfx;
+
+	Root.VertexBuffer = CreateGPUResource(Gfx, GPUMemory_Geometry, D3D12_HEAP_TYPE_DEFAULT, CD3DX12_RESOURCE_DESC::Buffer((uint64_t)NumVertices * sizeof(FVertex)), D3D12_RESOURCE_STATE_COPY_DEST);
+	Root.IndexBuffer = CreateGPUResource(Gfx, GPUMemory_Geometry, D3D12_HEAP_TYPE_DEFAULT, CD3DX12_RESOURCE_DESC::Buffer((uint64_t)NumIndices * sizeof(uint32_t)), D3D12_RESOURCE_STATE_COPY_DEST);
+
+	Upload.CookedIndicesOffset = sizeof(FCookedGeometryHeader) + (uint64_t)NumVertices * sizeof(FVertex);
+}
+
+// Uploads part of the static vertex or index buffer. When cooking, the same bytes go to the matching offset in the
+// cooked file.
+static void UploadStaticGeometry(FDemoRoot& Root, FGeometryUpload& Upload, ID3D12Resource* DestBuffer, uint64_t DestOffset, const void* Data, uint64_t DataSize)
+{
+	EA_ASSERT(DestBuffer == Root.VertexBuffer || DestBuffer == Root.IndexBuffer);
+
+	UploadBufferData(Root.Gfx, Upload.Staging, DestBuffer, DestOffset, Data, DataSize);
 
-	// Update camera position.
+	if (Upload.CookedFile)
 	{
-		const float Angle = XMScalarModAngle(0.25f * (float)Time);
-		XMVECTOR Position = XMVectorSet(2.5f * cosf(Angle), 2.0f, 2.5f * sinf(Angle), 1.0f);
-		XMStoreFloat3(&Root.CameraPosition, Position);
+		const uint64_t FileOffset = (DestBuffer == Root.VertexBuffer ? sizeof(FCookedGeometryHeader) : Upload.CookedIndicesOffset) + DestOffset;
+		_fseeki64(Upload.CookedFile, FileOffset, SEEK_SET);
+		fwrite(Data, 1, DataSize, Upload.CookedFile);
 	}
-
-	ImGui::ShowDemoWindow();
 }
 
-static void Draw(FDemoRoot& Root)
+static void LoadPLYGeometry(FDemoRoot& Root, const char* FileName, FGeometryUpload& Upload, eastl::vector<FMeshInstance>& OutInstances)
 {
-	FGraphicsContext& Gfx = Root.Gfx;
-	ID3D12GraphicsCommandList5* CmdList = GetAndInitCommandList(Gfx);
+	CPU_ZONE("LoadPLYGeometry");
+	// We only ever walk the file forward.
+	FFileView View;
+	FPLYFile File;
+	if (!OpenFileView(FileName, View, FileView_SequentialScan) || !ParsePLYHeader(View.Data, View.Size, File))
+	{
+		EA_ASSERT(0);
+		CloseFileView(View);
+		return;
+	}
+	const uint32_t NumVertices = File.NumVertices;
+	const uint32_t NumIndices = File.NumTriangles * 3;
 
-	ID3D12Resource* BackBuffer;
-	D3D12_CPU_DESCRIPTOR_HANDLE BackBufferRTV;
-	GetBackBuffer(Gfx, BackBuffer, BackBufferRTV);
+	CreateStaticGeometryBuffers(Root, Upload, NumVertices, NumIndices);
 
-	// Raytrace and copy result to the back buffer.
+	// Vertices.
 	{
-		const XMMATRIX ViewTransform = XMMatrixLookAtLH(XMLoadFloat3(&Root.CameraPosition), XMLoadFloat3(&Root.CameraFocusPosition), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
-		const XMMATRIX ProjectionTransform = XMMatrixPerspectiveFovLH(XM_PI / 3, 1.777f, 0.1f, 100.0f);
-		const XMMATRIX ProjectionToWorld = XMMatrixTranspose(XMMatrixInverse(nullptr, ViewTransform * ProjectionTransform));
+		eastl::vector<XMFLOAT3> Positions(kStreamWindowSize);
+		eastl::vector<XMFLOAT3> Normals(kStreamWindowSize, XMFLOAT3(0.0f, 0.0f, 0.0f));
+		eastl::vector<FVertex> Vertices(kStreamWindowSize);
 
-		D3D12_GPU_VIRTUAL_ADDRESS GPUAddress;
-		auto* CPUAddress = (FPerFrameConstantData*)AllocateGPUMemory(Gfx, sizeof(FPerFrameConstantData), GPUAddress);
-		XMStoreFloat4x4(&CPUAddress->ProjectionToWorld, ProjectionToWorld);
+		uint64_t DestOffset = 0;
+		for (;;)
 		{
-			const XMFLOAT3 P = Root.CameraPosition;
-			CPUAddress->CameraPosition = XMFLOAT4(P.x, P.y, P.z, 1.0f);
+			const uint32_t Count = ReadPLYVertices(File, kStreamWindowSize, Positions.data(), Normals.data(), nullptr);
+			if (Count == 0)
+			{
+				break;
+			}
+
+			for (uint32_t Idx = 0; Idx < Count; ++Idx)
+			{
+				Vertices[Idx].Position = Positions[Idx];
+				Vertices[Idx].Normal = Normals[Idx];
+			}
+
+			UploadStaticGeometry(Root, Upload, Root.VertexBuffer, DestOffset, Vertices.data(), Count * sizeof(FVertex));
+			DestOffset += Count * sizeof(FVertex);
 		}
+	}
 
-		CmdList->SetPipelineState1(Root.RTPipelines[RTPSO_Raytracing].RTPipeline);
-		CmdList->SetComputeRootSignature(Root.RTPipelines[RTPSO_Raytracing].RTGlobalSignature);
-		CmdList->SetComputeRootDescriptorTable(0, CopyDescriptorsToGPUHeap(Gfx, 1, Root.RTOutputUAV));
-		CmdList->SetComputeRootShaderResourceView(1, Root.TLASResultBuffer->GetGPUVirtualAddress());
-		CmdList->SetComputeRootConstantBufferView(2, GPUAddress);
+	// Indices.
+	{
+		eastl::vector<uint32_t> Triangles(kStreamWindowSize * 3);
+
+		uint64_t DestOffset = 0;
+		for (;;)
 		{
-			const D3D12_GPU_DESCRIPTOR_HANDLE TableBase = CopyDescriptorsToGPUHeap(Gfx, 1, Root.VertexBufferSRV);
-			CopyDescriptorsToGPUHeap(Gfx, 1, Root.IndexBufferSRV);
-			CmdList->SetComputeRootDescriptorTable(3, TableBase);
+			const uint32_t Count = ReadPLYTriangles(File, kStreamWindowSize, Triangles.data());
+			if (Count == 0)
+			{
+				break;
+			}
+
+			UploadStaticGeometry(Root, Upload, Root.IndexBuffer, DestOffset, Triangles.data(), Count * 3 * sizeof(uint32_t));
+			DestOffset += Count * 3 * sizeof(uint32_t);
 		}
+	}
 
+	CloseFileView(View);
+	// Truncated or malformed file, nothing is added so the load fails and the cooked geometry is not committed.
+	if (File.bIsCorrupt)
+	{
+		EA_ASSERT(0);
+		return;
+	}
+
+	Root.StaticMeshes.push_back({ 0, NumVertices, 0, NumIndices });
+
+	FMeshInstance Instance = { 0 };
+	XMStoreFloat4x4(&Instance.Transform, XMMatrixIdentity());
+	OutInstances.push_back(Instance);
+}
+
+static void LoadGLBGeometry(FDemoRoot& Root, const char* FileName, FGeometryUpload& Upload, eastl::vector<FMeshInstance>& OutInstances)
+{
+	CPU_ZONE("LoadGLBGeometry");
+	FFileView View;
+	FGLBFile File;
+	if (!OpenFileView(FileName, View) || !ParseGLB(View.Data, View.Size, File))
+	{
+		EA_ASSERT(0);
+		CloseFileView(View);
+		return;
+	}
+
+	// Every glTF primitive becomes one static mesh. Totals are summed in 64 bits, meshes address vertices and indices
+	// with 32-bit offsets.
+	uint64_t NumVertices = 0;
+	uint64_t NumIndices = 0;
+	for (const FGLBPrimitive& Primitive : File.Primitives)
+	{
+		NumVertices += Primitive.Positions.Count;
+		NumIndices += Primitive.Indices.Count;
+	}
+	if (NumVertices > UINT32_MAX || NumIndices > UINT32_MAX)
+	{
+		EA_ASSERT(0);
+		CloseFileView(View);
+		return;
+	}
+
+	const uint32_t FirstMesh = (uint32_t)Root.StaticMeshes.size();
+	{
+		uint32_t BaseVertex = 0;
+		uint32_t BaseIndex = 0;
+		for (const FGLBPrimitive& Primitive : File.Primitives)
 		{
-			const D3D12_GPU_VIRTUAL_ADDRESS Base = Root.ShaderTable->GetGPUVirtualAddress();
-			D3D12_DISPATCH_RAYS_DESC DispatchDesc = {};
-			DispatchDesc.RayGenerationShaderRecord = { Base, 32 };
-			DispatchDesc.MissShaderTable = { Base + 64, 32, 32 };
-			DispatchDesc.HitGroupTable = { Base + 128, 32, 32 };
-			DispatchDesc.Width = Gfx.Resolution[0];
-			DispatchDesc.Height = Gfx.Resolution[1];
-			DispatchDesc.Depth = 1;
-			CmdList->DispatchRays(&DispatchDesc);
+			Root.StaticMeshes.push_back({ BaseVertex, Primitive.Positions.Count, BaseIndex, Primitive.Indices.Count });
+			BaseVertex += Primitive.Positions.Count;
+			BaseIndex += Primitive.Indices.Count;
 		}
+	}
+
+	CreateStaticGeometryBuffers(Root, Upload, (uint32_t)NumVertices, (uint32_t)NumIndices);
+
+	eastl::vector<FVertex> Vertices;
+	eastl::vector<uint32_t> Indices;
+
+	for (uint32_t PrimitiveIdx = 0; PrimitiveIdx < File.Primitives.size(); ++PrimitiveIdx)
+	{
+		const FGLBPrimitive& Primitive = File.Primitives[PrimitiveIdx];
+		const FStaticMesh& Mesh = Root.StaticMeshes[FirstMesh + PrimitiveIdx];
 
+		// Vertices. When positions and normals are already interleaved like FVertex the whole range goes to the staging
+		// memory as is, otherwise it is repacked window by window.
+		if (Primitive.Positions.Stride == sizeof(FVertex) && Primitive.Normals.Stride == sizeof(FVertex) && Primitive.Normals.Data == Primitive.Positions.Data + offsetof(FVertex, Normal))
 		{
-			const CD3DX12_RESOURCE_BARRIER Barriers[] =
-			{
-				CD3DX12_RESOURCE_BARRIER::Transition(BackBuffer, D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_COPY_DEST),
-				CD3DX12_RESOURCE_BARRIER::Transition(Root.RTOutput, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_COPY_SOURCE),
-			};
-			CmdList->ResourceBarrier((uint32_t)eastl::size(Barriers), Barriers);
+			UploadStaticGeometry(Root, Upload, Root.VertexBuffer, Mesh.BaseVertex * sizeof(FVertex), Primitive.Positions.Data, Mesh.NumVertices * sizeof(FVertex));
 		}
+		else
+		{
+			Vertices.resize(kStreamWindowSize);
+
+			for (uint32_t First = 0; First < Mesh.NumVertices; First += kStreamWindowSize)
+			{
+				const uint32_t Count = eastl::min(kStreamWindowSize, Mesh.NumVertices - First);
 
-		CmdList->CopyResource(BackBuffer, Root.RTOutput);
+				for (uint32_t Idx = 0; Idx < Count; ++Idx)
+				{
+					memcpy(&Vertices[Idx].Position, Primitive.Positions.Data + (uint64_t)(First + Idx) * Primitive.Positions.Stride, sizeof(XMFLOAT3));
+					if (Primitive.Normals.Data)
+					{
+						memcpy(&Vertices[Idx].Normal, Primitive.Normals.Data + (uint64_t)(First + Idx) * Primitive.Normals.Stride, sizeof(XMFLOAT3));
+					}
+					else
+					{
+						Vertices[Idx].Normal = XMFLOAT3(0.0f, 0.0f, 0.0f);
+					}
+				}
+
+				UploadStaticGeometry(Root, Upload, Root.VertexBuffer, (uint64_t)(Mesh.BaseVertex + First) * sizeof(FVertex), Vertices.data(), Count * sizeof(FVertex));
+			}
+		}
 
+		// Indices. 32-bit indices are copied as is, smaller ones are widened.
+		if (Primitive.Indices.ComponentType == GLBComponent_UnsignedInt)
 		{
-			const CD3DX12_RESOURCE_BARRIER Barriers[] =
+			UploadStaticGeometry(Root, Upload, Root.IndexBuffer, Mesh.BaseIndex * sizeof(uint32_t), Primitive.Indices.Data, Mesh.NumIndices * sizeof(uint32_t));
+		}
+		else
+		{
+			Indices.resize(kStreamWindowSize);
+
+			for (uint32_t First = 0; First < Mesh.NumIndices; First += kStreamWindowSize)
 			{
-				CD3DX12_RESOURCE_BARRIER::Transition(BackBuffer, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_RENDER_TARGET),
-				CD3DX12_RESOURCE_BARRIER::Transition(Root.RTOutput, D3D12_RESOURCE_STATE_COPY_SOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS),
-			};
-			CmdList->ResourceBarrier((uint32_t)eastl::size(Barriers), Barriers);
+				const uint32_t Count = eastl::min(kStreamWindowSize, Mesh.NumIndices - First);
+
+				for (uint32_t Idx = 0; Idx < Count; ++Idx)
+				{
+					Indices[Idx] = Primitive.Indices.ComponentType == GLBComponent_UnsignedShort ? ((const uint16_t*)Primitive.Indices.Data)[First + Idx] : Primitive.Indices.Data[First + Idx];
+				}
+
+				UploadStaticGeometry(Root, Upload, Root.IndexBuffer, (uint64_t)(Mesh.BaseIndex + First) * sizeof(uint32_t), Indices.data(), Count * sizeof(uint32_t));
+			}
 		}
 	}
 
-	// Draw UI.
-	{
-		CmdList->RSSetViewports(1, &CD3DX12_VIEWPORT(0.0f, 0.0f, (float)Gfx.Resolution[0], (float)Gfx.Resolution[1]));
-		CmdList->RSSetScissorRects(1, &CD3DX12_RECT(0, 0, (LONG)Gfx.Resolution[0], (LONG)Gfx.Resolution[1]));
-
-		CmdList->OMSetRenderTargets(1, &BackBufferRTV, TRUE, nullptr);
+	// glTF is right-handed, we mirror Z to bring it to our left-handed world. Triangle facing in DXR is determined in
+	// object space so this does not affect culling.
+	const XMMATRIX ToLeftHanded = XMMatrixScaling(1.0f, 1.0f, -1.0f);
 
-		DrawUI(Gfx, Root.UI);
+	for (const FGLBInstance& GLBInstance : File.Instances)
+	{
+		FMeshInstance Instance;
+		XMStoreFloat4x4(&Instance.Transform, XMLoadFloat4x4(&GLBInstance.Transform) * ToLeftHanded);
 
-		CmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(BackBuffer, D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT));
+		for (uint32_t Idx = File.MeshFirstPrimitive[GLBInstance.MeshIndex]; Idx < File.MeshFirstPrimitive[GLBInstance.MeshIndex + 1]; ++Idx)
+		{
+			Instance.MeshIndex = FirstMesh + Idx;
+			OutInstances.push_back(Instance);
+		}
 	}
 
-	CmdList->Close();
-
-	Gfx.CmdQueue->ExecuteCommandLists(1, CommandListCast(&CmdList));
+	CloseFileView(View);
 }
 
-static void CreateRTPipelines(FGraphicsContext& Gfx, eastl::vector<FRTPipeline>& OutRTPipelines)
+static bool LoadCookedGeometry(FDemoRoot& Root, FGeometryUpload& Upload, const FFileView& Data, eastl::vector<FMeshInstance>& OutInstances)
 {
-	// RTPSO_Raytracing.
+	CPU_ZONE("LoadCookedGeometry");
+	FCookedGeometryHeader Header;
+	if (Data.Size < sizeof(Header))
 	{
-		char Path[MAX_PATH];
-		EA::StdC::Snprintf(Path, sizeof(Path), "Data/Shaders/%s", "Raytracing.lib.cso");
-		eastl::vector<uint8_t> DXIL = LoadFile(Path);
-
-		CD3DX12_STATE_OBJECT_DESC PipelineDesc{ D3D12_STATE_OBJECT_TYPE_RAYTRACING_PIPELINE };
-		auto DXILLibrary = PipelineDesc.CreateSubobject<CD3DX12_DXIL_LIBRARY_SUBOBJECT>();
+		return false;
+	}
+	memcpy(&Header, Data.Data, sizeof(Header));
 
-		DXILLibrary->SetDXILLibrary(&CD3DX12_SHADER_BYTECODE(DXIL.data(), DXIL.size()));
+	const uint64_t VerticesSize = (uint64_t)Header.NumVertices * sizeof(FVertex);
+	const uint64_t IndicesSize = (uint64_t)Header.NumIndices * sizeof(uint32_t);
+	const uint64_t MeshesSize = (uint64_t)Header.NumMeshes * sizeof(FStaticMesh);
+	const uint64_t InstancesSize = (uint64_t)Header.NumInstances * sizeof(FMeshInstance);
 
-		FRTPipeline Pipeline = {};
-		VHR(Gfx.Device->CreateStateObject(PipelineDesc, IID_PPV_ARGS(&Pipeline.RTPipeline)));
-		VHR(Gfx.Device->CreateRootSignature(0, DXIL.data(), DXIL.size(), IID_PPV_ARGS(&Pipeline.RTGlobalSignature)));
-		EA_ASSERT(OutRTPipelines.size() == RTPSO_Raytracing);
-		OutRTPipelines.push_back(Pipeline);
+	if (Header.Version != kCookedGeometryVersion || Header.NumMeshes == 0 || Header.NumInstances == 0 || Data.Size != sizeof(Header) + VerticesSize + IndicesSize + MeshesSize + InstancesSize)
+	{
+		return false;
 	}
+
+	const uint8_t* Vertices = Data.Data + sizeof(Header);
+	const uint8_t* Indices = Vertices + VerticesSize;
+	const auto* Meshes = (const FStaticMesh*)(Indices + IndicesSize);
+	const auto* Instances = (const FMeshInstance*)((const uint8_t*)Meshes + MeshesSize);
+
+	CreateStaticGeometryBuffers(Root, Upload, Header.NumVertices, Header.NumIndices);
+	UploadStaticGeometry(Root, Upload, Root.VertexBuffer, 0, Vertices, VerticesSize);
+	UploadStaticGeometry(Root, Upload, Root.IndexBuffer, 0, Indices, IndicesSize);
+
+	Root.StaticMeshes.assign(Meshes, Meshes + Header.NumMeshes);
+	OutInstances.assign(Instances, Instances + Header.NumInstances);
+	return true;
 }
 
-static void CreateStaticGeometry(FDemoRoot& Root, eastl::vector<ID3D12Resource*>& OutTempResources)
+static void CreateStaticGeometry(FDemoRoot& Root, const char* FileName, eastl::vector<ID3D12Resource*>& OutTempResources)
 {
+	CPU_ZONE("CreateStaticGeometry");
 	FGraphicsContext& Gfx = Root.Gfx;
 
-	eastl::vector<FVertex> VertexData;
-	eastl::vector<uint32_t> Triangles;
+	// All geometry data goes through one staging chunk which is reused when full, so memory use does not depend on the
+	// size of the scene.
+	FGeometryUpload Upload = {};
+	CreateStagingChunk(Gfx, 32 * 1024 * 1024, Upload.Staging);
+	OutTempResources.push_back(Upload.Staging.Resource);
 
+	eastl::vector<FMeshInstance>& Instances = Root.MeshInstances;
 	{
-		eastl::vector<XMFLOAT3> Positions;
-		eastl::vector<XMFLOAT3> Normals;
-		eastl::vector<XMFLOAT2> Texcoords;
-
-		const size_t PositionsSize = Positions.size();
-		const size_t TrianglesSize = Triangles.size();
-		LoadPLYFile("Data/Meshes/Monkey.ply", Positions, Normals, Texcoords, Triangles);
+		const uint32_t CookParams[] = { kCookedGeometryVersion, (uint32_t)sizeof(FVertex) };
+		const uint64_t CacheKey = GetAssetCacheKey(FileName, CookParams, sizeof(CookParams));
 
-		VertexData.reserve(Positions.size());
+		FFileView CookedGeometry;
+		const bool bIsCached = ReadCachedAsset(Root.AssetCache, CacheKey, "geometry", CookedGeometry) && LoadCookedGeometry(Root, Upload, CookedGeometry, Instances);
+		CloseFileView(CookedGeometry);
 
-		for (uint32_t Idx = 0; Idx < Positions.size(); ++Idx)
+		if (!bIsCached)
 		{
-			FVertex Vertex;
-			Vertex.Position = Positions[Idx];
-			Vertex.Normal = Normals[Idx];
-			VertexData.push_back(Vertex);
+			Upload.CookedFile = BeginCachedAsset(Root.AssetCache, CacheKey, "geometry");
+
+			const char* Extension = strrchr(FileName, '.');
+			if (Extension && EA::StdC::Stricmp(Extension, ".glb") == 0)
+			{
+				LoadGLBGeometry(Root, FileName, Upload, Instances);
+			}
+			else
+			{
+				LoadPLYGeometry(Root, FileName, Upload, Instances);
+			}
+
+			if (Upload.CookedFile && !Root.StaticMeshes.empty() && !Instances.empty())
+			{
+				const FStaticMesh& LastMesh = Root.StaticMeshes.back();
+
+				FCookedGeometryHeader Header = {};
+				Header.Version = kCookedGeometryVersion;
+				Header.NumVertices = LastMesh.BaseVertex + LastMesh.NumVertices;
+				Header.NumIndices = LastMesh.BaseIndex + LastMesh.NumIndices;
+				Header.NumMeshes = (uint32_t)Root.StaticMeshes.size();
+				Header.NumInstances = (uint32_t)Instances.size();
+
+				_fseeki64(Upload.CookedFile, 0, SEEK_SET);
+				fwrite(&Header, sizeof(Header), 1, Upload.CookedFile);
+				_fseeki64(Upload.CookedFile, Upload.CookedIndicesOffset + (uint64_t)Header.NumIndices * sizeof(uint32_t), SEEK_SET);
+				fwrite(Root.StaticMeshes.data(), sizeof(FStaticMesh), Root.StaticMeshes.size(), Upload.CookedFile);
+				fwrite(Instances.data(), sizeof(FMeshInstance), Instances.size(), Upload.CookedFile);
+			}
+			EndCachedAsset(Root.AssetCache, CacheKey, "geometry", Upload.CookedFile, !Root.StaticMeshes.empty() && !Instances.empty());
+			Upload.CookedFile = nullptr;
 		}
 	}
+	EA_ASSERT(!Root.StaticMeshes.empty() && !Instances.empty());
 
-	// Static geometry vertex buffer (single buffer for all static meshes).
+	// Per-mesh base vertex and base index for the ray query path, indexed with InstanceID(). RT pipelines get the same
+	// data from hit group records.
 	{
-		const D3D12_RESOURCE_DESC Desc = CD3DX12_RESOURCE_DESC::Buffer(VertexData.size() * sizeof(FVertex));
+		eastl::vector<FStaticMeshInfo> MeshInfos;
+		MeshInfos.reserve(Root.StaticMeshes.size());
+		for (const FStaticMesh& Mesh : Root.StaticMeshes)
+		{
+			MeshInfos.push_back({ Mesh.BaseVertex, Mesh.BaseIndex });
+		}
+
+		const uint64_t Size = MeshInfos.size() * sizeof(FStaticMeshInfo);
+		Root.MeshInfoBuffer = CreateGPUResource(Gfx, GPUMemory_Geometry, D3D12_HEAP_TYPE_DEFAULT, CD3DX12_RESOURCE_DESC::Buffer(Size), D3D12_RESOURCE_STATE_COPY_DEST);
+		UploadBufferData(Gfx, Upload.Staging, Root.MeshInfoBuffer, 0, MeshInfos.data(), Size);
 
-		ID3D12Resource* StagingVB;
-		VHR(Gfx.Device->CreateCommittedResource(&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD), D3D12_HEAP_FLAG_NONE, &Desc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&StagingVB)));
-		OutTempResources.push_back(StagingVB);
+		Root.MeshInfoSRV = AllocateDescriptors(Gfx, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, 1);
 
-		void* Ptr;
-		VHR(StagingVB->Map(0, &CD3DX12_RANGE(0, 0), &Ptr));
-		memcpy(Ptr, VertexData.data(), VertexData.size() * sizeof(FVertex));
-		StagingVB->Unmap(0, nullptr);
+		D3D12_SHADER_RESOURCE_VIEW_DESC SRVDesc = {};
+		SRVDesc.Format = DXGI_FORMAT_UNKNOWN;
+		SRVDesc.ViewDimension = D3D12_SRV_DIMENSION_BUFFER;
+		SRVDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+		SRVDesc.Buffer.NumElements = (uint32_t)MeshInfos.size();
+		SRVDesc.Buffer.StructureByteStride = sizeof(FStaticMeshInfo);
+		Gfx.Device->CreateShaderResourceView(Root.MeshInfoBuffer, &SRVDesc, Root.MeshInfoSRV);
+	}
 
-		VHR(Gfx.Device->CreateCommittedResource(&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT), D3D12_HEAP_FLAG_NONE, &Desc, D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS(&Root.VertexBuffer)));
+	const uint32_t NumVertices = Root.StaticMeshes.back().BaseVertex + Root.StaticMeshes.back().NumVertices;
+	const uint32_t NumIndices = Root.StaticMeshes.back().BaseIndex + Root.StaticMeshes.back().NumIndices;
 
-		Gfx.CmdList->CopyResource(Root.VertexBuffer, StagingVB);
-		Gfx.CmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(Root.VertexBuffer, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE));
+	{
+		const CD3DX12_RESOURCE_BARRIER Barriers[] =
+		{
+			CD3DX12_RESOURCE_BARRIER::Transition(Root.VertexBuffer, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE),
+			CD3DX12_RESOURCE_BARRIER::Transition(Root.IndexBuffer, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE),
+			CD3DX12_RESOURCE_BARRIER::Transition(Root.MeshInfoBuffer, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE),
+		};
+		Gfx.CmdList->ResourceBarrier((uint32_t)eastl::size(Barriers), Barriers);
+	}
 
+	// Static geometry vertex buffer view.
+	{
 		Root.VertexBufferSRV = AllocateDescriptors(Gfx, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, 1);
 
 		D3D12_SHADER_RESOURCE_VIEW_DESC SRVDesc = {};
 		SRVDesc.Format = DXGI_FORMAT_UNKNOWN;
 		SRVDesc.ViewDimension = D3D12_SRV_DIMENSION_BUFFER;
 		SRVDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-		SRVDesc.Buffer.NumElements = (uint32_t)VertexData.size();
+		SRVDesc.Buffer.NumElements = NumVertices;
 		SRVDesc.Buffer.StructureByteStride = sizeof(FVertex);
 		Gfx.Device->CreateShaderResourceView(Root.VertexBuffer, &SRVDesc, Root.VertexBufferSRV);
 	}
 
-	// Static geometry index buffer (single buffer for all static meshes).
+	// Static geometry index buffer view.
 	{
-		const D3D12_RESOURCE_DESC Desc = CD3DX12_RESOURCE_DESC::Buffer(Triangles.size() * sizeof(uint32_t));
-
-		ID3D12Resource* StagingIB;
-		VHR(Gfx.Device->CreateCommittedResource(&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD), D3D12_HEAP_FLAG_NONE, &Desc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&StagingIB)));
-		OutTempResources.push_back(StagingIB);
-
-		void* Ptr;
-		VHR(StagingIB->Map(0, &CD3DX12_RANGE(0, 0), &Ptr));
-		memcpy(Ptr, Triangles.data(), Triangles.size() * sizeof(uint32_t));
-		StagingIB->Unmap(0, nullptr);
-
-		VHR(Gfx.Device->CreateCommittedResource(&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT), D3D12_HEAP_FLAG_NONE, &Desc, D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS(&Root.IndexBuffer)));
-
-		Gfx.CmdList->CopyResource(Root.IndexBuffer, StagingIB);
-		Gfx.CmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(Root.IndexBuffer, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE));
-
 		Root.IndexBufferSRV = AllocateDescriptors(Gfx, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, 1);
 
 		D3D12_SHADER_RESOURCE_VIEW_DESC SRVDesc = {};
 		SRVDesc.Format = DXGI_FORMAT_R32G32B32_UINT;
 		SRVDesc.ViewDimension = D3D12_SRV_DIMENSION_BUFFER;
 		SRVDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-		SRVDesc.Buffer.NumElements = (uint32_t)Triangles.size() / 3;
+		SRVDesc.Buffer.NumElements = NumIndices / 3;
 		Gfx.Device->CreateShaderResourceView(Root.IndexBuffer, &SRVDesc, Root.IndexBufferSRV);
 	}
 
-	// Bottom Level Acceleration Structure (BLAS).
+	// Bottom Level Acceleration Structures (one BLAS per static mesh).
 	{
-		D3D12_RAYTRACING_GEOMETRY_DESC GeometryDesc = {};
-		GeometryDesc.Flags = D3D12_RAYTRACING_GEOMETRY_FLAG_OPAQUE;
-		GeometryDesc.Type = D3D12_RAYTRACING_GEOMETRY_TYPE_TRIANGLES;
-		GeometryDesc.Triangles.VertexBuffer.StartAddress = Root.VertexBuffer->GetGPUVirtualAddress();
-		GeometryDesc.Triangles.VertexBuffer.StrideInBytes = (UINT)sizeof(FVertex);
-		GeometryDesc.Triangles.VertexCount = (UINT)VertexData.size();
-		GeometryDesc.Triangles.VertexFormat = DXGI_FORMAT_R32G32B32_FLOAT;
-		GeometryDesc.Triangles.IndexBuffer = Root.IndexBuffer->GetGPUVirtualAddress();
-		GeometryDesc.Triangles.IndexCount = (UINT)Triangles.size();
-		GeometryDesc.Triangles.IndexFormat = DXGI_FORMAT_R32_UINT;
+		eastl::vector<D3D12_RAYTRACING_GEOMETRY_DESC> GeometryDescs(Root.StaticMeshes.size());
+		eastl::vector<D3D12_RAYTRACING_ACCELERATION_STRUCTURE_PREBUILD_INFO> BuildInfos(Root.StaticMeshes.size());
+		uint64_t ScratchSize = 0;
 
-		D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS BLASInputs = {};
-		BLASInputs.Type = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL;
-		BLASInputs.Flags = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_TRACE;
-		BLASInputs.NumDescs = 1;
-		BLASInputs.DescsLayout = D3D12_ELEMENTS_LAYOUT_ARRAY;
-		BLASInputs.pGeometryDescs = &GeometryDesc;
-
-		D3D12_RAYTRACING_ACCELERATION_STRUCTURE_PREBUILD_INFO BLASBuildInfo = {};
-		Gfx.Device->GetRaytracingAccelerationStructurePrebuildInfo(&BLASInputs, &BLASBuildInfo);
+		for (uint32_t MeshIdx = 0; MeshIdx < Root.StaticMeshes.size(); ++MeshIdx)
+		{
+			const FStaticMesh& Mesh = Root.StaticMeshes[MeshIdx];
+
+			D3D12_RAYTRACING_GEOMETRY_DESC& GeometryDesc = GeometryDescs[MeshIdx];
+			GeometryDesc = {};
+			GeometryDesc.Flags = D3D12_RAYTRACING_GEOMETRY_FLAG_OPAQUE;
+			GeometryDesc.Type = D3D12_RAYTRACING_GEOMETRY_TYPE_TRIANGLES;
+			GeometryDesc.Triangles.VertexBuffer.StartAddress = Root.VertexBuffer->GetGPUVirtualAddress() + (uint64_t)Mesh.BaseVertex * sizeof(FVertex);
+			GeometryDesc.Triangles.VertexBuffer.StrideInBytes = (UINT)sizeof(FVertex);
+			GeometryDesc.Triangles.VertexCount = Mesh.NumVertices;
+			GeometryDesc.Triangles.VertexFormat = DXGI_FORMAT_R32G32B32_FLOAT;
+			GeometryDesc.Triangles.IndexBuffer = Root.IndexBuffer->GetGPUVirtualAddress() + (uint64_t)Mesh.BaseIndex * sizeof(uint32_t);
+			GeometryDesc.Triangles.IndexCount = Mesh.NumIndices;
+			GeometryDesc.Triangles.IndexFormat = DXGI_FORMAT_R32_UINT;
+
+			D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS BLASInputs = {};
+			BLASInputs.Type = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL;
+			BLASInputs.Flags = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_TRACE;
+			BLASInputs.NumDescs = 1;
+			BLASInputs.DescsLayout = D3D12_ELEMENTS_LAYOUT_ARRAY;
+			BLASInputs.pGeometryDescs = &GeometryDesc;
+
+			Gfx.Device->GetRaytracingAccelerationStructurePrebuildInfo(&BLASInputs, &BuildInfos[MeshIdx]);
+			ScratchSize = eastl::max(ScratchSize, BuildInfos[MeshIdx].ScratchDataSizeInBytes);
+		}
 
+		// Builds are serialized with UAV barriers so a single scratch buffer is enough.
 		ID3D12Resource* BLASScratchBuffer;
 		{
-			const CD3DX12_RESOURCE_DESC Desc = CD3DX12_RESOURCE_DESC::Buffer(BLASBuildInfo.ScratchDataSizeInBytes, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
-			VHR(Gfx.Device->CreateCommittedResource(&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT), D3D12_HEAP_FLAG_NONE, &Desc, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, nullptr, IID_PPV_ARGS(&BLASScratchBuffer)));
+			const CD3DX12_RESOURCE_DESC Desc = CD3DX12_RESOURCE_DESC::Buffer(ScratchSize, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+			BLASScratchBuffer = CreateGPUResource(Gfx, GPUMemory_Scratch, D3D12_HEAP_TYPE_DEFAULT, Desc, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
 			OutTempResources.push_back(BLASScratchBuffer);
 		}
 
-		// Create BLASResultBuffer.
+		const uint32_t ProfilerScope = BeginGPUScope(Gfx, "BLAS build");
+		for (uint32_t MeshIdx = 0; MeshIdx < Root.StaticMeshes.size(); ++MeshIdx)
 		{
-			const CD3DX12_RESOURCE_DESC Desc = CD3DX12_RESOURCE_DESC::Buffer(BLASBuildInfo.ResultDataMaxSizeInBytes, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
-			VHR(Gfx.Device->CreateCommittedResource(&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT), D3D12_HEAP_FLAG_NONE, &Desc, D3D12_RESOURCE_STATE_RAYTRACING_ACCELERATION_STRUCTURE, nullptr, IID_PPV_ARGS(&Root.BLASResultBuffer)));
-		}
+			// Create BLASResultBuffer.
+			ID3D12Resource* BLASResultBuffer;
+			{
+				const CD3DX12_RESOURCE_DESC Desc = CD3DX12_RESOURCE_DESC::Buffer(BuildInfos[MeshIdx].ResultDataMaxSizeInBytes, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+				BLASResultBuffer = CreateGPUResource(Gfx, GPUMemory_AccelerationStructure, D3D12_HEAP_TYPE_DEFAULT, Desc, D3D12_RESOURCE_STATE_RAYTRACING_ACCELERATION_STRUCTURE);
+				Root.BLASResultBuffers.push_back(BLASResultBuffer);
+			}
 
-		D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC BLASBuildDesc = {};
-		BLASBuildDesc.Inputs = BLASInputs;
-		BLASBuildDesc.ScratchAccelerationStructureData = BLASScratchBuffer->GetGPUVirtualAddress();
-		BLASBuildDesc.DestAccelerationStructureData = Root.BLASResultBuffer->GetGPUVirtualAddress();
+			D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC BLASBuildDesc = {};
+			BLASBuildDesc.Inputs.Type = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL;
+			BLASBuildDesc.Inputs.Flags = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_TRACE;
+			BLASBuildDesc.Inputs.NumDescs = 1;
+			BLASBuildDesc.Inputs.DescsLayout = D3D12_ELEMENTS_LAYOUT_ARRAY;
+			BLASBuildDesc.Inputs.pGeometryDescs = &GeometryDescs[MeshIdx];
+			BLASBuildDesc.ScratchAccelerationStructureData = BLASScratchBuffer->GetGPUVirtualAddress();
+			BLASBuildDesc.DestAccelerationStructureData = BLASResultBuffer->GetGPUVirtualAddress();
 
-		Gfx.CmdList->BuildRaytracingAccelerationStructure(&BLASBuildDesc, 0, nullptr);
-		Gfx.CmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::UAV(Root.BLASResultBuffer));
+			Gfx.CmdList->BuildRaytracingAccelerationStructure(&BLASBuildDesc, 0, nullptr);
+
+			const CD3DX12_RESOURCE_BARRIER Barriers[] =
+			{
+				CD3DX12_RESOURCE_BARRIER::UAV(BLASResultBuffer),
+				CD3DX12_RESOURCE_BARRIER::UAV(BLASScratchBuffer),
+			};
+			Gfx.CmdList->ResourceBarrier((uint32_t)eastl::size(Barriers), Barriers);
+		}
+		EndGPUScope(Gfx, ProfilerScope);
 	}
+}
+
+// Top Level Acceleration Structure (TLAS) over all mesh instances. HitGroupIndices[i] is the first hit group record of
+// instance i.
+static void CreateTLAS(FDemoRoot& Root, const eastl::vector<uint32_t>& HitGroupIndices, eastl::vector<ID3D12Resource*>& OutTempResources)
+{
+	CPU_ZONE("CreateTLAS");
+	FGraphicsContext& Gfx = Root.Gfx;
+	EA_ASSERT(HitGroupIndices.size() == Root.MeshInstances.size());
 
-	// Top Level Acceleration Structure (TLAS).
+	const eastl::vector<FMeshInstance>& Instances = Root.MeshInstances;
+	const uint32_t NumInstances = (uint32_t)Instances.size();
 	{
-		const uint32_t NumInstances = 1;
-		ID3D12Resource* UploadInstanceBuffer;
+		eastl::vector<D3D12_RAYTRACING_INSTANCE_DESC> InstanceDescs(NumInstances);
+		for (uint32_t Idx = 0; Idx < NumInstances; ++Idx)
 		{
-			D3D12_RAYTRACING_INSTANCE_DESC InstanceDesc = {};
-			InstanceDesc.InstanceID = 0;
-			InstanceDesc.InstanceContributionToHitGroupIndex = 0;
+			D3D12_RAYTRACING_INSTANCE_DESC& InstanceDesc = InstanceDescs[Idx];
+			InstanceDesc = {};
+			InstanceDesc.InstanceID = Instances[Idx].MeshIndex;
+			InstanceDesc.InstanceContributionToHitGroupIndex = HitGroupIndices[Idx];
 			InstanceDesc.InstanceMask = 1;
-			{
-				const float Identity[3][4] = { { 1.0f, 0.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 1.0f, 0.0f } };
-				memcpy(InstanceDesc.Transform, Identity, sizeof(Identity));
-			}
-			InstanceDesc.AccelerationStructure = Root.BLASResultBuffer->GetGPUVirtualAddress();
-
-			// Create UploadInstanceBuffer.
-			{
-				CD3DX12_RESOURCE_DESC Desc = CD3DX12_RESOURCE_DESC::Buffer(NumInstances * sizeof(D3D12_RAYTRACING_INSTANCE_DESC));
-				VHR(Gfx.Device->CreateCommittedResource(&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD), D3D12_HEAP_FLAG_NONE, &Desc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&UploadInstanceBuffer)));
-				OutTempResources.push_back(UploadInstanceBuffer);
-			}
-
-			void* Ptr;
-			VHR(UploadInstanceBuffer->Map(0, &CD3DX12_RANGE(0, 0), &Ptr));
-			memcpy(Ptr, &InstanceDesc, NumInstances * sizeof(D3D12_RAYTRACING_INSTANCE_DESC));
-			UploadInstanceBuffer->Unmap(0, nullptr);
+			XMStoreFloat3x4((XMFLOAT3X4*)InstanceDesc.Transform, XMLoadFloat4x4(&Instances[Idx].Transform));
+			InstanceDesc.AccelerationStructure = Root.BLASResultBuffers[Instances[Idx].MeshIndex]->GetGPUVirtualAddress();
 		}
 
 		// Create TLASInstanceBuffer.
 		{
 			CD3DX12_RESOURCE_DESC Desc = CD3DX12_RESOURCE_DESC::Buffer(NumInstances * sizeof(D3D12_RAYTRACING_INSTANCE_DESC));
-			VHR(Gfx.Device->CreateCommittedResource(&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT), D3D12_HEAP_FLAG_NONE, &Desc, D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS(&Root.TLASInstanceBuffer)));
+			Root.TLASInstanceBuffer = CreateGPUResource(Gfx, GPUMemory_AccelerationStructure, D3D12_HEAP_TYPE_DEFAULT, Desc, D3D12_RESOURCE_STATE_COPY_DEST);
 		}
 
-		Gfx.CmdList->CopyResource(Root.TLASInstanceBuffer, UploadInstanceBuffer);
-		Gfx.CmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(Root.TLASInstanceBuffer, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE));
+		FStagingChunk Staging;
+		CreateStagingChunk(Gfx, NumInstances * sizeof(D3D12_RAYTRACING_INSTANCE_DESC), Staging);
+		OutTempResources.push_back(Staging.Resource);
 
-		D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS TLASInputs = {};
-		TLASInputs.Type = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE_TOP_LEVEL;
-		TLASInputs.Flags = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_TRACE;
-		TLASInputs.NumDescs = 1;
-		TLASInputs.DescsLayout = D3D12_ELEMENTS_LAYOUT_ARRAY;
-		TLASInputs.InstanceDescs = Root.TLASInstanceBuffer->GetGPUVirtualAddress();
+		UploadBufferData(Gfx, Staging, Root.TLASInstanceBuffer, 0, InstanceDescs.data(), NumInstances * sizeof(D3D12_RAYTRACING_INSTANCE_DESC));
+	}
 
-		D3D12_RAYTRACING_ACCELERATION_STRUCTURE_PREBUILD_INFO TLASBuildInfo = {};
-		Gfx.Device->GetRaytracingAccelerationStructurePrebuildInfo(&TLASInputs, &TLASBuildInfo);
+	Gfx.CmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(Root.TLASInstanceBuffer, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE));
 
-		ID3D12Resource* TLASScratchBuffer;
-		{
-			const CD3DX12_RESOURCE_DESC Desc = CD3DX12_RESOURCE_DESC::Buffer(TLASBuildInfo.ScratchDataSizeInBytes, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
-			VHR(Gfx.Device->CreateCommittedResource(&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT), D3D12_HEAP_FLAG_NONE, &Desc, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, nullptr, IID_PPV_ARGS(&TLASScratchBuffer)));
-			OutTempResources.push_back(TLASScratchBuffer);
-		}
+	D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS TLASInputs = {};
+	TLASInputs.Type = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE_TOP_LEVEL;
+	TLASInputs.Flags = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_TRACE;
+	TLASInputs.NumDescs = NumInstances;
+	TLASInputs.DescsLayout = D3D12_ELEMENTS_LAYOUT_ARRAY;
+	TLASInputs.InstanceDescs = Root.TLASInstanceBuffer->GetGPUVirtualAddress();
 
-		// Create TLASResultBuffer.
-		{
-			const CD3DX12_RESOURCE_DESC Desc = CD3DX12_RESOURCE_DESC::Buffer(TLASBuildInfo.ResultDataMaxSizeInBytes, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
-			VHR(Gfx.Device->CreateCommittedResource(&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT), D3D12_HEAP_FLAG_NONE, &Desc, D3D12_RESOURCE_STATE_RAYTRACING_ACCELERATION_STRUCTURE, nullptr, IID_PPV_ARGS(&Root.TLASResultBuffer)));
-		}
+	D3D12_RAYTRACING_ACCELERATION_STRUCTURE_PREBUILD_INFO TLASBuildInfo = {};
+	Gfx.Device->GetRaytracingAccelerationStructurePrebuildInfo(&TLASInputs, &TLASBuildInfo);
+
+	ID3D12Resource* TLASScratchBuffer;
+	{
+		const CD3DX12_RESOURCE_DESC Desc = CD3DX12_RESOURCE_DESC::Buffer(TLASBuildInfo.ScratchDataSizeInBytes, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+		TLASScratchBuffer = CreateGPUResource(Gfx, GPUMemory_Scratch, D3D12_HEAP_TYPE_DEFAULT, Desc, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+		OutTempResources.push_back(TLASScratchBuffer);
+	}
+
+	// Create TLASResultBuffer.
+	{
+		const CD3DX12_RESOURCE_DESC Desc = CD3DX12_RESOURCE_DESC::Buffer(TLASBuildInfo.ResultDataMaxSizeInBytes, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+		Root.TLASResultBuffer = CreateGPUResource(Gfx, GPUMemory_AccelerationStructure, D3D12_HEAP_TYPE_DEFAULT, Desc, D3D12_RESOURCE_STATE_RAYTRACING_ACCELERATION_STRUCTURE);
+	}
+
+	D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC TLASBuildDesc = {};
+	TLASBuildDesc.Inputs = TLASInputs;
+	TLASBuildDesc.ScratchAccelerationStructureData = TLASScratchBuffer->GetGPUVirtualAddress();
+	TLASBuildDesc.DestAccelerationStructureData = Root.TLASResultBuffer->GetGPUVirtualAddress();
+
+	const uint32_t ProfilerScope = BeginGPUScope(Gfx, "TLAS build");
+	Gfx.CmdList->BuildRaytracingAccelerationStructure(&TLASBuildDesc, 0, nullptr);
+	EndGPUScope(Gfx, ProfilerScope);
+	Gfx.CmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::UAV(Root.TLASResultBuffer));
+}
+
+// One hit group record range per instance (kNumRayTypes records), instances of the same mesh end up sharing their
+// records. Returns first hit group record of each instance. Only records that changed are uploaded by the next
+// UpdateShaderTable.
+template<typename TAllocator>
+static void WriteRTShaderRecords(FDemoRoot& Root, const FRTPipeline& Pipeline, eastl::vector<uint32_t, TAllocator>& OutHitGroupIndices)
+{
+	ID3D12StateObjectProperties* Props;
+	VHR(Pipeline.RTPipeline->QueryInterface(IID_PPV_ARGS(&Props)));
+
+	FRayGenRecord RayGenRecord;
+	memcpy(RayGenRecord.Identifier, Props->GetShaderIdentifier(L"MainRGS"), D3D12_SHADER_IDENTIFIER_SIZE_IN_BYTES);
+	SetRayGenRecord(Root.ShaderTable, RayGenRecord);
 
-		D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC TLASBuildDesc = {};
-		TLASBuildDesc.Inputs = TLASInputs;
-		TLASBuildDesc.ScratchAccelerationStructureData = TLASScratchBuffer->GetGPUVirtualAddress();
-		TLASBuildDesc.DestAccelerationStructureData = Root.TLASResultBuffer->GetGPUVirtualAddress();
+	FMissRecord MissRecord;
+	memcpy(MissRecord.Identifier, Props->GetShaderIdentifier(L"MainMS"), D3D12_SHADER_IDENTIFIER_SIZE_IN_BYTES);
+	SetMissRecord(Root.ShaderTable, 0, MissRecord);
 
-		Gfx.CmdList->BuildRaytracingAccelerationStructure(&TLASBuildDesc, 0, nullptr);
-		Gfx.CmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::UAV(Root.TLASResultBuffer));
+	FHitGroupRecord HitGroupRecords[kNumRayTypes];
+	memcpy(HitGroupRecords[0].Identifier, Props->GetShaderIdentifier(L"HitGroup"), D3D12_SHADER_IDENTIFIER_SIZE_IN_BYTES);
+
+	ResetHitGroupRecords(Root.ShaderTable);
+	OutHitGroupIndices.clear();
+	for (const FMeshInstance& Instance : Root.MeshInstances)
+	{
+		const FStaticMesh& Mesh = Root.StaticMeshes[Instance.MeshIndex];
+		HitGroupRecords[0].Args = { Mesh.BaseVertex, Mesh.BaseIndex };
+		OutHitGroupIndices.push_back(AddHitGroupRecords(Root.ShaderTable, HitGroupRecords, kNumRayTypes));
 	}
+
+	SAFE_RELEASE(Props);
+}
+
+static void CreateRTShaderTable(FDemoRoot& Root, eastl::vector<uint32_t>& OutHitGroupIndices)
+{
+	FGraphicsContext& Gfx = Root.Gfx;
+
+	const uint32_t MaxHitGroupRecords = (uint32_t)Root.MeshInstances.size() * kNumRayTypes;
+	CreateShaderTable(Gfx, GetShaderTableLayout<FRayGenRecord, FMissRecord, FHitGroupRecord>(1, MaxHitGroupRecords), Root.ShaderTable);
+
+	WriteRTShaderRecords(Root, Root.RTPipelines[Root.RTPermutation], OutHitGroupIndices);
+	UpdateShaderTable(Gfx, Root.ShaderTable);
 }
 
 static bool Initialize(FDemoRoot& Root)
 {
+	CPU_ZONE("Initialize");
 	FGraphicsContext& Gfx = Root.Gfx;
+	bool bSupportsRayQuery;
 
 	{
 		D3D12_FEATURE_DATA_D3D12_OPTIONS5 Options5 = {};
@@ -370,58 +2267,98 @@ static bool Initialize(FDemoRoot& Root)
 			MessageBox(Gfx.Window, "This application requires GPU with raytracing support.", "Raytracing is not supported", MB_OK | MB_ICONERROR);
 			return false;
 		}
+		bSupportsRayQuery = Options5.RaytracingTier >= D3D12_RAYTRACING_TIER_1_1;
 	}
 
+	const double StartTime = GetTime();
+
 	eastl::vector<ID3D12Resource*> TempResources;
+	eastl::vector<FStartupTask> StartupTasks;
+
+	// Files present in the archive are read from it, everything else from loose files.
+	StartupTasks.push_back(BeginStartupTask("Caches"));
+	MountArchive("Data.pak");
+	CreateAssetCache("Data/Cache", Root.AssetCache);
+	CreatePipelineCache(Gfx, "Data/Cache/Pipelines.bin");
+	EndStartupTask(StartupTasks.back());
+
+	// Startup GPU work is one profiler frame, its results show up with the first frame.
+	CreateGPUProfiler(Gfx);
+	BeginGPUProfilerFrame(Gfx);
 
+	// RT pipelines compile in the background until the shader table needs them.
+	FRTPipelineBuild RTPipelineBuilds[RTPermutation_Count];
+	BeginRTPipelines(Gfx, RTPipelineBuilds);
+
+	StartupTasks.push_back(BeginStartupTask("UI"));
 	CreateUIContext(Gfx, 1, Root.UI, TempResources);
-	CreateStaticGeometry(Root, TempResources);
-	CreateRTPipelines(Gfx, Root.RTPipelines);
+	EndStartupTask(StartupTasks.back());
 
-	// Create Shader Table.
+	// Compute pipeline for the ray query path, goes through the pipeline cache.
+	StartupTasks.push_back(BeginStartupTask("Ray query pipeline"));
+	if (bSupportsRayQuery)
 	{
-		ID3D12Resource* TempShaderTable;
+		FFileView CSBytecode;
+		if (!OpenFileView("Data/Shaders/RayQuery.cs.cso", CSBytecode))
 		{
-			const auto Desc = CD3DX12_RESOURCE_DESC::Buffer(1024);
-			VHR(Gfx.Device->CreateCommittedResource(&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD), D3D12_HEAP_FLAG_NONE, &Desc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&TempShaderTable)));
-			TempResources.push_back(TempShaderTable);
-
-			VHR(Gfx.Device->CreateCommittedResource(&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT), D3D12_HEAP_FLAG_NONE, &Desc, D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS(&Root.ShaderTable)));
+			EA_ASSERT(0);
 		}
 
-		uint8_t* ShaderTableAddr;
-		VHR(TempShaderTable->Map(0, &CD3DX12_RANGE(0, 0), (void**)& ShaderTableAddr));
+		D3D12_COMPUTE_PIPELINE_STATE_DESC PSODesc = {};
+		PSODesc.CS = { CSBytecode.Data, CSBytecode.Size };
+
+		Root.RayQueryPipeline = CreateComputePipeline(Gfx, PSODesc);
+		VHR(Gfx.Device->CreateRootSignature(0, CSBytecode.Data, CSBytecode.Size, IID_PPV_ARGS(&Root.RayQuerySignature)));
+		CloseFileView(CSBytecode);
+	}
+	EndStartupTask(StartupTasks.back());
 
-		ID3D12StateObject* Pipeline = Root.RTPipelines[RTPSO_Raytracing].RTPipeline;
-		ID3D12StateObjectProperties* Props;
-		VHR(Pipeline->QueryInterface(IID_PPV_ARGS(&Props)));
+	StartupTasks.push_back(BeginStartupTask("Static geometry"));
+	CreateStaticGeometry(Root, "Data/Meshes/Monkey.ply", TempResources);
+	EndStartupTask(StartupTasks.back());
 
-		memcpy(ShaderTableAddr + 0, Props->GetShaderIdentifier(L"MainRGS"), D3D12_SHADER_IDENTIFIER_SIZE_IN_BYTES);
-		memcpy(ShaderTableAddr + 64, Props->GetShaderIdentifier(L"MainMS"), D3D12_SHADER_IDENTIFIER_SIZE_IN_BYTES);
-		memcpy(ShaderTableAddr + 128, Props->GetShaderIdentifier(L"HitGroup"), D3D12_SHADER_IDENTIFIER_SIZE_IN_BYTES);
+	{
+		FStartupTask WaitTask = BeginStartupTask("Wait for RT pipelines");
+		EndRTPipelines(RTPipelineBuilds, Root.RTPipelines, StartupTasks);
+		EndStartupTask(WaitTask);
+		StartupTasks.push_back(WaitTask);
+	}
 
-		SAFE_RELEASE(Props);
-		TempShaderTable->Unmap(0, nullptr);
+	// Shader table needs pipelines, TLAS needs hit group indices from the shader table.
+	{
+		Root.RTSettings = { /*bLambertShading*/false, /*bCullBackFaces*/true, /*bNeedsFloatPayload*/false };
+		Root.RTPermutation = SelectRTPermutation(Root.RTSettings);
 
-		Gfx.CmdList->CopyResource(Root.ShaderTable, TempShaderTable);
-		Gfx.CmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(Root.ShaderTable, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE));
+		eastl::vector<uint32_t> HitGroupIndices;
+		CreateRTShaderTable(Root, HitGroupIndices);
+		CreateTLAS(Root, HitGroupIndices, TempResources);
 	}
 
 	// Create output texture for raytracing stage.
 	{
 		auto Desc = CD3DX12_RESOURCE_DESC::Tex2D(DXGI_FORMAT_R8G8B8A8_UNORM, Gfx.Resolution[0], Gfx.Resolution[1], 1, 1);
 		Desc.Flags = D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
-		VHR(Gfx.Device->CreateCommittedResource(&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT), D3D12_HEAP_FLAG_NONE, &Desc, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, nullptr, IID_PPV_ARGS(&Root.RTOutput)));
+		Root.RTOutput = CreateGPUResource(Gfx, GPUMemory_RenderTarget, D3D12_HEAP_TYPE_DEFAULT, Desc, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
 
 		Root.RTOutputUAV = AllocateDescriptors(Gfx, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, 1);
 		Gfx.Device->CreateUnorderedAccessView(Root.RTOutput, nullptr, nullptr, Root.RTOutputUAV);
 	}
 
+	CreateRayCounters(Gfx, Root.RayCounters);
+	CreateDynamicResolution(Gfx, Root.RTOutput, Root.DynamicResolution);
+	CreateTraceHistory(Gfx, Root.RTOutput, Root.TraceHistory);
+	CreateInterleavedTrace(Gfx, Root.RTOutput, Root.Interleaved);
+	CreateDenoiser(Gfx, Root.RTOutput, Root.Denoiser);
+	CreateTemporalAccumulation(Gfx, Root.RTOutput, Root.Temporal);
+	CreateGBufferCapture(Gfx, Root.RTOutput, Root.TraceHistory, Root.GBufferCapture);
+
 	// Execute "data upload" and "data generation" GPU commands, create mipmaps etc. Destroy temp resources when GPU is done.
 	{
-		Root.Gfx.CmdList->Close();
-		Root.Gfx.CmdQueue->ExecuteCommandLists(1, CommandListCast(&Root.Gfx.CmdList));
+		StartupTasks.push_back(BeginStartupTask("GPU upload"));
+		EndGPUProfilerFrame(Gfx);
+		ExecuteCommandList(Root.Gfx);
 		WaitForGPU(Root.Gfx);
+		EndStartupTask(StartupTasks.back());
 
 		for (ID3D12Resource* Resource : TempResources)
 		{
@@ -429,6 +2366,17 @@ static bool Initialize(FDemoRoot& Root)
 		}
 	}
 
+	// Report startup time and asset cache usage (compare cold and warm runs), timeline of startup tasks goes to a file.
+	{
+		WriteStartupTimeline(StartupTasks, StartTime, "StartupTimeline.csv");
+
+		const FAssetCache& Cache = Root.AssetCache;
+		const FPipelineCache& Pipelines = Gfx.PipelineCache;
+		char Text[512];
+		EA::StdC::Snprintf(Text, sizeof(Text), "Startup: %.1f ms (%s), asset cache: %u hits, %u misses, %llu bytes read, %llu bytes written, pipeline cache: %.1f ms open, %u hits in %.1f ms, %u misses in %.1f ms\n", (GetTime() - StartTime) * 1000.0, IsArchiveMounted() ? "archive" : "loose files", Cache.NumHits, Cache.NumMisses, (unsigned long long)Cache.NumBytesRead, (unsigned long long)Cache.NumBytesWritten, Pipelines.OpenMs, Pipelines.NumHits, Pipelines.HitMs, Pipelines.NumMisses, Pipelines.MissMs);
+		OutputDebugString(Text);
+	}
+
 	Root.CameraPosition = XMFLOAT3(0.0f, 0.0f, 3.0f);
 	Root.CameraFocusPosition = XMFLOAT3(0.0f, 0.0f, 0.0f);
 
@@ -442,14 +2390,31 @@ static void Shutdown(FDemoRoot& Root)
 		SAFE_RELEASE(Pipeline.RTPipeline);
 		SAFE_RELEASE(Pipeline.RTGlobalSignature);
 	}
+	SAFE_RELEASE(Root.RayQueryPipeline);
+	SAFE_RELEASE(Root.RayQuerySignature);
 	SAFE_RELEASE(Root.VertexBuffer);
 	SAFE_RELEASE(Root.IndexBuffer);
-	SAFE_RELEASE(Root.BLASResultBuffer);
+	SAFE_RELEASE(Root.MeshInfoBuffer);
+	for (ID3D12Resource* Resource : Root.BLASResultBuffers)
+	{
+		SAFE_RELEASE(Resource);
+	}
 	SAFE_RELEASE(Root.TLASInstanceBuffer);
 	SAFE_RELEASE(Root.TLASResultBuffer);
-	SAFE_RELEASE(Root.ShaderTable);
+	DestroyShaderTable(Root.ShaderTable);
 	SAFE_RELEASE(Root.RTOutput);
+	DestroyRayCounters(Root.RayCounters);
+	DestroyDynamicResolution(Root.DynamicResolution);
+	DestroyTraceHistory(Root.TraceHistory);
+	DestroyInterleavedTrace(Root.Interleaved);
+	DestroyDenoiser(Root.Denoiser);
+	DestroyTemporalAccumulation(Root.Temporal);
+	DestroyGBufferCapture(Root.GBufferCapture);
 	DestroyUIContext(Root.UI);
+	DestroyGPUProfiler(Root.Gfx);
+	DestroyPipelineCache(Root.Gfx);
+	UnmountArchive();
+	DestroyCPUProfiler();
 }
 
 static int32_t Run(FDemoRoot& Root)
@@ -457,9 +2422,21 @@ static int32_t Run(FDemoRoot& Root)
 	EA::StdC::Init();
 	ImGui::CreateContext();
 
+	SetCPUProfilerThreadName("Main");
+	{
+		char Text[128];
+		EA::StdC::Snprintf(Text, sizeof(Text), "CPU profiler: %.1f ns per zone\n", MeasureCPUZoneOverhead());
+		OutputDebugString(Text);
+	}
+
 	HWND Window = CreateSimpleWindow("DXRTest", 1920, 1080);
 	CreateGraphicsContext(Window, /*bShouldCreateDepthBuffer*/false, Root.Gfx);
+	if (Root.BenchmarkMode.bUsesNullCommandList)
+	{
+		UseNullCommandList(Root.Gfx);
+	}
 
+	int32_t ExitCode = 0;
 	if (Initialize(Root))
 	{
 		for (;;)
@@ -470,11 +2447,13 @@ static int32_t Run(FDemoRoot& Root)
 				DispatchMessage(&Message);
 				if (Message.message == WM_QUIT)
 				{
+					ExitCode = (int32_t)Message.wParam;
 					break;
 				}
 			}
 			else
 			{
+				CPU_ZONE("Frame");
 				Update(Root);
 				Draw(Root);
 				PresentFrame(Root.Gfx, 0);
@@ -486,14 +2465,49 @@ static int32_t Run(FDemoRoot& Root)
 	Shutdown(Root);
 	DestroyGraphicsContext(Root.Gfx);
 	ImGui::DestroyContext();
+
+	// Whatever is still live here is a leak or owned by Root, which goes away with WinMain.
+	WriteAllocationReport("AllocationReport.json");
 	EA::StdC::Shutdown();
 
-	return 0;
+	return ExitCode;
 }
 
-int32_t CALLBACK WinMain(_In_ HINSTANCE, _In_opt_ HINSTANCE, _In_ LPSTR, _In_ int32_t)
+int32_t CALLBACK WinMain(_In_ HINSTANCE, _In_opt_ HINSTANCE, _In_ LPSTR CmdLine, _In_ int32_t)
 {
 	SetProcessDPIAware();
 	FDemoRoot Root = {};
+	Root.BenchmarkMode.bIsEnabled = strstr(CmdLine, "--benchmark") != nullptr;
+	Root.BenchmarkMode.bUsesNullCommandList = Root.BenchmarkMode.bIsEnabled && strstr(CmdLine, "--null-gpu") != nullptr;
+	Root.RayCounters.bIsEnabled = strstr(CmdLine, "--ray-counters") != nullptr;
+	Root.Temporal.bIsEnabled = strstr(CmdLine, "--temporal") != nullptr;
+	if (const char* Arg = strstr(CmdLine, "--interleave="))
+	{
+		const uint32_t Interleave = (uint32_t)EA::StdC::AtoU32(Arg + strlen("--interleave="));
+		Root.Interleaved.Mode = Interleave >= 4 ? 2 : Interleave >= 2 ? 1 : 0;
+	}
+	if (const char* Arg = strstr(CmdLine, "--denoise"))
+	{
+		Root.Denoiser.bIsEnabled = true;
+		if (Arg[strlen("--denoise")] == '=')
+		{
+			Root.Denoiser.NumIterations = eastl::min(eastl::max((uint32_t)EA::StdC::AtoU32(Arg + strlen("--denoise=")), 1u), kDenoiseMaxIterations);
+		}
+	}
+	if (const char* Arg = strstr(CmdLine, "--upscale="))
+	{
+		Root.DynamicResolution.UpscaleFactor = FindUpscaleFactor((float)EA::StdC::AtofEnglish(Arg + strlen("--upscale=")));
+	}
+	// Captures need executed command lists, the file name ends at the next space.
+	if (const char* Arg = strstr(CmdLine, "--dump-gbuffer="))
+	{
+		if (Root.BenchmarkMode.bIsEnabled && !Root.BenchmarkMode.bUsesNullCommandList)
+		{
+			Arg += strlen("--dump-gbuffer=");
+			const size_t Length = eastl::min(strcspn(Arg, " "), sizeof(Root.GBufferCapture.FileName) - 1);
+			memcpy(Root.GBufferCapture.FileName, Arg, Length);
+		}
+	}
+	Root.BenchmarkMode.ReportFileName = "BenchmarkReport.json";
 	return Run(Root);
 }
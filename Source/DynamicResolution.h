@@ -0,0 +1,25 @@
+#pragma once
+
+#include <math.h>
+#include "EASTL/algorithm.h"
+
+// Controller of the dynamic trace resolution (FDynamicResolution in DXRTest.cpp), called once per frame with the last
+// "Frame" GPU scope time.
+static const float kDynamicResolutionMinScale = 0.5f;
+static const float kDynamicResolutionDeadband = 0.05f; // Relative error of the frame time that is left alone.
+static const float kDynamicResolutionGain = 0.25f; // Part of the correction taken per frame, GPU times are two frames old.
+static const float kDynamicResolutionMaxStep = 0.05f;
+
+// GPU time is close to proportional to the number of rays, so the scale that meets the target is
+// Scale * sqrt(Target / Measured). Only part of the way is taken each frame (the measurement lags behind) and small
+// errors are ignored so that the resolution does not flicker.
+inline float GetDynamicResolutionScale(float Scale, float TargetMs, float MeasuredMs)
+{
+	if (MeasuredMs <= 0.0f || fabsf(MeasuredMs - TargetMs) <= kDynamicResolutionDeadband * TargetMs)
+	{
+		return Scale;
+	}
+	const float IdealScale = Scale * sqrtf(TargetMs / MeasuredMs);
+	const float Step = eastl::min(eastl::max(kDynamicResolutionGain * (IdealScale - Scale), -kDynamicResolutionMaxStep), kDynamicResolutionMaxStep);
+	return eastl::min(eastl::max(Scale + Step, kDynamicResolutionMinScale), 1.0f);
+}
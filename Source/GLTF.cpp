@@ -0,0 +1,554 @@
+#include "GLTF.h"
+#include <string.h>
+#include "EASTL/algorithm.h"
+#include "EAStdC/EAString.h"
+
+enum EJSONType
+{
+	JSON_Null,
+	JSON_Bool,
+	JSON_Number,
+	JSON_String,
+	JSON_Array,
+	JSON_Object,
+};
+
+// Flat token list produced by a single pass over the JSON text. Containers are followed by their children, Next is the
+// index of the token after the whole subtree so siblings can be walked without recursion. Object children alternate
+// between key (string) and value tokens; NumChildren counts members, not tokens.
+struct FJSONToken
+{
+	uint32_t Type;
+	uint32_t Start;
+	uint32_t Length;
+	uint32_t NumChildren;
+	uint32_t Next;
+};
+
+struct FJSONDocument
+{
+	const char* Text;
+	uint32_t Length;
+	eastl::vector<FJSONToken> Tokens;
+};
+
+static void SkipJSONWhitespace(const FJSONDocument& Doc, uint32_t& Pos)
+{
+	while (Pos < Doc.Length && (Doc.Text[Pos] == ' ' || Doc.Text[Pos] == '\t' || Doc.Text[Pos] == '\n' || Doc.Text[Pos] == '\r'))
+	{
+		++Pos;
+	}
+}
+
+static bool ParseJSONValue(FJSONDocument& Doc, uint32_t& Pos, uint32_t Depth)
+{
+	SkipJSONWhitespace(Doc, Pos);
+	if (Depth > 64 || Pos >= Doc.Length)
+	{
+		return false;
+	}
+
+	const uint32_t TokenIdx = (uint32_t)Doc.Tokens.size();
+	Doc.Tokens.push_back();
+
+	FJSONToken Token = {};
+	Token.Start = Pos;
+
+	const char C = Doc.Text[Pos];
+	if (C == '{' || C == '[')
+	{
+		const bool bIsObject = C == '{';
+		const char Terminator = bIsObject ? '}' : ']';
+		++Pos;
+
+		SkipJSONWhitespace(Doc, Pos);
+		if (Pos < Doc.Length && Doc.Text[Pos] == Terminator)
+		{
+			++Pos;
+		}
+		else
+		{
+			for (;;)
+			{
+				if (bIsObject)
+				{
+					SkipJSONWhitespace(Doc, Pos);
+					if (Pos >= Doc.Length || Doc.Text[Pos] != '"' || !ParseJSONValue(Doc, Pos, Depth + 1))
+					{
+						return false;
+					}
+					SkipJSONWhitespace(Doc, Pos);
+					if (Pos >= Doc.Length || Doc.Text[Pos] != ':')
+					{
+						return false;
+					}
+					++Pos;
+				}
+				if (!ParseJSONValue(Doc, Pos, Depth + 1))
+				{
+					return false;
+				}
+				Token.NumChildren++;
+
+				SkipJSONWhitespace(Doc, Pos);
+				if (Pos >= Doc.Length)
+				{
+					return false;
+				}
+				else if (Doc.Text[Pos] == ',')
+				{
+					++Pos;
+				}
+				else if (Doc.Text[Pos] == Terminator)
+				{
+					++Pos;
+					break;
+				}
+				else
+				{
+					return false;
+				}
+			}
+		}
+		Token.Type = bIsObject ? JSON_Object : JSON_Array;
+		Token.Length = Pos - Token.Start;
+	}
+	else if (C == '"')
+	{
+		Token.Type = JSON_String;
+		Token.Start = ++Pos;
+		while (Pos < Doc.Length && Doc.Text[Pos] != '"')
+		{
+			Pos += Doc.Text[Pos] == '\\' ? 2 : 1;
+		}
+		if (Pos >= Doc.Length)
+		{
+			return false;
+		}
+		Token.Length = Pos++ - Token.Start;
+	}
+	else if (C == 't' || C == 'f' || C == 'n')
+	{
+		const char* Literal = C == 't' ? "true" : (C == 'f' ? "false" : "null");
+		const uint32_t LiteralLength = (uint32_t)strlen(Literal);
+		if (Doc.Length - Pos < LiteralLength || memcmp(Doc.Text + Pos, Literal, LiteralLength) != 0)
+		{
+			return false;
+		}
+		Token.Type = C == 'n' ? JSON_Null : JSON_Bool;
+		Token.Length = LiteralLength;
+		Pos += LiteralLength;
+	}
+	else
+	{
+		while (Pos < Doc.Length && strchr("+-0123456789.eE", Doc.Text[Pos]))
+		{
+			++Pos;
+		}
+		if (Pos == Token.Start)
+		{
+			return false;
+		}
+		Token.Type = JSON_Number;
+		Token.Length = Pos - Token.Start;
+	}
+
+	Token.Next = (uint32_t)Doc.Tokens.size();
+	Doc.Tokens[TokenIdx] = Token;
+	return true;
+}
+
+static uint32_t FindJSONMember(const FJSONDocument& Doc, uint32_t Object, const char* Key)
+{
+	if (Object >= Doc.Tokens.size() || Doc.Tokens[Object].Type != JSON_Object)
+	{
+		return UINT32_MAX;
+	}
+
+	const size_t KeyLength = strlen(Key);
+	uint32_t KeyIdx = Object + 1;
+	for (uint32_t Idx = 0; Idx < Doc.Tokens[Object].NumChildren; ++Idx)
+	{
+		const FJSONToken& KeyToken = Doc.Tokens[KeyIdx];
+		if (KeyToken.Length == KeyLength && memcmp(Doc.Text + KeyToken.Start, Key, KeyLength) == 0)
+		{
+			return KeyIdx + 1;
+		}
+		KeyIdx = Doc.Tokens[KeyIdx + 1].Next;
+	}
+	return UINT32_MAX;
+}
+
+static uint32_t GetJSONArraySize(const FJSONDocument& Doc, uint32_t Array)
+{
+	if (Array >= Doc.Tokens.size() || Doc.Tokens[Array].Type != JSON_Array)
+	{
+		return 0;
+	}
+	return Doc.Tokens[Array].NumChildren;
+}
+
+// Tokens of all elements of Array, so that arrays indexed by the file (nodes, meshes, accessors) are walked once instead
+// of once per lookup.
+static void GetJSONElements(const FJSONDocument& Doc, uint32_t Array, eastl::vector<uint32_t>& OutElements)
+{
+	OutElements.resize(GetJSONArraySize(Doc, Array));
+	uint32_t ElementIdx = Array + 1;
+	for (uint32_t& Element : OutElements)
+	{
+		Element = ElementIdx;
+		ElementIdx = Doc.Tokens[ElementIdx].Next;
+	}
+}
+
+static uint32_t GetJSONElement(const eastl::vector<uint32_t>& Elements, uint32_t Index)
+{
+	return Index < Elements.size() ? Elements[Index] : UINT32_MAX;
+}
+
+static double GetJSONNumber(const FJSONDocument& Doc, uint32_t Token, double Default)
+{
+	if (Token >= Doc.Tokens.size() || Doc.Tokens[Token].Type != JSON_Number)
+	{
+		return Default;
+	}
+	// Number is always followed by a delimiter inside the root object so Strtod stops before the end of the text.
+	return EA::StdC::Strtod(Doc.Text + Doc.Tokens[Token].Start, nullptr);
+}
+
+// Non-negative integer below UINT32_MAX, Default when the token is missing and UINT32_MAX when it is out of range or
+// not an integer, so every count, offset and index read from the file can be validated with a single compare.
+static uint32_t GetJSONUInt(const FJSONDocument& Doc, uint32_t Token, uint32_t Default)
+{
+	const double Value = GetJSONNumber(Doc, Token, (double)Default);
+	return (Value >= 0.0 && Value < (double)UINT32_MAX && Value == (double)(uint32_t)Value) ? (uint32_t)Value : UINT32_MAX;
+}
+
+static uint32_t GetJSONIndex(const FJSONDocument& Doc, uint32_t Token)
+{
+	return GetJSONUInt(Doc, Token, UINT32_MAX);
+}
+
+static bool JSONStringEquals(const FJSONDocument& Doc, uint32_t Token, const char* String)
+{
+	if (Token >= Doc.Tokens.size() || Doc.Tokens[Token].Type != JSON_String)
+	{
+		return false;
+	}
+	const FJSONToken& T = Doc.Tokens[Token];
+	return T.Length == strlen(String) && memcmp(Doc.Text + T.Start, String, T.Length) == 0;
+}
+
+struct FGLBBufferView
+{
+	const uint8_t* Data;
+	uint32_t Length;
+	uint32_t Stride;
+};
+
+static bool ParseGLBAccessor(const FJSONDocument& Doc, const eastl::vector<FGLBBufferView>& Views, const eastl::vector<uint32_t>& Accessors, uint32_t AccessorIdx, FGLBAccessor& OutAccessor)
+{
+	const uint32_t Accessor = GetJSONElement(Accessors, AccessorIdx);
+	const uint32_t ViewIdx = GetJSONIndex(Doc, FindJSONMember(Doc, Accessor, "bufferView"));
+	if (Accessor == UINT32_MAX || ViewIdx >= Views.size())
+	{
+		return false; // Sparse accessors and accessors without a buffer view are not supported.
+	}
+
+	const uint32_t Type = FindJSONMember(Doc, Accessor, "type");
+	OutAccessor.ComponentType = GetJSONUInt(Doc, FindJSONMember(Doc, Accessor, "componentType"), 0);
+	OutAccessor.Count = GetJSONUInt(Doc, FindJSONMember(Doc, Accessor, "count"), 0);
+	OutAccessor.NumComponents = JSONStringEquals(Doc, Type, "SCALAR") ? 1 : (JSONStringEquals(Doc, Type, "VEC2") ? 2 : (JSONStringEquals(Doc, Type, "VEC3") ? 3 : (JSONStringEquals(Doc, Type, "VEC4") ? 4 : 0)));
+
+	const FGLBBufferView& View = Views[ViewIdx];
+	const uint32_t ComponentSize = GetGLBComponentSize(OutAccessor.ComponentType);
+	const uint32_t ElementSize = ComponentSize * OutAccessor.NumComponents;
+	const uint32_t Offset = GetJSONUInt(Doc, FindJSONMember(Doc, Accessor, "byteOffset"), 0);
+
+	OutAccessor.Stride = View.Stride ? View.Stride : ElementSize;
+
+	if (ElementSize == 0 || OutAccessor.Count == 0 || OutAccessor.Count == UINT32_MAX || Offset == UINT32_MAX || OutAccessor.Stride < ElementSize || (Offset % ComponentSize) != 0)
+	{
+		return false;
+	}
+	if (Offset + (uint64_t)OutAccessor.Stride * (OutAccessor.Count - 1) + ElementSize > View.Length)
+	{
+		return false;
+	}
+
+	OutAccessor.Data = View.Data + Offset;
+	return true;
+}
+
+static uint32_t GetGLBMaxIndex(const FGLBAccessor& Indices)
+{
+	uint32_t MaxIndex = 0;
+	for (uint32_t Idx = 0; Idx < Indices.Count; ++Idx)
+	{
+		const uint32_t Index = Indices.ComponentType == GLBComponent_UnsignedInt ? ((const uint32_t*)Indices.Data)[Idx] :
+			(Indices.ComponentType == GLBComponent_UnsignedShort ? ((const uint16_t*)Indices.Data)[Idx] : Indices.Data[Idx]);
+		MaxIndex = eastl::max(MaxIndex, Index);
+	}
+	return MaxIndex;
+}
+
+static bool ParseGLBContents(const uint8_t* Data, uint64_t Size, FGLBFile& File)
+{
+	auto ReadU32 = [Data](uint64_t Offset) -> uint32_t
+	{
+		uint32_t Value;
+		memcpy(&Value, Data + Offset, sizeof(Value));
+		return Value;
+	};
+
+	// Header (magic, version, length) followed by JSON chunk and optional BIN chunk.
+	if (!Data || Size < 20 || ReadU32(0) != 0x46546C67 || ReadU32(4) != 2 || ReadU32(8) > Size)
+	{
+		return false;
+	}
+	const uint32_t JSONLength = ReadU32(12);
+	if (ReadU32(16) != 0x4E4F534A || 20ull + JSONLength > Size)
+	{
+		return false;
+	}
+
+	const uint8_t* BinData = nullptr;
+	uint32_t BinLength = 0;
+	{
+		const uint64_t BinChunk = 20ull + ((JSONLength + 3) & ~3u);
+		if (BinChunk + 8 <= Size && ReadU32(BinChunk + 4) == 0x004E4942)
+		{
+			BinLength = ReadU32(BinChunk);
+			BinData = Data + BinChunk + 8;
+			if (BinChunk + 8 + BinLength > Size)
+			{
+				return false;
+			}
+		}
+	}
+
+	FJSONDocument Doc;
+	Doc.Text = (const char*)Data + 20;
+	Doc.Length = JSONLength;
+	{
+		uint32_t Pos = 0;
+		if (!ParseJSONValue(Doc, Pos, 0) || Doc.Tokens[0].Type != JSON_Object)
+		{
+			return false;
+		}
+	}
+
+	eastl::vector<uint32_t> Elements; // Scratch for the small arrays.
+
+	eastl::vector<FGLBBufferView> Views;
+	{
+		GetJSONElements(Doc, FindJSONMember(Doc, 0, "bufferViews"), Elements);
+		Views.resize(Elements.size());
+
+		for (uint32_t Idx = 0; Idx < Views.size(); ++Idx)
+		{
+			const uint32_t View = Elements[Idx];
+			const uint32_t Offset = GetJSONUInt(Doc, FindJSONMember(Doc, View, "byteOffset"), 0);
+			const uint32_t Length = GetJSONUInt(Doc, FindJSONMember(Doc, View, "byteLength"), 0);
+			const uint32_t Stride = GetJSONUInt(Doc, FindJSONMember(Doc, View, "byteStride"), 0);
+
+			// Only the embedded BIN chunk (buffer 0) is supported. Strides are 4 to 252 bytes and 4-byte aligned.
+			if (GetJSONIndex(Doc, FindJSONMember(Doc, View, "buffer")) != 0 || !BinData || Offset == UINT32_MAX || Length == UINT32_MAX || (uint64_t)Offset + Length > BinLength)
+			{
+				return false;
+			}
+			if (Stride != 0 && (Stride < 4 || Stride > 252 || (Stride % 4) != 0))
+			{
+				return false;
+			}
+			Views[Idx].Data = BinData + Offset;
+			Views[Idx].Length = Length;
+			Views[Idx].Stride = Stride;
+		}
+	}
+
+	// Meshes. Only indexed triangle lists are loaded, other primitives are skipped.
+	{
+		eastl::vector<uint32_t> Accessors;
+		eastl::vector<uint32_t> Meshes;
+		GetJSONElements(Doc, FindJSONMember(Doc, 0, "accessors"), Accessors);
+		GetJSONElements(Doc, FindJSONMember(Doc, 0, "meshes"), Meshes);
+
+		for (uint32_t Mesh : Meshes)
+		{
+			File.MeshFirstPrimitive.push_back((uint32_t)File.Primitives.size());
+
+			GetJSONElements(Doc, FindJSONMember(Doc, Mesh, "primitives"), Elements);
+			for (uint32_t Primitive : Elements)
+			{
+				const uint32_t Attributes = FindJSONMember(Doc, Primitive, "attributes");
+				const uint32_t Positions = FindJSONMember(Doc, Attributes, "POSITION");
+				const uint32_t Normals = FindJSONMember(Doc, Attributes, "NORMAL");
+				const uint32_t Indices = FindJSONMember(Doc, Primitive, "indices");
+
+				if (GetJSONNumber(Doc, FindJSONMember(Doc, Primitive, "mode"), 4.0) != 4.0 || Positions == UINT32_MAX || Indices == UINT32_MAX)
+				{
+					continue;
+				}
+
+				FGLBPrimitive P = {};
+				if (!ParseGLBAccessor(Doc, Views, Accessors, GetJSONIndex(Doc, Positions), P.Positions) ||
+					!ParseGLBAccessor(Doc, Views, Accessors, GetJSONIndex(Doc, Indices), P.Indices))
+				{
+					return false;
+				}
+				if (Normals != UINT32_MAX && !ParseGLBAccessor(Doc, Views, Accessors, GetJSONIndex(Doc, Normals), P.Normals))
+				{
+					return false;
+				}
+
+				if (P.Positions.ComponentType != GLBComponent_Float || P.Positions.NumComponents != 3)
+				{
+					return false;
+				}
+				if (P.Normals.Data && (P.Normals.ComponentType != GLBComponent_Float || P.Normals.NumComponents != 3 || P.Normals.Count != P.Positions.Count))
+				{
+					return false;
+				}
+				if (P.Indices.NumComponents != 1 || P.Indices.ComponentType == GLBComponent_Float || (P.Indices.Count % 3) != 0 || P.Indices.Stride != GetGLBComponentSize(P.Indices.ComponentType))
+				{
+					return false;
+				}
+				if (GetGLBMaxIndex(P.Indices) >= P.Positions.Count)
+				{
+					return false; // Indices go to the GPU as is, out of range ones would read other meshes' vertices.
+				}
+				File.Primitives.push_back(P);
+			}
+		}
+		File.MeshFirstPrimitive.push_back((uint32_t)File.Primitives.size());
+	}
+
+	// Scene graph. Walk from the root nodes and accumulate world transforms for every node that references a mesh.
+	{
+		eastl::vector<uint32_t> Nodes;
+		GetJSONElements(Doc, FindJSONMember(Doc, 0, "nodes"), Nodes);
+		const uint32_t NumNodes = (uint32_t)Nodes.size();
+		const uint32_t NumMeshes = (uint32_t)File.MeshFirstPrimitive.size() - 1;
+
+		eastl::vector<eastl::pair<uint32_t, XMFLOAT4X4>> Stack;
+		{
+			XMFLOAT4X4 Identity;
+			XMStoreFloat4x4(&Identity, XMMatrixIdentity());
+
+			GetJSONElements(Doc, FindJSONMember(Doc, 0, "scenes"), Elements);
+			if (!Elements.empty())
+			{
+				const uint32_t Scene = GetJSONElement(Elements, GetJSONUInt(Doc, FindJSONMember(Doc, 0, "scene"), 0));
+				GetJSONElements(Doc, FindJSONMember(Doc, Scene, "nodes"), Elements);
+				for (uint32_t RootNode : Elements)
+				{
+					Stack.push_back(eastl::make_pair(GetJSONIndex(Doc, RootNode), Identity));
+				}
+			}
+			else
+			{
+				// No scene, every node that is not a child of another node is a root.
+				eastl::vector<bool> bIsChild(NumNodes, false);
+				for (uint32_t Node : Nodes)
+				{
+					GetJSONElements(Doc, FindJSONMember(Doc, Node, "children"), Elements);
+					for (uint32_t ChildToken : Elements)
+					{
+						const uint32_t Child = GetJSONIndex(Doc, ChildToken);
+						if (Child < NumNodes)
+						{
+							bIsChild[Child] = true;
+						}
+					}
+				}
+				for (uint32_t NodeIdx = 0; NodeIdx < NumNodes; ++NodeIdx)
+				{
+					if (!bIsChild[NodeIdx])
+					{
+						Stack.push_back(eastl::make_pair(NodeIdx, Identity));
+					}
+				}
+			}
+		}
+
+		uint32_t NumVisited = 0;
+		while (!Stack.empty())
+		{
+			const uint32_t NodeIdx = Stack.back().first;
+			const XMMATRIX ParentTransform = XMLoadFloat4x4(&Stack.back().second);
+			Stack.pop_back();
+
+			// Valid glTF node hierarchy is a forest, visiting more nodes than exist means there is a cycle.
+			if (NodeIdx >= NumNodes || ++NumVisited > NumNodes)
+			{
+				return false;
+			}
+			const uint32_t Node = Nodes[NodeIdx];
+
+			XMMATRIX LocalTransform;
+			GetJSONElements(Doc, FindJSONMember(Doc, Node, "matrix"), Elements);
+			if (Elements.size() == 16)
+			{
+				// glTF matrices are column-major with column vectors which is the same memory layout as row-major
+				// matrix with row vectors.
+				XMFLOAT4X4 M;
+				for (uint32_t Idx = 0; Idx < 16; ++Idx)
+				{
+					M.m[Idx / 4][Idx % 4] = (float)GetJSONNumber(Doc, Elements[Idx], 0.0);
+				}
+				LocalTransform = XMLoadFloat4x4(&M);
+			}
+			else
+			{
+				float T[3] = { 0.0f, 0.0f, 0.0f };
+				float R[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+				float S[3] = { 1.0f, 1.0f, 1.0f };
+				GetJSONElements(Doc, FindJSONMember(Doc, Node, "translation"), Elements);
+				for (uint32_t Idx = 0; Idx < 3; ++Idx)
+				{
+					T[Idx] = (float)GetJSONNumber(Doc, GetJSONElement(Elements, Idx), T[Idx]);
+				}
+				GetJSONElements(Doc, FindJSONMember(Doc, Node, "rotation"), Elements);
+				for (uint32_t Idx = 0; Idx < 4; ++Idx)
+				{
+					R[Idx] = (float)GetJSONNumber(Doc, GetJSONElement(Elements, Idx), R[Idx]);
+				}
+				GetJSONElements(Doc, FindJSONMember(Doc, Node, "scale"), Elements);
+				for (uint32_t Idx = 0; Idx < 3; ++Idx)
+				{
+					S[Idx] = (float)GetJSONNumber(Doc, GetJSONElement(Elements, Idx), S[Idx]);
+				}
+				LocalTransform = XMMatrixScaling(S[0], S[1], S[2]) * XMMatrixRotationQuaternion(XMVectorSet(R[0], R[1], R[2], R[3])) * XMMatrixTranslation(T[0], T[1], T[2]);
+			}
+
+			XMFLOAT4X4 WorldTransform;
+			XMStoreFloat4x4(&WorldTransform, LocalTransform * ParentTransform);
+
+			const uint32_t MeshIdx = GetJSONIndex(Doc, FindJSONMember(Doc, Node, "mesh"));
+			if (MeshIdx < NumMeshes)
+			{
+				File.Instances.push_back({ MeshIdx, WorldTransform });
+			}
+
+			GetJSONElements(Doc, FindJSONMember(Doc, Node, "children"), Elements);
+			for (uint32_t Child : Elements)
+			{
+				Stack.push_back(eastl::make_pair(GetJSONIndex(Doc, Child), WorldTransform));
+			}
+		}
+	}
+
+	return true;
+}
+
+bool ParseGLB(const uint8_t* Data, uint64_t Size, FGLBFile& OutFile)
+{
+	OutFile = {};
+	if (!ParseGLBContents(Data, Size, OutFile))
+	{
+		OutFile = {};
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <stdint.h>
+#include "EASTL/vector.h"
+#include "DirectXMath/DirectXMath.h"
+
+// Binary glTF 2.0 (.glb) reader. ParseGLB works on the file contents in memory (the application maps the file with
+// OpenFileView) and all accessors point straight into the BIN chunk, nothing is copied or converted at load time. It
+// needs neither the device nor Win32, the headless tests (Tests/) build it.
+
+struct FGLBAccessor
+{
+	const uint8_t* Data;
+	uint32_t Count;
+	uint32_t Stride;
+	uint32_t ComponentType;
+	uint32_t NumComponents;
+};
+
+// One glTF mesh primitive (triangle list). Normals.Data is nullptr when the primitive has no normals.
+struct FGLBPrimitive
+{
+	FGLBAccessor Positions;
+	FGLBAccessor Normals;
+	FGLBAccessor Indices;
+};
+
+// Instance of a glTF mesh placed by a scene node. Transform is node's world matrix (row-vector convention).
+struct FGLBInstance
+{
+	uint32_t MeshIndex;
+	XMFLOAT4X4 Transform;
+};
+
+// Parsed contents of a .glb file, valid while the memory passed to ParseGLB is.
+struct FGLBFile
+{
+	eastl::vector<FGLBPrimitive> Primitives;
+	eastl::vector<uint32_t> MeshFirstPrimitive; // Meshes[i] owns Primitives[MeshFirstPrimitive[i] .. MeshFirstPrimitive[i + 1]).
+	eastl::vector<FGLBInstance> Instances;
+};
+
+enum EGLBComponentType
+{
+	GLBComponent_UnsignedByte = 5121,
+	GLBComponent_UnsignedShort = 5123,
+	GLBComponent_UnsignedInt = 5125,
+	GLBComponent_Float = 5126,
+};
+
+bool ParseGLB(const uint8_t* Data, uint64_t Size, FGLBFile& OutFile);
+
+inline uint32_t GetGLBComponentSize(uint32_t ComponentType)
+{
+	switch (ComponentType)
+	{
+	case GLBComponent_UnsignedByte: return 1;
+	case GLBComponent_UnsignedShort: return 2;
+	case GLBComponent_UnsignedInt:
+	case GLBComponent_Float: return 4;
+	}
+	return 0;
+}
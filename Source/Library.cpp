@@ -1,22 +1,60 @@
 #include "Library.h"
+#include "Allocator.h"
+#include "NullCommandList.h"
 #include <stdio.h>
+#include <psapi.h>
 #include "d3dx12.h"
 #include "imgui/imgui.h"
 #include "EAStdC/EASprintf.h"
-#include "EAStdC/EATextUtil.h"
 #include "EAStdC/EABitTricks.h"
+#include "EAStdC/EAHashCRC.h"
+#include "EASTL/algorithm.h"
+#include "EASTL/sort.h"
+#include "EAThread/eathread_atomic.h"
 
 
 void CreateHeaps(FGraphicsContext& Gfx);
 
-void* operator new[](size_t Size, const char* /*Name*/, int /*Flags*/, unsigned /*DebugFlags*/, const char* /*File*/, int /*Line*/)
+static EA::Thread::AtomicUint64 GNumAllocations;
+
+// Nothing checks the result of new[] (exceptions are disabled, EASTL assumes success), running out of memory ends the
+// process right here instead of at the first use of a null pointer.
+static void* CheckAllocation(void* Pointer)
+{
+	if (!Pointer)
+	{
+		EA_ASSERT_MSG(0, "Out of memory.");
+		abort();
+	}
+	return Pointer;
+}
+
+void* operator new[](size_t Size, const char* Name, int /*Flags*/, unsigned /*DebugFlags*/, const char* /*File*/, int /*Line*/)
+{
+	GNumAllocations.Increment();
+	return CheckAllocation(AllocateTaggedMemory(Size, 16, 0, Name));
+}
+
+void* operator new[](size_t Size, size_t Alignment, size_t AlignmentOffset, const char* Name, int /*Flags*/, unsigned /*DebugFlags*/, const char* /*File*/, int /*Line*/)
+{
+	GNumAllocations.Increment();
+	return CheckAllocation(AllocateTaggedMemory(Size, Alignment, AlignmentOffset, Name));
+}
+
+// EASTL frees through the global operator delete[], so every array allocation has to come from the same heap.
+void* operator new[](size_t Size)
 {
-	return malloc(Size);
+	return CheckAllocation(AllocateTaggedMemory(Size, 16, 0, "operator new[]"));
 }
 
-void* operator new[](size_t Size, size_t Alignment, size_t AlignmentOffset, const char* /*Name*/, int /*Flags*/, unsigned /*DebugFlags*/, const char* /*File*/, int /*Line*/)
+void operator delete[](void* Pointer) noexcept
 {
-	return _aligned_offset_malloc(Size, Alignment, AlignmentOffset);
+	FreeTaggedMemory(Pointer);
+}
+
+void operator delete[](void* Pointer, size_t /*Size*/) noexcept
+{
+	FreeTaggedMemory(Pointer);
 }
 
 void CreateGraphicsContext(HWND Window, bool bShouldCreateDepthBuffer, FGraphicsContext& Gfx)
@@ -52,6 +90,7 @@ void CreateGraphicsContext(HWND Window, bool bShouldCreateDepthBuffer, FGraphics
 	}
 
 	Gfx.Window = Window;
+	VHR(Factory->EnumAdapterByLuid(Gfx.Device->GetAdapterLuid(), IID_PPV_ARGS(&Gfx.Adapter)));
 
 	D3D12_COMMAND_QUEUE_DESC CmdQueueDesc = {};
 	CmdQueueDesc.Flags = D3D12_COMMAND_QUEUE_FLAG_NONE;
@@ -106,7 +145,7 @@ void CreateGraphicsContext(HWND Window, bool bShouldCreateDepthBuffer, FGraphics
 		auto ImageDesc = CD3DX12_RESOURCE_DESC::Tex2D(DXGI_FORMAT_D32_FLOAT, Gfx.Resolution[0], Gfx.Resolution[1], 1, 1);
 		ImageDesc.Flags = D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL | D3D12_RESOURCE_FLAG_DENY_SHADER_RESOURCE;
 
-		VHR(Gfx.Device->CreateCommittedResource(&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT), D3D12_HEAP_FLAG_NONE, &ImageDesc, D3D12_RESOURCE_STATE_DEPTH_WRITE, &CD3DX12_CLEAR_VALUE(DXGI_FORMAT_D32_FLOAT, 1.0f, 0), IID_PPV_ARGS(&Gfx.DepthStencilBuffer)));
+		Gfx.DepthStencilBuffer = CreateGPUResource(Gfx, GPUMemory_RenderTarget, D3D12_HEAP_TYPE_DEFAULT, ImageDesc, D3D12_RESOURCE_STATE_DEPTH_WRITE, &CD3DX12_CLEAR_VALUE(DXGI_FORMAT_D32_FLOAT, 1.0f, 0));
 
 		D3D12_CPU_DESCRIPTOR_HANDLE Handle = AllocateDescriptors(Gfx, D3D12_DESCRIPTOR_HEAP_TYPE_DSV, 1);
 
@@ -148,29 +187,151 @@ void DestroyGraphicsContext(FGraphicsContext& Gfx)
 	SAFE_RELEASE(Gfx.SwapChain);
 	SAFE_RELEASE(Gfx.CmdQueue);
 	SAFE_RELEASE(Gfx.Device);
+	SAFE_RELEASE(Gfx.Adapter);
+}
+
+static_assert(kNumGPUHeapTypes == D3D12_HEAP_TYPE_CUSTOM + 1, "FGPUMemoryTracker::HeapTypeBytes is indexed with D3D12_HEAP_TYPE.");
+
+static void __stdcall OnGPUResourceDestroyed(void* Context)
+{
+	ReleaseGPUMemoryAllocation(Context);
+}
+
+// Committed resource accounted in Gfx.GPUMemory. The resource is released as usual, its memory leaves the tracker when
+// the last reference goes away (destruction callbacks run on the releasing thread, all resources are released on the
+// main thread).
+ID3D12Resource* CreateGPUResource(FGraphicsContext& Gfx, EGPUMemoryCategory Category, D3D12_HEAP_TYPE HeapType, const D3D12_RESOURCE_DESC& Desc, D3D12_RESOURCE_STATES InitialState, const D3D12_CLEAR_VALUE* ClearValue)
+{
+	EA_ASSERT(Category < GPUMemory_Count);
+
+	ID3D12Resource* Resource;
+	VHR(Gfx.Device->CreateCommittedResource(&CD3DX12_HEAP_PROPERTIES(HeapType), D3D12_HEAP_FLAG_NONE, &Desc, InitialState, ClearValue, IID_PPV_ARGS(&Resource)));
+
+	const uint64_t Size = Gfx.Device->GetResourceAllocationInfo(0, 1, &Desc).SizeInBytes;
+	FGPUMemoryAllocation* Allocation = AddGPUMemoryAllocation(Gfx.GPUMemory, Category, HeapType, Size);
+
+	ID3DDestructionNotifier* Notifier;
+	VHR(Resource->QueryInterface(IID_PPV_ARGS(&Notifier)));
+	UINT CallbackID;
+	VHR(Notifier->RegisterDestructionCallback(OnGPUResourceDestroyed, Allocation, &CallbackID));
+	SAFE_RELEASE(Notifier);
+	return Resource;
+}
+
+void GetGPUMemoryBudget(const FGraphicsContext& Gfx, DXGI_QUERY_VIDEO_MEMORY_INFO& OutLocal, DXGI_QUERY_VIDEO_MEMORY_INFO& OutNonLocal)
+{
+	OutLocal = {};
+	OutNonLocal = {};
+	if (Gfx.Adapter)
+	{
+		Gfx.Adapter->QueryVideoMemoryInfo(0, DXGI_MEMORY_SEGMENT_GROUP_LOCAL, &OutLocal);
+		Gfx.Adapter->QueryVideoMemoryInfo(0, DXGI_MEMORY_SEGMENT_GROUP_NON_LOCAL, &OutNonLocal);
+	}
+}
+
+void ShowGPUMemoryWindow(const FGraphicsContext& Gfx)
+{
+	if (ImGui::Begin("GPU memory"))
+	{
+		const FGPUMemoryTracker& Tracker = Gfx.GPUMemory;
+		const float kMB = 1.0f / (1024.0f * 1024.0f);
+
+		ImGui::Columns(5, "GPUMemory");
+		ImGui::Text("Category"); ImGui::NextColumn();
+		ImGui::Text("Resources"); ImGui::NextColumn();
+		ImGui::Text("Created"); ImGui::NextColumn();
+		ImGui::Text("MB"); ImGui::NextColumn();
+		ImGui::Text("Peak MB"); ImGui::NextColumn();
+		ImGui::Separator();
+		for (uint32_t Category = 0; Category < GPUMemory_Count; ++Category)
+		{
+			const FGPUMemoryCategoryStats& Stats = Tracker.Categories[Category];
+			ImGui::Text("%s", kGPUMemoryCategoryNames[Category]); ImGui::NextColumn();
+			ImGui::Text("%u", Stats.NumResources); ImGui::NextColumn();
+			ImGui::Text("%u", Stats.NumCreated); ImGui::NextColumn();
+			ImGui::Text("%.2f", Stats.Bytes * kMB); ImGui::NextColumn();
+			ImGui::Text("%.2f", Stats.HighWaterBytes * kMB); ImGui::NextColumn();
+		}
+		ImGui::Separator();
+		ImGui::Text("Total"); ImGui::NextColumn();
+		ImGui::NextColumn();
+		ImGui::NextColumn();
+		ImGui::Text("%.2f", Tracker.Bytes * kMB); ImGui::NextColumn();
+		ImGui::Text("%.2f", Tracker.HighWaterBytes * kMB); ImGui::NextColumn();
+		ImGui::Columns(1);
+
+		ImGui::Text("Default heap: %.2f MB, upload heap: %.2f MB, readback heap: %.2f MB", Tracker.HeapTypeBytes[D3D12_HEAP_TYPE_DEFAULT] * kMB, Tracker.HeapTypeBytes[D3D12_HEAP_TYPE_UPLOAD] * kMB, Tracker.HeapTypeBytes[D3D12_HEAP_TYPE_READBACK] * kMB);
+
+		// Default heap resources live in local memory on discrete GPUs, upload and readback heaps in system memory.
+		DXGI_QUERY_VIDEO_MEMORY_INFO Local, NonLocal;
+		GetGPUMemoryBudget(Gfx, Local, NonLocal);
+		ImGui::Text("Local: %.2f of %.2f MB budget", Local.CurrentUsage * kMB, Local.Budget * kMB);
+		ImGui::Text("Non-local: %.2f of %.2f MB budget", NonLocal.CurrentUsage * kMB, NonLocal.Budget * kMB);
+		if (Local.Budget > 0 && Local.CurrentUsage > Local.Budget)
+		{
+			ImGui::TextColored(ImVec4(1.0f, 0.3f, 0.3f, 1.0f), "Over the local budget by %.2f MB", (Local.CurrentUsage - Local.Budget) * kMB);
+		}
+	}
+	ImGui::End();
+}
+
+// Allocations made by EASTL containers since startup.
+uint64_t GetNumAllocations()
+{
+	return GNumAllocations.GetValue();
+}
+
+// Replaces the frame command list with a null one (see NullCommandList.h). Everything recorded from now on is thrown
+// away and nothing is presented, resources are still created on the real device. Call right after
+// CreateGraphicsContext.
+void UseNullCommandList(FGraphicsContext& Gfx)
+{
+	VHR(Gfx.CmdList->Close());
+	SAFE_RELEASE(Gfx.CmdList);
+	Gfx.CmdList = CreateNullCommandList();
+	Gfx.bHasNullCommandList = true;
+	GetAndInitCommandList(Gfx);
+}
+
+// Closes Gfx.CmdList and submits it to Gfx.CmdQueue. Null command list is only closed.
+void ExecuteCommandList(FGraphicsContext& Gfx)
+{
+	VHR(Gfx.CmdList->Close());
+	if (!Gfx.bHasNullCommandList)
+	{
+		Gfx.CmdQueue->ExecuteCommandLists(1, CommandListCast(&Gfx.CmdList));
+	}
 }
 
 void PresentFrame(FGraphicsContext& Gfx, uint32_t SwapInterval)
 {
-	Gfx.SwapChain->Present(SwapInterval, 0);
+	const double BeginTime = GetTime();
+	if (!Gfx.bHasNullCommandList)
+	{
+		Gfx.SwapChain->Present(SwapInterval, 0);
+	}
 	Gfx.CmdQueue->Signal(Gfx.FrameFence, ++Gfx.FrameCount);
 
 	const uint64_t GPUFrameCount = Gfx.FrameFence->GetCompletedValue();
 
 	if ((Gfx.FrameCount - GPUFrameCount) >= 2)
 	{
+		CPU_ZONE("Wait for GPU");
 		Gfx.FrameFence->SetEventOnCompletion(GPUFrameCount + 1, Gfx.FrameFenceEvent);
 		WaitForSingleObject(Gfx.FrameFenceEvent, INFINITE);
 	}
+	Gfx.FrameStats.PresentWaitMs = (float)((GetTime() - BeginTime) * 1000.0);
 
 	Gfx.FrameIndex = !Gfx.FrameIndex;
 	Gfx.BackBufferIndex = Gfx.SwapChain->GetCurrentBackBufferIndex();
+	ResetFrameMemory();
 	Gfx.GPUDescriptorHeaps[Gfx.FrameIndex].Size = 0;
 	Gfx.GPUUploadMemoryHeaps[Gfx.FrameIndex].Size = 0;
 }
 
 void WaitForGPU(FGraphicsContext& Gfx)
 {
+	CPU_ZONE("Wait for GPU");
 	Gfx.CmdQueue->Signal(Gfx.FrameFence, ++Gfx.FrameCount);
 	Gfx.FrameFence->SetEventOnCompletion(Gfx.FrameCount, Gfx.FrameFenceEvent);
 	WaitForSingleObject(Gfx.FrameFenceEvent, INFINITE);
@@ -179,6 +340,56 @@ void WaitForGPU(FGraphicsContext& Gfx)
 	Gfx.GPUUploadMemoryHeaps[Gfx.FrameIndex].Size = 0;
 }
 
+void FlushGPUCommands(FGraphicsContext& Gfx)
+{
+	ExecuteCommandList(Gfx);
+	WaitForGPU(Gfx);
+	GetAndInitCommandList(Gfx);
+}
+
+void CreateStagingChunk(FGraphicsContext& Gfx, uint64_t Capacity, FStagingChunk& OutChunk)
+{
+	OutChunk = {};
+	OutChunk.Capacity = Capacity;
+
+	OutChunk.Resource = CreateGPUResource(Gfx, GPUMemory_Upload, D3D12_HEAP_TYPE_UPLOAD, CD3DX12_RESOURCE_DESC::Buffer(Capacity), D3D12_RESOURCE_STATE_GENERIC_READ);
+	VHR(OutChunk.Resource->Map(0, &CD3DX12_RANGE(0, 0), (void**)&OutChunk.CPUStart));
+}
+
+uint8_t* AllocateStagingMemory(FGraphicsContext& Gfx, FStagingChunk& Chunk, uint64_t Size, uint64_t& OutOffset)
+{
+	EA_ASSERT(Size > 0 && Size <= Chunk.Capacity);
+
+	if ((Chunk.Size + Size) > Chunk.Capacity)
+	{
+		// Copies recorded so far must complete before we overwrite the chunk.
+		FlushGPUCommands(Gfx);
+		Chunk.Size = 0;
+	}
+
+	OutOffset = Chunk.Size;
+	Chunk.Size += Size;
+	return Chunk.CPUStart + OutOffset;
+}
+
+void UploadBufferData(FGraphicsContext& Gfx, FStagingChunk& Chunk, ID3D12Resource* DestBuffer, uint64_t DestOffset, const void* Data, uint64_t DataSize)
+{
+	auto* Src = (const uint8_t*)Data;
+
+	while (DataSize > 0)
+	{
+		const uint64_t Size = eastl::min(DataSize, Chunk.Capacity);
+		uint64_t SrcOffset;
+		memcpy(AllocateStagingMemory(Gfx, Chunk, Size, SrcOffset), Src, Size);
+
+		Gfx.CmdList->CopyBufferRegion(DestBuffer, DestOffset, Chunk.Resource, SrcOffset, Size);
+
+		Src += Size;
+		DestOffset += Size;
+		DataSize -= Size;
+	}
+}
+
 FDescriptorHeap& GetDescriptorHeap(FGraphicsContext& Gfx, D3D12_DESCRIPTOR_HEAP_TYPE Type, D3D12_DESCRIPTOR_HEAP_FLAGS Flags, uint32_t& OutDescriptorSize)
 {
 	if (Type == D3D12_DESCRIPTOR_HEAP_TYPE_RTV)
@@ -270,7 +481,7 @@ static void CreateHeaps(FGraphicsContext& Gfx)
 			UploadHeap.CPUStart = nullptr;
 			UploadHeap.GPUStart = 0;
 
-			VHR(Gfx.Device->CreateCommittedResource(&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD), D3D12_HEAP_FLAG_NONE, &CD3DX12_RESOURCE_DESC::Buffer(UploadHeap.Capacity), D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&UploadHeap.Heap)));
+			UploadHeap.Heap = CreateGPUResource(Gfx, GPUMemory_Upload, D3D12_HEAP_TYPE_UPLOAD, CD3DX12_RESOURCE_DESC::Buffer(UploadHeap.Capacity), D3D12_RESOURCE_STATE_GENERIC_READ);
 
 			VHR(UploadHeap.Heap->Map(0, &CD3DX12_RANGE(0, 0), (void**)& UploadHeap.CPUStart));
 			UploadHeap.GPUStart = UploadHeap.Heap->GetGPUVirtualAddress();
@@ -280,6 +491,7 @@ static void CreateHeaps(FGraphicsContext& Gfx)
 
 void CreateUIContext(FGraphicsContext& Gfx, uint32_t NumSamples, FUIContext& UI, eastl::vector<ID3D12Resource*>& OutStagingResources)
 {
+	CPU_ZONE("CreateUIContext");
 	ImGuiIO& IO = ImGui::GetIO();
 	IO.KeyMap[ImGuiKey_Tab] = VK_TAB;
 	IO.KeyMap[ImGuiKey_LeftArrow] = VK_LEFT;
@@ -308,11 +520,22 @@ void CreateUIContext(FGraphicsContext& Gfx, uint32_t NumSamples, FUIContext& UI,
 
 	uint8_t* Pixels;
 	int32_t Width, Height;
-	ImGui::GetIO().Fonts->AddFontFromFileTTF("Data/Roboto-Medium.ttf", 18.0f);
-	ImGui::GetIO().Fonts->GetTexDataAsRGBA32(&Pixels, &Width, &Height);
+	{
+		// Font data is only needed until the atlas is built.
+		FFileView FontFile;
+		if (!OpenFileView("Data/Roboto-Medium.ttf", FontFile))
+		{
+			EA_ASSERT(0);
+		}
+		ImFontConfig FontConfig;
+		FontConfig.FontDataOwnedByAtlas = false;
+		ImGui::GetIO().Fonts->AddFontFromMemoryTTF((void*)FontFile.Data, (int)FontFile.Size, 18.0f, &FontConfig);
+		ImGui::GetIO().Fonts->GetTexDataAsRGBA32(&Pixels, &Width, &Height);
+		CloseFileView(FontFile);
+	}
 
 	const auto TextureDesc = CD3DX12_RESOURCE_DESC::Tex2D(DXGI_FORMAT_R8G8B8A8_UNORM, Width, Height, 1, 1);
-	VHR(Gfx.Device->CreateCommittedResource(&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT), D3D12_HEAP_FLAG_NONE, &TextureDesc, D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS(&UI.Font)));
+	UI.Font = CreateGPUResource(Gfx, GPUMemory_UI, D3D12_HEAP_TYPE_DEFAULT, TextureDesc, D3D12_RESOURCE_STATE_COPY_DEST);
 
 	{
 		ID3D12Resource* StagingBuffer = nullptr;
@@ -320,7 +543,7 @@ void CreateUIContext(FGraphicsContext& Gfx, uint32_t NumSamples, FUIContext& UI,
 		Gfx.Device->GetCopyableFootprints(&TextureDesc, 0, 1, 0, nullptr, nullptr, nullptr, &BufferSize);
 
 		const auto BufferDesc = CD3DX12_RESOURCE_DESC::Buffer(BufferSize);
-		VHR(Gfx.Device->CreateCommittedResource(&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD), D3D12_HEAP_FLAG_NONE, &BufferDesc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&StagingBuffer)));
+		StagingBuffer = CreateGPUResource(Gfx, GPUMemory_UI, D3D12_HEAP_TYPE_UPLOAD, BufferDesc, D3D12_RESOURCE_STATE_GENERIC_READ);
 		OutStagingResources.push_back(StagingBuffer);
 
 		D3D12_SUBRESOURCE_DATA TextureData = { Pixels, (LONG_PTR)Width * 4 };
@@ -346,13 +569,21 @@ void CreateUIContext(FGraphicsContext& Gfx, uint32_t NumSamples, FUIContext& UI,
 		{ "_Color", 0, DXGI_FORMAT_R8G8B8A8_UNORM, 0, 16, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
 	};
 
-	eastl::vector<uint8_t> VSBytecode = LoadFile("Data/Shaders/UserInterface.vs.cso");
-	eastl::vector<uint8_t> PSBytecode = LoadFile("Data/Shaders/UserInterface.ps.cso");
+	FFileView VSBytecode;
+	FFileView PSBytecode;
+	if (!OpenFileView("Data/Shaders/UserInterface.vs.cso", VSBytecode))
+	{
+		EA_ASSERT(0);
+	}
+	if (!OpenFileView("Data/Shaders/UserInterface.ps.cso", PSBytecode))
+	{
+		EA_ASSERT(0);
+	}
 
 	D3D12_GRAPHICS_PIPELINE_STATE_DESC PSODesc = {};
 	PSODesc.InputLayout = { InputElements, (uint32_t)eastl::size(InputElements) };
-	PSODesc.VS = { VSBytecode.data(), VSBytecode.size() };
-	PSODesc.PS = { PSBytecode.data(), PSBytecode.size() };
+	PSODesc.VS = { VSBytecode.Data, VSBytecode.Size };
+	PSODesc.PS = { PSBytecode.Data, PSBytecode.Size };
 	PSODesc.RasterizerState.FillMode = D3D12_FILL_MODE_SOLID;
 	PSODesc.RasterizerState.CullMode = D3D12_CULL_MODE_NONE;
 	PSODesc.RasterizerState.MultisampleEnable = NumSamples > 1 ? TRUE : FALSE;
@@ -370,8 +601,11 @@ void CreateUIContext(FGraphicsContext& Gfx, uint32_t NumSamples, FUIContext& UI,
 	PSODesc.RTVFormats[0] = DXGI_FORMAT_R8G8B8A8_UNORM;
 	PSODesc.SampleDesc.Count = NumSamples;
 
-	VHR(Gfx.Device->CreateGraphicsPipelineState(&PSODesc, IID_PPV_ARGS(&UI.PipelineState)));
-	VHR(Gfx.Device->CreateRootSignature(0, VSBytecode.data(), VSBytecode.size(), IID_PPV_ARGS(&UI.RootSignature)));
+	UI.PipelineState = CreateGraphicsPipeline(Gfx, PSODesc);
+	VHR(Gfx.Device->CreateRootSignature(0, VSBytecode.Data, VSBytecode.Size, IID_PPV_ARGS(&UI.RootSignature)));
+
+	CloseFileView(VSBytecode);
+	CloseFileView(PSBytecode);
 }
 
 void DestroyUIContext(FUIContext& UI)
@@ -399,6 +633,7 @@ void UpdateUI(float DeltaTime)
 
 void DrawUI(FGraphicsContext& Gfx, FUIContext& UI)
 {
+	CPU_ZONE("DrawUI");
 	ImGui::Render();
 
 	ImDrawData* DrawData = ImGui::GetDrawData();
@@ -418,7 +653,7 @@ void DrawUI(FGraphicsContext& Gfx, FUIContext& UI)
 	if (Frame.VertexBufferSize == 0 || Frame.VertexBufferSize < DrawData->TotalVtxCount * sizeof(ImDrawVert))
 	{
 		SAFE_RELEASE(Frame.VertexBuffer);
-		VHR(Gfx.Device->CreateCommittedResource(&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD), D3D12_HEAP_FLAG_NONE, &CD3DX12_RESOURCE_DESC::Buffer(DrawData->TotalVtxCount * sizeof(ImDrawVert)), D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&Frame.VertexBuffer)));
+		Frame.VertexBuffer = CreateGPUResource(Gfx, GPUMemory_UI, D3D12_HEAP_TYPE_UPLOAD, CD3DX12_RESOURCE_DESC::Buffer(DrawData->TotalVtxCount * sizeof(ImDrawVert)), D3D12_RESOURCE_STATE_GENERIC_READ);
 
 		VHR(Frame.VertexBuffer->Map(0, &CD3DX12_RANGE(0, 0), &Frame.VertexBufferCPUAddress));
 
@@ -433,7 +668,7 @@ void DrawUI(FGraphicsContext& Gfx, FUIContext& UI)
 	if (Frame.IndexBufferSize == 0 || Frame.IndexBufferSize < DrawData->TotalIdxCount * sizeof(ImDrawIdx))
 	{
 		SAFE_RELEASE(Frame.IndexBuffer);
-		VHR(Gfx.Device->CreateCommittedResource(&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD), D3D12_HEAP_FLAG_NONE, &CD3DX12_RESOURCE_DESC::Buffer(DrawData->TotalIdxCount * sizeof(ImDrawIdx)), D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&Frame.IndexBuffer)));
+		Frame.IndexBuffer = CreateGPUResource(Gfx, GPUMemory_UI, D3D12_HEAP_TYPE_UPLOAD, CD3DX12_RESOURCE_DESC::Buffer(DrawData->TotalIdxCount * sizeof(ImDrawIdx)), D3D12_RESOURCE_STATE_GENERIC_READ);
 
 		VHR(Frame.IndexBuffer->Map(0, &CD3DX12_RANGE(0, 0), &Frame.IndexBufferCPUAddress));
 
@@ -521,7 +756,7 @@ void CreateMipmapGenerator(FGraphicsContext& Gfx, DXGI_FORMAT Format, FMipmapGen
 		auto TextureDesc = CD3DX12_RESOURCE_DESC::Tex2D(Format, Width, Height, 1, 1);
 		TextureDesc.Flags = D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
 
-		VHR(Gfx.Device->CreateCommittedResource(&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT), D3D12_HEAP_FLAG_NONE, &TextureDesc, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, nullptr, IID_PPV_ARGS(&OutGenerator.ScratchTextures[Idx])));
+		OutGenerator.ScratchTextures[Idx] = CreateGPUResource(Gfx, GPUMemory_Texture, D3D12_HEAP_TYPE_DEFAULT, TextureDesc, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
 
 		Width /= 2;
 		Height /= 2;
@@ -537,13 +772,18 @@ void CreateMipmapGenerator(FGraphicsContext& Gfx, DXGI_FORMAT Format, FMipmapGen
 	}
 
 	{
-		eastl::vector<uint8_t> CSBytecode = LoadFile("Data/Shaders/GenerateMipmaps.cs.cso");
+		FFileView CSBytecode;
+		if (!OpenFileView("Data/Shaders/GenerateMipmaps.cs.cso", CSBytecode))
+		{
+			EA_ASSERT(0);
+		}
 
 		D3D12_COMPUTE_PIPELINE_STATE_DESC PSODesc = {};
-		PSODesc.CS = { CSBytecode.data(), CSBytecode.size() };
+		PSODesc.CS = { CSBytecode.Data, CSBytecode.Size };
 
-		VHR(Gfx.Device->CreateComputePipelineState(&PSODesc, IID_PPV_ARGS(&OutGenerator.ComputePipeline)));
-		VHR(Gfx.Device->CreateRootSignature(0, CSBytecode.data(), CSBytecode.size(), IID_PPV_ARGS(&OutGenerator.RootSignature)));
+		OutGenerator.ComputePipeline = CreateComputePipeline(Gfx, PSODesc);
+		VHR(Gfx.Device->CreateRootSignature(0, CSBytecode.Data, CSBytecode.Size, IID_PPV_ARGS(&OutGenerator.RootSignature)));
+		CloseFileView(CSBytecode);
 	}
 }
 
@@ -569,7 +809,7 @@ void GenerateMipmaps(FGraphicsContext& Gfx, FMipmapGenerator& Generator, ID3D12R
 	EA_ASSERT(TextureDesc.MipLevels > 1);
 
 	ID3D12GraphicsCommandList2* CmdList = Gfx.CmdList;
-
+	const uint32_t ProfilerScope = BeginGPUScope(Gfx, "Mipmaps");
 
 	for (uint32_t ArraySliceIdx = 0; ArraySliceIdx < TextureDesc.DepthOrArraySize; ++ArraySliceIdx)
 	{
@@ -643,53 +883,931 @@ void GenerateMipmaps(FGraphicsContext& Gfx, FMipmapGenerator& Generator, ID3D12R
 			CurrentSrcMipLevel += NumMipsInDispatch;
 		}
 	}
+
+	EndGPUScope(Gfx, ProfilerScope);
+}
+
+static FArchive GMountedArchive;
+
+static const uint32_t kArchiveMagic = 0x41525844; // 'DXRA'
+static const uint32_t kArchiveVersion = 1;
+
+// Archive names are relative paths compared case-insensitively with '/' separators. Must match Tools/PackArchive.py.
+static uint64_t NormalizeArchiveName(const char* Name, char* OutName, uint32_t NameSize)
+{
+	while (Name[0] == '.' && (Name[1] == '/' || Name[1] == '\\'))
+	{
+		Name += 2;
+	}
+
+	// 64-bit FNV-1a.
+	uint64_t Hash = 0xcbf29ce484222325ull;
+	uint32_t Length = 0;
+	for (; *Name && Length + 1 < NameSize; ++Name)
+	{
+		char C = *Name == '\\' ? '/' : *Name;
+		C = (C >= 'A' && C <= 'Z') ? C - 'A' + 'a' : C;
+		OutName[Length++] = C;
+		Hash = (Hash ^ (uint8_t)C) * 0x100000001b3ull;
+	}
+	OutName[Length] = '\0';
+	return Hash;
+}
+
+static bool DecompressLZ4(const uint8_t* Src, uint64_t SrcSize, uint8_t* Dst, uint64_t DstSize)
+{
+	const uint8_t* SrcEnd = Src + SrcSize;
+	uint8_t* DstStart = Dst;
+	uint8_t* DstEnd = Dst + DstSize;
+
+	auto ReadLength = [&Src, SrcEnd](uint64_t& InOutLength) -> bool
+	{
+		if (InOutLength != 15)
+		{
+			return true;
+		}
+		for (;;)
+		{
+			if (Src >= SrcEnd)
+			{
+				return false;
+			}
+			const uint8_t Byte = *Src++;
+			InOutLength += Byte;
+			if (Byte != 255)
+			{
+				return true;
+			}
+		}
+	};
+
+	for (;;)
+	{
+		if (Src >= SrcEnd)
+		{
+			return false;
+		}
+		const uint8_t Token = *Src++;
+
+		uint64_t NumLiterals = Token >> 4;
+		if (!ReadLength(NumLiterals) || NumLiterals > (uint64_t)(SrcEnd - Src) || NumLiterals > (uint64_t)(DstEnd - Dst))
+		{
+			return false;
+		}
+		memcpy(Dst, Src, NumLiterals);
+		Src += NumLiterals;
+		Dst += NumLiterals;
+
+		// Last sequence has literals only.
+		if (Src == SrcEnd)
+		{
+			return Dst == DstEnd;
+		}
+
+		if (SrcEnd - Src < 2)
+		{
+			return false;
+		}
+		const uint64_t Offset = Src[0] | (Src[1] << 8);
+		Src += 2;
+
+		uint64_t MatchLength = Token & 15;
+		if (Offset == 0 || Offset > (uint64_t)(Dst - DstStart) || !ReadLength(MatchLength) || MatchLength + 4 > (uint64_t)(DstEnd - Dst))
+		{
+			return false;
+		}
+		MatchLength += 4;
+
+		// Match can overlap the output (repeating pattern), copy byte by byte.
+		const uint8_t* Match = Dst - Offset;
+		for (uint64_t Idx = 0; Idx < MatchLength; ++Idx)
+		{
+			Dst[Idx] = Match[Idx];
+		}
+		Dst += MatchLength;
+	}
+}
+
+static const FArchiveEntry* FindArchiveEntry(const FArchive& Archive, const char* Name)
+{
+	char NormalizedName[MAX_PATH];
+	const uint64_t Hash = NormalizeArchiveName(Name, NormalizedName, sizeof(NormalizedName));
+
+	const FArchiveEntry* Entry = eastl::lower_bound(Archive.Entries, Archive.Entries + Archive.NumEntries, Hash, [](const FArchiveEntry& E, uint64_t H) { return E.NameHash < H; });
+	for (; Entry != Archive.Entries + Archive.NumEntries && Entry->NameHash == Hash; ++Entry)
+	{
+		if (strcmp((const char*)Archive.View.Data + Entry->NameOffset, NormalizedName) == 0)
+		{
+			return Entry;
+		}
+	}
+	return nullptr;
+}
+
+static bool OpenArchiveEntry(const FArchive& Archive, const FArchiveEntry& Entry, FFileView& OutView)
+{
+	const uint8_t* Data = Archive.View.Data + Entry.Offset;
+
+	if (Entry.Compression == ArchiveCompression_None)
+	{
+		OutView.Data = Data;
+		OutView.Size = Entry.Size;
+		return true;
+	}
+	if (Entry.Compression == ArchiveCompression_LZ4)
+	{
+		OutView.Buffer.resize((size_t)Entry.UncompressedSize);
+		if (DecompressLZ4(Data, Entry.Size, OutView.Buffer.data(), Entry.UncompressedSize))
+		{
+			OutView.Data = OutView.Buffer.data();
+			OutView.Size = Entry.UncompressedSize;
+			return true;
+		}
+	}
+	EA_ASSERT(0);
+	CloseFileView(OutView);
+	return false;
 }
 
-eastl::vector<uint8_t> LoadFile(const char* Name)
+bool MountArchive(const char* Name)
 {
-	FILE* File = fopen(Name, "rb");
-	EA_ASSERT(File);
-	fseek(File, 0, SEEK_END);
-	long Size = ftell(File);
-	if (Size <= 0)
+	CPU_ZONE("MountArchive");
+	UnmountArchive();
+
+	FArchive& Archive = GMountedArchive;
+	if (!OpenFileView(Name, Archive.View))
+	{
+		return false;
+	}
+
+	// Validate the table once so lookups do not need to.
+	FArchiveHeader Header;
+	bool bIsValid = Archive.View.Size >= sizeof(Header);
+	if (bIsValid)
+	{
+		memcpy(&Header, Archive.View.Data, sizeof(Header));
+		bIsValid = Header.Magic == kArchiveMagic && Header.Version == kArchiveVersion && sizeof(Header) + (uint64_t)Header.NumEntries * sizeof(FArchiveEntry) <= Archive.View.Size;
+	}
+	if (bIsValid)
+	{
+		Archive.Entries = (const FArchiveEntry*)(Archive.View.Data + sizeof(Header));
+		Archive.NumEntries = Header.NumEntries;
+
+		for (uint32_t Idx = 0; Idx < Archive.NumEntries && bIsValid; ++Idx)
+		{
+			const FArchiveEntry& Entry = Archive.Entries[Idx];
+			bIsValid = Entry.Offset <= Archive.View.Size && Entry.Size <= Archive.View.Size - Entry.Offset &&
+				Entry.NameOffset < Archive.View.Size && memchr(Archive.View.Data + Entry.NameOffset, 0, (size_t)(Archive.View.Size - Entry.NameOffset)) &&
+				(Idx == 0 || Archive.Entries[Idx - 1].NameHash <= Entry.NameHash);
+		}
+	}
+	if (!bIsValid)
 	{
 		EA_ASSERT(0);
-		return eastl::vector<uint8_t>();
+		UnmountArchive();
+		return false;
 	}
-	eastl::vector<uint8_t> Content(Size);
-	fseek(File, 0, SEEK_SET);
-	fread(Content.data(), 1, Content.size(), File);
-	fclose(File);
-	return Content;
+	return true;
+}
+
+void UnmountArchive()
+{
+	CloseFileView(GMountedArchive.View);
+	GMountedArchive = {};
+}
+
+bool IsArchiveMounted()
+{
+	return GMountedArchive.NumEntries > 0;
+}
+
+bool OpenFileView(const char* Name, FFileView& OutView, uint32_t Flags)
+{
+	OutView = {};
+
+	if (const FArchiveEntry* Entry = IsArchiveMounted() ? FindArchiveEntry(GMountedArchive, Name) : nullptr)
+	{
+		if (!OpenArchiveEntry(GMountedArchive, *Entry, OutView))
+		{
+			return false;
+		}
+		if (Flags & FileView_Prefetch)
+		{
+			PrefetchFileView(OutView, 0, OutView.Size);
+		}
+		return true;
+	}
+
+	HANDLE File = CreateFile(Name, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, (Flags & FileView_SequentialScan) ? FILE_FLAG_SEQUENTIAL_SCAN : FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (File == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	LARGE_INTEGER FileSize;
+	if (!GetFileSizeEx(File, &FileSize) || FileSize.QuadPart == 0)
+	{
+		CloseHandle(File);
+		return false;
+	}
+	OutView.Size = (uint64_t)FileSize.QuadPart;
+
+	// The view keeps the mapping (and the file) alive so both handles can be closed right away.
+	if (HANDLE Mapping = CreateFileMapping(File, nullptr, PAGE_READONLY, 0, 0, nullptr))
+	{
+		OutView.Data = (const uint8_t*)MapViewOfFile(Mapping, FILE_MAP_READ, 0, 0, 0);
+		OutView.bIsMapped = OutView.Data != nullptr;
+		CloseHandle(Mapping);
+	}
+
+	// Mapping can fail (out of address space, some network shares), fall back to reading the file.
+	if (!OutView.bIsMapped)
+	{
+		OutView.Buffer.resize((size_t)OutView.Size);
+
+		uint64_t Offset = 0;
+		while (Offset < OutView.Size)
+		{
+			const DWORD Size = (DWORD)eastl::min<uint64_t>(OutView.Size - Offset, 64 * 1024 * 1024);
+			DWORD NumBytesRead;
+			if (!ReadFile(File, OutView.Buffer.data() + Offset, Size, &NumBytesRead, nullptr) || NumBytesRead != Size)
+			{
+				break;
+			}
+			Offset += Size;
+		}
+		if (Offset != OutView.Size)
+		{
+			CloseHandle(File);
+			CloseFileView(OutView);
+			return false;
+		}
+		OutView.Data = OutView.Buffer.data();
+	}
+	CloseHandle(File);
+
+	if (Flags & FileView_Prefetch)
+	{
+		PrefetchFileView(OutView, 0, OutView.Size);
+	}
+	return true;
+}
+
+void CloseFileView(FFileView& View)
+{
+	if (View.bIsMapped)
+	{
+		UnmapViewOfFile(View.Data);
+	}
+	View = {};
+}
+
+void PrefetchFileView(const FFileView& View, uint64_t Offset, uint64_t Size)
+{
+	// Buffered views are already resident.
+	if (!View.Data || !View.Buffer.empty() || Offset >= View.Size)
+	{
+		return;
+	}
+	WIN32_MEMORY_RANGE_ENTRY Range;
+	Range.VirtualAddress = (void*)(View.Data + Offset);
+	Range.NumberOfBytes = (size_t)eastl::min(Size, View.Size - Offset);
+	PrefetchVirtualMemory(GetCurrentProcess(), 1, &Range, 0);
+}
+
+void CreateAssetCache(const char* Directory, FAssetCache& OutCache)
+{
+	OutCache = {};
+	EA::StdC::Strlcpy(OutCache.Directory, Directory, sizeof(OutCache.Directory));
+	CreateDirectory(Directory, nullptr);
+}
+
+uint64_t GetAssetCacheKey(const char* SourceFileName, const void* Params, uint32_t ParamsSize)
+{
+	FFileView View;
+	if (!OpenFileView(SourceFileName, View, FileView_SequentialScan))
+	{
+		return 0;
+	}
+
+	uint64_t Key = EA::StdC::CRC64(View.Data, (size_t)View.Size, EA::StdC::kCRC64InitialValue, false);
+	Key = EA::StdC::CRC64(Params, ParamsSize, Key, true);
+	CloseFileView(View);
+
+	return Key != 0 ? Key : 1;
+}
+
+static void GetCachedAssetPath(const FAssetCache& Cache, uint64_t Key, const char* Extension, char* OutPath, uint32_t PathSize)
+{
+	EA::StdC::Snprintf(OutPath, PathSize, "%s/%016llx.%s", Cache.Directory, (unsigned long long)Key, Extension);
+}
+
+bool ReadCachedAsset(FAssetCache& Cache, uint64_t Key, const char* Extension, FFileView& OutView)
+{
+	char Path[MAX_PATH];
+	GetCachedAssetPath(Cache, Key, Extension, Path, sizeof(Path));
+
+	if (Key == 0 || !OpenFileView(Path, OutView, FileView_Prefetch))
+	{
+		Cache.NumMisses++;
+		return false;
+	}
+	Cache.NumHits++;
+	Cache.NumBytesRead += OutView.Size;
+	return true;
 }
 
-void UpdateFrameStats(HWND Window, const char* Name, double& OutTime, float& OutDeltaTime)
+FILE* BeginCachedAsset(FAssetCache& Cache, uint64_t Key, const char* Extension)
 {
-	static double PreviousTime = -1.0;
-	static double HeaderRefreshTime = 0.0;
-	static uint32_t FrameCount = 0;
+	if (Key == 0)
+	{
+		return nullptr;
+	}
+
+	// Written under a temporary name and renamed when complete so a crash never leaves a truncated entry behind.
+	char Path[MAX_PATH];
+	char TempPath[MAX_PATH];
+	GetCachedAssetPath(Cache, Key, Extension, Path, sizeof(Path));
+	EA::StdC::Snprintf(TempPath, sizeof(TempPath), "%s.tmp", Path);
+	return fopen(TempPath, "wb");
+}
+
+void EndCachedAsset(FAssetCache& Cache, uint64_t Key, const char* Extension, FILE* File, bool bShouldCommit)
+{
+	if (!File)
+	{
+		return;
+	}
+	_fseeki64(File, 0, SEEK_END);
+	const int64_t Size = _ftelli64(File);
+	bShouldCommit = fclose(File) == 0 && bShouldCommit && Size > 0;
+
+	char Path[MAX_PATH];
+	char TempPath[MAX_PATH];
+	GetCachedAssetPath(Cache, Key, Extension, Path, sizeof(Path));
+	EA::StdC::Snprintf(TempPath, sizeof(TempPath), "%s.tmp", Path);
 
-	if (PreviousTime < 0.0)
+	if (bShouldCommit && MoveFileEx(TempPath, Path, MOVEFILE_REPLACE_EXISTING))
+	{
+		Cache.NumBytesWritten += Size;
+	}
+	else
 	{
-		PreviousTime = GetTime();
-		HeaderRefreshTime = PreviousTime;
+		DeleteFile(TempPath);
 	}
+}
+
+void CreatePipelineCache(FGraphicsContext& Gfx, const char* FileName)
+{
+	CPU_ZONE("CreatePipelineCache");
+	FPipelineCache& Cache = Gfx.PipelineCache;
+	Cache = {};
+	EA::StdC::Strlcpy(Cache.FileName, FileName, sizeof(Cache.FileName));
+
+	const double BeginTime = GetTime();
+
+	// Reuse serialized library when the file is ours and intact, the driver validates the rest.
+	uint64_t DataSize = 0;
+	const uint8_t* Data = OpenFileView(FileName, Cache.File) ? GetPipelineCacheData(Cache.File.Data, Cache.File.Size, DataSize) : nullptr;
+	if (Data)
+	{
+		// Fails with D3D12_ERROR_DRIVER_VERSION_MISMATCH or D3D12_ERROR_ADAPTER_NOT_FOUND when the data is stale.
+		if (FAILED(Gfx.Device->CreatePipelineLibrary(Data, (size_t)DataSize, IID_PPV_ARGS(&Cache.Library))))
+		{
+			Cache.Library = nullptr;
+		}
+	}
+
+	if (!Cache.Library)
+	{
+		CloseFileView(Cache.File);
+		VHR(Gfx.Device->CreatePipelineLibrary(nullptr, 0, IID_PPV_ARGS(&Cache.Library)));
+		Cache.bIsDirty = true;
+	}
+	Cache.OpenMs = (float)((GetTime() - BeginTime) * 1000.0);
+}
+
+void DestroyPipelineCache(FGraphicsContext& Gfx)
+{
+	FPipelineCache& Cache = Gfx.PipelineCache;
+
+	eastl::vector<uint8_t> Content;
+	if (Cache.Library && Cache.bIsDirty)
+	{
+		const size_t DataSize = Cache.Library->GetSerializedSize();
+		Content.resize(sizeof(FPipelineCacheHeader) + DataSize);
+		if (SUCCEEDED(Cache.Library->Serialize(Content.data() + sizeof(FPipelineCacheHeader), DataSize)))
+		{
+			const FPipelineCacheHeader Header = MakePipelineCacheHeader(Content.data() + sizeof(FPipelineCacheHeader), DataSize);
+			memcpy(Content.data(), &Header, sizeof(Header));
+		}
+		else
+		{
+			Content.clear();
+		}
+	}
+
+	// Old file stays mapped until the library is gone, only then it can be replaced.
+	SAFE_RELEASE(Cache.Library);
+	CloseFileView(Cache.File);
+
+	if (!Content.empty())
+	{
+		char TempFileName[MAX_PATH];
+		EA::StdC::Snprintf(TempFileName, sizeof(TempFileName), "%s.tmp", Cache.FileName);
+
+		FILE* File = fopen(TempFileName, "wb");
+		const bool bIsWritten = File && fwrite(Content.data(), 1, Content.size(), File) == Content.size();
+		if (File)
+		{
+			fclose(File);
+		}
+		if (!bIsWritten || !MoveFileEx(TempFileName, Cache.FileName, MOVEFILE_REPLACE_EXISTING))
+		{
+			DeleteFile(TempFileName);
+		}
+	}
+	Cache = {};
+}
+
+template<typename TDesc, typename TLoad, typename TCreate>
+static ID3D12PipelineState* CreateCachedPipeline(FGraphicsContext& Gfx, const TDesc& Desc, uint64_t Key, TLoad Load, TCreate Create)
+{
+	FPipelineCache& Cache = Gfx.PipelineCache;
+
+	wchar_t Name[32];
+	EA::StdC::Snprintf(Name, eastl::size(Name), L"%016llx", (unsigned long long)Key);
+
+	const double BeginTime = GetTime();
+	ID3D12PipelineState* Pipeline = nullptr;
+	if (Cache.Library && SUCCEEDED(Load(Cache.Library, Name, Desc, &Pipeline)))
+	{
+		Cache.NumHits++;
+		Cache.HitMs += (float)((GetTime() - BeginTime) * 1000.0);
+		return Pipeline;
+	}
+
+	Cache.NumMisses++;
+	VHR(Create(Gfx.Device, Desc, &Pipeline));
+
+	// Fails when a different pipeline with the same name is already stored, it is then simply not cached.
+	if (Pipeline && Cache.Library && SUCCEEDED(Cache.Library->StorePipeline(Name, Pipeline)))
+	{
+		Cache.bIsDirty = true;
+	}
+	Cache.MissMs += (float)((GetTime() - BeginTime) * 1000.0);
+	return Pipeline;
+}
+
+ID3D12PipelineState* CreateGraphicsPipeline(FGraphicsContext& Gfx, const D3D12_GRAPHICS_PIPELINE_STATE_DESC& Desc)
+{
+	return CreateCachedPipeline(Gfx, Desc, GetGraphicsPipelineKey(Desc),
+		[](ID3D12PipelineLibrary1* Library, const wchar_t* Name, const D3D12_GRAPHICS_PIPELINE_STATE_DESC& D, ID3D12PipelineState** Out) { return Library->LoadGraphicsPipeline(Name, &D, IID_PPV_ARGS(Out)); },
+		[](ID3D12Device6* Device, const D3D12_GRAPHICS_PIPELINE_STATE_DESC& D, ID3D12PipelineState** Out) { return Device->CreateGraphicsPipelineState(&D, IID_PPV_ARGS(Out)); });
+}
+
+ID3D12PipelineState* CreateComputePipeline(FGraphicsContext& Gfx, const D3D12_COMPUTE_PIPELINE_STATE_DESC& Desc)
+{
+	return CreateCachedPipeline(Gfx, Desc, GetComputePipelineKey(Desc),
+		[](ID3D12PipelineLibrary1* Library, const wchar_t* Name, const D3D12_COMPUTE_PIPELINE_STATE_DESC& D, ID3D12PipelineState** Out) { return Library->LoadComputePipeline(Name, &D, IID_PPV_ARGS(Out)); },
+		[](ID3D12Device6* Device, const D3D12_COMPUTE_PIPELINE_STATE_DESC& D, ID3D12PipelineState** Out) { return Device->CreateComputePipelineState(&D, IID_PPV_ARGS(Out)); });
+}
+
+// Zones of the calling thread inside the last completed FrameZoneName zone, nested by time.
+void ShowCPUProfilerWindow(const char* FrameZoneName, const char* TraceFileName)
+{
+	if (!ImGui::Begin("CPU profiler"))
+	{
+		ImGui::End();
+		return;
+	}
+
+	if (FCPUProfilerThread* Thread = GetCPUProfilerThread())
+	{
+		eastl::vector<FCPUZoneEvent, FFrameAllocator> Events;
+		GetCPUZoneEvents(*Thread, Events);
+
+		// Events are stored in end order, the frame zone ends after everything it contains.
+		int32_t FrameIndex = (int32_t)Events.size() - 1;
+		while (FrameIndex >= 0 && strcmp(Events[FrameIndex].Name, FrameZoneName) != 0)
+		{
+			--FrameIndex;
+		}
+
+		if (FrameIndex >= 0)
+		{
+			const FCPUZoneEvent Frame = Events[FrameIndex];
+			int32_t FirstIndex = FrameIndex;
+			while (FirstIndex > 0 && Events[FirstIndex - 1].BeginCycle >= Frame.BeginCycle)
+			{
+				--FirstIndex;
+			}
+			eastl::sort(Events.begin() + FirstIndex, Events.begin() + FrameIndex + 1, [](const FCPUZoneEvent& A, const FCPUZoneEvent& B)
+			{
+				return A.BeginCycle < B.BeginCycle || (A.BeginCycle == B.BeginCycle && A.EndCycle > B.EndCycle);
+			});
+
+			const double CyclesToMs = 1000.0 / EA::StdC::Stopwatch::GetCPUFrequency();
+			uint64_t EndCycles[16];
+			uint32_t Depth = 0;
+			for (int32_t Idx = FirstIndex; Idx <= FrameIndex; ++Idx)
+			{
+				const FCPUZoneEvent& Event = Events[Idx];
+				while (Depth > 0 && Event.BeginCycle >= EndCycles[Depth - 1])
+				{
+					--Depth;
+				}
+				ImGui::Text("%*s%s  %.3f ms", Depth * 2, "", Event.Name, (Event.EndCycle - Event.BeginCycle) * CyclesToMs);
+				if (Depth < eastl::size(EndCycles))
+				{
+					EndCycles[Depth++] = Event.EndCycle;
+				}
+			}
+		}
+	}
+
+	if (ImGui::Button("Export Chrome trace"))
+	{
+		WriteCPUProfilerTrace(TraceFileName);
+	}
+	ImGui::End();
+}
+
+void CreateGPUProfiler(FGraphicsContext& Gfx)
+{
+	FGPUProfiler& Profiler = Gfx.GPUProfiler;
+	Profiler = {};
+
+	const uint32_t NumQueries = 2 * 2 * kMaxGPUScopesPerFrame;
+
+	D3D12_QUERY_HEAP_DESC QueryHeapDesc = {};
+	QueryHeapDesc.Type = D3D12_QUERY_HEAP_TYPE_TIMESTAMP;
+	QueryHeapDesc.Count = NumQueries;
+	VHR(Gfx.Device->CreateQueryHeap(&QueryHeapDesc, IID_PPV_ARGS(&Profiler.QueryHeap)));
+
+	Profiler.ReadbackBuffer = CreateGPUResource(Gfx, GPUMemory_Readback, D3D12_HEAP_TYPE_READBACK, CD3DX12_RESOURCE_DESC::Buffer(NumQueries * sizeof(uint64_t)), D3D12_RESOURCE_STATE_COPY_DEST);
+	VHR(Profiler.ReadbackBuffer->Map(0, &CD3DX12_RANGE(0, NumQueries * sizeof(uint64_t)), (void**)&Profiler.ReadbackData));
+
+	uint64_t Frequency;
+	VHR(Gfx.CmdQueue->GetTimestampFrequency(&Frequency));
+	Profiler.TicksToMs = 1000.0 / Frequency;
+}
+
+void DestroyGPUProfiler(FGraphicsContext& Gfx)
+{
+	FGPUProfiler& Profiler = Gfx.GPUProfiler;
+	if (Profiler.ReadbackBuffer)
+	{
+		Profiler.ReadbackBuffer->Unmap(0, &CD3DX12_RANGE(0, 0));
+	}
+	SAFE_RELEASE(Profiler.ReadbackBuffer);
+	SAFE_RELEASE(Profiler.QueryHeap);
+	Profiler = {};
+}
+
+// Reads timestamps recorded the last time this frame slot was used (PresentFrame keeps at most two frames in flight,
+// so they are complete) and starts recording new ones.
+void BeginGPUProfilerFrame(FGraphicsContext& Gfx)
+{
+	FGPUProfiler& Profiler = Gfx.GPUProfiler;
+	if (!Profiler.QueryHeap)
+	{
+		return;
+	}
+	EA_ASSERT(!Profiler.bIsFrameOpen);
+
+	const uint32_t Slot = Gfx.FrameIndex;
+	const uint64_t* Timestamps = Profiler.ReadbackData + (uint64_t)Slot * 2 * kMaxGPUScopesPerFrame;
+
+	AddGPUScopeFrame(Profiler.Scopes, Profiler.NumScopes, Profiler.FrameScopes[Slot], Timestamps, Profiler.NumFrameScopes[Slot], Profiler.TicksToMs);
+
+	Profiler.NumFrameScopes[Slot] = 0;
+	Profiler.bIsFrameOpen = true;
+}
+
+// Resolves all timestamps of the frame, must be recorded last to the frame command list.
+void EndGPUProfilerFrame(FGraphicsContext& Gfx)
+{
+	FGPUProfiler& Profiler = Gfx.GPUProfiler;
+	if (!Profiler.QueryHeap)
+	{
+		return;
+	}
+	EA_ASSERT(Profiler.bIsFrameOpen);
+
+	const uint32_t Slot = Gfx.FrameIndex;
+	const uint32_t FirstQuery = Slot * 2 * kMaxGPUScopesPerFrame;
+	if (Profiler.NumFrameScopes[Slot] > 0)
+	{
+		Gfx.CmdList->ResolveQueryData(Profiler.QueryHeap, D3D12_QUERY_TYPE_TIMESTAMP, FirstQuery, 2 * Profiler.NumFrameScopes[Slot], Profiler.ReadbackBuffer, FirstQuery * sizeof(uint64_t));
+	}
+	Profiler.bIsFrameOpen = false;
+}
+
+// Returns handle for EndGPUScope. Name has to stay valid for the lifetime of the profiler (string literal). Scopes
+// outside of a profiler frame or over the per-frame limit are not recorded.
+uint32_t BeginGPUScope(FGraphicsContext& Gfx, const char* Name)
+{
+	FGPUProfiler& Profiler = Gfx.GPUProfiler;
+	const uint32_t Slot = Gfx.FrameIndex;
+	if (!Profiler.bIsFrameOpen || Profiler.NumFrameScopes[Slot] == kMaxGPUScopesPerFrame)
+	{
+		return ~0u;
+	}
+
+	uint32_t ScopeIndex = 0;
+	while (ScopeIndex < Profiler.NumScopes && Profiler.Scopes[ScopeIndex].Name != Name && strcmp(Profiler.Scopes[ScopeIndex].Name, Name) != 0)
+	{
+		++ScopeIndex;
+	}
+	if (ScopeIndex == Profiler.NumScopes)
+	{
+		if (Profiler.NumScopes == kMaxGPUScopes)
+		{
+			return ~0u;
+		}
+		Profiler.Scopes[Profiler.NumScopes++] = { Name };
+	}
+
+	const uint32_t FrameScope = Profiler.NumFrameScopes[Slot]++;
+	Profiler.FrameScopes[Slot][FrameScope] = ScopeIndex;
+	Gfx.CmdList->EndQuery(Profiler.QueryHeap, D3D12_QUERY_TYPE_TIMESTAMP, (Slot * kMaxGPUScopesPerFrame + FrameScope) * 2);
+	return FrameScope;
+}
+
+void EndGPUScope(FGraphicsContext& Gfx, uint32_t Scope)
+{
+	if (Scope != ~0u)
+	{
+		Gfx.CmdList->EndQuery(Gfx.GPUProfiler.QueryHeap, D3D12_QUERY_TYPE_TIMESTAMP, (Gfx.FrameIndex * kMaxGPUScopesPerFrame + Scope) * 2 + 1);
+	}
+}
+
+const FGPUScopeStats* FindGPUScopeStats(const FGPUProfiler& Profiler, const char* Name)
+{
+	for (uint32_t Idx = 0; Idx < Profiler.NumScopes; ++Idx)
+	{
+		if (strcmp(Profiler.Scopes[Idx].Name, Name) == 0)
+		{
+			return &Profiler.Scopes[Idx];
+		}
+	}
+	return nullptr;
+}
+
+void ShowGPUProfilerWindow(const FGPUProfiler& Profiler, const char* CSVFileName)
+{
+	if (ImGui::Begin("GPU profiler"))
+	{
+		ImGui::Columns(5, "GPUScopes");
+		ImGui::Text("Scope"); ImGui::NextColumn();
+		ImGui::Text("Last ms"); ImGui::NextColumn();
+		ImGui::Text("Min ms"); ImGui::NextColumn();
+		ImGui::Text("Avg ms"); ImGui::NextColumn();
+		ImGui::Text("Max ms"); ImGui::NextColumn();
+		ImGui::Separator();
+		for (uint32_t Idx = 0; Idx < Profiler.NumScopes; ++Idx)
+		{
+			const FGPUScopeStats& Stats = Profiler.Scopes[Idx];
+			ImGui::Text("%s", Stats.Name); ImGui::NextColumn();
+			ImGui::Text("%.3f", Stats.LastMs); ImGui::NextColumn();
+			ImGui::Text("%.3f", Stats.MinMs); ImGui::NextColumn();
+			ImGui::Text("%.3f", Stats.AvgMs); ImGui::NextColumn();
+			ImGui::Text("%.3f", Stats.MaxMs); ImGui::NextColumn();
+		}
+		ImGui::Columns(1);
+
+		if (ImGui::Button("Export CSV"))
+		{
+			WriteGPUProfilerCSV(Profiler, CSVFileName);
+		}
+	}
+	ImGui::End();
+}
+
+// One row per scope with its rolling statistics.
+bool WriteGPUProfilerCSV(const FGPUProfiler& Profiler, const char* FileName)
+{
+	FILE* File = fopen(FileName, "w");
+	if (!File)
+	{
+		return false;
+	}
+	fprintf(File, "Scope,Samples,LastMs,MinMs,AvgMs,MaxMs\n");
+	for (uint32_t Idx = 0; Idx < Profiler.NumScopes; ++Idx)
+	{
+		const FGPUScopeStats& Stats = Profiler.Scopes[Idx];
+		fprintf(File, "%s,%u,%.4f,%.4f,%.4f,%.4f\n", Stats.Name, eastl::min(Stats.NumSamples, kGPUScopeHistorySize), Stats.LastMs, Stats.MinMs, Stats.AvgMs, Stats.MaxMs);
+	}
+	fclose(File);
+	return true;
+}
+
+// Called once per frame before anything else. Records timings of the previous frame, which ends here.
+void UpdateFrameStats(FGraphicsContext& Gfx, const char* Name, double& OutTime, float& OutDeltaTime)
+{
+	FFrameStats& Stats = Gfx.FrameStats;
 
 	OutTime = GetTime();
-	OutDeltaTime = (float)(OutTime - PreviousTime);
-	PreviousTime = OutTime;
+	if (Stats.PreviousTime == 0.0)
+	{
+		Stats.PreviousTime = OutTime;
+		Stats.TitleRefreshTime = OutTime;
+	}
+	OutDeltaTime = (float)(OutTime - Stats.PreviousTime);
+
+	if (OutTime > Stats.PreviousTime)
+	{
+		const FGPUScopeStats* GPUFrame = FindGPUScopeStats(Gfx.GPUProfiler, "Frame");
+
+		float Ms[FrameMetric_Count];
+		Ms[FrameMetric_Frame] = OutDeltaTime * 1000.0f;
+		Ms[FrameMetric_PresentWait] = eastl::min(Stats.PresentWaitMs, Ms[FrameMetric_Frame]);
+		Ms[FrameMetric_CPU] = Ms[FrameMetric_Frame] - Ms[FrameMetric_PresentWait];
+		Ms[FrameMetric_GPU] = GPUFrame ? GPUFrame->LastMs : 0.0f;
+		AddFrameTiming(Stats, Ms);
+		Stats.NumTitleFrames++;
+	}
+	Stats.PreviousTime = OutTime;
+
+	const uint64_t NumAllocations = GetNumAllocations();
+	Stats.LastFrameAllocations = (uint32_t)(NumAllocations - Stats.NumAllocations);
+	Stats.NumAllocations = NumAllocations;
 
-	if ((OutTime - HeaderRefreshTime) >= 1.0)
+	if ((OutTime - Stats.TitleRefreshTime) >= 1.0)
 	{
-		const double FPS = FrameCount / (OutTime - HeaderRefreshTime);
-		const double MS = (1.0 / FPS) * 1000.0;
+		FFrameStatsSummary Summary;
+		GetFrameStatsSummary(Stats, Summary);
+
+		const double FPS = Stats.NumTitleFrames / (OutTime - Stats.TitleRefreshTime);
 		char Header[256];
-		EA::StdC::Snprintf(Header, sizeof(Header), "[%.1f fps  %.3f ms] %s", FPS, MS, Name);
-		SetWindowText(Window, Header);
-		HeaderRefreshTime = OutTime;
-		FrameCount = 0;
+		EA::StdC::Snprintf(Header, sizeof(Header), "[%.1f fps  p50 %.2f ms  p99 %.2f ms] %s", FPS, Summary.Metrics[FrameMetric_Frame].P50Ms, Summary.Metrics[FrameMetric_Frame].P99Ms, Name);
+		SetWindowText(Gfx.Window, Header);
+		Stats.TitleRefreshTime = OutTime;
+		Stats.NumTitleFrames = 0;
+	}
+}
+
+void ShowFrameStatsWindow(const FFrameStats& Stats, const char* DumpFileName)
+{
+	if (ImGui::Begin("Frame stats"))
+	{
+		FFrameStatsSummary Summary;
+		GetFrameStatsSummary(Stats, Summary);
+		const FFrameMetricSummary& Frame = Summary.Metrics[FrameMetric_Frame];
+
+		// Frame times oldest to newest, the ring starts at the oldest frame once it is full.
+		const uint32_t Offset = Stats.NumFrames > kFrameStatsHistorySize ? Stats.NumFrames % kFrameStatsHistorySize : 0;
+		ImGui::PlotLines("Frame ms", &Stats.History[0][FrameMetric_Frame], (int)Summary.NumFrames, (int)Offset, nullptr, 0.0f, eastl::max(Frame.MaxMs, 1.0f), ImVec2(0.0f, 80.0f), sizeof(Stats.History[0]));
+
+		// 0.5 ms buckets from 0 to twice the p99, the last bucket also counts everything longer.
+		static const uint32_t kNumBuckets = 48;
+		float Buckets[kNumBuckets] = {};
+		const float BucketMs = eastl::max(eastl::max(Frame.P99Ms * 2.0f, 1.0f) / kNumBuckets, 0.5f);
+		for (uint32_t Idx = 0; Idx < Summary.NumFrames; ++Idx)
+		{
+			Buckets[eastl::min((uint32_t)(Stats.History[Idx][FrameMetric_Frame] / BucketMs), kNumBuckets - 1)] += 1.0f;
+		}
+		char Overlay[64];
+		EA::StdC::Snprintf(Overlay, sizeof(Overlay), "%.2f ms per bucket", BucketMs);
+		ImGui::PlotHistogram("Histogram", Buckets, kNumBuckets, 0, Overlay, 0.0f, FLT_MAX, ImVec2(0.0f, 80.0f));
+
+		ImGui::Columns(6, "FrameStats");
+		ImGui::Text("Metric"); ImGui::NextColumn();
+		ImGui::Text("Avg ms"); ImGui::NextColumn();
+		ImGui::Text("p50 ms"); ImGui::NextColumn();
+		ImGui::Text("p95 ms"); ImGui::NextColumn();
+		ImGui::Text("p99 ms"); ImGui::NextColumn();
+		ImGui::Text("Max ms"); ImGui::NextColumn();
+		ImGui::Separator();
+		for (uint32_t Metric = 0; Metric < FrameMetric_Count; ++Metric)
+		{
+			const FFrameMetricSummary& Metrics = Summary.Metrics[Metric];
+			ImGui::Text("%s", kFrameMetricNames[Metric]); ImGui::NextColumn();
+			ImGui::Text("%.3f", Metrics.AvgMs); ImGui::NextColumn();
+			ImGui::Text("%.3f", Metrics.P50Ms); ImGui::NextColumn();
+			ImGui::Text("%.3f", Metrics.P95Ms); ImGui::NextColumn();
+			ImGui::Text("%.3f", Metrics.P99Ms); ImGui::NextColumn();
+			ImGui::Text("%.3f", Metrics.MaxMs); ImGui::NextColumn();
+		}
+		ImGui::Columns(1);
+
+		ImGui::Text("Hitches (> %.1fx p50): %u of %u frames", kFrameHitchFactor, Summary.NumHitches, Summary.NumFrames);
+		if (Stats.RaysPerSecond > 0.0)
+		{
+			ImGui::Text("Rays: %.3f Grays/s", Stats.RaysPerSecond * 1.0e-9);
+		}
+		FFrameArenaStats Arena;
+		GetFrameArenaStats(Arena);
+		ImGui::Text("Allocations: %u last frame, frame arena %.1f of %.1f KB (%u blocks)", Stats.LastFrameAllocations, Arena.LastFrameBytes / 1024.0, Arena.CapacityBytes / 1024.0, Arena.NumBlocks);
+		if (ImGui::Button("Dump stats"))
+		{
+			WriteFrameStats(Stats, DumpFileName);
+		}
+	}
+	ImGui::End();
+}
+
+// Allocator totals and, when allocation tracking is enabled, the tags largest first.
+void ShowCPUMemoryWindow(const char* ReportFileName)
+{
+	if (ImGui::Begin("CPU memory"))
+	{
+		FAllocatorStats Allocator;
+		GetAllocatorStats(Allocator);
+		ImGui::Text("Small objects: %.2f MB committed, %llu large allocations", Allocator.CommittedBytes / (1024.0 * 1024.0), (unsigned long long)Allocator.NumLargeAllocations);
+
+		if (!IsAllocationTrackingEnabled())
+		{
+			ImGui::Text("Set DXRTEST_TRACK_ALLOCATIONS=1 before starting to track allocations.");
+		}
+		else
+		{
+			eastl::vector<FAllocationTagStats, FFrameAllocator> Tags(kMaxAllocationTags);
+			const uint32_t NumTags = GetAllocationTagStats(Tags.data(), kMaxAllocationTags);
+			eastl::sort(Tags.begin(), Tags.begin() + NumTags, [](const FAllocationTagStats& A, const FAllocationTagStats& B) { return A.Bytes > B.Bytes; });
+
+			ImGui::Columns(6, "CPUMemory");
+			ImGui::Text("Tag"); ImGui::NextColumn();
+			ImGui::Text("KB"); ImGui::NextColumn();
+			ImGui::Text("Peak KB"); ImGui::NextColumn();
+			ImGui::Text("Growth KB"); ImGui::NextColumn();
+			ImGui::Text("Live"); ImGui::NextColumn();
+			ImGui::Text("Allocations"); ImGui::NextColumn();
+			ImGui::Separator();
+			for (uint32_t Idx = 0; Idx < NumTags; ++Idx)
+			{
+				const FAllocationTagStats& Tag = Tags[Idx];
+				ImGui::Text("%s", Tag.Name); ImGui::NextColumn();
+				ImGui::Text("%.1f", Tag.Bytes / 1024.0); ImGui::NextColumn();
+				ImGui::Text("%.1f", Tag.PeakBytes / 1024.0); ImGui::NextColumn();
+				ImGui::Text("%.1f", ((double)Tag.Bytes - (double)Tag.BaselineBytes) / 1024.0); ImGui::NextColumn();
+				ImGui::Text("%llu", (unsigned long long)Tag.NumLive); ImGui::NextColumn();
+				ImGui::Text("%llu", (unsigned long long)Tag.NumAllocations); ImGui::NextColumn();
+			}
+			ImGui::Columns(1);
+
+			if (ImGui::Button("Mark baseline"))
+			{
+				MarkAllocationBaseline();
+			}
+			ImGui::SameLine();
+			if (ImGui::Button("Dump report"))
+			{
+				WriteAllocationReport(ReportFileName);
+			}
+		}
 	}
-	FrameCount++;
+	ImGui::End();
+}
+
+// JSON with the summary and every frame in the ring, oldest first.
+bool WriteFrameStats(const FFrameStats& Stats, const char* FileName)
+{
+	FILE* File = fopen(FileName, "w");
+	if (!File)
+	{
+		return false;
+	}
+
+	FFrameStatsSummary Summary;
+	GetFrameStatsSummary(Stats, Summary);
+
+	fprintf(File, "{\n\t\"numFrames\": %u,\n\t\"numHitches\": %u,\n\t\"hitchFactor\": %.2f,\n\t\"raysPerSecond\": %.0f,\n\t\"summary\": {\n", Summary.NumFrames, Summary.NumHitches, kFrameHitchFactor, Stats.RaysPerSecond);
+	for (uint32_t Metric = 0; Metric < FrameMetric_Count; ++Metric)
+	{
+		const FFrameMetricSummary& Metrics = Summary.Metrics[Metric];
+		fprintf(File, "\t\t\"%s\": { \"avg\": %.4f, \"p50\": %.4f, \"p95\": %.4f, \"p99\": %.4f, \"max\": %.4f }%s\n", kFrameMetricNames[Metric], Metrics.AvgMs, Metrics.P50Ms, Metrics.P95Ms, Metrics.P99Ms, Metrics.MaxMs, Metric + 1 < FrameMetric_Count ? "," : "");
+	}
+	fprintf(File, "\t},\n\t\"frames\": [\n");
+
+	const uint32_t FirstFrame = Stats.NumFrames - Summary.NumFrames;
+	for (uint32_t Idx = 0; Idx < Summary.NumFrames; ++Idx)
+	{
+		const float* Ms = Stats.History[(FirstFrame + Idx) % kFrameStatsHistorySize];
+		fprintf(File, "\t\t[%.4f, %.4f, %.4f, %.4f]%s\n", Ms[FrameMetric_Frame], Ms[FrameMetric_CPU], Ms[FrameMetric_GPU], Ms[FrameMetric_PresentWait], Idx + 1 < Summary.NumFrames ? "," : "");
+	}
+	fprintf(File, "\t],\n\t\"frameColumns\": [\"%s\", \"%s\", \"%s\", \"%s\"]\n}\n", kFrameMetricNames[0], kFrameMetricNames[1], kFrameMetricNames[2], kFrameMetricNames[3]);
+	fclose(File);
+	return true;
+}
+
+void GetMemoryUsage(const FGraphicsContext& Gfx, FMemoryUsage& OutUsage)
+{
+	OutUsage = {};
+
+	PROCESS_MEMORY_COUNTERS_EX Counters = {};
+	if (GetProcessMemoryInfo(GetCurrentProcess(), (PROCESS_MEMORY_COUNTERS*)&Counters, sizeof(Counters)))
+	{
+		OutUsage.WorkingSetBytes = Counters.WorkingSetSize;
+		OutUsage.PeakWorkingSetBytes = Counters.PeakWorkingSetSize;
+		OutUsage.PrivateBytes = Counters.PrivateUsage;
+	}
+
+	DXGI_QUERY_VIDEO_MEMORY_INFO Local, NonLocal;
+	GetGPUMemoryBudget(Gfx, Local, NonLocal);
+	OutUsage.GPULocalBytes = Local.CurrentUsage;
+	OutUsage.GPUNonLocalBytes = NonLocal.CurrentUsage;
 }
 
 double GetTime()
@@ -795,132 +1913,3 @@ HWND CreateSimpleWindow(const char* Name, uint32_t Width, uint32_t Height)
 	EA_ASSERT(Window);
 	return Window;
 }
-
-void LoadPLYFile(const char* FileName, eastl::vector<XMFLOAT3>& InOutPositions, eastl::vector<XMFLOAT3>& InOutNormals, eastl::vector<XMFLOAT2>& InOutTexcoords, eastl::vector<uint32_t>& InOutTriangles)
-{
-	using namespace EA::StdC;
-	FILE* File = fopen(FileName, "r");
-	EA_ASSERT(File);
-
-	char LineBuffer[1024];
-	char Token[64];
-	uint32_t NumVertices = UINT32_MAX;
-	uint32_t NumTriangles = UINT32_MAX;
-
-	struct FProperty
-	{
-		const char* Name;
-		bool bIsPresent;
-	} Properties[] =
-	{
-		{ "x\n", false }, { "y\n", false }, { "z\n", false },
-		{ "nx\n", false }, { "ny\n", false }, { "nz\n", false },
-		{ "s\n", false }, { "t\n", false },
-	};
-	bool bHasPositions = false;
-	bool bHasNormals = false;
-	bool bHasTexcoords = false;
-
-	while (fgets(LineBuffer, sizeof(LineBuffer), File))
-	{
-		const char* Line = LineBuffer;
-		while (SplitTokenSeparated(Line, kLengthNull, ' ', Token, sizeof(Token), &Line))
-		{
-			if (Strcmp(Token, "comment") == 0 || Strcmp(Token, "format") == 0)
-			{
-				break; // Skip the line.
-			}
-			else if (Strcmp(Token, "vertex") == 0)
-			{
-				NumVertices = AtoU32(Line);
-			}
-			else if (Strcmp(Token, "face") == 0)
-			{
-				NumTriangles = AtoU32(Line);
-			}
-			else if (Strcmp(Token, "float") == 0)
-			{
-				for (uint32_t Idx = 0; Idx < eastl::size(Properties); ++Idx)
-				{
-					if (Strcmp(Line, Properties[Idx].Name) == 0)
-					{
-						Properties[Idx].bIsPresent = true;
-						break;
-					}
-				}
-			}
-			else if (Strcmp(Token, "end_header\n") == 0)
-			{
-				bHasPositions = Properties[0].bIsPresent && Properties[1].bIsPresent && Properties[2].bIsPresent;
-				bHasNormals = Properties[3].bIsPresent && Properties[4].bIsPresent && Properties[5].bIsPresent;
-				bHasTexcoords = Properties[6].bIsPresent && Properties[7].bIsPresent;
-				goto HeaderIsDone;
-			}
-		}
-	}
-HeaderIsDone:
-
-	EA_ASSERT(bHasPositions);
-	EA_ASSERT(NumVertices != UINT32_MAX);
-	EA_ASSERT(NumTriangles != UINT32_MAX);
-
-	InOutPositions.reserve(InOutPositions.size() + NumVertices);
-	if (bHasNormals)
-	{
-		InOutNormals.reserve(InOutNormals.size() + NumVertices);
-	}
-	if (bHasTexcoords)
-	{
-		InOutTexcoords.reserve(InOutTexcoords.size() + NumVertices);
-	}
-
-	for (uint32_t LineIdx = 0; LineIdx < NumVertices; ++LineIdx)
-	{
-		char* Line = fgets(LineBuffer, sizeof(LineBuffer), File);
-		EA_ASSERT(Line);
-
-		XMFLOAT3 Position;
-		Position.x = StrtoF32(Line, &Line);
-		Position.y = StrtoF32(Line, &Line);
-		Position.z = StrtoF32(Line, &Line);
-		InOutPositions.push_back(Position);
-
-		if (bHasNormals)
-		{
-			XMFLOAT3 Normal;
-			Normal.x = StrtoF32(Line, &Line);
-			Normal.y = StrtoF32(Line, &Line);
-			Normal.z = StrtoF32(Line, &Line);
-			InOutNormals.push_back(Normal);
-		}
-		if (bHasTexcoords)
-		{
-			XMFLOAT2 Texcoord;
-			Texcoord.x = StrtoF32(Line, &Line);
-			Texcoord.y = StrtoF32(Line, &Line);
-			InOutTexcoords.push_back(Texcoord);
-		}
-	}
-
-	InOutTriangles.reserve(InOutTriangles.size() + NumTriangles * 3);
-
-	for (uint32_t LineIdx = 0; LineIdx < NumTriangles; ++LineIdx)
-	{
-		char* Line = fgets(LineBuffer, sizeof(LineBuffer), File);
-		EA_ASSERT(Line);
-
-		uint32_t NumIndices = StrtoU32(Line, &Line, 10);
-		EA_ASSERT(NumIndices == 3);
-
-		uint32_t Triangle[3];
-		Triangle[0] = StrtoU32(Line, &Line, 10);
-		Triangle[1] = StrtoU32(Line, &Line, 10);
-		Triangle[2] = StrtoU32(Line, &Line, 10);
-
-		InOutTriangles.push_back(Triangle[0]);
-		InOutTriangles.push_back(Triangle[1]);
-		InOutTriangles.push_back(Triangle[2]);
-	}
-
-	fclose(File);
-}
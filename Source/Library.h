@@ -1,11 +1,16 @@
 #pragma once
 
 #include <stdint.h>
+#include <stdio.h>
 #include <dxgi1_4.h>
 #include <d3d12.h>
 #include "EAAssert/eaassert.h"
 #include "EASTL/vector.h"
 #include "DirectXMath/DirectXMath.h"
+#include "EAStdC/EAStopwatch.h"
+#include "CPUProfiler.h"
+#include "PipelineCache.h"
+#include "Stats.h"
 
 #define VHR(hr) if (FAILED(hr)) { EA_ASSERT(0); }
 #define SAFE_RELEASE(obj) if ((obj)) { (obj)->Release(); (obj) = nullptr; }
@@ -28,10 +33,124 @@ struct FGPUMemoryHeap
 	uint32_t Capacity;
 };
 
+// Upload buffer that is filled front to back. When it runs out of space pending GPU work is flushed and the chunk is
+// reused from the start, so arbitrary amounts of data can go through a fixed amount of upload memory.
+struct FStagingChunk
+{
+	ID3D12Resource* Resource;
+	uint8_t* CPUStart;
+	uint64_t Size;
+	uint64_t Capacity;
+};
+
+// Read-only view of a whole file. The file is memory-mapped when possible (pages come straight from the file cache,
+// nothing is copied) and read into Buffer otherwise. Files found in the mounted archive point into the archive mapping
+// (or into Buffer when compressed). Data is valid until CloseFileView.
+struct FFileView
+{
+	const uint8_t* Data;
+	uint64_t Size;
+	bool bIsMapped;
+	eastl::vector<uint8_t> Buffer;
+};
+
+enum EFileViewFlags
+{
+	FileView_SequentialScan = 0x1, // Hint that the file will be read front to back once.
+	FileView_Prefetch = 0x2, // Start reading the whole file into memory asynchronously.
+};
+
+// Packed archive (see Tools/PackArchive.py): header, FArchiveEntry table sorted by NameHash, zero-terminated names,
+// then entry data aligned to D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT so uncompressed entries can be copied to the GPU as
+// is. The whole archive is one mapping, entries are views into it.
+struct FArchiveHeader
+{
+	uint32_t Magic;
+	uint32_t Version;
+	uint32_t NumEntries;
+	uint32_t Reserved;
+};
+
+struct FArchiveEntry
+{
+	uint64_t NameHash;
+	uint64_t Offset;
+	uint64_t Size;
+	uint64_t UncompressedSize;
+	uint32_t NameOffset;
+	uint32_t Compression;
+};
+
+enum EArchiveCompression
+{
+	ArchiveCompression_None = 0,
+	ArchiveCompression_LZ4 = 1, // LZ4 block format.
+};
+
+struct FArchive
+{
+	FFileView View;
+	const FArchiveEntry* Entries;
+	uint32_t NumEntries;
+};
+
+// Directory of derived artifacts (cooked meshes etc.) stored under a hash of the source bytes and the processing
+// parameters. Stale entries are never looked up because any change to the inputs changes the key.
+struct FAssetCache
+{
+	char Directory[MAX_PATH];
+	uint32_t NumHits;
+	uint32_t NumMisses;
+	uint64_t NumBytesRead;
+	uint64_t NumBytesWritten;
+};
+
+// PSOs stored in ID3D12PipelineLibrary1 under a hash of the shader bytecode and the pipeline desc. The library is
+// loaded from (and saved to) a versioned file; a driver or adapter change invalidates it and it is rebuilt.
+struct FPipelineCache
+{
+	ID3D12PipelineLibrary1* Library;
+	FFileView File; // Library references the serialized data, must outlive it.
+	char FileName[MAX_PATH];
+	uint32_t NumHits;
+	uint32_t NumMisses;
+	float OpenMs; // Reading and validating the file and creating the library.
+	float HitMs; // Total of pipeline loads from the library.
+	float MissMs; // Total of pipeline creation (and storing) on misses.
+	bool bIsDirty;
+};
+
+// Timestamp queries around named scopes of the frame command list. Every frame slot (Gfx.FrameIndex) has its own range
+// of queries and of the readback buffer. Results are read when the slot is reused, the GPU is done with it by then so
+// nothing ever waits.
+struct FGPUProfiler
+{
+	ID3D12QueryHeap* QueryHeap;
+	ID3D12Resource* ReadbackBuffer;
+	const uint64_t* ReadbackData; // Persistently mapped.
+	double TicksToMs;
+	uint32_t FrameScopes[2][kMaxGPUScopesPerFrame]; // Index into Scopes for each query pair recorded in the slot.
+	uint32_t NumFrameScopes[2];
+	bool bIsFrameOpen;
+	FGPUScopeStats Scopes[kMaxGPUScopes];
+	uint32_t NumScopes;
+};
+
+struct FMemoryUsage
+{
+	uint64_t WorkingSetBytes;
+	uint64_t PeakWorkingSetBytes;
+	uint64_t PrivateBytes;
+	uint64_t GPULocalBytes; // Video memory in use by the process as reported by DXGI.
+	uint64_t GPUNonLocalBytes;
+};
+
 struct FGraphicsContext
 {
 	ID3D12Device6* Device;
+	IDXGIAdapter3* Adapter;
 	ID3D12GraphicsCommandList5* CmdList;
+	bool bHasNullCommandList; // See UseNullCommandList.
 	ID3D12CommandQueue* CmdQueue;
 	ID3D12CommandAllocator* CmdAlloc[2];
 	uint32_t Resolution[2];
@@ -47,6 +166,10 @@ struct FGraphicsContext
 	FDescriptorHeap CPUDescriptorHeap;
 	FDescriptorHeap GPUDescriptorHeaps[2];
 	FGPUMemoryHeap GPUUploadMemoryHeaps[2];
+	FPipelineCache PipelineCache;
+	FGPUProfiler GPUProfiler;
+	FFrameStats FrameStats;
+	FGPUMemoryTracker GPUMemory;
 	ID3D12Fence* FrameFence;
 	HANDLE FrameFenceEvent;
 	uint64_t FrameCount;
@@ -80,25 +203,66 @@ struct FMipmapGenerator
 	D3D12_CPU_DESCRIPTOR_HANDLE ScratchTexturesBaseUAV;
 };
 
+void ShowCPUProfilerWindow(const char* FrameZoneName, const char* TraceFileName);
+
 void CreateMipmapGenerator(FGraphicsContext& Gfx, DXGI_FORMAT Format, FMipmapGenerator& Out);
 void DestroyMipmapGenerator(FMipmapGenerator& Generator);
 void GenerateMipmaps(FGraphicsContext& Gfx, FMipmapGenerator& Generator, ID3D12Resource* Texture);
 
-void LoadPLYFile(const char* FileName, eastl::vector<XMFLOAT3>& InOutPositions, eastl::vector<XMFLOAT3>& InOutNormals, eastl::vector<XMFLOAT2>& InOutTexcoords, eastl::vector<uint32_t>& InOutTriangles);
-
 void CreateGraphicsContext(HWND Window, bool bShouldCreateDepthBuffer, FGraphicsContext& Gfx);
 void DestroyGraphicsContext(FGraphicsContext& Gfx);
+void UseNullCommandList(FGraphicsContext& Gfx);
+void ExecuteCommandList(FGraphicsContext& Gfx);
+uint64_t GetNumAllocations();
+ID3D12Resource* CreateGPUResource(FGraphicsContext& Gfx, EGPUMemoryCategory Category, D3D12_HEAP_TYPE HeapType, const D3D12_RESOURCE_DESC& Desc, D3D12_RESOURCE_STATES InitialState, const D3D12_CLEAR_VALUE* ClearValue = nullptr);
+void GetGPUMemoryBudget(const FGraphicsContext& Gfx, DXGI_QUERY_VIDEO_MEMORY_INFO& OutLocal, DXGI_QUERY_VIDEO_MEMORY_INFO& OutNonLocal);
+void ShowGPUMemoryWindow(const FGraphicsContext& Gfx);
 FDescriptorHeap& GetDescriptorHeap(FGraphicsContext& Gfx, D3D12_DESCRIPTOR_HEAP_TYPE Type, D3D12_DESCRIPTOR_HEAP_FLAGS Flags, uint32_t& OutDescriptorSize);
 void PresentFrame(FGraphicsContext& Gfx, uint32_t SwapInterval);
 void WaitForGPU(FGraphicsContext& Gfx);
+void FlushGPUCommands(FGraphicsContext& Gfx);
+
+void CreateStagingChunk(FGraphicsContext& Gfx, uint64_t Capacity, FStagingChunk& OutChunk);
+uint8_t* AllocateStagingMemory(FGraphicsContext& Gfx, FStagingChunk& Chunk, uint64_t Size, uint64_t& OutOffset);
+void UploadBufferData(FGraphicsContext& Gfx, FStagingChunk& Chunk, ID3D12Resource* DestBuffer, uint64_t DestOffset, const void* Data, uint64_t DataSize);
 
 void CreateUIContext(FGraphicsContext& Gfx, uint32_t NumSamples, FUIContext& UI, eastl::vector<ID3D12Resource*>& OutStagingResources);
 void DestroyUIContext(FUIContext& UI);
 void UpdateUI(float DeltaTime);
 void DrawUI(FGraphicsContext& Gfx, FUIContext& UI);
 
-eastl::vector<uint8_t> LoadFile(const char* Name);
-void UpdateFrameStats(HWND Window, const char* Name, double& OutTime, float& OutDeltaTime);
+void CreateAssetCache(const char* Directory, FAssetCache& OutCache);
+uint64_t GetAssetCacheKey(const char* SourceFileName, const void* Params, uint32_t ParamsSize);
+bool ReadCachedAsset(FAssetCache& Cache, uint64_t Key, const char* Extension, FFileView& OutView);
+FILE* BeginCachedAsset(FAssetCache& Cache, uint64_t Key, const char* Extension);
+void EndCachedAsset(FAssetCache& Cache, uint64_t Key, const char* Extension, FILE* File, bool bShouldCommit);
+
+void CreatePipelineCache(FGraphicsContext& Gfx, const char* FileName);
+void DestroyPipelineCache(FGraphicsContext& Gfx);
+ID3D12PipelineState* CreateGraphicsPipeline(FGraphicsContext& Gfx, const D3D12_GRAPHICS_PIPELINE_STATE_DESC& Desc);
+ID3D12PipelineState* CreateComputePipeline(FGraphicsContext& Gfx, const D3D12_COMPUTE_PIPELINE_STATE_DESC& Desc);
+
+void CreateGPUProfiler(FGraphicsContext& Gfx);
+void DestroyGPUProfiler(FGraphicsContext& Gfx);
+void BeginGPUProfilerFrame(FGraphicsContext& Gfx);
+void EndGPUProfilerFrame(FGraphicsContext& Gfx);
+uint32_t BeginGPUScope(FGraphicsContext& Gfx, const char* Name);
+void EndGPUScope(FGraphicsContext& Gfx, uint32_t Scope);
+const FGPUScopeStats* FindGPUScopeStats(const FGPUProfiler& Profiler, const char* Name);
+void ShowGPUProfilerWindow(const FGPUProfiler& Profiler, const char* CSVFileName);
+bool WriteGPUProfilerCSV(const FGPUProfiler& Profiler, const char* FileName);
+
+bool OpenFileView(const char* Name, FFileView& OutView, uint32_t Flags = 0);
+void CloseFileView(FFileView& View);
+void PrefetchFileView(const FFileView& View, uint64_t Offset, uint64_t Size);
+bool MountArchive(const char* Name);
+void UnmountArchive();
+bool IsArchiveMounted();
+void UpdateFrameStats(FGraphicsContext& Gfx, const char* Name, double& OutTime, float& OutDeltaTime);
+void GetMemoryUsage(const FGraphicsContext& Gfx, FMemoryUsage& OutUsage);
+void ShowFrameStatsWindow(const FFrameStats& Stats, const char* DumpFileName);
+bool WriteFrameStats(const FFrameStats& Stats, const char* FileName);
+void ShowCPUMemoryWindow(const char* ReportFileName);
 double GetTime();
 HWND CreateSimpleWindow(const char* Name, uint32_t Width, uint32_t Height);
 
@@ -0,0 +1,145 @@
+#include "NullCommandList.h"
+#include "EASTL/algorithm.h"
+
+
+static const char* const kNullCommandNames[NullCommand_Count] =
+{
+#define NULL_COMMAND_NAME(Name) #Name,
+	NULL_COMMANDS(NULL_COMMAND_NAME)
+#undef NULL_COMMAND_NAME
+};
+
+class FNullCommandList final : public ID3D12GraphicsCommandList5
+{
+public:
+	eastl::vector<uint32_t> Stream;
+	FNullCommandStats Stats = {};
+	ULONG RefCount = 1;
+
+	template<typename... TArgs>
+	void Record(ENullCommand Command, TArgs... Args)
+	{
+		const uint32_t Words[] = { (uint32_t)Command | ((uint32_t)sizeof...(Args) << 16), (uint32_t)Args... };
+		Stream.insert(Stream.end(), Words, Words + eastl::size(Words));
+		Stats.NumCalls[Command] += 1;
+		Stats.NumStreamWords += eastl::size(Words);
+	}
+
+	// IUnknown, ID3D12Object, ID3D12DeviceChild, ID3D12CommandList.
+	HRESULT STDMETHODCALLTYPE QueryInterface(REFIID, void** OutObject) override { *OutObject = nullptr; return E_NOINTERFACE; }
+	ULONG STDMETHODCALLTYPE AddRef() override { return ++RefCount; }
+	ULONG STDMETHODCALLTYPE Release() override
+	{
+		const ULONG Count = --RefCount;
+		if (Count == 0)
+		{
+			delete this;
+		}
+		return Count;
+	}
+	HRESULT STDMETHODCALLTYPE GetPrivateData(REFGUID, UINT*, void*) override { return E_NOTIMPL; }
+	HRESULT STDMETHODCALLTYPE SetPrivateData(REFGUID, UINT, const void*) override { return S_OK; }
+	HRESULT STDMETHODCALLTYPE SetPrivateDataInterface(REFGUID, const IUnknown*) override { return S_OK; }
+	HRESULT STDMETHODCALLTYPE SetName(LPCWSTR) override { return S_OK; }
+	HRESULT STDMETHODCALLTYPE GetDevice(REFIID, void** OutDevice) override { *OutDevice = nullptr; return E_NOTIMPL; }
+	D3D12_COMMAND_LIST_TYPE STDMETHODCALLTYPE GetType() override { return D3D12_COMMAND_LIST_TYPE_DIRECT; }
+
+	// ID3D12GraphicsCommandList.
+	HRESULT STDMETHODCALLTYPE Close() override { Record(NullCommand_Close); return S_OK; }
+	HRESULT STDMETHODCALLTYPE Reset(ID3D12CommandAllocator*, ID3D12PipelineState*) override { Stream.clear(); Record(NullCommand_Reset); return S_OK; }
+	void STDMETHODCALLTYPE ClearState(ID3D12PipelineState*) override { Record(NullCommand_ClearState); }
+	void STDMETHODCALLTYPE DrawInstanced(UINT NumVertices, UINT NumInstances, UINT, UINT) override { Record(NullCommand_DrawInstanced, NumVertices, NumInstances); }
+	void STDMETHODCALLTYPE DrawIndexedInstanced(UINT NumIndices, UINT NumInstances, UINT, INT, UINT) override { Record(NullCommand_DrawIndexedInstanced, NumIndices, NumInstances); }
+	void STDMETHODCALLTYPE Dispatch(UINT X, UINT Y, UINT Z) override { Record(NullCommand_Dispatch, X, Y, Z); }
+	void STDMETHODCALLTYPE CopyBufferRegion(ID3D12Resource*, UINT64, ID3D12Resource*, UINT64, UINT64 Size) override { Record(NullCommand_CopyBufferRegion, Size); }
+	void STDMETHODCALLTYPE CopyTextureRegion(const D3D12_TEXTURE_COPY_LOCATION*, UINT, UINT, UINT, const D3D12_TEXTURE_COPY_LOCATION*, const D3D12_BOX*) override { Record(NullCommand_CopyTextureRegion); }
+	void STDMETHODCALLTYPE CopyResource(ID3D12Resource*, ID3D12Resource*) override { Record(NullCommand_CopyResource); }
+	void STDMETHODCALLTYPE CopyTiles(ID3D12Resource*, const D3D12_TILED_RESOURCE_COORDINATE*, const D3D12_TILE_REGION_SIZE*, ID3D12Resource*, UINT64, D3D12_TILE_COPY_FLAGS) override { Record(NullCommand_CopyTiles); }
+	void STDMETHODCALLTYPE ResolveSubresource(ID3D12Resource*, UINT, ID3D12Resource*, UINT, DXGI_FORMAT) override { Record(NullCommand_ResolveSubresource); }
+	void STDMETHODCALLTYPE IASetPrimitiveTopology(D3D12_PRIMITIVE_TOPOLOGY Topology) override { Record(NullCommand_IASetPrimitiveTopology, Topology); }
+	void STDMETHODCALLTYPE RSSetViewports(UINT Count, const D3D12_VIEWPORT*) override { Record(NullCommand_RSSetViewports, Count); }
+	void STDMETHODCALLTYPE RSSetScissorRects(UINT Count, const D3D12_RECT*) override { Record(NullCommand_RSSetScissorRects, Count); }
+	void STDMETHODCALLTYPE OMSetBlendFactor(const FLOAT[4]) override { Record(NullCommand_OMSetBlendFactor); }
+	void STDMETHODCALLTYPE OMSetStencilRef(UINT StencilRef) override { Record(NullCommand_OMSetStencilRef, StencilRef); }
+	void STDMETHODCALLTYPE SetPipelineState(ID3D12PipelineState*) override { Record(NullCommand_SetPipelineState); }
+	void STDMETHODCALLTYPE ResourceBarrier(UINT Count, const D3D12_RESOURCE_BARRIER*) override { Record(NullCommand_ResourceBarrier, Count); }
+	void STDMETHODCALLTYPE ExecuteBundle(ID3D12GraphicsCommandList*) override { Record(NullCommand_ExecuteBundle); }
+	void STDMETHODCALLTYPE SetDescriptorHeaps(UINT Count, ID3D12DescriptorHeap* const*) override { Record(NullCommand_SetDescriptorHeaps, Count); }
+	void STDMETHODCALLTYPE SetComputeRootSignature(ID3D12RootSignature*) override { Record(NullCommand_SetComputeRootSignature); }
+	void STDMETHODCALLTYPE SetGraphicsRootSignature(ID3D12RootSignature*) override { Record(NullCommand_SetGraphicsRootSignature); }
+	void STDMETHODCALLTYPE SetComputeRootDescriptorTable(UINT Index, D3D12_GPU_DESCRIPTOR_HANDLE) override { Record(NullCommand_SetComputeRootDescriptorTable, Index); }
+	void STDMETHODCALLTYPE SetGraphicsRootDescriptorTable(UINT Index, D3D12_GPU_DESCRIPTOR_HANDLE) override { Record(NullCommand_SetGraphicsRootDescriptorTable, Index); }
+	void STDMETHODCALLTYPE SetComputeRoot32BitConstant(UINT Index, UINT, UINT) override { Record(NullCommand_SetComputeRoot32BitConstant, Index); }
+	void STDMETHODCALLTYPE SetGraphicsRoot32BitConstant(UINT Index, UINT, UINT) override { Record(NullCommand_SetGraphicsRoot32BitConstant, Index); }
+	void STDMETHODCALLTYPE SetComputeRoot32BitConstants(UINT Index, UINT Count, const void*, UINT) override { Record(NullCommand_SetComputeRoot32BitConstants, Index, Count); }
+	void STDMETHODCALLTYPE SetGraphicsRoot32BitConstants(UINT Index, UINT Count, const void*, UINT) override { Record(NullCommand_SetGraphicsRoot32BitConstants, Index, Count); }
+	void STDMETHODCALLTYPE SetComputeRootConstantBufferView(UINT Index, D3D12_GPU_VIRTUAL_ADDRESS) override { Record(NullCommand_SetComputeRootConstantBufferView, Index); }
+	void STDMETHODCALLTYPE SetGraphicsRootConstantBufferView(UINT Index, D3D12_GPU_VIRTUAL_ADDRESS) override { Record(NullCommand_SetGraphicsRootConstantBufferView, Index); }
+	void STDMETHODCALLTYPE SetComputeRootShaderResourceView(UINT Index, D3D12_GPU_VIRTUAL_ADDRESS) override { Record(NullCommand_SetComputeRootShaderResourceView, Index); }
+	void STDMETHODCALLTYPE SetGraphicsRootShaderResourceView(UINT Index, D3D12_GPU_VIRTUAL_ADDRESS) override { Record(NullCommand_SetGraphicsRootShaderResourceView, Index); }
+	void STDMETHODCALLTYPE SetComputeRootUnorderedAccessView(UINT Index, D3D12_GPU_VIRTUAL_ADDRESS) override { Record(NullCommand_SetComputeRootUnorderedAccessView, Index); }
+	void STDMETHODCALLTYPE SetGraphicsRootUnorderedAccessView(UINT Index, D3D12_GPU_VIRTUAL_ADDRESS) override { Record(NullCommand_SetGraphicsRootUnorderedAccessView, Index); }
+	void STDMETHODCALLTYPE IASetIndexBuffer(const D3D12_INDEX_BUFFER_VIEW*) override { Record(NullCommand_IASetIndexBuffer); }
+	void STDMETHODCALLTYPE IASetVertexBuffers(UINT StartSlot, UINT Count, const D3D12_VERTEX_BUFFER_VIEW*) override { Record(NullCommand_IASetVertexBuffers, StartSlot, Count); }
+	void STDMETHODCALLTYPE SOSetTargets(UINT StartSlot, UINT Count, const D3D12_STREAM_OUTPUT_BUFFER_VIEW*) override { Record(NullCommand_SOSetTargets, StartSlot, Count); }
+	void STDMETHODCALLTYPE OMSetRenderTargets(UINT Count, const D3D12_CPU_DESCRIPTOR_HANDLE*, BOOL, const D3D12_CPU_DESCRIPTOR_HANDLE*) override { Record(NullCommand_OMSetRenderTargets, Count); }
+	void STDMETHODCALLTYPE ClearDepthStencilView(D3D12_CPU_DESCRIPTOR_HANDLE, D3D12_CLEAR_FLAGS, FLOAT, UINT8, UINT, const D3D12_RECT*) override { Record(NullCommand_ClearDepthStencilView); }
+	void STDMETHODCALLTYPE ClearRenderTargetView(D3D12_CPU_DESCRIPTOR_HANDLE, const FLOAT[4], UINT, const D3D12_RECT*) override { Record(NullCommand_ClearRenderTargetView); }
+	void STDMETHODCALLTYPE ClearUnorderedAccessViewUint(D3D12_GPU_DESCRIPTOR_HANDLE, D3D12_CPU_DESCRIPTOR_HANDLE, ID3D12Resource*, const UINT[4], UINT, const D3D12_RECT*) override { Record(NullCommand_ClearUnorderedAccessViewUint); }
+	void STDMETHODCALLTYPE ClearUnorderedAccessViewFloat(D3D12_GPU_DESCRIPTOR_HANDLE, D3D12_CPU_DESCRIPTOR_HANDLE, ID3D12Resource*, const FLOAT[4], UINT, const D3D12_RECT*) override { Record(NullCommand_ClearUnorderedAccessViewFloat); }
+	void STDMETHODCALLTYPE DiscardResource(ID3D12Resource*, const D3D12_DISCARD_REGION*) override { Record(NullCommand_DiscardResource); }
+	void STDMETHODCALLTYPE BeginQuery(ID3D12QueryHeap*, D3D12_QUERY_TYPE Type, UINT Index) override { Record(NullCommand_BeginQuery, Type, Index); }
+	void STDMETHODCALLTYPE EndQuery(ID3D12QueryHeap*, D3D12_QUERY_TYPE Type, UINT Index) override { Record(NullCommand_EndQuery, Type, Index); }
+	void STDMETHODCALLTYPE ResolveQueryData(ID3D12QueryHeap*, D3D12_QUERY_TYPE Type, UINT StartIndex, UINT Count, ID3D12Resource*, UINT64) override { Record(NullCommand_ResolveQueryData, Type, StartIndex, Count); }
+	void STDMETHODCALLTYPE SetPredication(ID3D12Resource*, UINT64, D3D12_PREDICATION_OP) override { Record(NullCommand_SetPredication); }
+	void STDMETHODCALLTYPE SetMarker(UINT, const void*, UINT) override { Record(NullCommand_SetMarker); }
+	void STDMETHODCALLTYPE BeginEvent(UINT, const void*, UINT) override { Record(NullCommand_BeginEvent); }
+	void STDMETHODCALLTYPE EndEvent() override { Record(NullCommand_EndEvent); }
+	void STDMETHODCALLTYPE ExecuteIndirect(ID3D12CommandSignature*, UINT MaxCount, ID3D12Resource*, UINT64, ID3D12Resource*, UINT64) override { Record(NullCommand_ExecuteIndirect, MaxCount); }
+
+	// ID3D12GraphicsCommandList1.
+	void STDMETHODCALLTYPE AtomicCopyBufferUINT(ID3D12Resource*, UINT64, ID3D12Resource*, UINT64, UINT, ID3D12Resource* const*, const D3D12_SUBRESOURCE_RANGE_UINT64*) override { Record(NullCommand_AtomicCopyBufferUINT); }
+	void STDMETHODCALLTYPE AtomicCopyBufferUINT64(ID3D12Resource*, UINT64, ID3D12Resource*, UINT64, UINT, ID3D12Resource* const*, const D3D12_SUBRESOURCE_RANGE_UINT64*) override { Record(NullCommand_AtomicCopyBufferUINT64); }
+	void STDMETHODCALLTYPE OMSetDepthBounds(FLOAT, FLOAT) override { Record(NullCommand_OMSetDepthBounds); }
+	void STDMETHODCALLTYPE SetSamplePositions(UINT, UINT, D3D12_SAMPLE_POSITION*) override { Record(NullCommand_SetSamplePositions); }
+	void STDMETHODCALLTYPE ResolveSubresourceRegion(ID3D12Resource*, UINT, UINT, UINT, ID3D12Resource*, UINT, D3D12_RECT*, DXGI_FORMAT, D3D12_RESOLVE_MODE) override { Record(NullCommand_ResolveSubresourceRegion); }
+	void STDMETHODCALLTYPE SetViewInstanceMask(UINT Mask) override { Record(NullCommand_SetViewInstanceMask, Mask); }
+
+	// ID3D12GraphicsCommandList2, ID3D12GraphicsCommandList3.
+	void STDMETHODCALLTYPE WriteBufferImmediate(UINT Count, const D3D12_WRITEBUFFERIMMEDIATE_PARAMETER*, const D3D12_WRITEBUFFERIMMEDIATE_MODE*) override { Record(NullCommand_WriteBufferImmediate, Count); }
+	void STDMETHODCALLTYPE SetProtectedResourceSession(ID3D12ProtectedResourceSession*) override { Record(NullCommand_SetProtectedResourceSession); }
+
+	// ID3D12GraphicsCommandList4.
+	void STDMETHODCALLTYPE BeginRenderPass(UINT Count, const D3D12_RENDER_PASS_RENDER_TARGET_DESC*, const D3D12_RENDER_PASS_DEPTH_STENCIL_DESC*, D3D12_RENDER_PASS_FLAGS) override { Record(NullCommand_BeginRenderPass, Count); }
+	void STDMETHODCALLTYPE EndRenderPass() override { Record(NullCommand_EndRenderPass); }
+	void STDMETHODCALLTYPE InitializeMetaCommand(ID3D12MetaCommand*, const void*, SIZE_T) override { Record(NullCommand_InitializeMetaCommand); }
+	void STDMETHODCALLTYPE ExecuteMetaCommand(ID3D12MetaCommand*, const void*, SIZE_T) override { Record(NullCommand_ExecuteMetaCommand); }
+	void STDMETHODCALLTYPE BuildRaytracingAccelerationStructure(const D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC* Desc, UINT NumPostbuildInfoDescs, const D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_DESC*) override { Record(NullCommand_BuildRaytracingAccelerationStructure, Desc->Inputs.Type, Desc->Inputs.NumDescs, NumPostbuildInfoDescs); }
+	void STDMETHODCALLTYPE EmitRaytracingAccelerationStructurePostbuildInfo(const D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_DESC*, UINT Count, const D3D12_GPU_VIRTUAL_ADDRESS*) override { Record(NullCommand_EmitRaytracingAccelerationStructurePostbuildInfo, Count); }
+	void STDMETHODCALLTYPE CopyRaytracingAccelerationStructure(D3D12_GPU_VIRTUAL_ADDRESS, D3D12_GPU_VIRTUAL_ADDRESS, D3D12_RAYTRACING_ACCELERATION_STRUCTURE_COPY_MODE Mode) override { Record(NullCommand_CopyRaytracingAccelerationStructure, Mode); }
+	void STDMETHODCALLTYPE SetPipelineState1(ID3D12StateObject*) override { Record(NullCommand_SetPipelineState1); }
+	void STDMETHODCALLTYPE DispatchRays(const D3D12_DISPATCH_RAYS_DESC* Desc) override { Record(NullCommand_DispatchRays, Desc->Width, Desc->Height, Desc->Depth); }
+
+	// ID3D12GraphicsCommandList5.
+	void STDMETHODCALLTYPE RSSetShadingRate(D3D12_SHADING_RATE Rate, const D3D12_SHADING_RATE_COMBINER*) override { Record(NullCommand_RSSetShadingRate, Rate); }
+	void STDMETHODCALLTYPE RSSetShadingRateImage(ID3D12Resource*) override { Record(NullCommand_RSSetShadingRateImage); }
+};
+
+ID3D12GraphicsCommandList5* CreateNullCommandList()
+{
+	auto* CmdList = new FNullCommandList();
+	CmdList->Stream.reserve(64 * 1024);
+	return CmdList;
+}
+
+// CmdList has to come from CreateNullCommandList.
+void GetNullCommandStats(ID3D12GraphicsCommandList5* CmdList, FNullCommandStats& OutStats)
+{
+	OutStats = static_cast<FNullCommandList*>(CmdList)->Stats;
+}
+
+const char* GetNullCommandName(uint32_t Command)
+{
+	EA_ASSERT(Command < NullCommand_Count);
+	return kNullCommandNames[Command];
+}
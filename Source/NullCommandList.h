@@ -0,0 +1,45 @@
+#pragma once
+
+#include "Library.h"
+
+// Command list that executes nothing. Every call is appended to a compact command stream (a header word with the
+// command and the number of argument words, followed by the few scalar arguments worth keeping) and counted, so the
+// CPU cost of building a frame can be measured without driver and GPU in the way. See UseNullCommandList.
+
+#define NULL_COMMANDS(X) \
+	X(Close) X(Reset) X(ClearState) X(DrawInstanced) X(DrawIndexedInstanced) X(Dispatch) X(CopyBufferRegion) \
+	X(CopyTextureRegion) X(CopyResource) X(CopyTiles) X(ResolveSubresource) X(IASetPrimitiveTopology) \
+	X(RSSetViewports) X(RSSetScissorRects) X(OMSetBlendFactor) X(OMSetStencilRef) X(SetPipelineState) \
+	X(ResourceBarrier) X(ExecuteBundle) X(SetDescriptorHeaps) X(SetComputeRootSignature) \
+	X(SetGraphicsRootSignature) X(SetComputeRootDescriptorTable) X(SetGraphicsRootDescriptorTable) \
+	X(SetComputeRoot32BitConstant) X(SetGraphicsRoot32BitConstant) X(SetComputeRoot32BitConstants) \
+	X(SetGraphicsRoot32BitConstants) X(SetComputeRootConstantBufferView) X(SetGraphicsRootConstantBufferView) \
+	X(SetComputeRootShaderResourceView) X(SetGraphicsRootShaderResourceView) X(SetComputeRootUnorderedAccessView) \
+	X(SetGraphicsRootUnorderedAccessView) X(IASetIndexBuffer) X(IASetVertexBuffers) X(SOSetTargets) \
+	X(OMSetRenderTargets) X(ClearDepthStencilView) X(ClearRenderTargetView) X(ClearUnorderedAccessViewUint) \
+	X(ClearUnorderedAccessViewFloat) X(DiscardResource) X(BeginQuery) X(EndQuery) X(ResolveQueryData) \
+	X(SetPredication) X(SetMarker) X(BeginEvent) X(EndEvent) X(ExecuteIndirect) X(AtomicCopyBufferUINT) \
+	X(AtomicCopyBufferUINT64) X(OMSetDepthBounds) X(SetSamplePositions) X(ResolveSubresourceRegion) \
+	X(SetViewInstanceMask) X(WriteBufferImmediate) X(SetProtectedResourceSession) X(BeginRenderPass) \
+	X(EndRenderPass) X(InitializeMetaCommand) X(ExecuteMetaCommand) X(BuildRaytracingAccelerationStructure) \
+	X(EmitRaytracingAccelerationStructurePostbuildInfo) X(CopyRaytracingAccelerationStructure) \
+	X(SetPipelineState1) X(DispatchRays) X(RSSetShadingRate) X(RSSetShadingRateImage)
+
+enum ENullCommand
+{
+#define NULL_COMMAND_ENUM(Name) NullCommand_##Name,
+	NULL_COMMANDS(NULL_COMMAND_ENUM)
+#undef NULL_COMMAND_ENUM
+	NullCommand_Count,
+};
+
+// Totals since the command list was created, the stream itself only holds commands recorded since the last Reset.
+struct FNullCommandStats
+{
+	uint64_t NumCalls[NullCommand_Count];
+	uint64_t NumStreamWords;
+};
+
+ID3D12GraphicsCommandList5* CreateNullCommandList();
+void GetNullCommandStats(ID3D12GraphicsCommandList5* CmdList, FNullCommandStats& OutStats);
+const char* GetNullCommandName(uint32_t Command);
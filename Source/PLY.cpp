@@ -0,0 +1,213 @@
+#include "PLY.h"
+#include "CPUProfiler.h"
+#include "EAAssert/eaassert.h"
+#include "EASTL/algorithm.h"
+#include "EAStdC/EAString.h"
+#include "EAStdC/EATextUtil.h"
+
+// Copies the next line (including '\n', without '\r') like fgets does. Returns nullptr at the end of the file.
+static char* ReadPLYLine(FPLYFile& File, char* OutLine, uint32_t LineSize)
+{
+	if (File.Cursor >= File.Size)
+	{
+		return nullptr;
+	}
+
+	uint32_t Length = 0;
+	while (File.Cursor < File.Size && Length + 1 < LineSize)
+	{
+		const char C = (char)File.Data[File.Cursor++];
+		if (C != '\r')
+		{
+			OutLine[Length++] = C;
+		}
+		if (C == '\n')
+		{
+			break;
+		}
+	}
+	OutLine[Length] = '\0';
+	return OutLine;
+}
+
+// False when Line holds no further number.
+static bool ReadPLYFloat(char*& Line, float& OutValue)
+{
+	char* End;
+	OutValue = EA::StdC::StrtoF32(Line, &End);
+	const bool bIsParsed = End != Line;
+	Line = End;
+	return bIsParsed;
+}
+
+static bool ReadPLYUint(char*& Line, uint32_t& OutValue)
+{
+	char* End;
+	OutValue = EA::StdC::StrtoU32(Line, &End, 10);
+	const bool bIsParsed = End != Line;
+	Line = End;
+	return bIsParsed;
+}
+
+bool ParsePLYHeader(const uint8_t* Data, uint64_t Size, FPLYFile& OutFile)
+{
+	CPU_ZONE("ParsePLYHeader");
+	using namespace EA::StdC;
+	OutFile = {};
+	OutFile.Data = Data;
+	OutFile.Size = Size;
+
+	char LineBuffer[1024];
+	char Token[64];
+	uint32_t NumVertices = UINT32_MAX;
+	uint32_t NumTriangles = UINT32_MAX;
+
+	struct FProperty
+	{
+		const char* Name;
+		bool bIsPresent;
+	} Properties[] =
+	{
+		{ "x\n", false }, { "y\n", false }, { "z\n", false },
+		{ "nx\n", false }, { "ny\n", false }, { "nz\n", false },
+		{ "s\n", false }, { "t\n", false },
+	};
+	bool bHasPositions = false;
+
+	while (ReadPLYLine(OutFile, LineBuffer, sizeof(LineBuffer)))
+	{
+		const char* Line = LineBuffer;
+		while (SplitTokenSeparated(Line, kLengthNull, ' ', Token, sizeof(Token), &Line))
+		{
+			if (Strcmp(Token, "comment") == 0 || Strcmp(Token, "format") == 0)
+			{
+				break; // Skip the line.
+			}
+			else if (Strcmp(Token, "vertex") == 0)
+			{
+				NumVertices = AtoU32(Line);
+			}
+			else if (Strcmp(Token, "face") == 0)
+			{
+				NumTriangles = AtoU32(Line);
+			}
+			else if (Strcmp(Token, "float") == 0)
+			{
+				for (uint32_t Idx = 0; Idx < eastl::size(Properties); ++Idx)
+				{
+					if (Strcmp(Line, Properties[Idx].Name) == 0)
+					{
+						Properties[Idx].bIsPresent = true;
+						break;
+					}
+				}
+			}
+			else if (Strcmp(Token, "end_header\n") == 0)
+			{
+				bHasPositions = Properties[0].bIsPresent && Properties[1].bIsPresent && Properties[2].bIsPresent;
+				OutFile.bHasNormals = Properties[3].bIsPresent && Properties[4].bIsPresent && Properties[5].bIsPresent;
+				OutFile.bHasTexcoords = Properties[6].bIsPresent && Properties[7].bIsPresent;
+				goto HeaderIsDone;
+			}
+		}
+	}
+HeaderIsDone:
+
+	if (!bHasPositions || NumVertices == UINT32_MAX || NumTriangles == UINT32_MAX)
+	{
+		return false;
+	}
+
+	// Vertex lines take at least 6 bytes ("0 0 0\n") and face lines 8, counts the rest of the file cannot hold are
+	// rejected before the caller sizes anything by them. Indices are addressed with 32 bits.
+	if (NumTriangles > UINT32_MAX / 3 || NumVertices * 6ull + NumTriangles * 8ull > Size - OutFile.Cursor)
+	{
+		return false;
+	}
+
+	OutFile.NumVertices = NumVertices;
+	OutFile.NumTriangles = NumTriangles;
+	return true;
+}
+
+uint32_t ReadPLYVertices(FPLYFile& File, uint32_t MaxCount, XMFLOAT3* OutPositions, XMFLOAT3* OutNormals, XMFLOAT2* OutTexcoords)
+{
+	CPU_ZONE("ReadPLYVertices");
+	EA_ASSERT(File.Data && OutPositions);
+
+	const uint32_t MaxIdx = File.bIsCorrupt ? 0 : eastl::min(MaxCount, File.NumVertices - File.NumVerticesRead);
+	char LineBuffer[1024];
+
+	uint32_t Count = 0;
+	for (; Count < MaxIdx; ++Count)
+	{
+		char* Line = ReadPLYLine(File, LineBuffer, sizeof(LineBuffer));
+		XMFLOAT3 Position;
+		if (!Line || !ReadPLYFloat(Line, Position.x) || !ReadPLYFloat(Line, Position.y) || !ReadPLYFloat(Line, Position.z))
+		{
+			File.bIsCorrupt = true;
+			break;
+		}
+		OutPositions[Count] = Position;
+
+		if (File.bHasNormals)
+		{
+			XMFLOAT3 Normal;
+			if (!ReadPLYFloat(Line, Normal.x) || !ReadPLYFloat(Line, Normal.y) || !ReadPLYFloat(Line, Normal.z))
+			{
+				File.bIsCorrupt = true;
+				break;
+			}
+			if (OutNormals)
+			{
+				OutNormals[Count] = Normal;
+			}
+		}
+		if (File.bHasTexcoords)
+		{
+			XMFLOAT2 Texcoord;
+			if (!ReadPLYFloat(Line, Texcoord.x) || !ReadPLYFloat(Line, Texcoord.y))
+			{
+				File.bIsCorrupt = true;
+				break;
+			}
+			if (OutTexcoords)
+			{
+				OutTexcoords[Count] = Texcoord;
+			}
+		}
+	}
+
+	File.NumVerticesRead += Count;
+	return Count;
+}
+
+uint32_t ReadPLYTriangles(FPLYFile& File, uint32_t MaxCount, uint32_t* OutTriangles)
+{
+	CPU_ZONE("ReadPLYTriangles");
+	EA_ASSERT(File.Data && OutTriangles);
+	// Faces follow all vertex lines in the file.
+	EA_ASSERT(File.bIsCorrupt || File.NumVerticesRead == File.NumVertices);
+
+	const uint32_t MaxIdx = File.bIsCorrupt ? 0 : eastl::min(MaxCount, File.NumTriangles - File.NumTrianglesRead);
+	char LineBuffer[1024];
+
+	uint32_t Count = 0;
+	for (; Count < MaxIdx; ++Count)
+	{
+		// Indices go to the GPU as is, out of range ones would read other meshes' vertices.
+		char* Line = ReadPLYLine(File, LineBuffer, sizeof(LineBuffer));
+		uint32_t NumIndices;
+		uint32_t* Triangle = OutTriangles + Count * 3;
+		if (!Line || !ReadPLYUint(Line, NumIndices) || NumIndices != 3 ||
+			!ReadPLYUint(Line, Triangle[0]) || !ReadPLYUint(Line, Triangle[1]) || !ReadPLYUint(Line, Triangle[2]) ||
+			eastl::max(eastl::max(Triangle[0], Triangle[1]), Triangle[2]) >= File.NumVertices)
+		{
+			File.bIsCorrupt = true;
+			break;
+		}
+	}
+
+	File.NumTrianglesRead += Count;
+	return Count;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <stdint.h>
+#include "DirectXMath/DirectXMath.h"
+
+// Forward-only reader of ASCII PLY meshes. Vertices and faces are pulled in windows so large meshes never have to be
+// resident in CPU memory at once, the application maps the file with OpenFileView and ParsePLYHeader works on its
+// contents. It needs neither the device nor Win32, the headless tests (Tests/) build it.
+struct FPLYFile
+{
+	const uint8_t* Data;
+	uint64_t Size;
+	uint64_t Cursor;
+	uint32_t NumVertices;
+	uint32_t NumTriangles;
+	uint32_t NumVerticesRead;
+	uint32_t NumTrianglesRead;
+	bool bHasNormals;
+	bool bHasTexcoords;
+	bool bIsCorrupt; // A window came back short because the file ended early or a line did not parse.
+};
+
+// Reads up to the end of the header, the file is valid while Data is.
+bool ParsePLYHeader(const uint8_t* Data, uint64_t Size, FPLYFile& OutFile);
+
+// Both return the number of elements read. That is below MaxCount at the end of the element list and when the file is
+// corrupt, which sets bIsCorrupt. Faces have to be triangles with indices below NumVertices.
+uint32_t ReadPLYVertices(FPLYFile& File, uint32_t MaxCount, XMFLOAT3* OutPositions, XMFLOAT3* OutNormals, XMFLOAT2* OutTexcoords);
+uint32_t ReadPLYTriangles(FPLYFile& File, uint32_t MaxCount, uint32_t* OutTriangles);
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <stdint.h>
+#include <d3d12.h>
+
+// Keys and file format of the pipeline cache (FPipelineCache in Library.h). Both need neither the device nor Win32,
+// PipelineCacheKeys.cpp is built by the headless tests (Tests/).
+
+// Start of the cache file, the serialized ID3D12PipelineLibrary1 follows. Fixed-size fields only, the layout is the same
+// for every compiler.
+struct FPipelineCacheHeader
+{
+	uint32_t Magic;
+	uint32_t Version;
+	uint64_t DataSize;
+	uint64_t DataHash; // CRC64 of the DataSize bytes after the header.
+	uint64_t Reserved;
+};
+static_assert(sizeof(FPipelineCacheHeader) == 32, "Pipeline cache header layout changed, bump kPipelineCacheVersion");
+
+static const uint32_t kPipelineCacheMagic = 0x43505844; // 'DXPC'
+static const uint32_t kPipelineCacheVersion = 2; // 2: keys hash the desc fields instead of the desc bytes.
+
+FPipelineCacheHeader MakePipelineCacheHeader(const void* Data, uint64_t DataSize);
+const uint8_t* GetPipelineCacheData(const uint8_t* File, uint64_t FileSize, uint64_t& OutDataSize);
+
+uint64_t GetGraphicsPipelineKey(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& Desc);
+uint64_t GetComputePipelineKey(const D3D12_COMPUTE_PIPELINE_STATE_DESC& Desc);
@@ -0,0 +1,191 @@
+#include "PipelineCache.h"
+#include <string.h>
+#include "EASTL/type_traits.h"
+#include "EAStdC/EAHashCRC.h"
+
+// Header for a cache file whose serialized library is the DataSize bytes at Data.
+FPipelineCacheHeader MakePipelineCacheHeader(const void* Data, uint64_t DataSize)
+{
+	FPipelineCacheHeader Header = {};
+	Header.Magic = kPipelineCacheMagic;
+	Header.Version = kPipelineCacheVersion;
+	Header.DataSize = DataSize;
+	Header.DataHash = EA::StdC::CRC64(Data, (size_t)DataSize);
+	return Header;
+}
+
+// Serialized library in the file contents, nullptr when the file is not ours, of another version, truncated, extended or
+// corrupt. The driver validates the rest (CreatePipelineLibrary).
+const uint8_t* GetPipelineCacheData(const uint8_t* File, uint64_t FileSize, uint64_t& OutDataSize)
+{
+	OutDataSize = 0;
+	FPipelineCacheHeader Header;
+	if (!File || FileSize < sizeof(Header))
+	{
+		return nullptr;
+	}
+	memcpy(&Header, File, sizeof(Header));
+	const uint8_t* Data = File + sizeof(Header);
+
+	if (Header.Magic != kPipelineCacheMagic || Header.Version != kPipelineCacheVersion || Header.DataSize != FileSize - sizeof(Header) ||
+		Header.DataHash != EA::StdC::CRC64(Data, (size_t)Header.DataSize))
+	{
+		return nullptr;
+	}
+	OutDataSize = Header.DataSize;
+	return Data;
+}
+
+// Fields are hashed one by one, never whole structs, so that padding bytes do not reach the key.
+template<typename T>
+static uint64_t HashValue(const T& Value, uint64_t Key)
+{
+	static_assert(eastl::is_arithmetic<T>::value || eastl::is_enum<T>::value, "Hash the fields of structs separately");
+	return EA::StdC::CRC64(&Value, sizeof(Value), Key, false);
+}
+
+static uint64_t HashString(const char* String, uint64_t Key)
+{
+	// Length first so that a null name and an empty one differ and names cannot run into the next field.
+	const uint32_t Length = String ? (uint32_t)strlen(String) : ~0u;
+	Key = HashValue(Length, Key);
+	return String ? EA::StdC::CRC64(String, Length, Key, false) : Key;
+}
+
+static uint64_t HashShaderBytecode(const D3D12_SHADER_BYTECODE& Bytecode, uint64_t Key)
+{
+	Key = HashValue((uint64_t)Bytecode.BytecodeLength, Key);
+	return Bytecode.pShaderBytecode ? EA::StdC::CRC64(Bytecode.pShaderBytecode, Bytecode.BytecodeLength, Key, false) : Key;
+}
+
+static uint64_t HashStreamOutput(const D3D12_STREAM_OUTPUT_DESC& StreamOutput, uint64_t Key)
+{
+	Key = HashValue(StreamOutput.NumEntries, Key);
+	for (uint32_t Idx = 0; Idx < StreamOutput.NumEntries; ++Idx)
+	{
+		const D3D12_SO_DECLARATION_ENTRY& Entry = StreamOutput.pSODeclaration[Idx];
+		Key = HashValue(Entry.Stream, Key);
+		Key = HashString(Entry.SemanticName, Key);
+		Key = HashValue(Entry.SemanticIndex, Key);
+		Key = HashValue(Entry.StartComponent, Key);
+		Key = HashValue(Entry.ComponentCount, Key);
+		Key = HashValue(Entry.OutputSlot, Key);
+	}
+	Key = HashValue(StreamOutput.NumStrides, Key);
+	for (uint32_t Idx = 0; Idx < StreamOutput.NumStrides; ++Idx)
+	{
+		Key = HashValue(StreamOutput.pBufferStrides[Idx], Key);
+	}
+	return HashValue(StreamOutput.RasterizedStream, Key);
+}
+
+static uint64_t HashBlendState(const D3D12_BLEND_DESC& Blend, uint64_t Key)
+{
+	Key = HashValue(Blend.AlphaToCoverageEnable, Key);
+	Key = HashValue(Blend.IndependentBlendEnable, Key);
+	for (const D3D12_RENDER_TARGET_BLEND_DESC& Target : Blend.RenderTarget)
+	{
+		Key = HashValue(Target.BlendEnable, Key);
+		Key = HashValue(Target.LogicOpEnable, Key);
+		Key = HashValue(Target.SrcBlend, Key);
+		Key = HashValue(Target.DestBlend, Key);
+		Key = HashValue(Target.BlendOp, Key);
+		Key = HashValue(Target.SrcBlendAlpha, Key);
+		Key = HashValue(Target.DestBlendAlpha, Key);
+		Key = HashValue(Target.BlendOpAlpha, Key);
+		Key = HashValue(Target.LogicOp, Key);
+		Key = HashValue(Target.RenderTargetWriteMask, Key);
+	}
+	return Key;
+}
+
+static uint64_t HashRasterizerState(const D3D12_RASTERIZER_DESC& Rasterizer, uint64_t Key)
+{
+	Key = HashValue(Rasterizer.FillMode, Key);
+	Key = HashValue(Rasterizer.CullMode, Key);
+	Key = HashValue(Rasterizer.FrontCounterClockwise, Key);
+	Key = HashValue(Rasterizer.DepthBias, Key);
+	Key = HashValue(Rasterizer.DepthBiasClamp, Key);
+	Key = HashValue(Rasterizer.SlopeScaledDepthBias, Key);
+	Key = HashValue(Rasterizer.DepthClipEnable, Key);
+	Key = HashValue(Rasterizer.MultisampleEnable, Key);
+	Key = HashValue(Rasterizer.AntialiasedLineEnable, Key);
+	Key = HashValue(Rasterizer.ForcedSampleCount, Key);
+	return HashValue(Rasterizer.ConservativeRaster, Key);
+}
+
+static uint64_t HashStencilOp(const D3D12_DEPTH_STENCILOP_DESC& Op, uint64_t Key)
+{
+	Key = HashValue(Op.StencilFailOp, Key);
+	Key = HashValue(Op.StencilDepthFailOp, Key);
+	Key = HashValue(Op.StencilPassOp, Key);
+	return HashValue(Op.StencilFunc, Key);
+}
+
+static uint64_t HashDepthStencilState(const D3D12_DEPTH_STENCIL_DESC& DepthStencil, uint64_t Key)
+{
+	Key = HashValue(DepthStencil.DepthEnable, Key);
+	Key = HashValue(DepthStencil.DepthWriteMask, Key);
+	Key = HashValue(DepthStencil.DepthFunc, Key);
+	Key = HashValue(DepthStencil.StencilEnable, Key);
+	Key = HashValue(DepthStencil.StencilReadMask, Key);
+	Key = HashValue(DepthStencil.StencilWriteMask, Key);
+	Key = HashStencilOp(DepthStencil.FrontFace, Key);
+	return HashStencilOp(DepthStencil.BackFace, Key);
+}
+
+static uint64_t HashInputLayout(const D3D12_INPUT_LAYOUT_DESC& InputLayout, uint64_t Key)
+{
+	Key = HashValue(InputLayout.NumElements, Key);
+	for (uint32_t Idx = 0; Idx < InputLayout.NumElements; ++Idx)
+	{
+		const D3D12_INPUT_ELEMENT_DESC& Element = InputLayout.pInputElementDescs[Idx];
+		Key = HashString(Element.SemanticName, Key);
+		Key = HashValue(Element.SemanticIndex, Key);
+		Key = HashValue(Element.Format, Key);
+		Key = HashValue(Element.InputSlot, Key);
+		Key = HashValue(Element.AlignedByteOffset, Key);
+		Key = HashValue(Element.InputSlotClass, Key);
+		Key = HashValue(Element.InstanceDataStepRate, Key);
+	}
+	return Key;
+}
+
+// Root signature object and cached PSO blob are not part of the key, root signatures in this project are embedded in the
+// shader bytecode.
+uint64_t GetGraphicsPipelineKey(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& Desc)
+{
+	uint64_t Key = EA::StdC::kCRC64InitialValue;
+	Key = HashShaderBytecode(Desc.VS, Key);
+	Key = HashShaderBytecode(Desc.PS, Key);
+	Key = HashShaderBytecode(Desc.DS, Key);
+	Key = HashShaderBytecode(Desc.HS, Key);
+	Key = HashShaderBytecode(Desc.GS, Key);
+	Key = HashStreamOutput(Desc.StreamOutput, Key);
+	Key = HashBlendState(Desc.BlendState, Key);
+	Key = HashValue(Desc.SampleMask, Key);
+	Key = HashRasterizerState(Desc.RasterizerState, Key);
+	Key = HashDepthStencilState(Desc.DepthStencilState, Key);
+	Key = HashInputLayout(Desc.InputLayout, Key);
+	Key = HashValue(Desc.IBStripCutValue, Key);
+	Key = HashValue(Desc.PrimitiveTopologyType, Key);
+	Key = HashValue(Desc.NumRenderTargets, Key);
+	for (DXGI_FORMAT Format : Desc.RTVFormats)
+	{
+		Key = HashValue(Format, Key);
+	}
+	Key = HashValue(Desc.DSVFormat, Key);
+	Key = HashValue(Desc.SampleDesc.Count, Key);
+	Key = HashValue(Desc.SampleDesc.Quality, Key);
+	Key = HashValue(Desc.NodeMask, Key);
+	Key = HashValue(Desc.Flags, Key);
+	return EA::StdC::CRC64(nullptr, 0, Key, true);
+}
+
+uint64_t GetComputePipelineKey(const D3D12_COMPUTE_PIPELINE_STATE_DESC& Desc)
+{
+	uint64_t Key = HashShaderBytecode(Desc.CS, EA::StdC::kCRC64InitialValue);
+	Key = HashValue(Desc.NodeMask, Key);
+	Key = HashValue(Desc.Flags, Key);
+	return EA::StdC::CRC64(nullptr, 0, Key, true);
+}
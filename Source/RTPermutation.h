@@ -0,0 +1,46 @@
+#pragma once
+
+#include <stdint.h>
+#include "CPUAndGPUCommon.h"
+
+// RT pipeline permutations. Each key has its own DXIL library (Raytracing_P<Key>.hlsl sets the matching RT_* macros
+// in Raytracing.hlsl), all of them are compiled at startup and RTPipelines is indexed by the key.
+enum ERTPermutation
+{
+	RTPermutation_PackedPayload = 0x1, // RT_PACKED_PAYLOAD
+	RTPermutation_LambertShading = 0x2, // RT_LAMBERT_SHADING
+	RTPermutation_NoCulling = 0x4, // RT_NO_CULLING
+	RTPermutation_Count = 8,
+};
+
+// What the frame needs from ray tracing, SelectRTPermutation maps it to the cheapest permutation that provides it.
+struct FRTSettings
+{
+	bool bLambertShading;
+	bool bCullBackFaces;
+	bool bNeedsFloatPayload; // Payload has to keep more than 8 bits per channel (RT output is RGBA8 so nothing does yet).
+};
+
+inline uint32_t SelectRTPermutation(const FRTSettings& Settings)
+{
+	uint32_t Key = 0;
+	if (!Settings.bNeedsFloatPayload)
+	{
+		Key |= RTPermutation_PackedPayload;
+	}
+	if (Settings.bLambertShading)
+	{
+		Key |= RTPermutation_LambertShading;
+	}
+	if (!Settings.bCullBackFaces)
+	{
+		Key |= RTPermutation_NoCulling;
+	}
+	return Key;
+}
+
+// Max payload size of the pipeline config, RT_PAYLOAD_SIZE of the permutation's shaders.
+inline uint32_t GetRTPermutationPayloadSize(uint32_t Key)
+{
+	return (Key & RTPermutation_PackedPayload) ? RT_PACKED_PAYLOAD_SIZE : RT_FLOAT_PAYLOAD_SIZE;
+}
@@ -0,0 +1,665 @@
+#include "Reference.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "EAAssert/eaassert.h"
+#include "EASTL/algorithm.h"
+#include "EAThread/eathread.h"
+#include "EAThread/eathread_thread.h"
+
+static const uint32_t kMaxReferenceThreads = 32;
+static uint32_t GNumReferenceThreads;
+
+typedef void (*FRowFunction)(const void* Pass, uint32_t BeginRow, uint32_t EndRow);
+
+struct FRowBand
+{
+	FRowFunction Function;
+	const void* Pass;
+	uint32_t BeginRow;
+	uint32_t EndRow;
+	EA::Thread::Thread Thread;
+};
+
+// Splits the rows into one band per worker thread and returns when all are done, the calling thread takes the first
+// band.
+static void ForEachRowBand(uint32_t NumRows, FRowFunction Function, const void* Pass)
+{
+	uint32_t NumThreads = GNumReferenceThreads ? GNumReferenceThreads : (uint32_t)EA::Thread::GetProcessorCount();
+	NumThreads = eastl::max(eastl::min(eastl::min(NumThreads, kMaxReferenceThreads), NumRows), 1u);
+
+	FRowBand Bands[kMaxReferenceThreads];
+	for (uint32_t Idx = 0; Idx < NumThreads; ++Idx)
+	{
+		FRowBand& Band = Bands[Idx];
+		Band.Function = Function;
+		Band.Pass = Pass;
+		Band.BeginRow = (uint32_t)((uint64_t)NumRows * Idx / NumThreads);
+		Band.EndRow = (uint32_t)((uint64_t)NumRows * (Idx + 1) / NumThreads);
+		if (Idx > 0)
+		{
+			Band.Thread.Begin([](void* Context) -> intptr_t
+			{
+				const FRowBand& Band = *(const FRowBand*)Context;
+				Band.Function(Band.Pass, Band.BeginRow, Band.EndRow);
+				return 0;
+			}, &Band);
+		}
+	}
+	Function(Pass, Bands[0].BeginRow, Bands[0].EndRow);
+	for (uint32_t Idx = 1; Idx < NumThreads; ++Idx)
+	{
+		Bands[Idx].Thread.WaitForEnd();
+	}
+}
+
+void InitImage(uint32_t Width, uint32_t Height, FImage& OutImage)
+{
+	OutImage.Width = Width;
+	OutImage.Height = Height;
+	OutImage.Texels.clear();
+	OutImage.Texels.resize((size_t)Width * Height, XMFLOAT4(0.0f, 0.0f, 0.0f, 0.0f));
+}
+
+void SetNumReferenceThreads(uint32_t NumThreads)
+{
+	GNumReferenceThreads = NumThreads;
+}
+
+float GetImagePSNR(const FImage& Image, const FImage& Reference)
+{
+	EA_ASSERT(Image.Width == Reference.Width && Image.Height == Reference.Height);
+	double SquaredErrorSum = 0.0;
+	for (size_t Idx = 0; Idx < Image.Texels.size(); ++Idx)
+	{
+		const XMVECTOR Delta = XMVectorSubtract(XMLoadFloat4(&Image.Texels[Idx]), XMLoadFloat4(&Reference.Texels[Idx]));
+		SquaredErrorSum += XMVectorGetX(XMVector3Dot(Delta, Delta));
+	}
+	const double MeanSquaredError = SquaredErrorSum / (3.0 * Image.Texels.size());
+	if (MeanSquaredError <= 0.0)
+	{
+		return kMaxPSNR;
+	}
+	return (float)eastl::min(10.0 * log10(1.0 / MeanSquaredError), (double)kMaxPSNR);
+}
+
+float GetImageMaxError(const FImage& Image, const FImage& Reference)
+{
+	EA_ASSERT(Image.Width == Reference.Width && Image.Height == Reference.Height);
+	XMVECTOR MaxError = XMVectorZero();
+	for (size_t Idx = 0; Idx < Image.Texels.size(); ++Idx)
+	{
+		MaxError = XMVectorMax(MaxError, XMVectorAbs(XMVectorSubtract(XMLoadFloat4(&Image.Texels[Idx]), XMLoadFloat4(&Reference.Texels[Idx]))));
+	}
+	return eastl::max(eastl::max(XMVectorGetX(MaxError), XMVectorGetY(MaxError)), XMVectorGetZ(MaxError));
+}
+
+static float GetLuma(FXMVECTOR Color)
+{
+	return XMVectorGetX(XMVector3Dot(Color, XMVectorSet(0.299f, 0.587f, 0.114f, 0.0f)));
+}
+
+static float Saturate(float Value)
+{
+	return eastl::min(eastl::max(Value, 0.0f), 1.0f);
+}
+
+XMVECTOR XM_CALLCONV GetLanczos2Weights(FXMVECTOR X2, float Lobe, float Clip)
+{
+	const XMVECTOR Clipped = XMVectorMin(X2, XMVectorReplicate(Clip));
+	XMVECTOR Base = XMVectorMultiplyAdd(Clipped, XMVectorReplicate(2.0f / 5.0f), g_XMNegativeOne);
+	XMVECTOR Window = XMVectorMultiplyAdd(Clipped, XMVectorReplicate(Lobe), g_XMNegativeOne);
+	Base = XMVectorMultiply(Base, Base);
+	Window = XMVectorMultiply(Window, Window);
+	return XMVectorMultiply(XMVectorMultiplyAdd(Base, XMVectorReplicate(25.0f / 16.0f), XMVectorReplicate(-(25.0f / 16.0f - 1.0f))), Window);
+}
+
+struct FUpscalePass
+{
+	const FImage* Input;
+	FImage* Output;
+	uint32_t InputWidth;
+	uint32_t InputHeight;
+	uint32_t Filter;
+	float Sharpness;
+};
+
+// The 12 taps of the 4x4 footprint without its corners in groups of four, as X and Y in the footprint and as offsets
+// from the texel before the position.
+static const uint8_t kUpscaleTaps[3][4][2] = { { { 1, 0 }, { 2, 0 }, { 1, 3 }, { 2, 3 } }, { { 0, 1 }, { 1, 1 }, { 2, 1 }, { 3, 1 } }, { { 0, 2 }, { 1, 2 }, { 2, 2 }, { 3, 2 } } };
+static const XMVECTORF32 kUpscaleTapOffsetsX[3] = { { { { 0.0f, 1.0f, 0.0f, 1.0f } } }, { { { -1.0f, 0.0f, 1.0f, 2.0f } } }, { { { -1.0f, 0.0f, 1.0f, 2.0f } } } };
+static const XMVECTORF32 kUpscaleTapOffsetsY[3] = { { { { -1.0f, -1.0f, 2.0f, 2.0f } } }, { { { 0.0f, 0.0f, 0.0f, 0.0f } } }, { { { 1.0f, 1.0f, 1.0f, 1.0f } } } };
+
+// UpscaleEdgeAdaptive of Upscale.hlsl, comments are there.
+static XMVECTOR UpscaleEdgeAdaptive(const FUpscalePass& Pass, float InputX, float InputY)
+{
+	const float CornerX = floorf(InputX - 0.5f);
+	const float CornerY = floorf(InputY - 0.5f);
+	const float FractionX = InputX - 0.5f - CornerX;
+	const float FractionY = InputY - 0.5f - CornerY;
+	const FImage& Input = *Pass.Input;
+
+	XMVECTOR Colors[4][4];
+	float Lumas[4][4];
+	for (int32_t Y = 0; Y < 4; ++Y)
+	{
+		const int32_t CoordY = eastl::min(eastl::max((int32_t)CornerY + Y - 1, 0), (int32_t)Pass.InputHeight - 1);
+		for (int32_t X = 0; X < 4; ++X)
+		{
+			const int32_t CoordX = eastl::min(eastl::max((int32_t)CornerX + X - 1, 0), (int32_t)Pass.InputWidth - 1);
+			Colors[Y][X] = XMLoadFloat4(&Input.Texels[(size_t)CoordY * Input.Width + CoordX]);
+			Lumas[Y][X] = GetLuma(Colors[Y][X]);
+		}
+	}
+
+	const float BilinearWeights[2][2] = { { (1.0f - FractionX) * (1.0f - FractionY), FractionX * (1.0f - FractionY) }, { (1.0f - FractionX) * FractionY, FractionX * FractionY } };
+	float GradientX = 0.0f;
+	float GradientY = 0.0f;
+	float Edge = 0.0f;
+	for (int32_t Y = 1; Y < 3; ++Y)
+	{
+		for (int32_t X = 1; X < 3; ++X)
+		{
+			const float DeltaX = Lumas[Y][X + 1] - Lumas[Y][X - 1];
+			const float DeltaY = Lumas[Y + 1][X] - Lumas[Y - 1][X];
+			const float RangeX = eastl::max(fabsf(Lumas[Y][X + 1] - Lumas[Y][X]), fabsf(Lumas[Y][X] - Lumas[Y][X - 1]));
+			const float RangeY = eastl::max(fabsf(Lumas[Y + 1][X] - Lumas[Y][X]), fabsf(Lumas[Y][X] - Lumas[Y - 1][X]));
+			const float StepX = Saturate(fabsf(DeltaX) / eastl::max(2.0f * RangeX, 1.0f / 1024.0f));
+			const float StepY = Saturate(fabsf(DeltaY) / eastl::max(2.0f * RangeY, 1.0f / 1024.0f));
+			const float Weight = BilinearWeights[Y - 1][X - 1];
+			GradientX += DeltaX * Weight;
+			GradientY += DeltaY * Weight;
+			Edge += (StepX * StepX * 0.5f + StepY * StepY * 0.5f) * Weight;
+		}
+	}
+
+	float DirectionX = 1.0f;
+	float DirectionY = 0.0f;
+	const float DirectionLength2 = GradientX * GradientX + GradientY * GradientY;
+	if (DirectionLength2 >= 1.0f / 32768.0f)
+	{
+		const float InvLength = 1.0f / sqrtf(DirectionLength2);
+		DirectionX = GradientX * InvLength;
+		DirectionY = GradientY * InvLength;
+	}
+	const float Stretch = 1.0f / eastl::max(fabsf(DirectionX), fabsf(DirectionY));
+	const float AxisScaleX = 1.0f + (Stretch - 1.0f) * Edge;
+	const float AxisScaleY = 1.0f - 0.5f * Edge;
+	const float Lobe = 0.5f + (0.25f - 0.04f - 0.5f) * Edge;
+	const float Clip = 1.0f / Lobe;
+
+	XMVECTOR Sum = XMVectorZero();
+	XMVECTOR WeightSums = XMVectorZero();
+	for (uint32_t Group = 0; Group < 3; ++Group)
+	{
+		const XMVECTOR OffsetX = XMVectorSubtract(kUpscaleTapOffsetsX[Group], XMVectorReplicate(FractionX));
+		const XMVECTOR OffsetY = XMVectorSubtract(kUpscaleTapOffsetsY[Group], XMVectorReplicate(FractionY));
+		const XMVECTOR RotatedX = XMVectorScale(XMVectorAdd(XMVectorScale(OffsetX, DirectionX), XMVectorScale(OffsetY, DirectionY)), AxisScaleX);
+		const XMVECTOR RotatedY = XMVectorScale(XMVectorSubtract(XMVectorScale(OffsetY, DirectionX), XMVectorScale(OffsetX, DirectionY)), AxisScaleY);
+		const XMVECTOR Weights = GetLanczos2Weights(XMVectorAdd(XMVectorMultiply(RotatedX, RotatedX), XMVectorMultiply(RotatedY, RotatedY)), Lobe, Clip);
+		WeightSums = XMVectorAdd(WeightSums, Weights);
+
+		const uint8_t (&Taps)[4][2] = kUpscaleTaps[Group];
+		Sum = XMVectorMultiplyAdd(Colors[Taps[0][1]][Taps[0][0]], XMVectorSplatX(Weights), Sum);
+		Sum = XMVectorMultiplyAdd(Colors[Taps[1][1]][Taps[1][0]], XMVectorSplatY(Weights), Sum);
+		Sum = XMVectorMultiplyAdd(Colors[Taps[2][1]][Taps[2][0]], XMVectorSplatZ(Weights), Sum);
+		Sum = XMVectorMultiplyAdd(Colors[Taps[3][1]][Taps[3][0]], XMVectorSplatW(Weights), Sum);
+	}
+
+	const XMVECTOR Min = XMVectorMin(XMVectorMin(Colors[1][1], Colors[1][2]), XMVectorMin(Colors[2][1], Colors[2][2]));
+	const XMVECTOR Max = XMVectorMax(XMVectorMax(Colors[1][1], Colors[1][2]), XMVectorMax(Colors[2][1], Colors[2][2]));
+	XMVECTOR Color = XMVectorClamp(XMVectorDivide(Sum, XMVector4Dot(WeightSums, g_XMOne)), Min, Max);
+
+	if (Pass.Sharpness > 0.0f)
+	{
+		XMVECTOR Bilinear = XMVectorScale(Colors[1][1], BilinearWeights[0][0]);
+		Bilinear = XMVectorMultiplyAdd(Colors[1][2], XMVectorReplicate(BilinearWeights[0][1]), Bilinear);
+		Bilinear = XMVectorMultiplyAdd(Colors[2][1], XMVectorReplicate(BilinearWeights[1][0]), Bilinear);
+		Bilinear = XMVectorMultiplyAdd(Colors[2][2], XMVectorReplicate(BilinearWeights[1][1]), Bilinear);
+		const XMVECTOR Headroom = XMVectorDivide(XMVectorMin(Min, XMVectorSubtract(g_XMOne, Max)), XMVectorMax(Max, XMVectorReplicate(1.0f / 256.0f)));
+		const XMVECTOR Amount = XMVectorScale(XMVectorSqrt(XMVectorSaturate(Headroom)), Pass.Sharpness);
+		Color = XMVectorSaturate(XMVectorMultiplyAdd(XMVectorSubtract(Color, Bilinear), Amount, Color));
+	}
+	return XMVectorSetW(Color, 1.0f);
+}
+
+// Texel space position (texel centers at +0.5) filtered like a linear sampler with clamp addressing.
+static XMVECTOR SampleLinear(const FImage& Image, float X, float Y)
+{
+	X -= 0.5f;
+	Y -= 0.5f;
+	const float FloorX = floorf(X);
+	const float FloorY = floorf(Y);
+	const uint32_t X0 = (uint32_t)eastl::min(eastl::max((int32_t)FloorX, 0), (int32_t)Image.Width - 1);
+	const uint32_t Y0 = (uint32_t)eastl::min(eastl::max((int32_t)FloorY, 0), (int32_t)Image.Height - 1);
+	const uint32_t X1 = eastl::min(X0 + 1, Image.Width - 1);
+	const uint32_t Y1 = eastl::min(Y0 + 1, Image.Height - 1);
+
+	const XMFLOAT4* Row0 = &Image.Texels[(size_t)Y0 * Image.Width];
+	const XMFLOAT4* Row1 = &Image.Texels[(size_t)Y1 * Image.Width];
+	const XMVECTOR Top = XMVectorLerp(XMLoadFloat4(&Row0[X0]), XMLoadFloat4(&Row0[X1]), X - FloorX);
+	const XMVECTOR Bottom = XMVectorLerp(XMLoadFloat4(&Row1[X0]), XMLoadFloat4(&Row1[X1]), X - FloorX);
+	return XMVectorLerp(Top, Bottom, Y - FloorY);
+}
+
+// The linear sampler of Upscale.hlsl, positions are clamped to the traced rectangle so taps stay inside of it.
+static XMVECTOR UpscaleBilinear(const FUpscalePass& Pass, float InputX, float InputY)
+{
+	return SampleLinear(*Pass.Input, eastl::min(eastl::max(InputX, 0.5f), Pass.InputWidth - 0.5f), eastl::min(eastl::max(InputY, 0.5f), Pass.InputHeight - 0.5f));
+}
+
+static void UpscaleRows(const void* Context, uint32_t BeginRow, uint32_t EndRow)
+{
+	const FUpscalePass& Pass = *(const FUpscalePass*)Context;
+	FImage& Output = *Pass.Output;
+	for (uint32_t Y = BeginRow; Y < EndRow; ++Y)
+	{
+		const float InputY = (Y + 0.5f) / Output.Height * Pass.InputHeight;
+		XMFLOAT4* Row = &Output.Texels[(size_t)Y * Output.Width];
+		for (uint32_t X = 0; X < Output.Width; ++X)
+		{
+			const float InputX = (X + 0.5f) / Output.Width * Pass.InputWidth;
+			const XMVECTOR Color = Pass.Filter == UPSCALE_FILTER_EDGE_ADAPTIVE ? UpscaleEdgeAdaptive(Pass, InputX, InputY) : UpscaleBilinear(Pass, InputX, InputY);
+			XMStoreFloat4(&Row[X], Color);
+		}
+	}
+}
+
+void UpscaleImage(const FImage& Input, uint32_t InputWidth, uint32_t InputHeight, uint32_t Filter, float Sharpness, FImage& Output)
+{
+	EA_ASSERT(InputWidth > 0 && InputHeight > 0 && InputWidth <= Input.Width && InputHeight <= Input.Height);
+	EA_ASSERT(Output.Texels.size() == (size_t)Output.Width * Output.Height);
+	FUpscalePass Pass = { &Input, &Output, InputWidth, InputHeight, Filter, Sharpness };
+	ForEachRowBand(Output.Height, UpscaleRows, &Pass);
+}
+
+struct FReconstructPass
+{
+	const FPerFrameConstantData* Constants;
+	const FImage* PrevColor;
+	const FImage* PrevHitPosition;
+	FImage* Color;
+	FImage* HitPosition;
+};
+
+// MainCS of Reconstruct.hlsl, comments are there. Skipped pixels only read traced ones, so rows can be written in place
+// while other threads read them.
+static void ReconstructRows(const void* Context, uint32_t BeginRow, uint32_t EndRow)
+{
+	const FReconstructPass& Pass = *(const FReconstructPass*)Context;
+	const FPerFrameConstantData& Constants = *Pass.Constants;
+	const int32_t Width = (int32_t)Constants.TraceWidth;
+	const int32_t Height = (int32_t)Constants.TraceHeight;
+	const float3 CameraPosition(Constants.CameraPosition.x, Constants.CameraPosition.y, Constants.CameraPosition.z);
+	const float2 PrevDimensions((float)Constants.PrevTraceWidth, (float)Constants.PrevTraceHeight);
+	FImage& Color = *Pass.Color;
+	FImage& HitPosition = *Pass.HitPosition;
+
+	for (int32_t Y = (int32_t)BeginRow; Y < (int32_t)EndRow; ++Y)
+	{
+		for (int32_t X = 0; X < Width; ++X)
+		{
+			if (IsTracedPixel(uint2(X, Y), Constants.TraceInterleave, Constants.InterleavePhase))
+			{
+				continue;
+			}
+
+			XMVECTOR Sum = XMVectorZero();
+			XMVECTOR Min = XMVectorReplicate(1.0e30f);
+			XMVECTOR Max = XMVectorReplicate(-1.0e30f);
+			float NumSamples = 0.0f;
+			XMFLOAT4 Position(0.0f, 0.0f, 0.0f, 0.0f);
+			int32_t NeighborX = X;
+			int32_t NeighborY = Y;
+			float NearestDistance2 = 1.0e30f;
+			for (int32_t CoordY = Y - 1; CoordY <= Y + 1; ++CoordY)
+			{
+				for (int32_t CoordX = X - 1; CoordX <= X + 1; ++CoordX)
+				{
+					if (CoordX < 0 || CoordY < 0 || CoordX >= Width || CoordY >= Height || !IsTracedPixel(uint2(CoordX, CoordY), Constants.TraceInterleave, Constants.InterleavePhase))
+					{
+						continue;
+					}
+
+					const size_t Coord = (size_t)CoordY * Color.Width + CoordX;
+					const XMVECTOR NeighborColor = XMLoadFloat4(&Color.Texels[Coord]);
+					Sum = XMVectorAdd(Sum, NeighborColor);
+					Min = XMVectorMin(Min, NeighborColor);
+					Max = XMVectorMax(Max, NeighborColor);
+					NumSamples += 1.0f;
+
+					const XMFLOAT4& NeighborPosition = HitPosition.Texels[Coord];
+					const XMVECTOR View = XMVectorSubtract(XMLoadFloat4(&NeighborPosition), XMLoadFloat4(&Constants.CameraPosition));
+					const float Distance2 = NeighborPosition.w > 0.0f ? XMVectorGetX(XMVector3Dot(View, View)) : 1.0e29f;
+					if (Distance2 < NearestDistance2)
+					{
+						NearestDistance2 = Distance2;
+						Position = NeighborPosition;
+						NeighborX = CoordX;
+						NeighborY = CoordY;
+					}
+				}
+			}
+
+			XMVECTOR Result = NumSamples > 0.0f ? XMVectorDivide(Sum, XMVectorReplicate(NumSamples)) : XMVectorZero();
+			if (Constants.HasReconstructionHistory != 0 && Position.w > 0.0f)
+			{
+				const float3 SurfacePosition(Position.x, Position.y, Position.z);
+				const float2 Reprojected = GetReprojectedPixel(SurfacePosition, Constants.PrevWorldToProjection, PrevDimensions);
+				const float PrevX = X + 0.5f + (Reprojected.x - (NeighborX + 0.5f + Constants.Jitter.x));
+				const float PrevY = Y + 0.5f + (Reprojected.y - (NeighborY + 0.5f + Constants.Jitter.y));
+				if (PrevX >= 0.0f && PrevY >= 0.0f && PrevX < PrevDimensions.x && PrevY < PrevDimensions.y)
+				{
+					const XMFLOAT4& PrevPosition = Pass.PrevHitPosition->Texels[(size_t)PrevY * Pass.PrevHitPosition->Width + (size_t)PrevX];
+					if (PrevPosition.w > 0.0f && !IsDisoccluded(SurfacePosition, float3(PrevPosition.x, PrevPosition.y, PrevPosition.z), CameraPosition, Constants.DisocclusionTolerance))
+					{
+						const float SampleX = eastl::min(eastl::max(PrevX, 0.5f), PrevDimensions.x - 0.5f);
+						const float SampleY = eastl::min(eastl::max(PrevY, 0.5f), PrevDimensions.y - 0.5f);
+						Result = XMVectorClamp(SampleLinear(*Pass.PrevColor, SampleX, SampleY), Min, Max);
+					}
+				}
+			}
+
+			const size_t Pixel = (size_t)Y * Color.Width + X;
+			XMStoreFloat4(&Color.Texels[Pixel], XMVectorSetW(Result, 1.0f));
+			HitPosition.Texels[Pixel] = Position;
+		}
+	}
+}
+
+void ReconstructImage(const FPerFrameConstantData& Constants, const FImage& PrevColor, const FImage& PrevHitPosition, FImage& Color, FImage& HitPosition)
+{
+	EA_ASSERT(Constants.TraceWidth <= Color.Width && Constants.TraceHeight <= Color.Height);
+	EA_ASSERT(Color.Width == HitPosition.Width && Color.Height == HitPosition.Height);
+	EA_ASSERT(PrevColor.Width == PrevHitPosition.Width && PrevColor.Height == PrevHitPosition.Height);
+	FReconstructPass Pass = { &Constants, &PrevColor, &PrevHitPosition, &Color, &HitPosition };
+	ForEachRowBand(Constants.TraceHeight, ReconstructRows, &Pass);
+}
+
+struct FDenoiseTemporalPass
+{
+	const FPerFrameConstantData* Constants;
+	const FImage* HistoryColor;
+	const FImage* HistoryMoments;
+	const FImage* HistoryHitPosition;
+	const FImage* Color;
+	const FImage* HitPosition;
+	FImage* Normal;
+	FImage* Moments;
+	FImage* OutputColor;
+};
+
+// GetTangent of DenoiseTemporal.hlsl.
+static XMVECTOR GetDenoiseTangent(const FImage& HitPosition, int32_t X, int32_t Y, FXMVECTOR Position, int32_t AxisX, int32_t AxisY, int32_t Width, int32_t Height)
+{
+	const bool bHasNext = X + AxisX < Width && Y + AxisY < Height;
+	const bool bHasPrev = X - AxisX >= 0 && Y - AxisY >= 0;
+	const XMFLOAT4 Zero(0.0f, 0.0f, 0.0f, 0.0f);
+	const XMFLOAT4& NextPosition = bHasNext ? HitPosition.Texels[(size_t)(Y + AxisY) * HitPosition.Width + X + AxisX] : Zero;
+	const XMFLOAT4& PrevPosition = bHasPrev ? HitPosition.Texels[(size_t)(Y - AxisY) * HitPosition.Width + X - AxisX] : Zero;
+	const XMVECTOR NextDelta = XMVectorSubtract(XMLoadFloat4(&NextPosition), Position);
+	const XMVECTOR PrevDelta = XMVectorSubtract(Position, XMLoadFloat4(&PrevPosition));
+	if (NextPosition.w > 0.0f && (PrevPosition.w <= 0.0f || XMVectorGetX(XMVector3Dot(NextDelta, NextDelta)) < XMVectorGetX(XMVector3Dot(PrevDelta, PrevDelta))))
+	{
+		return NextDelta;
+	}
+	return PrevPosition.w > 0.0f ? PrevDelta : XMVectorZero();
+}
+
+// GetNormal of DenoiseTemporal.hlsl.
+static XMVECTOR GetDenoiseNormal(const FImage& HitPosition, int32_t X, int32_t Y, FXMVECTOR Position, FXMVECTOR CameraPosition, int32_t Width, int32_t Height)
+{
+	const XMVECTOR View = XMVectorSubtract(CameraPosition, Position);
+	const XMVECTOR N = XMVector3Cross(GetDenoiseTangent(HitPosition, X, Y, Position, 1, 0, Width, Height), GetDenoiseTangent(HitPosition, X, Y, Position, 0, 1, Width, Height));
+	const float Length2 = XMVectorGetX(XMVector3Dot(N, N));
+	if (Length2 < 1.0e-12f)
+	{
+		return XMVector3Normalize(View);
+	}
+	return XMVectorScale(XMVectorGetX(XMVector3Dot(N, View)) < 0.0f ? XMVectorNegate(N) : N, 1.0f / sqrtf(Length2));
+}
+
+// MainCS of DenoiseTemporal.hlsl, comments are there.
+static void DenoiseTemporalRows(const void* Context, uint32_t BeginRow, uint32_t EndRow)
+{
+	const FDenoiseTemporalPass& Pass = *(const FDenoiseTemporalPass*)Context;
+	const FPerFrameConstantData& Constants = *Pass.Constants;
+	const int32_t Width = (int32_t)Constants.TraceWidth;
+	const int32_t Height = (int32_t)Constants.TraceHeight;
+	const XMVECTOR CameraPosition = XMLoadFloat4(&Constants.CameraPosition);
+	const float3 Camera(Constants.CameraPosition.x, Constants.CameraPosition.y, Constants.CameraPosition.z);
+	const float2 PrevDimensions((float)Constants.PrevTraceWidth, (float)Constants.PrevTraceHeight);
+	const FImage& Color = *Pass.Color;
+	const FImage& HitPosition = *Pass.HitPosition;
+
+	for (int32_t Y = (int32_t)BeginRow; Y < (int32_t)EndRow; ++Y)
+	{
+		for (int32_t X = 0; X < Width; ++X)
+		{
+			const size_t Pixel = (size_t)Y * Color.Width + X;
+			const XMVECTOR PixelColor = XMLoadFloat4(&Color.Texels[Pixel]);
+			const XMFLOAT4& Position = HitPosition.Texels[Pixel];
+			const float Luma = GetLuma(PixelColor);
+			const XMVECTOR Normal = Position.w > 0.0f ? GetDenoiseNormal(HitPosition, X, Y, XMLoadFloat4(&Position), CameraPosition, Width, Height) : XMVectorZero();
+			XMStoreFloat4(&Pass.Normal->Texels[Pixel], XMVectorSetW(Normal, 0.0f));
+
+			XMVECTOR HistoryColor = XMVectorZero();
+			XMFLOAT4 HistoryMoments(0.0f, 0.0f, 0.0f, 0.0f);
+			if (Constants.HasDenoiseHistory != 0 && Position.w > 0.0f)
+			{
+				const float3 SurfacePosition(Position.x, Position.y, Position.z);
+				const float2 PrevPixel = GetReprojectedPixel(SurfacePosition, Constants.PrevWorldToProjection, PrevDimensions);
+				if (PrevPixel.x >= 0.0f && PrevPixel.y >= 0.0f && PrevPixel.x < PrevDimensions.x && PrevPixel.y < PrevDimensions.y)
+				{
+					const XMFLOAT4& HistoryPosition = Pass.HistoryHitPosition->Texels[(size_t)PrevPixel.y * Pass.HistoryHitPosition->Width + (size_t)PrevPixel.x];
+					if (HistoryPosition.w > 0.0f && !IsDisoccluded(SurfacePosition, float3(HistoryPosition.x, HistoryPosition.y, HistoryPosition.z), Camera, Constants.DisocclusionTolerance))
+					{
+						const float SampleX = eastl::min(eastl::max(PrevPixel.x, 0.5f), PrevDimensions.x - 0.5f);
+						const float SampleY = eastl::min(eastl::max(PrevPixel.y, 0.5f), PrevDimensions.y - 0.5f);
+						HistoryColor = SampleLinear(*Pass.HistoryColor, SampleX, SampleY);
+						XMStoreFloat4(&HistoryMoments, SampleLinear(*Pass.HistoryMoments, SampleX, SampleY));
+					}
+				}
+			}
+
+			const float NumFrames = eastl::min(HistoryMoments.z + 1.0f, DENOISE_MAX_FRAMES);
+			const XMVECTOR Result = XMVectorLerp(HistoryColor, PixelColor, GetHistoryBlendFactor(NumFrames, DENOISE_COLOR_MIN_BLEND_FACTOR));
+			const float MomentsBlendFactor = GetHistoryBlendFactor(NumFrames, DENOISE_MOMENTS_MIN_BLEND_FACTOR);
+			const float Moment1 = HistoryMoments.x + (Luma - HistoryMoments.x) * MomentsBlendFactor;
+			const float Moment2 = HistoryMoments.y + (Luma * Luma - HistoryMoments.y) * MomentsBlendFactor;
+
+			float Variance = eastl::max(Moment2 - Moment1 * Moment1, 0.0f);
+			if (NumFrames < DENOISE_MIN_TEMPORAL_VARIANCE_FRAMES)
+			{
+				float Sum = 0.0f;
+				float SquaredSum = 0.0f;
+				float NumSamples = 0.0f;
+				for (int32_t CoordY = eastl::max(Y - 1, 0); CoordY <= eastl::min(Y + 1, Height - 1); ++CoordY)
+				{
+					for (int32_t CoordX = eastl::max(X - 1, 0); CoordX <= eastl::min(X + 1, Width - 1); ++CoordX)
+					{
+						const float SampleLuma = GetLuma(XMLoadFloat4(&Color.Texels[(size_t)CoordY * Color.Width + CoordX]));
+						Sum += SampleLuma;
+						SquaredSum += SampleLuma * SampleLuma;
+						NumSamples += 1.0f;
+					}
+				}
+				Variance = eastl::max(SquaredSum / NumSamples - (Sum / NumSamples) * (Sum / NumSamples), 0.0f);
+			}
+
+			Pass.Moments->Texels[Pixel] = XMFLOAT4(Moment1, Moment2, NumFrames, 0.0f);
+			XMStoreFloat4(&Pass.OutputColor->Texels[Pixel], XMVectorSetW(Result, Variance));
+		}
+	}
+}
+
+void DenoiseTemporalImage(const FPerFrameConstantData& Constants, const FImage& HistoryColor, const FImage& HistoryMoments, const FImage& HistoryHitPosition, const FImage& Color, const FImage& HitPosition, FImage& OutNormal, FImage& OutMoments, FImage& OutColor)
+{
+	EA_ASSERT(Constants.TraceWidth <= Color.Width && Constants.TraceHeight <= Color.Height);
+	EA_ASSERT(Color.Width == HitPosition.Width && Color.Height == HitPosition.Height);
+	EA_ASSERT(OutNormal.Width == Color.Width && OutMoments.Width == Color.Width && OutColor.Width == Color.Width);
+	EA_ASSERT(OutNormal.Height == Color.Height && OutMoments.Height == Color.Height && OutColor.Height == Color.Height);
+	FDenoiseTemporalPass Pass = { &Constants, &HistoryColor, &HistoryMoments, &HistoryHitPosition, &Color, &HitPosition, &OutNormal, &OutMoments, &OutColor };
+	ForEachRowBand(Constants.TraceHeight, DenoiseTemporalRows, &Pass);
+}
+
+struct FDenoiseFilterPass
+{
+	const FPerFrameConstantData* Constants;
+	const FDenoiseConstants* DenoiseConstants;
+	const FImage* Input;
+	const FImage* HitPosition;
+	const FImage* Normal;
+	FImage* Output;
+	FImage* HistoryColor;
+};
+
+static const float kDenoiseKernel[3] = { 3.0f / 8.0f, 1.0f / 4.0f, 1.0f / 16.0f };
+
+// GetPrefilteredVariance of DenoiseFilter.hlsl.
+static float GetDenoisePrefilteredVariance(const FImage& Input, int32_t X, int32_t Y, int32_t Width, int32_t Height)
+{
+	const float Kernel[2] = { 1.0f / 2.0f, 1.0f / 4.0f };
+	float Sum = 0.0f;
+	float WeightSum = 0.0f;
+	for (int32_t CoordY = eastl::max(Y - 1, 0); CoordY <= eastl::min(Y + 1, Height - 1); ++CoordY)
+	{
+		for (int32_t CoordX = eastl::max(X - 1, 0); CoordX <= eastl::min(X + 1, Width - 1); ++CoordX)
+		{
+			const float Weight = Kernel[abs(CoordX - X)] * Kernel[abs(CoordY - Y)];
+			Sum += Input.Texels[(size_t)CoordY * Input.Width + CoordX].w * Weight;
+			WeightSum += Weight;
+		}
+	}
+	return Sum / WeightSum;
+}
+
+// MainCS of DenoiseFilter.hlsl, comments are there. Color and variance of a tap are accumulated as one vector, with
+// the variance lane weighted twice.
+static void DenoiseFilterRows(const void* Context, uint32_t BeginRow, uint32_t EndRow)
+{
+	const FDenoiseFilterPass& Pass = *(const FDenoiseFilterPass*)Context;
+	const FPerFrameConstantData& Constants = *Pass.Constants;
+	const FDenoiseConstants& DenoiseConstants = *Pass.DenoiseConstants;
+	const int32_t Width = (int32_t)Constants.TraceWidth;
+	const int32_t Height = (int32_t)Constants.TraceHeight;
+	const int32_t StepSize = (int32_t)DenoiseConstants.StepSize;
+	const XMVECTOR CameraPosition = XMLoadFloat4(&Constants.CameraPosition);
+	const FImage& Input = *Pass.Input;
+	const FImage& HitPosition = *Pass.HitPosition;
+	const FImage& Normal = *Pass.Normal;
+
+	for (int32_t Y = (int32_t)BeginRow; Y < (int32_t)EndRow; ++Y)
+	{
+		for (int32_t X = 0; X < Width; ++X)
+		{
+			const size_t Pixel = (size_t)Y * Input.Width + X;
+			XMVECTOR Result = XMLoadFloat4(&Input.Texels[Pixel]);
+			const XMVECTOR Position = XMLoadFloat4(&HitPosition.Texels[Pixel]);
+			if (HitPosition.Texels[Pixel].w > 0.0f)
+			{
+				const XMVECTOR N = XMLoadFloat4(&Normal.Texels[Pixel]);
+				const float ViewDistance = XMVectorGetX(XMVector3Length(XMVectorSubtract(Position, CameraPosition)));
+				const float CenterLuma = GetLuma(Result);
+				const float Sigma = sqrtf(GetDenoisePrefilteredVariance(Input, X, Y, Width, Height));
+
+				XMVECTOR Sum = XMVectorZero();
+				float WeightSum = 0.0f;
+				for (int32_t TapY = -2; TapY <= 2; ++TapY)
+				{
+					const int32_t CoordY = Y + TapY * StepSize;
+					if (CoordY < 0 || CoordY >= Height)
+					{
+						continue;
+					}
+					for (int32_t TapX = -2; TapX <= 2; ++TapX)
+					{
+						const int32_t CoordX = X + TapX * StepSize;
+						if (CoordX < 0 || CoordX >= Width)
+						{
+							continue;
+						}
+
+						const size_t Coord = (size_t)CoordY * Input.Width + CoordX;
+						const XMVECTOR Sample = XMLoadFloat4(&Input.Texels[Coord]);
+						float Weight = kDenoiseKernel[abs(TapX)] * kDenoiseKernel[abs(TapY)];
+						if (TapX != 0 || TapY != 0)
+						{
+							if (HitPosition.Texels[Coord].w <= 0.0f)
+							{
+								continue;
+							}
+							const float PlaneDistance = fabsf(XMVectorGetX(XMVector3Dot(N, XMVectorSubtract(XMLoadFloat4(&HitPosition.Texels[Coord]), Position))));
+							const float NormalDot = XMVectorGetX(XMVector3Dot(N, XMLoadFloat4(&Normal.Texels[Coord])));
+							Weight *= GetDenoiseEdgeWeight(fabsf(GetLuma(Sample) - CenterLuma), Sigma, NormalDot, PlaneDistance, ViewDistance, DenoiseConstants.LuminancePhi, DenoiseConstants.NormalPhi, DenoiseConstants.DepthPhi);
+						}
+						Sum = XMVectorMultiplyAdd(Sample, XMVectorSet(Weight, Weight, Weight, Weight * Weight), Sum);
+						WeightSum += Weight;
+					}
+				}
+				Result = XMVectorDivide(Sum, XMVectorSet(WeightSum, WeightSum, WeightSum, WeightSum * WeightSum));
+			}
+
+			XMStoreFloat4(&Pass.Output->Texels[Pixel], DenoiseConstants.IsLastIteration != 0 ? XMVectorSetW(Result, 1.0f) : Result);
+			if (DenoiseConstants.WritesHistory != 0)
+			{
+				XMStoreFloat4(&Pass.HistoryColor->Texels[Pixel], XMVectorSetW(Result, 1.0f));
+			}
+		}
+	}
+}
+
+void DenoiseFilterImage(const FPerFrameConstantData& Constants, const FDenoiseConstants& DenoiseConstants, const FImage& Input, const FImage& HitPosition, const FImage& Normal, FImage& Output, FImage* OutHistoryColor)
+{
+	EA_ASSERT(Constants.TraceWidth <= Input.Width && Constants.TraceHeight <= Input.Height);
+	EA_ASSERT(&Input != &Output && Output.Width == Input.Width && Output.Height == Input.Height);
+	EA_ASSERT(HitPosition.Width == Input.Width && Normal.Width == Input.Width);
+	EA_ASSERT(!DenoiseConstants.WritesHistory || (OutHistoryColor && OutHistoryColor->Width == Input.Width && OutHistoryColor->Height == Input.Height));
+	FDenoiseFilterPass Pass = { &Constants, &DenoiseConstants, &Input, &HitPosition, &Normal, &Output, OutHistoryColor };
+	ForEachRowBand(Constants.TraceHeight, DenoiseFilterRows, &Pass);
+}
+
+// File layout: kGBufferDumpMagic, width and height as uint32_t, then the matrix, camera position, color and hit position
+// texels as floats, in the byte order of the writer.
+static const uint32_t kGBufferDumpMagic = 0x31444247; // "GBD1"
+
+bool WriteGBufferDump(const char* FileName, const FGBufferDump& Dump)
+{
+	EA_ASSERT(Dump.Color.Width == Dump.HitPosition.Width && Dump.Color.Height == Dump.HitPosition.Height);
+	FILE* File = fopen(FileName, "wb");
+	if (!File)
+	{
+		return false;
+	}
+	const uint32_t Header[3] = { kGBufferDumpMagic, Dump.Color.Width, Dump.Color.Height };
+	const size_t NumTexels = Dump.Color.Texels.size();
+	bool bIsWritten = fwrite(Header, sizeof(Header), 1, File) == 1;
+	bIsWritten = bIsWritten && fwrite(&Dump.WorldToProjection, sizeof(Dump.WorldToProjection), 1, File) == 1;
+	bIsWritten = bIsWritten && fwrite(&Dump.CameraPosition, sizeof(Dump.CameraPosition), 1, File) == 1;
+	bIsWritten = bIsWritten && fwrite(Dump.Color.Texels.data(), sizeof(XMFLOAT4), NumTexels, File) == NumTexels;
+	bIsWritten = bIsWritten && fwrite(Dump.HitPosition.Texels.data(), sizeof(XMFLOAT4), NumTexels, File) == NumTexels;
+	return fclose(File) == 0 && bIsWritten;
+}
+
+bool ReadGBufferDump(const char* FileName, FGBufferDump& OutDump)
+{
+	FILE* File = fopen(FileName, "rb");
+	if (!File)
+	{
+		return false;
+	}
+	uint32_t Header[3];
+	bool bIsRead = fread(Header, sizeof(Header), 1, File) == 1 && Header[0] == kGBufferDumpMagic && Header[1] > 0 && Header[2] > 0;
+	if (bIsRead)
+	{
+		InitImage(Header[1], Header[2], OutDump.Color);
+		InitImage(Header[1], Header[2], OutDump.HitPosition);
+		const size_t NumTexels = OutDump.Color.Texels.size();
+		bIsRead = fread(&OutDump.WorldToProjection, sizeof(OutDump.WorldToProjection), 1, File) == 1;
+		bIsRead = bIsRead && fread(&OutDump.CameraPosition, sizeof(OutDump.CameraPosition), 1, File) == 1;
+		bIsRead = bIsRead && fread(OutDump.Color.Texels.data(), sizeof(XMFLOAT4), NumTexels, File) == NumTexels;
+		bIsRead = bIsRead && fread(OutDump.HitPosition.Texels.data(), sizeof(XMFLOAT4), NumTexels, File) == NumTexels;
+	}
+	fclose(File);
+	return bIsRead;
+}
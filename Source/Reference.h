@@ -0,0 +1,62 @@
+#pragma once
+
+#include <stdint.h>
+#include "EASTL/vector.h"
+#include "CPUAndGPUCommon.h"
+
+// CPU versions of the post-processing compute shaders, for the headless tests and benchmarks in Tests/ and for checking
+// the GPU output in --benchmark mode. They use the helpers of CPUAndGPUCommon.h like the shaders do, process the four
+// channels of a texel as one XMVECTOR and split rows over worker threads. Results match the shaders up to float
+// rounding and texture filtering precision.
+
+// Row major texels, the float4 layout that the shaders read and write.
+struct FImage
+{
+	uint32_t Width;
+	uint32_t Height;
+	eastl::vector<XMFLOAT4> Texels;
+};
+
+void InitImage(uint32_t Width, uint32_t Height, FImage& OutImage);
+
+// Worker threads used by the passes, 0 (default) for one per processor.
+void SetNumReferenceThreads(uint32_t NumThreads);
+
+// Color channels in [0, 1], images of the same size. PSNR of identical images is kMaxPSNR.
+static const float kMaxPSNR = 100.0f;
+float GetImagePSNR(const FImage& Image, const FImage& Reference);
+float GetImageMaxError(const FImage& Image, const FImage& Reference);
+
+// GetLanczos2Weight of four squared distances at once.
+XMVECTOR XM_CALLCONV GetLanczos2Weights(FXMVECTOR X2, float Lobe, float Clip);
+
+// Upscale.hlsl: the InputWidth x InputHeight rectangle in the top-left corner of Input fills all of Output, which has
+// to be initialized to the output size.
+void UpscaleImage(const FImage& Input, uint32_t InputWidth, uint32_t InputHeight, uint32_t Filter, float Sharpness, FImage& Output);
+
+// Reconstruct.hlsl: fills the pixels of Color that were not traced this frame, Color and HitPosition are updated in place
+// like the UAVs of the shader (which also copies Color to RTOutput). PrevColor and PrevHitPosition are the results of
+// the previous frame. PrevWorldToProjection of Constants is not transposed, as the shaders see it.
+void ReconstructImage(const FPerFrameConstantData& Constants, const FImage& PrevColor, const FImage& PrevHitPosition, FImage& Color, FImage& HitPosition);
+
+// DenoiseTemporal.hlsl: Color and HitPosition are the trace output of this frame, HistoryColor (the first filter
+// iteration's result), HistoryMoments and HistoryHitPosition those of the previous frame. Writes OutNormal, OutMoments
+// and OutColor (color and luminance variance), which have to be initialized to the size of Color.
+void DenoiseTemporalImage(const FPerFrameConstantData& Constants, const FImage& HistoryColor, const FImage& HistoryMoments, const FImage& HistoryHitPosition, const FImage& Color, const FImage& HitPosition, FImage& OutNormal, FImage& OutMoments, FImage& OutColor);
+
+// One a-trous iteration of DenoiseFilter.hlsl from Input into Output, which cannot be the same image. OutHistoryColor
+// is written when WritesHistory of DenoiseConstants is set and can be null otherwise.
+void DenoiseFilterImage(const FPerFrameConstantData& Constants, const FDenoiseConstants& DenoiseConstants, const FImage& Input, const FImage& HitPosition, const FImage& Normal, FImage& Output, FImage* OutHistoryColor);
+
+// Denoiser input of one frame of the application (--dump-gbuffer), for running the CPU denoiser on real scenes. Color
+// and HitPosition have the trace size.
+struct FGBufferDump
+{
+	XMFLOAT4X4 WorldToProjection; // Not transposed.
+	XMFLOAT4 CameraPosition;
+	FImage Color;
+	FImage HitPosition;
+};
+
+bool WriteGBufferDump(const char* FileName, const FGBufferDump& Dump);
+bool ReadGBufferDump(const char* FileName, FGBufferDump& OutDump);
@@ -0,0 +1,58 @@
+#include "ShaderTable.h"
+#include "Library.h"
+#include "d3dx12.h"
+
+static_assert(kShaderIdentifierSize == D3D12_SHADER_IDENTIFIER_SIZE_IN_BYTES, "Shader identifier size does not match d3d12.h.");
+static_assert(kShaderRecordAlignment == D3D12_RAYTRACING_SHADER_RECORD_BYTE_ALIGNMENT, "Shader record alignment does not match d3d12.h.");
+static_assert(kShaderTableAlignment == D3D12_RAYTRACING_SHADER_TABLE_BYTE_ALIGNMENT, "Shader table alignment does not match d3d12.h.");
+static_assert(kMaxShaderRecordStride == D3D12_RAYTRACING_MAX_SHADER_RECORD_STRIDE, "Maximum shader record stride does not match d3d12.h.");
+
+void CreateShaderTable(FGraphicsContext& Gfx, const FShaderTableLayout& Layout, FShaderTable& OutTable)
+{
+	InitShaderTableRecords(Layout, OutTable);
+	OutTable.Buffer = CreateGPUResource(Gfx, GPUMemory_ShaderTable, D3D12_HEAP_TYPE_DEFAULT, CD3DX12_RESOURCE_DESC::Buffer(Layout.Size), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+}
+
+void DestroyShaderTable(FShaderTable& Table)
+{
+	SAFE_RELEASE(Table.Buffer);
+	Table = FShaderTable();
+}
+
+// Records uploads of changed records to Gfx.CmdList, one copy per merged dirty range.
+void UpdateShaderTable(FGraphicsContext& Gfx, FShaderTable& Table)
+{
+	if (Table.DirtyRanges.empty())
+	{
+		return;
+	}
+
+	MergeShaderTableDirtyRanges(Table);
+	const eastl::vector<eastl::pair<uint64_t, uint64_t>>& Ranges = Table.DirtyRanges;
+
+	Gfx.CmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(Table.Buffer, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_COPY_DEST));
+
+	const FGPUMemoryHeap& UploadHeap = Gfx.GPUUploadMemoryHeaps[Gfx.FrameIndex];
+	for (const auto& Range : Ranges)
+	{
+		D3D12_GPU_VIRTUAL_ADDRESS GPUAddress;
+		void* CPUAddress = AllocateGPUMemory(Gfx, (uint32_t)Range.second, GPUAddress);
+		memcpy(CPUAddress, Table.CPUData.data() + Range.first, (size_t)Range.second);
+
+		Gfx.CmdList->CopyBufferRegion(Table.Buffer, Range.first, UploadHeap.Heap, GPUAddress - UploadHeap.GPUStart, Range.second);
+	}
+
+	Gfx.CmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(Table.Buffer, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE));
+
+	Table.DirtyRanges.clear();
+}
+
+void GetShaderTableRanges(const FShaderTable& Table, D3D12_DISPATCH_RAYS_DESC& InOutDesc)
+{
+	const D3D12_GPU_VIRTUAL_ADDRESS Base = Table.Buffer->GetGPUVirtualAddress();
+	const FShaderTableLayout& Layout = Table.Layout;
+
+	InOutDesc.RayGenerationShaderRecord = { Base, Layout.RayGenStride };
+	InOutDesc.MissShaderTable = { Base + Layout.MissOffset, (uint64_t)Layout.NumMissRecords * Layout.MissStride, Layout.MissStride };
+	InOutDesc.HitGroupTable = { Base + Layout.HitGroupOffset, (uint64_t)Table.NumHitGroupRecords * Layout.HitGroupStride, Layout.HitGroupStride };
+}
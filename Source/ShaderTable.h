@@ -0,0 +1,123 @@
+#pragma once
+
+#include <stdint.h>
+#include "EASTL/hash_map.h"
+#include "EASTL/vector.h"
+
+struct FGraphicsContext;
+struct ID3D12Resource;
+struct D3D12_DISPATCH_RAYS_DESC;
+
+// Shader binding table with one ray generation record, a fixed number of miss records and a growing list of hit group
+// records. Record types (identifier + local root arguments) are declared with TShaderRecord, strides and section
+// offsets follow from them at compile time. A CPU copy of the table is kept so only records that actually changed are
+// uploaded. Records are kept on the CPU by ShaderTableRecords.cpp, which needs no device, ShaderTable.cpp uploads them.
+
+// D3D12 constants the layout depends on, ShaderTable.cpp checks them against d3d12.h.
+static const uint32_t kShaderIdentifierSize = 32; // D3D12_SHADER_IDENTIFIER_SIZE_IN_BYTES
+static const uint32_t kShaderRecordAlignment = 32; // D3D12_RAYTRACING_SHADER_RECORD_BYTE_ALIGNMENT
+static const uint32_t kShaderTableAlignment = 64; // D3D12_RAYTRACING_SHADER_TABLE_BYTE_ALIGNMENT
+static const uint32_t kMaxShaderRecordStride = 4096; // D3D12_RAYTRACING_MAX_SHADER_RECORD_STRIDE
+
+template<typename TLocalArgs>
+struct TShaderRecord
+{
+	uint8_t Identifier[kShaderIdentifierSize];
+	TLocalArgs Args;
+};
+
+// Record without local root arguments.
+template<>
+struct TShaderRecord<void>
+{
+	uint8_t Identifier[kShaderIdentifierSize];
+};
+
+constexpr uint64_t AlignShaderTableSize(uint64_t Size, uint64_t Alignment)
+{
+	return (Size + Alignment - 1) & ~(Alignment - 1);
+}
+
+template<typename TRecord>
+constexpr uint32_t GetShaderRecordStride()
+{
+	return (uint32_t)AlignShaderTableSize(sizeof(TRecord), kShaderRecordAlignment);
+}
+
+struct FShaderTableLayout
+{
+	uint32_t RayGenStride;
+	uint32_t MissStride;
+	uint32_t HitGroupStride;
+	uint32_t NumMissRecords;
+	uint32_t MaxHitGroupRecords;
+	uint64_t MissOffset;
+	uint64_t HitGroupOffset;
+	uint64_t Size;
+};
+
+// Each section starts at kShaderTableAlignment.
+constexpr FShaderTableLayout GetShaderTableLayout(uint32_t RayGenStride, uint32_t MissStride, uint32_t HitGroupStride, uint32_t NumMissRecords, uint32_t MaxHitGroupRecords)
+{
+	const uint64_t MissOffset = AlignShaderTableSize(RayGenStride, kShaderTableAlignment);
+	const uint64_t HitGroupOffset = AlignShaderTableSize(MissOffset + (uint64_t)NumMissRecords * MissStride, kShaderTableAlignment);
+	return { RayGenStride, MissStride, HitGroupStride, NumMissRecords, MaxHitGroupRecords, MissOffset, HitGroupOffset, HitGroupOffset + (uint64_t)MaxHitGroupRecords * HitGroupStride };
+}
+
+template<typename TRayGenRecord, typename TMissRecord, typename THitGroupRecord>
+constexpr FShaderTableLayout GetShaderTableLayout(uint32_t NumMissRecords, uint32_t MaxHitGroupRecords)
+{
+	static_assert(GetShaderRecordStride<TRayGenRecord>() <= kMaxShaderRecordStride, "Ray generation record is too large.");
+	static_assert(GetShaderRecordStride<TMissRecord>() <= kMaxShaderRecordStride, "Miss record is too large.");
+	static_assert(GetShaderRecordStride<THitGroupRecord>() <= kMaxShaderRecordStride, "Hit group record is too large.");
+	return GetShaderTableLayout(GetShaderRecordStride<TRayGenRecord>(), GetShaderRecordStride<TMissRecord>(), GetShaderRecordStride<THitGroupRecord>(), NumMissRecords, MaxHitGroupRecords);
+}
+
+struct FShaderTable
+{
+	ID3D12Resource* Buffer;
+	FShaderTableLayout Layout;
+	uint32_t NumHitGroupRecords;
+	eastl::vector<uint8_t> CPUData;
+	eastl::vector<eastl::pair<uint64_t, uint64_t>> DirtyRanges; // Offset, size.
+	eastl::hash_map<uint64_t, uint32_t> HitGroupRanges; // Content hash -> first record of an identical range.
+};
+
+void CreateShaderTable(FGraphicsContext& Gfx, const FShaderTableLayout& Layout, FShaderTable& OutTable);
+void DestroyShaderTable(FShaderTable& Table);
+void InitShaderTableRecords(const FShaderTableLayout& Layout, FShaderTable& OutTable);
+void SetRayGenRecord(FShaderTable& Table, const void* Record, uint32_t RecordSize);
+void SetMissRecord(FShaderTable& Table, uint32_t Index, const void* Record, uint32_t RecordSize);
+uint32_t AddHitGroupRecords(FShaderTable& Table, const void* Records, uint32_t RecordSize, uint32_t NumRecords);
+void SetHitGroupRecord(FShaderTable& Table, uint32_t Index, const void* Record, uint32_t RecordSize);
+void ResetHitGroupRecords(FShaderTable& Table);
+void MergeShaderTableDirtyRanges(FShaderTable& Table);
+void UpdateShaderTable(FGraphicsContext& Gfx, FShaderTable& Table);
+void GetShaderTableRanges(const FShaderTable& Table, D3D12_DISPATCH_RAYS_DESC& InOutDesc);
+
+template<typename TRecord>
+inline void SetRayGenRecord(FShaderTable& Table, const TRecord& Record)
+{
+	SetRayGenRecord(Table, &Record, sizeof(Record));
+}
+
+template<typename TRecord>
+inline void SetMissRecord(FShaderTable& Table, uint32_t Index, const TRecord& Record)
+{
+	SetMissRecord(Table, Index, &Record, sizeof(Record));
+}
+
+// Returns index of the first record. When identical records were added before their index is returned instead, so
+// instances that share geometry and arguments share hit group records.
+template<typename TRecord>
+inline uint32_t AddHitGroupRecords(FShaderTable& Table, const TRecord* Records, uint32_t NumRecords)
+{
+	return AddHitGroupRecords(Table, Records, sizeof(TRecord), NumRecords);
+}
+
+// Records may be shared by several instances (see AddHitGroupRecords), changing one changes it for all of them.
+template<typename TRecord>
+inline void SetHitGroupRecord(FShaderTable& Table, uint32_t Index, const TRecord& Record)
+{
+	SetHitGroupRecord(Table, Index, &Record, sizeof(Record));
+}
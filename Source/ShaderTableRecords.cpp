@@ -0,0 +1,112 @@
+#include "ShaderTable.h"
+#include <string.h>
+#include "EAAssert/eaassert.h"
+#include "EASTL/sort.h"
+#include "EAStdC/EAHashCRC.h"
+
+// CPU copy of the table, every byte zero and nothing dirty. Records written before the first UpdateShaderTable are
+// uploaded by it.
+void InitShaderTableRecords(const FShaderTableLayout& Layout, FShaderTable& OutTable)
+{
+	OutTable = FShaderTable();
+	OutTable.Layout = Layout;
+	OutTable.CPUData.resize((size_t)Layout.Size, 0);
+}
+
+// Copies record to the CPU table and remembers the range for upload if anything changed. Stride padding stays zero.
+static void WriteShaderRecord(FShaderTable& Table, uint64_t Offset, uint32_t Stride, const void* Record, uint32_t RecordSize)
+{
+	EA_ASSERT(RecordSize <= Stride && Offset + Stride <= Table.CPUData.size());
+
+	uint8_t* Dest = Table.CPUData.data() + Offset;
+	if (memcmp(Dest, Record, RecordSize) != 0)
+	{
+		memcpy(Dest, Record, RecordSize);
+		Table.DirtyRanges.push_back({ Offset, Stride });
+	}
+}
+
+void SetRayGenRecord(FShaderTable& Table, const void* Record, uint32_t RecordSize)
+{
+	WriteShaderRecord(Table, 0, Table.Layout.RayGenStride, Record, RecordSize);
+}
+
+void SetMissRecord(FShaderTable& Table, uint32_t Index, const void* Record, uint32_t RecordSize)
+{
+	EA_ASSERT(Index < Table.Layout.NumMissRecords);
+	WriteShaderRecord(Table, Table.Layout.MissOffset + (uint64_t)Index * Table.Layout.MissStride, Table.Layout.MissStride, Record, RecordSize);
+}
+
+uint32_t AddHitGroupRecords(FShaderTable& Table, const void* Records, uint32_t RecordSize, uint32_t NumRecords)
+{
+	const uint64_t Size = (uint64_t)RecordSize * NumRecords;
+	const uint64_t Hash = EA::StdC::CRC64(Records, (size_t)Size, EA::StdC::CRC64(&NumRecords, sizeof(NumRecords), EA::StdC::kCRC64InitialValue, false), true);
+
+	// Reuse identical range. Hash match is confirmed by comparing the records themselves.
+	auto It = Table.HitGroupRanges.find(Hash);
+	if (It != Table.HitGroupRanges.end())
+	{
+		const uint8_t* Existing = Table.CPUData.data() + Table.Layout.HitGroupOffset + (uint64_t)It->second * Table.Layout.HitGroupStride;
+		bool bIsEqual = true;
+		for (uint32_t Idx = 0; Idx < NumRecords && bIsEqual; ++Idx)
+		{
+			bIsEqual = memcmp(Existing + (uint64_t)Idx * Table.Layout.HitGroupStride, (const uint8_t*)Records + (uint64_t)Idx * RecordSize, RecordSize) == 0;
+		}
+		if (bIsEqual)
+		{
+			return It->second;
+		}
+	}
+
+	const uint32_t FirstIndex = Table.NumHitGroupRecords;
+	EA_ASSERT(FirstIndex + NumRecords <= Table.Layout.MaxHitGroupRecords);
+
+	for (uint32_t Idx = 0; Idx < NumRecords; ++Idx)
+	{
+		SetHitGroupRecord(Table, FirstIndex + Idx, (const uint8_t*)Records + (uint64_t)Idx * RecordSize, RecordSize);
+	}
+	Table.NumHitGroupRecords += NumRecords;
+
+	Table.HitGroupRanges.insert(eastl::make_pair(Hash, FirstIndex));
+	return FirstIndex;
+}
+
+void SetHitGroupRecord(FShaderTable& Table, uint32_t Index, const void* Record, uint32_t RecordSize)
+{
+	EA_ASSERT(Index < Table.Layout.MaxHitGroupRecords);
+	WriteShaderRecord(Table, Table.Layout.HitGroupOffset + (uint64_t)Index * Table.Layout.HitGroupStride, Table.Layout.HitGroupStride, Record, RecordSize);
+}
+
+// Records already on the GPU stay there, re-adding the same records after a reset uploads nothing.
+void ResetHitGroupRecords(FShaderTable& Table)
+{
+	Table.NumHitGroupRecords = 0;
+	Table.HitGroupRanges.clear();
+}
+
+// Sorts the dirty ranges and merges overlapping and adjacent ones, UpdateShaderTable copies each of them at once.
+void MergeShaderTableDirtyRanges(FShaderTable& Table)
+{
+	eastl::vector<eastl::pair<uint64_t, uint64_t>>& Ranges = Table.DirtyRanges;
+	if (Ranges.empty())
+	{
+		return;
+	}
+
+	eastl::sort(Ranges.begin(), Ranges.end());
+
+	uint32_t NumMerged = 0;
+	for (uint32_t Idx = 1; Idx < Ranges.size(); ++Idx)
+	{
+		auto& Last = Ranges[NumMerged];
+		if (Ranges[Idx].first <= Last.first + Last.second)
+		{
+			Last.second = eastl::max(Last.second, Ranges[Idx].first + Ranges[Idx].second - Last.first);
+		}
+		else
+		{
+			Ranges[++NumMerged] = Ranges[Idx];
+		}
+	}
+	Ranges.resize(NumMerged + 1);
+}
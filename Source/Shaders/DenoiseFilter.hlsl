@@ -0,0 +1,109 @@
+#include "../CPUAndGPUCommon.h"
+
+// One a-trous wavelet iteration of the denoiser: a 5x5 B3 spline kernel whose taps are StepSize pixels apart,
+// weighted with GetDenoiseEdgeWeight against the center's luminance (relative to its 3x3 prefiltered standard
+// deviation), normal and tangent plane. Variance is filtered with the squared weights so that it shrinks with every
+// iteration. Misses keep the constant background. Reference.cpp has a CPU version.
+#define GDenoiseFilterRootSignature \
+	"CBV(b0)," \
+	"RootConstants(b1, num32BitConstants = 6)," \
+	"DescriptorTable(UAV(u0, numDescriptors = 5))"
+
+ConstantBuffer<FPerFrameConstantData> GPerFrameCB : register(b0);
+ConstantBuffer<FDenoiseConstants> GDenoiseCB : register(b1);
+RWTexture2D<float4> GInput : register(u0); // Color and luminance variance.
+RWTexture2D<float4> GOutput : register(u1);
+RWTexture2D<float4> GHitPosition : register(u2);
+RWTexture2D<float4> GNormal : register(u3);
+RWTexture2D<float4> GOutputHistoryColor : register(u4);
+
+static const float GKernel[3] = { 3.0f / 8.0f, 1.0f / 4.0f, 1.0f / 16.0f };
+
+float GetLuma(float3 Color)
+{
+	return dot(Color, float3(0.299f, 0.587f, 0.114f));
+}
+
+float GetPrefilteredVariance(int2 Pixel, int2 Dimensions)
+{
+	const float Kernel[2] = { 1.0f / 2.0f, 1.0f / 4.0f };
+	float Sum = 0.0f;
+	float WeightSum = 0.0f;
+	[unroll] for (int Y = -1; Y <= 1; ++Y)
+	{
+		[unroll] for (int X = -1; X <= 1; ++X)
+		{
+			const int2 Coord = Pixel + int2(X, Y);
+			if (all(Coord >= 0) && all(Coord < Dimensions))
+			{
+				const float Weight = Kernel[abs(X)] * Kernel[abs(Y)];
+				Sum += GInput[Coord].a * Weight;
+				WeightSum += Weight;
+			}
+		}
+	}
+	return Sum / WeightSum;
+}
+
+[RootSignature(GDenoiseFilterRootSignature)]
+[numthreads(8, 8, 1)]
+void MainCS(uint3 DispatchID : SV_DispatchThreadID)
+{
+	const int2 Dimensions = int2(GPerFrameCB.TraceWidth, GPerFrameCB.TraceHeight);
+	const int2 Pixel = int2(DispatchID.xy);
+	if (any(Pixel >= Dimensions))
+	{
+		return;
+	}
+
+	const float4 Center = GInput[Pixel];
+	const float4 Position = GHitPosition[Pixel];
+	float3 Color = Center.rgb;
+	float Variance = Center.a;
+	if (Position.w > 0.0f)
+	{
+		const float3 N = GNormal[Pixel].xyz;
+		const float ViewDistance = length(Position.xyz - GPerFrameCB.CameraPosition.xyz);
+		const float CenterLuma = GetLuma(Center.rgb);
+		const float Sigma = sqrt(GetPrefilteredVariance(Pixel, Dimensions));
+
+		float3 ColorSum = 0.0f;
+		float VarianceSum = 0.0f;
+		float WeightSum = 0.0f;
+		[unroll] for (int Y = -2; Y <= 2; ++Y)
+		{
+			[unroll] for (int X = -2; X <= 2; ++X)
+			{
+				const int2 Coord = Pixel + int2(X, Y) * (int)GDenoiseCB.StepSize;
+				if (any(Coord < 0) || any(Coord >= Dimensions))
+				{
+					continue;
+				}
+
+				const float4 Sample = GInput[Coord];
+				float Weight = GKernel[abs(X)] * GKernel[abs(Y)];
+				if (X != 0 || Y != 0)
+				{
+					const float4 SamplePosition = GHitPosition[Coord];
+					if (SamplePosition.w <= 0.0f)
+					{
+						continue;
+					}
+					const float PlaneDistance = abs(dot(N, SamplePosition.xyz - Position.xyz));
+					Weight *= GetDenoiseEdgeWeight(abs(GetLuma(Sample.rgb) - CenterLuma), Sigma, dot(N, GNormal[Coord].xyz), PlaneDistance, ViewDistance, GDenoiseCB.LuminancePhi, GDenoiseCB.NormalPhi, GDenoiseCB.DepthPhi);
+				}
+				ColorSum += Sample.rgb * Weight;
+				VarianceSum += Sample.a * Weight * Weight;
+				WeightSum += Weight;
+			}
+		}
+		Color = ColorSum / WeightSum;
+		Variance = VarianceSum / (WeightSum * WeightSum);
+	}
+
+	GOutput[Pixel] = float4(Color, GDenoiseCB.IsLastIteration != 0 ? 1.0f : Variance);
+	if (GDenoiseCB.WritesHistory != 0)
+	{
+		GOutputHistoryColor[Pixel] = float4(Color, 1.0f);
+	}
+}
@@ -0,0 +1,123 @@
+#include "../CPUAndGPUCommon.h"
+
+// First pass of the denoiser (SVGF-style). Accumulates color and the first two luminance moments over frames with the
+// same reprojection and disocclusion test as Temporal.hlsl, and outputs the color with its luminance variance for the
+// a-trous iterations (DenoiseFilter.hlsl). While the history is short the variance comes from the 3x3 neighbourhood.
+// Normals for the edge-stopping weights are derived from the hit positions here, the trace does not output them.
+// Reference.cpp has a CPU version of this pass and of the filter.
+#define GDenoiseTemporalRootSignature \
+	"CBV(b0)," \
+	"DescriptorTable(SRV(t0, numDescriptors = 3), UAV(u0, numDescriptors = 5))," \
+	"StaticSampler(s0, filter = FILTER_MIN_MAG_MIP_LINEAR, addressU = TEXTURE_ADDRESS_CLAMP, addressV = TEXTURE_ADDRESS_CLAMP)"
+
+ConstantBuffer<FPerFrameConstantData> GPerFrameCB : register(b0);
+Texture2D<float4> GHistoryColor : register(t0);
+Texture2D<float4> GHistoryMoments : register(t1); // Luminance, squared luminance, number of frames.
+Texture2D<float4> GHistoryHitPosition : register(t2);
+RWTexture2D<float4> GColor : register(u0);
+RWTexture2D<float4> GHitPosition : register(u1);
+RWTexture2D<float4> GNormal : register(u2);
+RWTexture2D<float4> GOutputMoments : register(u3);
+RWTexture2D<float4> GOutputColor : register(u4); // Color and luminance variance.
+SamplerState GLinearSampler : register(s0);
+
+float GetLuma(float3 Color)
+{
+	return dot(Color, float3(0.299f, 0.587f, 0.114f));
+}
+
+// Position difference to the neighbour along Axis, the side closer to the center so that depth discontinuities do not
+// bend the normal. Zero when both neighbours are misses or outside of the image.
+float3 GetTangent(int2 Pixel, float3 Position, int2 Axis, int2 Dimensions)
+{
+	const int2 Next = Pixel + Axis;
+	const int2 Prev = Pixel - Axis;
+	const float4 NextPosition = all(Next < Dimensions) ? GHitPosition[Next] : 0.0f;
+	const float4 PrevPosition = all(Prev >= 0) ? GHitPosition[Prev] : 0.0f;
+	const float3 NextDelta = NextPosition.xyz - Position;
+	const float3 PrevDelta = Position - PrevPosition.xyz;
+	if (NextPosition.w > 0.0f && (PrevPosition.w <= 0.0f || dot(NextDelta, NextDelta) < dot(PrevDelta, PrevDelta)))
+	{
+		return NextDelta;
+	}
+	return PrevPosition.w > 0.0f ? PrevDelta : 0.0f;
+}
+
+// Facing the camera, the view direction when the neighbourhood is degenerate.
+float3 GetNormal(int2 Pixel, float3 Position, int2 Dimensions)
+{
+	const float3 View = GPerFrameCB.CameraPosition.xyz - Position;
+	const float3 N = cross(GetTangent(Pixel, Position, int2(1, 0), Dimensions), GetTangent(Pixel, Position, int2(0, 1), Dimensions));
+	const float Length2 = dot(N, N);
+	if (Length2 < 1.0e-12f)
+	{
+		return normalize(View);
+	}
+	return (dot(N, View) < 0.0f ? -N : N) * rsqrt(Length2);
+}
+
+[RootSignature(GDenoiseTemporalRootSignature)]
+[numthreads(8, 8, 1)]
+void MainCS(uint3 DispatchID : SV_DispatchThreadID)
+{
+	const int2 Dimensions = int2(GPerFrameCB.TraceWidth, GPerFrameCB.TraceHeight);
+	const int2 Pixel = int2(DispatchID.xy);
+	if (any(Pixel >= Dimensions))
+	{
+		return;
+	}
+
+	const float3 Color = GColor[Pixel].rgb;
+	const float4 Position = GHitPosition[Pixel];
+	const float Luma = GetLuma(Color);
+	GNormal[Pixel] = float4(Position.w > 0.0f ? GetNormal(Pixel, Position.xyz, Dimensions) : 0.0f, 0.0f);
+
+	float3 HistoryColor = 0.0f;
+	float4 HistoryMoments = 0.0f;
+	if (GPerFrameCB.HasDenoiseHistory != 0 && Position.w > 0.0f)
+	{
+		const float2 PrevDimensions = float2(GPerFrameCB.PrevTraceWidth, GPerFrameCB.PrevTraceHeight);
+		const float2 PrevPixel = GetReprojectedPixel(Position.xyz, GPerFrameCB.PrevWorldToProjection, PrevDimensions);
+		if (all(PrevPixel >= 0.0f) && all(PrevPixel < PrevDimensions))
+		{
+			const float4 HistoryPosition = GHistoryHitPosition.Load(int3(PrevPixel, 0));
+			if (HistoryPosition.w > 0.0f && !IsDisoccluded(Position.xyz, HistoryPosition.xyz, GPerFrameCB.CameraPosition.xyz, GPerFrameCB.DisocclusionTolerance))
+			{
+				float2 TextureSize;
+				GHistoryColor.GetDimensions(TextureSize.x, TextureSize.y);
+				const float2 UV = clamp(PrevPixel, 0.5f, PrevDimensions - 0.5f) / TextureSize;
+				HistoryColor = GHistoryColor.SampleLevel(GLinearSampler, UV, 0.0f).rgb;
+				HistoryMoments = GHistoryMoments.SampleLevel(GLinearSampler, UV, 0.0f);
+			}
+		}
+	}
+
+	const float NumFrames = min(HistoryMoments.z + 1.0f, DENOISE_MAX_FRAMES);
+	const float3 Result = lerp(HistoryColor, Color, GetHistoryBlendFactor(NumFrames, DENOISE_COLOR_MIN_BLEND_FACTOR));
+	const float2 Moments = lerp(HistoryMoments.xy, float2(Luma, Luma * Luma), GetHistoryBlendFactor(NumFrames, DENOISE_MOMENTS_MIN_BLEND_FACTOR));
+
+	float Variance = max(Moments.y - Moments.x * Moments.x, 0.0f);
+	if (NumFrames < DENOISE_MIN_TEMPORAL_VARIANCE_FRAMES)
+	{
+		float2 Sum = 0.0f;
+		float NumSamples = 0.0f;
+		[unroll] for (int Y = -1; Y <= 1; ++Y)
+		{
+			[unroll] for (int X = -1; X <= 1; ++X)
+			{
+				const int2 Coord = Pixel + int2(X, Y);
+				if (all(Coord >= 0) && all(Coord < Dimensions))
+				{
+					const float SampleLuma = GetLuma(GColor[Coord].rgb);
+					Sum += float2(SampleLuma, SampleLuma * SampleLuma);
+					NumSamples += 1.0f;
+				}
+			}
+		}
+		const float2 SpatialMoments = Sum / NumSamples;
+		Variance = max(SpatialMoments.y - SpatialMoments.x * SpatialMoments.x, 0.0f);
+	}
+
+	GOutputMoments[Pixel] = float4(Moments, NumFrames, 0.0f);
+	GOutputColor[Pixel] = float4(Result, Variance);
+}
@@ -0,0 +1,46 @@
+#include "RaytracingCommon.hlsli"
+
+// Primary rays traced inline (DXR 1.1) from a compute shader, an alternative to the MainRGS/MainCHS pipeline in
+// Raytracing.hlsl that produces the same image. Culling and shading come from GPerFrameCB instead of permutations.
+[RootSignature(GRaytracingRootSignature)]
+[numthreads(8, 8, 1)]
+void MainCS(uint3 DispatchID : SV_DispatchThreadID)
+{
+	const uint2 Dimensions = uint2(GPerFrameCB.TraceWidth, GPerFrameCB.TraceHeight);
+	const uint2 Pixel = GetInterleavedPixel(DispatchID.xy, GPerFrameCB.TraceInterleave, GPerFrameCB.InterleavePhase);
+	if (any(Pixel >= Dimensions))
+	{
+		return;
+	}
+
+	float3 Origin, Direction;
+	GenerateCameraRay(Pixel, Dimensions, Origin, Direction);
+
+	RayDesc Ray;
+	Ray.Origin = Origin;
+	Ray.Direction = Direction;
+	Ray.TMin = 0.001f;
+	Ray.TMax = 1000.0f;
+
+	// All geometry is opaque, traversal finishes in a single Proceed().
+	RayQuery<RAY_FLAG_FORCE_OPAQUE> Query;
+	Query.TraceRayInline(GScene, GPerFrameCB.InlineRayFlags, ~0, Ray);
+	Query.Proceed();
+
+	const bool bIsHit = Query.CommittedStatus() == COMMITTED_TRIANGLE_HIT;
+	AddRayCounter(RAY_TYPE_PRIMARY, RAY_COUNTER_RAYS, true);
+	AddRayCounter(RAY_TYPE_PRIMARY, RAY_COUNTER_HITS, bIsHit);
+	AddRayCounter(RAY_TYPE_PRIMARY, RAY_COUNTER_MISSES, !bIsHit);
+
+	float4 Color = float4(0.0f, 0.0f, 0.0f, 1.0f);
+	float HitT = 0.0f;
+	if (bIsHit)
+	{
+		const FStaticMeshInfo Mesh = GMeshInfoBuffer[Query.CommittedInstanceID()];
+		const float3 N = GetHitNormal(Mesh, Query.CommittedPrimitiveIndex(), Query.CommittedTriangleBarycentrics(), Query.CommittedWorldToObject3x4());
+		Color = ShadeHit(N, GPerFrameCB.InlineLambertShading != 0);
+		HitT = Query.CommittedRayT();
+	}
+	GOutput[Pixel] = Color;
+	WriteHitPosition(Pixel, Origin, Direction, HitT);
+}
@@ -1,11 +1,43 @@
-#include "../CPUAndGPUCommon.h"
+#include "RaytracingCommon.hlsli"
+
+// This file is compiled once per permutation, Raytracing_P<Key>.hlsl sets the macros below (key bits are
+// RTPermutation_* in RTPermutation.h) and includes it.
+#ifndef RT_PACKED_PAYLOAD
+#define RT_PACKED_PAYLOAD 0 // Color payload packed to RGBA8 (4 bytes instead of 16).
+#endif
+#ifndef RT_LAMBERT_SHADING
+#define RT_LAMBERT_SHADING 0 // N.L with a fixed directional light instead of normal visualization.
+#endif
+#ifndef RT_NO_CULLING
+#define RT_NO_CULLING 0 // Back-facing triangles are not culled.
+#endif
+
+#if RT_PACKED_PAYLOAD
+#define RT_PAYLOAD_SIZE RT_PACKED_PAYLOAD_SIZE
+#else
+#define RT_PAYLOAD_SIZE RT_FLOAT_PAYLOAD_SIZE
+#endif
+
+#if RT_NO_CULLING
+#define RT_RAY_FLAGS RAY_FLAG_NONE
+#else
+#define RT_RAY_FLAGS RAY_FLAG_CULL_BACK_FACING_TRIANGLES
+#endif
 
 GlobalRootSignature GlobalSignature =
 {
-	"DescriptorTable(UAV(u0)),"
-	"SRV(t0),"
-	"CBV(b0),"
-	"DescriptorTable(SRV(t1, numDescriptors = 2)),"
+	GRaytracingRootSignature
+};
+
+LocalRootSignature MeshSignature =
+{
+	"RootConstants(num32BitConstants = 2, b1)"
+};
+
+SubobjectToExportsAssociation MeshSignatureAssociation =
+{
+	"MeshSignature",
+	"HitGroup",
 };
 
 TriangleHitGroup HitGroup =
@@ -16,7 +48,7 @@ TriangleHitGroup HitGroup =
 
 RaytracingShaderConfig ShaderConfig =
 {
-	16, // max payload size
+	RT_PAYLOAD_SIZE, // max payload size
 	8, // max attribute size
 };
 
@@ -25,65 +57,85 @@ RaytracingPipelineConfig PipelineConfig =
 	1, // max trace recursion depth
 };
 
-RaytracingAccelerationStructure GScene : register(t0);
-RWTexture2D<float4> GOutput : register(u0);
-ConstantBuffer<FPerFrameConstantData> GPerFrameCB : register(b0);
-StructuredBuffer<FVertex> GVertexBuffer : register(t1);
-Buffer<uint3> GIndexBuffer : register(t2);
+ConstantBuffer<FStaticMeshInfo> GMeshInfo : register(b1); // Hit group local root constants.
 
 typedef BuiltInTriangleIntersectionAttributes FAttributes;
+#if RT_PACKED_PAYLOAD
 struct FPayload
 {
-	float4 Color;
+	uint Color;
+	float HitT; // 0 for misses.
 };
 
-void GenerateCameraRay(uint2 RayIndex, out float3 Origin, out float3 Direction)
+void SetPayloadColor(inout FPayload Payload, float4 Color)
 {
-	float2 XY = RayIndex + 0.5f;
-	float2 ScreenPos = XY / DispatchRaysDimensions().xy * 2.0f - 1.0f;
+	const uint4 C = uint4(saturate(Color) * 255.0f + 0.5f);
+	Payload.Color = C.x | (C.y << 8) | (C.z << 16) | (C.w << 24);
+}
 
-	ScreenPos.y = -ScreenPos.y;
+float4 GetPayloadColor(FPayload Payload)
+{
+	return float4((Payload.Color >> uint4(0, 8, 16, 24)) & 0xff) / 255.0f;
+}
+#else
+struct FPayload
+{
+	float4 Color;
+	float HitT; // 0 for misses.
+};
 
-	float4 World = mul(float4(ScreenPos, 0.0f, 1.0f), GPerFrameCB.ProjectionToWorld);
-	World.xyz /= World.w;
+void SetPayloadColor(inout FPayload Payload, float4 Color)
+{
+	Payload.Color = Color;
+}
 
-	Origin = GPerFrameCB.CameraPosition.xyz;
-	Direction = normalize(World.xyz - Origin);
+float4 GetPayloadColor(FPayload Payload)
+{
+	return Payload.Color;
 }
+#endif
 
 [shader("raygeneration")]
 void MainRGS()
 {
+	// Rays are dispatched for the pixels of the current interleave phase, the grid may be larger than the image.
+	const uint2 Dimensions = uint2(GPerFrameCB.TraceWidth, GPerFrameCB.TraceHeight);
+	const uint2 Pixel = GetInterleavedPixel(DispatchRaysIndex().xy, GPerFrameCB.TraceInterleave, GPerFrameCB.InterleavePhase);
+	if (any(Pixel >= Dimensions))
+	{
+		return;
+	}
+
 	float3 Origin, Direction;
-	GenerateCameraRay(DispatchRaysIndex().xy, Origin, Direction);
+	GenerateCameraRay(Pixel, Dimensions, Origin, Direction);
 
 	RayDesc Ray;
 	Ray.Origin = Origin;
 	Ray.Direction = Direction;
 	Ray.TMin = 0.001f;
 	Ray.TMax = 1000.0f;
-	FPayload Payload = { float4(0.0f, 0.0f, 0.0f, 0.0f) };
-	TraceRay(GScene, RAY_FLAG_CULL_BACK_FACING_TRIANGLES, ~0, 0, 1, 0, Ray, Payload);
-
-	GOutput[DispatchRaysIndex().xy] = Payload.Color;
+	FPayload Payload;
+	SetPayloadColor(Payload, float4(0.0f, 0.0f, 0.0f, 0.0f));
+	Payload.HitT = 0.0f;
+	TraceRay(GScene, RT_RAY_FLAGS, ~0, RAY_TYPE_PRIMARY, RAY_TYPE_COUNT, 0, Ray, Payload);
+	AddRayCounter(RAY_TYPE_PRIMARY, RAY_COUNTER_RAYS, true);
+
+	GOutput[Pixel] = GetPayloadColor(Payload);
+	WriteHitPosition(Pixel, Origin, Direction, Payload.HitT);
 }
 
 [shader("miss")]
 void MainMS(inout FPayload Payload)
 {
-	Payload.Color = float4(0.0f, 0.0f, 0.0f, 1.0f);
+	AddRayCounter(RAY_TYPE_PRIMARY, RAY_COUNTER_MISSES, true);
+	SetPayloadColor(Payload, float4(0.0f, 0.0f, 0.0f, 1.0f));
 }
 
 [shader("closesthit")]
 void MainCHS(inout FPayload Payload, in FAttributes Attribs)
 {
-	float3 Position = WorldRayOrigin() + RayTCurrent() * WorldRayDirection();
-
-	uint3 Triangle = GIndexBuffer[PrimitiveIndex()];
-
-	float3 Normals[3] = { GVertexBuffer[Triangle.x].Normal, GVertexBuffer[Triangle.y].Normal, GVertexBuffer[Triangle.z].Normal };
-
-	float3 N = Normals[0] + (Normals[1] - Normals[0]) * Attribs.barycentrics.x + (Normals[2] - Normals[0]) * Attribs.barycentrics.y;
-
-	Payload.Color = float4(abs((N)), 1.0f);
+	AddRayCounter(RAY_TYPE_PRIMARY, RAY_COUNTER_HITS, true);
+	const float3 N = GetHitNormal(GMeshInfo, PrimitiveIndex(), Attribs.barycentrics, WorldToObject3x4());
+	SetPayloadColor(Payload, ShadeHit(N, RT_LAMBERT_SHADING));
+	Payload.HitT = RayTCurrent();
 }
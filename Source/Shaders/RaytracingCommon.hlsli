@@ -0,0 +1,75 @@
+#include "../CPUAndGPUCommon.h"
+
+// Bindings shared by the ray tracing pipelines (Raytracing.hlsl) and the inline ray query path (RayQuery.hlsl), Draw
+// sets them up the same way for both.
+#define GRaytracingRootSignature \
+	"DescriptorTable(UAV(u0), UAV(u2))," \
+	"SRV(t0)," \
+	"CBV(b0)," \
+	"DescriptorTable(SRV(t1, numDescriptors = 3))," \
+	"UAV(u1)"
+
+RaytracingAccelerationStructure GScene : register(t0);
+RWTexture2D<float4> GOutput : register(u0);
+ConstantBuffer<FPerFrameConstantData> GPerFrameCB : register(b0);
+StructuredBuffer<FVertex> GVertexBuffer : register(t1);
+Buffer<uint3> GIndexBuffer : register(t2);
+StructuredBuffer<FStaticMeshInfo> GMeshInfoBuffer : register(t3); // Indexed by InstanceID() (mesh index).
+RWByteAddressBuffer GRayCounters : register(u1);
+RWTexture2D<float4> GHitPosition : register(u2); // World space hit position, w is 0 for misses.
+
+// Adds lanes where bCondition is true to a ray counter, one atomic per wave. Counters only ever grow, the CPU reads
+// differences between frames so they never have to be cleared.
+void AddRayCounter(uint RayType, uint Counter, bool bCondition)
+{
+	if (GPerFrameCB.RayCounters != 0)
+	{
+		const uint Count = WaveActiveCountBits(bCondition);
+		if (WaveIsFirstLane() && Count > 0)
+		{
+			GRayCounters.InterlockedAdd((RayType * RAY_COUNTER_COUNT + Counter) * 4, Count);
+		}
+	}
+}
+
+void GenerateCameraRay(uint2 RayIndex, uint2 Dimensions, out float3 Origin, out float3 Direction)
+{
+	float2 XY = RayIndex + 0.5f + GPerFrameCB.Jitter;
+	float2 ScreenPos = XY / Dimensions * 2.0f - 1.0f;
+
+	ScreenPos.y = -ScreenPos.y;
+
+	float4 World = mul(float4(ScreenPos, 0.0f, 1.0f), GPerFrameCB.ProjectionToWorld);
+	World.xyz /= World.w;
+
+	Origin = GPerFrameCB.CameraPosition.xyz;
+	Direction = normalize(World.xyz - Origin);
+}
+
+// Interpolated world space normal of a triangle hit. Normals transform with the inverse transpose of the instance
+// transform, mul(N, WorldToObject) so that non-uniformly scaled instances keep them perpendicular to the surface.
+float3 GetHitNormal(FStaticMeshInfo Mesh, uint PrimitiveIndex, float2 Barycentrics, float3x4 WorldToObject)
+{
+	uint3 Triangle = GIndexBuffer[Mesh.BaseIndex / 3 + PrimitiveIndex] + Mesh.BaseVertex;
+
+	float3 Normals[3] = { GVertexBuffer[Triangle.x].Normal, GVertexBuffer[Triangle.y].Normal, GVertexBuffer[Triangle.z].Normal };
+
+	float3 N = Normals[0] + (Normals[1] - Normals[0]) * Barycentrics.x + (Normals[2] - Normals[0]) * Barycentrics.y;
+	return normalize(mul(N, (float3x3)WorldToObject));
+}
+
+// HitT is 0 for misses.
+void WriteHitPosition(uint2 RayIndex, float3 Origin, float3 Direction, float HitT)
+{
+	GHitPosition[RayIndex] = float4(Origin + Direction * HitT, HitT > 0.0f ? 1.0f : 0.0f);
+}
+
+float4 ShadeHit(float3 N, bool bLambertShading)
+{
+	if (bLambertShading)
+	{
+		const float3 L = normalize(float3(0.5f, 1.0f, -0.25f));
+		return float4((0.1f + 0.9f * saturate(dot(N, L))).xxx, 1.0f);
+	}
+	return float4(abs(N), 1.0f);
+}
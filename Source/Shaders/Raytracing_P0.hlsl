@@ -0,0 +1,5 @@
+// Ray tracing permutation 0, see Raytracing.hlsl.
+#define RT_PACKED_PAYLOAD 0
+#define RT_LAMBERT_SHADING 0
+#define RT_NO_CULLING 0
+#include "Raytracing.hlsl"
@@ -0,0 +1,5 @@
+// Ray tracing permutation 4, see Raytracing.hlsl.
+#define RT_PACKED_PAYLOAD 0
+#define RT_LAMBERT_SHADING 0
+#define RT_NO_CULLING 1
+#include "Raytracing.hlsl"
@@ -0,0 +1,97 @@
+#include "../CPUAndGPUCommon.h"
+
+// Fills the pixels that interleaved tracing skipped this frame (see GetInterleavedPixel). A skipped pixel takes the
+// surface of the nearest traced neighbour in its 3x3 neighbourhood, moves with that surface into the previous frame and
+// reuses the reconstructed color there, clamped to the range of the traced neighbours so that stale history can not
+// ghost. Without usable history (first frame, disocclusion, misses) the traced neighbours are averaged. Reference.cpp
+// has a CPU version.
+#define GReconstructRootSignature \
+	"CBV(b0)," \
+	"DescriptorTable(SRV(t0, numDescriptors = 2), UAV(u0, numDescriptors = 3))," \
+	"StaticSampler(s0, filter = FILTER_MIN_MAG_MIP_LINEAR, addressU = TEXTURE_ADDRESS_CLAMP, addressV = TEXTURE_ADDRESS_CLAMP)"
+
+ConstantBuffer<FPerFrameConstantData> GPerFrameCB : register(b0);
+Texture2D<float4> GPrevColor : register(t0);
+Texture2D<float4> GPrevHitPosition : register(t1);
+RWTexture2D<float4> GColor : register(u0); // Traced color in, reconstructed color out.
+RWTexture2D<float4> GHitPosition : register(u1);
+RWTexture2D<float4> GOutputColor : register(u2);
+SamplerState GLinearSampler : register(s0);
+
+[RootSignature(GReconstructRootSignature)]
+[numthreads(8, 8, 1)]
+void MainCS(uint3 DispatchID : SV_DispatchThreadID)
+{
+	const uint2 Dimensions = uint2(GPerFrameCB.TraceWidth, GPerFrameCB.TraceHeight);
+	const uint2 Pixel = DispatchID.xy;
+	if (any(Pixel >= Dimensions))
+	{
+		return;
+	}
+
+	if (IsTracedPixel(Pixel, GPerFrameCB.TraceInterleave, GPerFrameCB.InterleavePhase))
+	{
+		GOutputColor[Pixel] = GColor[Pixel];
+		return;
+	}
+
+	// Traced neighbours, the nearest hit wins and misses count as furthest.
+	float3 Sum = 0.0f;
+	float3 Min = 1.0e30f;
+	float3 Max = -1.0e30f;
+	float NumSamples = 0.0f;
+	float4 Position = 0.0f;
+	int2 Neighbor = int2(Pixel);
+	float NearestDistance2 = 1.0e30f;
+	[unroll] for (int Y = -1; Y <= 1; ++Y)
+	{
+		[unroll] for (int X = -1; X <= 1; ++X)
+		{
+			const int2 Coord = int2(Pixel) + int2(X, Y);
+			if (any(Coord < 0) || any(Coord >= int2(Dimensions)) || !IsTracedPixel(uint2(Coord), GPerFrameCB.TraceInterleave, GPerFrameCB.InterleavePhase))
+			{
+				continue;
+			}
+
+			const float3 Color = GColor[Coord].rgb;
+			Sum += Color;
+			Min = min(Min, Color);
+			Max = max(Max, Color);
+			NumSamples += 1.0f;
+
+			const float4 NeighborPosition = GHitPosition[Coord];
+			const float3 View = NeighborPosition.xyz - GPerFrameCB.CameraPosition.xyz;
+			const float Distance2 = NeighborPosition.w > 0.0f ? dot(View, View) : 1.0e29f;
+			if (Distance2 < NearestDistance2)
+			{
+				NearestDistance2 = Distance2;
+				Position = NeighborPosition;
+				Neighbor = Coord;
+			}
+		}
+	}
+
+	float3 Result = NumSamples > 0.0f ? Sum / NumSamples : 0.0f;
+	if (GPerFrameCB.HasReconstructionHistory != 0 && Position.w > 0.0f)
+	{
+		// Motion of the neighbour's surface applied to this pixel.
+		const float2 PrevDimensions = float2(GPerFrameCB.PrevTraceWidth, GPerFrameCB.PrevTraceHeight);
+		const float2 Motion = GetReprojectedPixel(Position.xyz, GPerFrameCB.PrevWorldToProjection, PrevDimensions) - (Neighbor + 0.5f + GPerFrameCB.Jitter);
+		const float2 PrevPixel = Pixel + 0.5f + Motion;
+		if (all(PrevPixel >= 0.0f) && all(PrevPixel < PrevDimensions))
+		{
+			const float4 PrevPosition = GPrevHitPosition.Load(int3(PrevPixel, 0));
+			if (PrevPosition.w > 0.0f && !IsDisoccluded(Position.xyz, PrevPosition.xyz, GPerFrameCB.CameraPosition.xyz, GPerFrameCB.DisocclusionTolerance))
+			{
+				float2 TextureSize;
+				GPrevColor.GetDimensions(TextureSize.x, TextureSize.y);
+				const float2 UV = clamp(PrevPixel, 0.5f, PrevDimensions - 0.5f) / TextureSize;
+				Result = clamp(GPrevColor.SampleLevel(GLinearSampler, UV, 0.0f).rgb, Min, Max);
+			}
+		}
+	}
+
+	GColor[Pixel] = float4(Result, 1.0f);
+	GHitPosition[Pixel] = Position;
+	GOutputColor[Pixel] = float4(Result, 1.0f);
+}
@@ -0,0 +1,57 @@
+#include "../CPUAndGPUCommon.h"
+
+// Accumulates the traced image over frames. Every hit is reprojected into the previous frame with its world space
+// position, history is used when the previous frame saw the same surface there (IsDisoccluded) and blended in as an
+// exponential average whose length is kept in the history alpha. Camera rays are jittered (GPerFrameCB.Jitter) so the
+// average converges to an antialiased image. Misses show the constant background and take no history.
+#define GTemporalRootSignature \
+	"CBV(b0)," \
+	"DescriptorTable(SRV(t0, numDescriptors = 2), UAV(u0, numDescriptors = 3))," \
+	"StaticSampler(s0, filter = FILTER_MIN_MAG_MIP_LINEAR, addressU = TEXTURE_ADDRESS_CLAMP, addressV = TEXTURE_ADDRESS_CLAMP)"
+
+// Accumulated frames saturate here, it only has to outgrow 1 / HistoryMinBlendFactor.
+#define TEMPORAL_MAX_FRAMES 256.0f
+
+ConstantBuffer<FPerFrameConstantData> GPerFrameCB : register(b0);
+Texture2D<float4> GHistoryColor : register(t0);
+Texture2D<float4> GHistoryHitPosition : register(t1);
+RWTexture2D<float4> GColor : register(u0); // Traced color in, accumulated color out.
+RWTexture2D<float4> GHitPosition : register(u1);
+RWTexture2D<float4> GOutputHistoryColor : register(u2);
+SamplerState GLinearSampler : register(s0);
+
+[RootSignature(GTemporalRootSignature)]
+[numthreads(8, 8, 1)]
+void MainCS(uint3 DispatchID : SV_DispatchThreadID)
+{
+	if (any(DispatchID.xy >= uint2(GPerFrameCB.TraceWidth, GPerFrameCB.TraceHeight)))
+	{
+		return;
+	}
+
+	const float4 Color = GColor[DispatchID.xy];
+	const float4 Position = GHitPosition[DispatchID.xy];
+
+	float4 History = 0.0f;
+	if (GPerFrameCB.HasTemporalHistory != 0 && Position.w > 0.0f)
+	{
+		const float2 PrevDimensions = float2(GPerFrameCB.PrevTraceWidth, GPerFrameCB.PrevTraceHeight);
+		const float2 PrevPixel = GetReprojectedPixel(Position.xyz, GPerFrameCB.PrevWorldToProjection, PrevDimensions);
+		if (all(PrevPixel >= 0.0f) && all(PrevPixel < PrevDimensions))
+		{
+			const float4 HistoryPosition = GHistoryHitPosition.Load(int3(PrevPixel, 0));
+			if (HistoryPosition.w > 0.0f && !IsDisoccluded(Position.xyz, HistoryPosition.xyz, GPerFrameCB.CameraPosition.xyz, GPerFrameCB.DisocclusionTolerance))
+			{
+				float2 TextureSize;
+				GHistoryColor.GetDimensions(TextureSize.x, TextureSize.y);
+				const float2 UV = clamp(PrevPixel, 0.5f, PrevDimensions - 0.5f) / TextureSize;
+				History = GHistoryColor.SampleLevel(GLinearSampler, UV, 0.0f);
+			}
+		}
+	}
+
+	const float NumFrames = min(History.a + 1.0f, TEMPORAL_MAX_FRAMES);
+	const float3 Result = lerp(History.rgb, Color.rgb, GetHistoryBlendFactor(NumFrames, GPerFrameCB.HistoryMinBlendFactor));
+	GOutputHistoryColor[DispatchID.xy] = float4(Result, NumFrames);
+	GColor[DispatchID.xy] = float4(Result, 1.0f);
+}
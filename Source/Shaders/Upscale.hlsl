@@ -0,0 +1,125 @@
+#include "../CPUAndGPUCommon.h"
+
+// Scales the traced sub-rectangle of the ray tracing output up to the full output, used when the trace resolution is
+// below the output resolution. Samples are clamped to the traced rectangle so nothing outside of it bleeds in at the
+// edges.
+//
+// UPSCALE_FILTER_EDGE_ADAPTIVE is a Lanczos2 filter over the 4x4 input texels around the output pixel (EASU-style):
+// the kernel is rotated to the local luma gradient, narrowed across edges and stretched along them, its negative lobe
+// shrinks on strong edges and the result is clamped to the nearest 2x2 texels against ringing. Sharpening is a
+// contrast-adaptive unsharp mask against the bilinear result, weaker where the neighbourhood is close to black or
+// white. Reference.cpp has a CPU version of both filters.
+#define GUpscaleRootSignature \
+	"RootConstants(b0, num32BitConstants = 6)," \
+	"DescriptorTable(SRV(t0), UAV(u0))," \
+	"StaticSampler(s0, filter = FILTER_MIN_MAG_MIP_LINEAR, addressU = TEXTURE_ADDRESS_CLAMP, addressV = TEXTURE_ADDRESS_CLAMP)"
+
+ConstantBuffer<FUpscaleConstants> GUpscaleCB : register(b0);
+Texture2D<float4> GInput : register(t0);
+RWTexture2D<float4> GOutput : register(u0);
+SamplerState GLinearSampler : register(s0);
+
+float GetLuma(float3 Color)
+{
+	return dot(Color, float3(0.299f, 0.587f, 0.114f));
+}
+
+float3 UpscaleEdgeAdaptive(float2 InputPosition)
+{
+	const float2 Corner = floor(InputPosition - 0.5f);
+	const float2 Fraction = InputPosition - 0.5f - Corner;
+	const int2 MaxCoord = int2(GUpscaleCB.InputSize) - 1;
+
+	float3 Colors[4][4];
+	float Lumas[4][4];
+	[unroll] for (int Y = 0; Y < 4; ++Y)
+	{
+		[unroll] for (int X = 0; X < 4; ++X)
+		{
+			const int2 Coord = clamp(int2(Corner) + int2(X - 1, Y - 1), 0, MaxCoord);
+			Colors[Y][X] = GInput.Load(int3(Coord, 0)).rgb;
+			Lumas[Y][X] = GetLuma(Colors[Y][X]);
+		}
+	}
+
+	// Gradient and edge strength from the 2x2 texels around the position, bilinearly weighted.
+	const float BilinearWeights[2][2] = { { (1.0f - Fraction.x) * (1.0f - Fraction.y), Fraction.x * (1.0f - Fraction.y) }, { (1.0f - Fraction.x) * Fraction.y, Fraction.x * Fraction.y } };
+	float2 Gradient = 0.0f;
+	float Edge = 0.0f;
+	[unroll] for (int Y = 1; Y < 3; ++Y)
+	{
+		[unroll] for (int X = 1; X < 3; ++X)
+		{
+			const float2 Delta = float2(Lumas[Y][X + 1] - Lumas[Y][X - 1], Lumas[Y + 1][X] - Lumas[Y - 1][X]);
+			const float2 Range = float2(max(abs(Lumas[Y][X + 1] - Lumas[Y][X]), abs(Lumas[Y][X] - Lumas[Y][X - 1])), max(abs(Lumas[Y + 1][X] - Lumas[Y][X]), abs(Lumas[Y][X] - Lumas[Y - 1][X])));
+			// 1 for a step, 0 for a linear ramp or flat area.
+			const float2 Step = saturate(abs(Delta) / max(2.0f * Range, 1.0f / 1024.0f));
+			const float Weight = BilinearWeights[Y - 1][X - 1];
+			Gradient += Delta * Weight;
+			Edge += dot(Step * Step, 0.5f) * Weight;
+		}
+	}
+
+	float2 Direction = Gradient;
+	const float DirectionLength2 = dot(Direction, Direction);
+	Direction = DirectionLength2 < 1.0f / 32768.0f ? float2(1.0f, 0.0f) : Direction * rsqrt(DirectionLength2);
+	const float Stretch = 1.0f / max(abs(Direction.x), abs(Direction.y));
+	const float2 AxisScale = float2(1.0f + (Stretch - 1.0f) * Edge, 1.0f - 0.5f * Edge);
+	const float Lobe = 0.5f + (0.25f - 0.04f - 0.5f) * Edge;
+	const float Clip = 1.0f / Lobe;
+
+	float3 Sum = 0.0f;
+	float WeightSum = 0.0f;
+	[unroll] for (int Y = 0; Y < 4; ++Y)
+	{
+		[unroll] for (int X = 0; X < 4; ++X)
+		{
+			// Corners of the 4x4 footprint are outside of the Lanczos2 support.
+			if ((X == 0 || X == 3) && (Y == 0 || Y == 3))
+			{
+				continue;
+			}
+			const float2 Offset = float2(X - 1, Y - 1) - Fraction;
+			const float2 Rotated = float2(dot(Offset, Direction), dot(Offset, float2(-Direction.y, Direction.x))) * AxisScale;
+			const float Weight = GetLanczos2Weight(dot(Rotated, Rotated), Lobe, Clip);
+			Sum += Colors[Y][X] * Weight;
+			WeightSum += Weight;
+		}
+	}
+
+	const float3 Min = min(min(Colors[1][1], Colors[1][2]), min(Colors[2][1], Colors[2][2]));
+	const float3 Max = max(max(Colors[1][1], Colors[1][2]), max(Colors[2][1], Colors[2][2]));
+	float3 Color = clamp(Sum / WeightSum, Min, Max);
+
+	if (GUpscaleCB.Sharpness > 0.0f)
+	{
+		const float3 Bilinear = Colors[1][1] * BilinearWeights[0][0] + Colors[1][2] * BilinearWeights[0][1] + Colors[2][1] * BilinearWeights[1][0] + Colors[2][2] * BilinearWeights[1][1];
+		const float3 Headroom = min(Min, 1.0f - Max) / max(Max, 1.0f / 256.0f);
+		const float3 Amount = GUpscaleCB.Sharpness * sqrt(saturate(Headroom));
+		Color = saturate(Color + (Color - Bilinear) * Amount);
+	}
+	return Color;
+}
+
+[RootSignature(GUpscaleRootSignature)]
+[numthreads(8, 8, 1)]
+void MainCS(uint3 DispatchID : SV_DispatchThreadID)
+{
+	uint2 Dimensions;
+	GOutput.GetDimensions(Dimensions.x, Dimensions.y);
+	if (any(DispatchID.xy >= Dimensions))
+	{
+		return;
+	}
+
+	const float2 InputPosition = (DispatchID.xy + 0.5f) / Dimensions * GUpscaleCB.InputSize;
+	if (GUpscaleCB.Filter == UPSCALE_FILTER_EDGE_ADAPTIVE)
+	{
+		GOutput[DispatchID.xy] = float4(UpscaleEdgeAdaptive(InputPosition), 1.0f);
+	}
+	else
+	{
+		const float2 Position = clamp(InputPosition, 0.5f, GUpscaleCB.InputSize - 0.5f);
+		GOutput[DispatchID.xy] = GInput.SampleLevel(GLinearSampler, Position * GUpscaleCB.InvInputTextureSize, 0.0f);
+	}
+}
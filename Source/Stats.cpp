@@ -0,0 +1,149 @@
+#include "Stats.h"
+#include <math.h>
+#include <string.h>
+#include "EAAssert/eaassert.h"
+#include "EASTL/algorithm.h"
+#include "EASTL/sort.h"
+
+void AddGPUScopeSample(FGPUScopeStats& Stats, float Ms)
+{
+	Stats.History[Stats.NumSamples % kGPUScopeHistorySize] = Ms;
+	Stats.NumSamples += 1;
+	Stats.LastMs = Ms;
+
+	const uint32_t Count = eastl::min(Stats.NumSamples, kGPUScopeHistorySize);
+	float Sum = 0.0f;
+	Stats.MinMs = Stats.MaxMs = Stats.History[0];
+	for (uint32_t Idx = 0; Idx < Count; ++Idx)
+	{
+		Sum += Stats.History[Idx];
+		Stats.MinMs = eastl::min(Stats.MinMs, Stats.History[Idx]);
+		Stats.MaxMs = eastl::max(Stats.MaxMs, Stats.History[Idx]);
+	}
+	Stats.AvgMs = Sum / Count;
+}
+
+// One frame of timestamp pairs, FrameScopes maps every pair to its scope. Scopes recorded several times in the frame
+// get the sum of their pairs as one sample, scopes not recorded get none.
+void AddGPUScopeFrame(FGPUScopeStats* Scopes, uint32_t NumScopes, const uint32_t* FrameScopes, const uint64_t* Timestamps, uint32_t NumFrameScopes, double TicksToMs)
+{
+	float FrameMs[kMaxGPUScopes] = {};
+	bool bIsRecorded[kMaxGPUScopes] = {};
+	for (uint32_t Idx = 0; Idx < NumFrameScopes; ++Idx)
+	{
+		const uint32_t ScopeIndex = FrameScopes[Idx];
+		const uint64_t Begin = Timestamps[2 * Idx];
+		const uint64_t End = Timestamps[2 * Idx + 1];
+		FrameMs[ScopeIndex] += End > Begin ? (float)((End - Begin) * TicksToMs) : 0.0f;
+		bIsRecorded[ScopeIndex] = true;
+	}
+	for (uint32_t Idx = 0; Idx < NumScopes; ++Idx)
+	{
+		if (bIsRecorded[Idx])
+		{
+			AddGPUScopeSample(Scopes[Idx], FrameMs[Idx]);
+		}
+	}
+}
+
+void AddFrameTiming(FFrameStats& Stats, const float (&Ms)[FrameMetric_Count])
+{
+	memcpy(Stats.History[Stats.NumFrames % kFrameStatsHistorySize], Ms, sizeof(Ms));
+	Stats.NumFrames++;
+}
+
+// Percentiles are nearest rank over the frames in the ring.
+void GetFrameStatsSummary(const FFrameStats& Stats, FFrameStatsSummary& OutSummary)
+{
+	OutSummary = {};
+	OutSummary.NumFrames = eastl::min(Stats.NumFrames, kFrameStatsHistorySize);
+	if (OutSummary.NumFrames == 0)
+	{
+		return;
+	}
+
+	const uint32_t NumFrames = OutSummary.NumFrames;
+	auto GetRank = [NumFrames](float Percentile) -> uint32_t
+	{
+		const uint32_t Rank = (uint32_t)ceilf(Percentile * NumFrames);
+		return eastl::max(Rank, 1u) - 1;
+	};
+
+	float Sorted[kFrameStatsHistorySize];
+	for (uint32_t Metric = 0; Metric < FrameMetric_Count; ++Metric)
+	{
+		double Sum = 0.0;
+		for (uint32_t Idx = 0; Idx < NumFrames; ++Idx)
+		{
+			Sorted[Idx] = Stats.History[Idx][Metric];
+			Sum += Sorted[Idx];
+		}
+		eastl::sort(Sorted, Sorted + NumFrames);
+
+		FFrameMetricSummary& Summary = OutSummary.Metrics[Metric];
+		Summary.AvgMs = (float)(Sum / NumFrames);
+		Summary.P50Ms = Sorted[GetRank(0.5f)];
+		Summary.P95Ms = Sorted[GetRank(0.95f)];
+		Summary.P99Ms = Sorted[GetRank(0.99f)];
+		Summary.MaxMs = Sorted[NumFrames - 1];
+	}
+
+	const float HitchMs = kFrameHitchFactor * OutSummary.Metrics[FrameMetric_Frame].P50Ms;
+	for (uint32_t Idx = 0; Idx < NumFrames; ++Idx)
+	{
+		OutSummary.NumHitches += Stats.History[Idx][FrameMetric_Frame] > HitchMs ? 1 : 0;
+	}
+}
+
+// Counts of one frame from two readbacks of the running totals, unsigned difference handles wrap-around.
+void GetRayCounterDeltas(const uint32_t (&Previous)[kNumRayCounters], const uint32_t* Current, uint64_t (&OutCounts)[kNumRayCounters])
+{
+	for (uint32_t Idx = 0; Idx < kNumRayCounters; ++Idx)
+	{
+		OutCounts[Idx] = (uint32_t)(Current[Idx] - Previous[Idx]);
+	}
+}
+
+void AddGPUMemory(FGPUMemoryTracker& Tracker, EGPUMemoryCategory Category, uint32_t HeapType, uint64_t Size)
+{
+	EA_ASSERT(Category < GPUMemory_Count && HeapType < kNumGPUHeapTypes);
+	FGPUMemoryCategoryStats& Stats = Tracker.Categories[Category];
+	Stats.Bytes += Size;
+	Stats.HighWaterBytes = eastl::max(Stats.HighWaterBytes, Stats.Bytes);
+	Stats.NumResources++;
+	Stats.NumCreated++;
+
+	Tracker.HeapTypeBytes[HeapType] += Size;
+	Tracker.Bytes += Size;
+	Tracker.HighWaterBytes = eastl::max(Tracker.HighWaterBytes, Tracker.Bytes);
+}
+
+void RemoveGPUMemory(FGPUMemoryTracker& Tracker, EGPUMemoryCategory Category, uint32_t HeapType, uint64_t Size)
+{
+	FGPUMemoryCategoryStats& Stats = Tracker.Categories[Category];
+	EA_ASSERT(Stats.Bytes >= Size && Stats.NumResources > 0 && Tracker.HeapTypeBytes[HeapType] >= Size);
+	Stats.Bytes -= Size;
+	Stats.NumResources--;
+
+	Tracker.HeapTypeBytes[HeapType] -= Size;
+	Tracker.Bytes -= Size;
+}
+
+// Accounts the memory and returns the context for the destruction callback of the resource.
+FGPUMemoryAllocation* AddGPUMemoryAllocation(FGPUMemoryTracker& Tracker, EGPUMemoryCategory Category, uint32_t HeapType, uint64_t Size)
+{
+	FGPUMemoryAllocation* Allocation = new FGPUMemoryAllocation();
+	Allocation->Tracker = &Tracker;
+	Allocation->Size = Size;
+	Allocation->Category = Category;
+	Allocation->HeapType = HeapType;
+	AddGPUMemory(Tracker, Category, HeapType, Size);
+	return Allocation;
+}
+
+void ReleaseGPUMemoryAllocation(void* Context)
+{
+	FGPUMemoryAllocation* Allocation = (FGPUMemoryAllocation*)Context;
+	RemoveGPUMemory(*Allocation->Tracker, Allocation->Category, Allocation->HeapType, Allocation->Size);
+	delete Allocation;
+}
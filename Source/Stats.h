@@ -0,0 +1,130 @@
+#pragma once
+
+#include <stdint.h>
+#include "CPUAndGPUCommon.h"
+
+// Statistics kept by the profilers and trackers in Library.cpp that need neither the device nor Win32, so that the
+// headless tests (Tests/) can build them.
+
+static const uint32_t kMaxGPUScopes = 32; // Distinct scope names.
+static const uint32_t kMaxGPUScopesPerFrame = 64;
+static const uint32_t kGPUScopeHistorySize = 128;
+
+// Rolling statistics of one named GPU scope over the last kGPUScopeHistorySize frames it was recorded in. Scopes with
+// the same name recorded several times in one frame add up to one sample.
+struct FGPUScopeStats
+{
+	const char* Name;
+	float History[kGPUScopeHistorySize];
+	uint32_t NumSamples; // Total samples added, History holds the last kGPUScopeHistorySize of them.
+	float LastMs;
+	float MinMs;
+	float AvgMs;
+	float MaxMs;
+};
+
+enum EFrameMetric
+{
+	FrameMetric_Frame,
+	FrameMetric_CPU, // Frame time without the present wait.
+	FrameMetric_GPU, // "Frame" GPU scope, arrives two frames late.
+	FrameMetric_PresentWait,
+	FrameMetric_Count,
+};
+
+static const char* const kFrameMetricNames[FrameMetric_Count] = { "Frame", "CPU", "GPU", "PresentWait" };
+
+static const uint32_t kFrameStatsHistorySize = 1024;
+static const float kFrameHitchFactor = 2.0f; // Frames longer than this times the median frame time are hitches.
+
+// Timings of every frame in a ring of the last kFrameStatsHistorySize frames, filled by UpdateFrameStats.
+struct FFrameStats
+{
+	float History[kFrameStatsHistorySize][FrameMetric_Count];
+	uint32_t NumFrames; // Total frames added, History holds the last kFrameStatsHistorySize of them.
+	float PresentWaitMs; // Written by PresentFrame, recorded with the frame by the next UpdateFrameStats.
+	double RaysPerSecond; // Latest value from the application (ray counters), zero when unknown.
+	uint64_t NumAllocations; // GetNumAllocations at the last UpdateFrameStats.
+	uint32_t LastFrameAllocations;
+	double PreviousTime;
+	double TitleRefreshTime;
+	uint32_t NumTitleFrames;
+};
+
+struct FFrameMetricSummary
+{
+	float AvgMs;
+	float P50Ms;
+	float P95Ms;
+	float P99Ms;
+	float MaxMs;
+};
+
+struct FFrameStatsSummary
+{
+	uint32_t NumFrames;
+	uint32_t NumHitches;
+	FFrameMetricSummary Metrics[FrameMetric_Count];
+};
+
+static const uint32_t kNumRayCounters = RAY_TYPE_COUNT * RAY_COUNTER_COUNT; // Running totals kept by the GPU.
+
+enum EGPUMemoryCategory
+{
+	GPUMemory_RenderTarget,
+	GPUMemory_Texture,
+	GPUMemory_Geometry,
+	GPUMemory_AccelerationStructure,
+	GPUMemory_Scratch,
+	GPUMemory_ShaderTable,
+	GPUMemory_Upload,
+	GPUMemory_Readback,
+	GPUMemory_UI,
+	GPUMemory_Other,
+	GPUMemory_Count,
+};
+
+static const char* const kGPUMemoryCategoryNames[GPUMemory_Count] =
+{
+	"RenderTarget", "Texture", "Geometry", "AccelerationStructure", "Scratch", "ShaderTable", "Upload", "Readback", "UI", "Other",
+};
+
+struct FGPUMemoryCategoryStats
+{
+	uint64_t Bytes;
+	uint64_t HighWaterBytes;
+	uint32_t NumResources;
+	uint32_t NumCreated; // Grows with every creation, shows resources that keep getting reallocated.
+};
+
+static const uint32_t kNumGPUHeapTypes = 5; // D3D12_HEAP_TYPE values, DEFAULT (1) to CUSTOM (4).
+
+// Resources created with CreateGPUResource. Sizes are the allocation sizes reported by the device, swap chain buffers
+// are not included.
+struct FGPUMemoryTracker
+{
+	FGPUMemoryCategoryStats Categories[GPUMemory_Count];
+	uint64_t HeapTypeBytes[kNumGPUHeapTypes];
+	uint64_t Bytes;
+	uint64_t HighWaterBytes;
+};
+
+// One resource in a tracker, from its creation until the destruction callback of the resource passes it to
+// ReleaseGPUMemoryAllocation.
+struct FGPUMemoryAllocation
+{
+	FGPUMemoryTracker* Tracker;
+	uint64_t Size;
+	EGPUMemoryCategory Category;
+	uint32_t HeapType;
+};
+
+void AddGPUScopeSample(FGPUScopeStats& Stats, float Ms);
+void AddGPUScopeFrame(FGPUScopeStats* Scopes, uint32_t NumScopes, const uint32_t* FrameScopes, const uint64_t* Timestamps, uint32_t NumFrameScopes, double TicksToMs);
+void AddFrameTiming(FFrameStats& Stats, const float (&Ms)[FrameMetric_Count]);
+void GetFrameStatsSummary(const FFrameStats& Stats, FFrameStatsSummary& OutSummary);
+void GetRayCounterDeltas(const uint32_t (&Previous)[kNumRayCounters], const uint32_t* Current, uint64_t (&OutCounts)[kNumRayCounters]);
+void AddGPUMemory(FGPUMemoryTracker& Tracker, EGPUMemoryCategory Category, uint32_t HeapType, uint64_t Size);
+void RemoveGPUMemory(FGPUMemoryTracker& Tracker, EGPUMemoryCategory Category, uint32_t HeapType, uint64_t Size);
+FGPUMemoryAllocation* AddGPUMemoryAllocation(FGPUMemoryTracker& Tracker, EGPUMemoryCategory Category, uint32_t HeapType, uint64_t Size);
+void ReleaseGPUMemoryAllocation(void* Context);
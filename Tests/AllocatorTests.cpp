@@ -0,0 +1,359 @@
+#include "Test.h"
+#include "Allocator.h"
+#include <stdlib.h>
+#include <string.h>
+#include "EASTL/algorithm.h"
+#include "EAStdC/EAStopwatch.h"
+#include "EAThread/eathread_thread.h"
+
+// Every size maps to the smallest class that holds it, classes are 16 byte multiples and waste at most 25% above the
+// 16 byte steps.
+TEST(AllocatorSizeClasses)
+{
+	CHECK(GetClassSize(kNumSizeClasses - 1) == kMaxSmallObjectSize);
+	bool bIsRoundTrip = true;
+	bool bIsAscending = true;
+	for (uint32_t SizeClass = 0; SizeClass < kNumSizeClasses; ++SizeClass)
+	{
+		const uint32_t ClassSize = GetClassSize(SizeClass);
+		bIsRoundTrip = bIsRoundTrip && GetSizeClass(ClassSize) == SizeClass && ClassSize % 16 == 0;
+		bIsAscending = bIsAscending && (SizeClass == 0 || GetClassSize(SizeClass - 1) < ClassSize);
+	}
+	CHECK(bIsRoundTrip);
+	CHECK(bIsAscending);
+
+	bool bIsSmallestFit = true;
+	bool bIsWasteBounded = true;
+	for (uint32_t Size = 0; Size <= kMaxSmallObjectSize; ++Size)
+	{
+		const uint32_t SizeClass = GetSizeClass(Size);
+		bIsSmallestFit = bIsSmallestFit && SizeClass < kNumSizeClasses && GetClassSize(SizeClass) >= Size && (SizeClass == 0 || GetClassSize(SizeClass - 1) < Size);
+		bIsWasteBounded = bIsWasteBounded && (Size <= 128 || GetClassSize(SizeClass) * 4 <= Size * 5);
+	}
+	CHECK(bIsSmallestFit);
+	CHECK(bIsWasteBounded);
+}
+
+struct FCrossThreadBlocks
+{
+	void* Blocks[4096];
+	uint32_t NumBlocks;
+	uint32_t Size;
+	bool bIsIntact;
+};
+
+static void FillBlocks(FCrossThreadBlocks& Blocks)
+{
+	for (uint32_t Idx = 0; Idx < Blocks.NumBlocks; ++Idx)
+	{
+		Blocks.Blocks[Idx] = AllocateMemory(Blocks.Size);
+		memset(Blocks.Blocks[Idx], (int)(Idx & 0xff), Blocks.Size);
+	}
+}
+
+static void FreeBlocks(FCrossThreadBlocks& Blocks)
+{
+	Blocks.bIsIntact = true;
+	for (uint32_t Idx = 0; Idx < Blocks.NumBlocks; ++Idx)
+	{
+		const uint8_t* Bytes = (const uint8_t*)Blocks.Blocks[Idx];
+		Blocks.bIsIntact = Blocks.bIsIntact && Bytes[0] == (Idx & 0xff) && Bytes[Blocks.Size - 1] == (Idx & 0xff);
+		FreeMemory(Blocks.Blocks[Idx]);
+	}
+}
+
+// Blocks allocated on one thread and freed on another, in both directions: the contents survive the hand over and
+// the freed blocks are reused, so after the first round no further spans are committed.
+TEST(AllocatorCrossThreadFree)
+{
+	FCrossThreadBlocks Blocks = {};
+	Blocks.NumBlocks = 4096;
+	Blocks.Size = 96;
+
+	uint64_t FirstRoundBytes = 0;
+	bool bIsIntact = true;
+	for (uint32_t Round = 0; Round < 8; ++Round)
+	{
+		EA::Thread::Thread Producer;
+		Producer.Begin([](void* Context) -> intptr_t
+		{
+			FillBlocks(*(FCrossThreadBlocks*)Context);
+			return 0;
+		}, &Blocks);
+		Producer.WaitForEnd();
+		FreeBlocks(Blocks);
+		bIsIntact = bIsIntact && Blocks.bIsIntact;
+
+		FillBlocks(Blocks);
+		EA::Thread::Thread Consumer;
+		Consumer.Begin([](void* Context) -> intptr_t
+		{
+			FreeBlocks(*(FCrossThreadBlocks*)Context);
+			return 0;
+		}, &Blocks);
+		Consumer.WaitForEnd();
+		bIsIntact = bIsIntact && Blocks.bIsIntact;
+
+		FAllocatorStats Stats;
+		GetAllocatorStats(Stats);
+		FirstRoundBytes = Round == 0 ? Stats.CommittedBytes : FirstRoundBytes;
+		CHECK(Stats.CommittedBytes == FirstRoundBytes);
+	}
+	CHECK(bIsIntact);
+	CHECK(FirstRoundBytes > 0);
+}
+
+struct FChurnThread
+{
+	void* (*Allocate)(size_t Size);
+	void (*Free)(void* Pointer);
+	uint32_t Seed;
+	uint32_t NumOperations;
+	EA::Thread::Thread Thread;
+};
+
+// Vectors that grow by copying into a new block and are cleared now and then, up to 8 KB so that all of them stay
+// below kMaxSmallObjectSize.
+static void ChurnVectors(const FChurnThread& Churn)
+{
+	static const uint32_t kNumVectors = 256;
+	void* Data[kNumVectors] = {};
+	uint32_t Sizes[kNumVectors] = {};
+	uint32_t Random = Churn.Seed;
+	for (uint32_t Operation = 0; Operation < Churn.NumOperations; ++Operation)
+	{
+		Random ^= Random << 13;
+		Random ^= Random >> 17;
+		Random ^= Random << 5;
+		const uint32_t Vector = Random % kNumVectors;
+		if ((Random >> 8) % 8 == 0 || Sizes[Vector] >= 8 * 1024)
+		{
+			Churn.Free(Data[Vector]);
+			Data[Vector] = nullptr;
+			Sizes[Vector] = 0;
+			continue;
+		}
+		const uint32_t NewSize = eastl::max(Sizes[Vector] * 2, 16u + (Random >> 16) % 112);
+		void* NewData = Churn.Allocate(NewSize);
+		memcpy(NewData, Data[Vector], Sizes[Vector]);
+		memset((uint8_t*)NewData + Sizes[Vector], (int)Operation, NewSize - Sizes[Vector]);
+		Churn.Free(Data[Vector]);
+		Data[Vector] = NewData;
+		Sizes[Vector] = NewSize;
+	}
+	for (uint32_t Vector = 0; Vector < kNumVectors; ++Vector)
+	{
+		Churn.Free(Data[Vector]);
+	}
+}
+
+// Nanoseconds per operation with every thread churning its own vectors, the calling thread included.
+static double MeasureVectorChurn(void* (*Allocate)(size_t), void (*Free)(void*), uint32_t NumThreads, uint32_t NumOperations)
+{
+	static const uint32_t kMaxChurnThreads = 8;
+	FChurnThread Threads[kMaxChurnThreads];
+	NumThreads = eastl::min(NumThreads, kMaxChurnThreads);
+	for (uint32_t Idx = 0; Idx < NumThreads; ++Idx)
+	{
+		Threads[Idx].Allocate = Allocate;
+		Threads[Idx].Free = Free;
+		Threads[Idx].Seed = 0x9e3779b9u * (Idx + 1);
+		Threads[Idx].NumOperations = NumOperations;
+	}
+
+	const uint64_t BeginCycle = EA::StdC::Stopwatch::GetCPUCycle();
+	for (uint32_t Idx = 1; Idx < NumThreads; ++Idx)
+	{
+		Threads[Idx].Thread.Begin([](void* Context) -> intptr_t
+		{
+			ChurnVectors(*(const FChurnThread*)Context);
+			return 0;
+		}, &Threads[Idx]);
+	}
+	ChurnVectors(Threads[0]);
+	for (uint32_t Idx = 1; Idx < NumThreads; ++Idx)
+	{
+		Threads[Idx].Thread.WaitForEnd();
+	}
+	return (EA::StdC::Stopwatch::GetCPUCycle() - BeginCycle) * 1e9 / EA::StdC::Stopwatch::GetCPUFrequency() / ((double)NumOperations * NumThreads);
+}
+
+static void* AllocateCRT(size_t Size)
+{
+	return malloc(Size);
+}
+
+static void FreeCRT(void* Pointer)
+{
+	free(Pointer);
+}
+
+// Against the CRT heap (glibc malloc here), with more threads than cores the numbers include the scheduling.
+BENCHMARK(AllocatorChurnBenchmark)
+{
+	const uint32_t kNumOperations = 1 << 20;
+	printf("Vector churn on %d cores:\n", EA::Thread::GetProcessorCount());
+	for (uint32_t NumThreads : { 1u, 2u, 4u, 8u })
+	{
+		// Best of a few runs, the first one also commits the spans.
+		double AllocatorNs = 1e9;
+		double CRTNs = 1e9;
+		for (uint32_t Run = 0; Run < 3; ++Run)
+		{
+			AllocatorNs = eastl::min(AllocatorNs, MeasureVectorChurn(AllocateMemory, FreeMemory, NumThreads, kNumOperations));
+			CRTNs = eastl::min(CRTNs, MeasureVectorChurn(AllocateCRT, FreeCRT, NumThreads, kNumOperations));
+		}
+		printf("%u threads: %.1f ns per operation, malloc %.1f ns\n", NumThreads, AllocatorNs, CRTNs);
+	}
+}
+
+// Tracking is chosen once per process on the first IsAllocationTrackingEnabled call, which nothing before the
+// tracking tests makes.
+static bool EnableAllocationTracking()
+{
+	setenv("DXRTEST_TRACK_ALLOCATIONS", "1", 1);
+	return IsAllocationTrackingEnabled();
+}
+
+struct FTaggedBlocks
+{
+	void* Blocks[1024];
+	const char* Tag;
+};
+
+// Tagged blocks allocated on one thread and freed on another come back to zero live bytes for their tag, with the peak
+// and the allocation count kept.
+TEST(AllocationTrackingCounts)
+{
+	CHECK(EnableAllocationTracking());
+	if (!IsAllocationTrackingEnabled())
+	{
+		return;
+	}
+
+	FTaggedBlocks Blocks = {};
+	Blocks.Tag = "AllocationTrackingCounts";
+	EA::Thread::Thread Producer;
+	Producer.Begin([](void* Context) -> intptr_t
+	{
+		FTaggedBlocks& Blocks = *(FTaggedBlocks*)Context;
+		for (uint32_t Idx = 0; Idx < eastl::size(Blocks.Blocks); ++Idx)
+		{
+			Blocks.Blocks[Idx] = AllocateTaggedMemory(100, 16, 0, Blocks.Tag);
+		}
+		return 0;
+	}, &Blocks);
+	Producer.WaitForEnd();
+
+	bool bIsAligned = true;
+	for (void* Block : Blocks.Blocks)
+	{
+		bIsAligned = bIsAligned && (uintptr_t)Block % 16 == 0;
+	}
+	CHECK(bIsAligned);
+
+	static FAllocationTagStats Tags[kMaxAllocationTags];
+	auto FindTag = [&Blocks]() -> const FAllocationTagStats*
+	{
+		const uint32_t NumTags = GetAllocationTagStats(Tags, kMaxAllocationTags);
+		for (uint32_t Idx = 0; Idx < NumTags; ++Idx)
+		{
+			if (Tags[Idx].Name == Blocks.Tag)
+			{
+				return &Tags[Idx];
+			}
+		}
+		return nullptr;
+	};
+	const FAllocationTagStats* Tag = FindTag();
+	CHECK(Tag && Tag->Bytes == 100 * eastl::size(Blocks.Blocks) && Tag->NumLive == eastl::size(Blocks.Blocks));
+
+	for (void* Block : Blocks.Blocks)
+	{
+		FreeTaggedMemory(Block);
+	}
+	Tag = FindTag();
+	CHECK(Tag && Tag->Bytes == 0 && Tag->NumLive == 0);
+	CHECK(Tag && Tag->PeakBytes == 100 * eastl::size(Blocks.Blocks) && Tag->NumAllocations == eastl::size(Blocks.Blocks));
+}
+
+// Tags picked by size so that the lookups cycle through several names, as the EASTL containers of the application do.
+static void* AllocateTagged(size_t Size)
+{
+	static const char* const kTags[] = { "Churn0", "Churn1", "Churn2", "Churn3", "Churn4", "Churn5", "Churn6", "Churn7" };
+	return AllocateTaggedMemory(Size, 16, 0, kTags[(Size >> 4) % eastl::size(kTags)]);
+}
+
+struct FTrackingOverheadThread
+{
+	float TaggedNs;
+	float UntaggedNs;
+	EA::Thread::Thread Thread;
+};
+
+// MeasureAllocationTrackingOverhead on several threads at once, averaged over the threads.
+static void MeasureTrackingOverhead(uint32_t NumThreads, float& OutTaggedNs, float& OutUntaggedNs)
+{
+	static const uint32_t kMaxOverheadThreads = 8;
+	FTrackingOverheadThread Threads[kMaxOverheadThreads];
+	NumThreads = eastl::min(NumThreads, kMaxOverheadThreads);
+	auto Measure = [](void* Context) -> intptr_t
+	{
+		FTrackingOverheadThread& Thread = *(FTrackingOverheadThread*)Context;
+		MeasureAllocationTrackingOverhead(Thread.TaggedNs, Thread.UntaggedNs);
+		return 0;
+	};
+	for (uint32_t Idx = 1; Idx < NumThreads; ++Idx)
+	{
+		Threads[Idx].Thread.Begin(Measure, &Threads[Idx]);
+	}
+	Measure(&Threads[0]);
+	OutTaggedNs = Threads[0].TaggedNs;
+	OutUntaggedNs = Threads[0].UntaggedNs;
+	for (uint32_t Idx = 1; Idx < NumThreads; ++Idx)
+	{
+		Threads[Idx].Thread.WaitForEnd();
+		OutTaggedNs += Threads[Idx].TaggedNs;
+		OutUntaggedNs += Threads[Idx].UntaggedNs;
+	}
+	OutTaggedNs /= NumThreads;
+	OutUntaggedNs /= NumThreads;
+}
+
+// Cost of leaving tracking on in the soak tests, where it has to stay below kMaxAllocationTrackingOverhead. The pairs
+// isolate the tracking itself, the churn does nothing but allocate and copy, so it is the worst case for the target.
+static const double kMaxAllocationTrackingOverhead = 0.05;
+
+BENCHMARK(AllocationTrackingBenchmark)
+{
+	if (!EnableAllocationTracking())
+	{
+		printf("Allocation tracking was decided before the benchmark, run it alone\n");
+		GNumFailedChecks++;
+		return;
+	}
+
+	const uint32_t kNumOperations = 1 << 20;
+	for (uint32_t NumThreads : { 1u, 8u })
+	{
+		// Best of several runs, tracked and untracked alternate so that both see the same noise.
+		float TaggedNs = 1e9f;
+		float UntaggedNs = 1e9f;
+		double TrackedNs = 1e9;
+		double UntrackedNs = 1e9;
+		for (uint32_t Run = 0; Run < 9; ++Run)
+		{
+			float RunTaggedNs, RunUntaggedNs;
+			MeasureTrackingOverhead(NumThreads, RunTaggedNs, RunUntaggedNs);
+			TaggedNs = eastl::min(TaggedNs, RunTaggedNs);
+			UntaggedNs = eastl::min(UntaggedNs, RunUntaggedNs);
+			TrackedNs = eastl::min(TrackedNs, MeasureVectorChurn(AllocateTagged, FreeTaggedMemory, NumThreads, kNumOperations));
+			UntrackedNs = eastl::min(UntrackedNs, MeasureVectorChurn(AllocateMemory, FreeMemory, NumThreads, kNumOperations));
+		}
+		const double Overhead = TrackedNs / UntrackedNs - 1.0;
+		// A thread stays within the target while the tracking cost of its allocations is below 5% of its time.
+		const double MaxPairsPerSecond = kMaxAllocationTrackingOverhead * 1e9 / eastl::max(TaggedNs - UntaggedNs, 0.1f);
+		printf("Allocation tracking on %u threads: %.1f ns per allocate and free pair, untracked %.1f ns, %.0f%% target up to %.1fM pairs per second and thread\n", NumThreads, TaggedNs, UntaggedNs, 100.0 * kMaxAllocationTrackingOverhead, MaxPairsPerSecond / 1e6);
+		printf("Vector churn on %u threads: %.1f ns per operation tracked, %.1f ns untracked, %+.1f%% (%s the %.0f%% target)\n", NumThreads, TrackedNs, UntrackedNs, 100.0 * Overhead, Overhead <= kMaxAllocationTrackingOverhead ? "within" : "over", 100.0 * kMaxAllocationTrackingOverhead);
+	}
+}
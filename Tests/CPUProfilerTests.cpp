@@ -0,0 +1,94 @@
+#include "Test.h"
+#include "CPUProfiler.h"
+#include <string.h>
+
+static const float kMaxCPUZoneOverheadNs = 50.0f;
+
+// Lowest of a few measurements, the others may include preemption or a cold cache.
+static float GetCPUZoneOverhead()
+{
+	float MinNs = MeasureCPUZoneOverhead();
+	for (uint32_t Run = 1; Run < 16; ++Run)
+	{
+		MinNs = eastl::min(MinNs, MeasureCPUZoneOverhead());
+	}
+	return MinNs;
+}
+
+TEST(CPUZoneOverhead)
+{
+	const float OverheadNs = GetCPUZoneOverhead();
+	if (OverheadNs > kMaxCPUZoneOverheadNs)
+	{
+		printf("CPU zone overhead %.1f ns, limit %.1f ns\n", OverheadNs, kMaxCPUZoneOverheadNs);
+	}
+	CHECK(OverheadNs > 0.0f && OverheadNs <= kMaxCPUZoneOverheadNs);
+	DestroyCPUProfiler();
+}
+
+// Zones come back in end order, with the newest kCPUZoneBufferSize / 2 kept once the ring wraps, also when the event
+// count itself wraps around.
+TEST(CPUZoneEvents)
+{
+	FCPUProfilerThread* Thread = GetCPUProfilerThread();
+	CHECK(Thread != nullptr);
+	if (!Thread)
+	{
+		return;
+	}
+
+	{
+		CPU_ZONE("Outer");
+		{
+			CPU_ZONE("Inner");
+		}
+	}
+	eastl::vector<FCPUZoneEvent> Events;
+	GetCPUZoneEvents(*Thread, Events);
+	CHECK(Events.size() == 2);
+	if (Events.size() == 2)
+	{
+		CHECK(strcmp(Events[0].Name, "Inner") == 0 && strcmp(Events[1].Name, "Outer") == 0);
+		CHECK(Events[1].BeginCycle <= Events[0].BeginCycle && Events[0].EndCycle <= Events[1].EndCycle);
+	}
+
+	static const char* const kNames[] = { "A", "B", "C" };
+	for (uint32_t FirstEvent : { 0u, 0x7ffffff0u, 0xfffffff0u })
+	{
+		Thread->NumEvents = FirstEvent;
+		const uint32_t NumZones = kCPUZoneBufferSize + 100;
+		for (uint32_t Idx = 0; Idx < NumZones; ++Idx)
+		{
+			AddCPUZoneEvent(kNames[Idx % 3], Idx, Idx + 1);
+		}
+		CHECK(Thread->NumEvents == FirstEvent + NumZones);
+
+		GetCPUZoneEvents(*Thread, Events);
+		CHECK(Events.size() == kCPUZoneBufferSize / 2);
+		bool bIsInOrder = true;
+		for (uint32_t Idx = 0; Idx < Events.size(); ++Idx)
+		{
+			const uint32_t Zone = NumZones - (uint32_t)Events.size() + Idx;
+			bIsInOrder = bIsInOrder && Events[Idx].Name == kNames[Zone % 3] && Events[Idx].BeginCycle == Zone;
+		}
+		CHECK(bIsInOrder);
+	}
+	DestroyCPUProfiler();
+}
+
+// Zone overhead next to the cost of its two TSC reads alone, which dominates it and is much higher in some VMs.
+BENCHMARK(CPUZoneBenchmark)
+{
+	const uint32_t kNumReads = 1 << 20;
+	const uint64_t BeginCycle = EA::StdC::Stopwatch::GetCPUCycle();
+	for (uint32_t Idx = 0; Idx < kNumReads; ++Idx)
+	{
+		EA::StdC::Stopwatch::GetCPUCycle();
+	}
+	const double ReadNs = (EA::StdC::Stopwatch::GetCPUCycle() - BeginCycle) * 1e9 / EA::StdC::Stopwatch::GetCPUFrequency() / kNumReads;
+
+	const float OverheadNs = GetCPUZoneOverhead();
+	printf("CPU zone: %.1f ns per zone (limit %.1f ns), two TSC reads %.1f ns\n", OverheadNs, kMaxCPUZoneOverheadNs, 2.0 * ReadNs);
+	CHECK(OverheadNs <= kMaxCPUZoneOverheadNs);
+	DestroyCPUProfiler();
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+// Stand-in for the MSVC headers DirectXMath and EAThread expect when the tests build with GCC or Clang.
+#define _In_
+#define _In_opt_
+#define _In_reads_(x)
+#define _In_reads_bytes_(x)
+#define _Out_
+#define _Out_opt_
+#define _Out_writes_(x)
+#define _Out_writes_bytes_(x)
+#define _Outptr_
+#define _Inout_
+#define _Inout_updates_bytes_(x)
+#define _Use_decl_annotations_
+#define _Analysis_assume_(x)
+#define _Success_(x)
+#define _Check_return_
+
+#define __fastcall
+#define __declspec(x) __declspec_##x
+#define __declspec_align(x) __attribute__((aligned(x)))
+#define __declspec_deprecated(x) __attribute__((deprecated(x)))
+#define __declspec_dllexport
+#define __declspec_dllimport
+#define __declspec_naked __attribute__((naked))
+#define __declspec_noinline __attribute__((noinline))
+#define __declspec_noreturn __attribute__((noreturn))
+#define __declspec_novtable
+#define __declspec_selectany __attribute__((weak))
+#define __declspec_thread __thread
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#undef __cpuid
+inline void __cpuid(int Info[4], int Leaf)
+{
+	__cpuid_count(Leaf, 0, Info[0], Info[1], Info[2], Info[3]);
+}
+#endif
@@ -0,0 +1,305 @@
+#include "Test.h"
+#include <stdlib.h>
+#include <string.h>
+#include "TestScene.h"
+#include "EASTL/algorithm.h"
+#include "EAStdC/EAStopwatch.h"
+
+static const uint32_t kDenoiseTestWidth = 192;
+static const uint32_t kDenoiseTestHeight = 108;
+
+TEST(DenoiseEdgeWeightStopsAtEdges)
+{
+	// Identical neighbours get the full weight, luminance and plane distance lower it relative to the center's sigma and
+	// view distance, normals facing away cut it off.
+	CHECK_NEAR(GetDenoiseEdgeWeight(0.0f, 0.1f, 1.0f, 0.0f, 5.0f, DENOISE_DEFAULT_LUMINANCE_PHI, DENOISE_DEFAULT_NORMAL_PHI, DENOISE_DEFAULT_DEPTH_PHI), 1.0f, 1.0e-6f);
+	CHECK(GetDenoiseEdgeWeight(0.0f, 0.1f, -0.5f, 0.0f, 5.0f, DENOISE_DEFAULT_LUMINANCE_PHI, DENOISE_DEFAULT_NORMAL_PHI, DENOISE_DEFAULT_DEPTH_PHI) == 0.0f);
+	const float SmallDelta = GetDenoiseEdgeWeight(0.05f, 0.1f, 1.0f, 0.0f, 5.0f, DENOISE_DEFAULT_LUMINANCE_PHI, DENOISE_DEFAULT_NORMAL_PHI, DENOISE_DEFAULT_DEPTH_PHI);
+	const float LargeDelta = GetDenoiseEdgeWeight(0.5f, 0.1f, 1.0f, 0.0f, 5.0f, DENOISE_DEFAULT_LUMINANCE_PHI, DENOISE_DEFAULT_NORMAL_PHI, DENOISE_DEFAULT_DEPTH_PHI);
+	CHECK(LargeDelta < SmallDelta && SmallDelta < 1.0f);
+	CHECK(GetDenoiseEdgeWeight(0.05f, 0.2f, 1.0f, 0.0f, 5.0f, DENOISE_DEFAULT_LUMINANCE_PHI, DENOISE_DEFAULT_NORMAL_PHI, DENOISE_DEFAULT_DEPTH_PHI) > SmallDelta);
+	CHECK(GetDenoiseEdgeWeight(0.0f, 0.1f, 1.0f, 0.05f, 5.0f, DENOISE_DEFAULT_LUMINANCE_PHI, DENOISE_DEFAULT_NORMAL_PHI, DENOISE_DEFAULT_DEPTH_PHI) < GetDenoiseEdgeWeight(0.0f, 0.1f, 1.0f, 0.05f, 50.0f, DENOISE_DEFAULT_LUMINANCE_PHI, DENOISE_DEFAULT_NORMAL_PHI, DENOISE_DEFAULT_DEPTH_PHI));
+	CHECK(GetDenoiseEdgeWeight(0.0f, 0.1f, 0.9f, 0.0f, 5.0f, DENOISE_DEFAULT_LUMINANCE_PHI, DENOISE_DEFAULT_NORMAL_PHI, DENOISE_DEFAULT_DEPTH_PHI) < 1.0e-4f);
+}
+
+// Noiseless trace of the test scene from the first orbit position.
+static void TraceDenoiseTestScene(uint32_t Width, uint32_t Height, FGBufferDump& OutScene)
+{
+	FTestView View;
+	GetTestView(0.0f, View);
+	OutScene.WorldToProjection = View.WorldToProjection;
+	OutScene.CameraPosition = View.CameraPosition;
+	InitImage(Width, Height, OutScene.Color);
+	InitImage(Width, Height, OutScene.HitPosition);
+	TraceTestScene(View, float2(0.0f, 0.0f), 1, 0, OutScene.Color, OutScene.HitPosition);
+}
+
+// Uniform in [0, 1), a different pattern every frame.
+static float GetDenoiseTestNoise(uint32_t X, uint32_t Y, uint32_t Frame)
+{
+	uint32_t Hash = X * 0x8da6b343u ^ Y * 0xd8163841u ^ Frame * 0xcb1ab31fu;
+	Hash ^= Hash >> 16;
+	Hash *= 0x7feb352du;
+	Hash ^= Hash >> 15;
+	Hash *= 0x846ca68bu;
+	Hash ^= Hash >> 16;
+	return (Hash >> 8) * (1.0f / 16777216.0f);
+}
+
+// Colors of hits scaled by 0.5 to 1.5, the noise of a low sample count that keeps the mean.
+static void AddDenoiseTestNoise(const FImage& Color, uint32_t Frame, FImage& OutColor)
+{
+	OutColor = Color;
+	for (uint32_t Y = 0; Y < Color.Height; ++Y)
+	{
+		for (uint32_t X = 0; X < Color.Width; ++X)
+		{
+			XMFLOAT4& Texel = OutColor.Texels[(size_t)Y * Color.Width + X];
+			XMStoreFloat4(&Texel, XMVectorSetW(XMVectorScale(XMLoadFloat4(&Texel), 0.5f + GetDenoiseTestNoise(X, Y, Frame)), Texel.w));
+		}
+	}
+}
+
+struct FDenoiseRun
+{
+	FImage Output; // Last frame, alpha is 1 like RTOutput.
+	double TemporalMs; // Last frame.
+	double FilterMs[DENOISE_MAX_ITERATIONS];
+};
+
+// Frames of the denoiser in the application's order (DenoiseRTOutput) with a static camera and new noise every frame.
+// Without noise the frames show the scene as it is.
+static void RunDenoiser(const FGBufferDump& Scene, uint32_t NumIterations, uint32_t NumFrames, bool bAddsNoise, FDenoiseRun& OutRun)
+{
+	const uint32_t Width = Scene.Color.Width;
+	const uint32_t Height = Scene.Color.Height;
+	FImage Color, Normal, HistoryColors[2], HistoryMoments[2], Filtered[2];
+	InitImage(Width, Height, Normal);
+	InitImage(Width, Height, Filtered[0]);
+	InitImage(Width, Height, Filtered[1]);
+	InitImage(Width, Height, OutRun.Output);
+	for (uint32_t Idx = 0; Idx < 2; ++Idx)
+	{
+		InitImage(Width, Height, HistoryColors[Idx]);
+		InitImage(Width, Height, HistoryMoments[Idx]);
+	}
+
+	FPerFrameConstantData Constants = {};
+	Constants.PrevWorldToProjection = Scene.WorldToProjection;
+	Constants.CameraPosition = Scene.CameraPosition;
+	Constants.TraceWidth = Constants.PrevTraceWidth = Width;
+	Constants.TraceHeight = Constants.PrevTraceHeight = Height;
+	Constants.DisocclusionTolerance = 0.02f;
+	for (uint32_t Frame = 0; Frame < NumFrames; ++Frame)
+	{
+		const uint32_t Current = Frame & 1;
+		const uint32_t Prev = Current ^ 1;
+		if (bAddsNoise)
+		{
+			AddDenoiseTestNoise(Scene.Color, Frame, Color);
+		}
+		else
+		{
+			Color = Scene.Color;
+		}
+		Constants.HasDenoiseHistory = Frame > 0 ? 1 : 0;
+
+		uint64_t BeginCycle = EA::StdC::Stopwatch::GetCPUCycle();
+		DenoiseTemporalImage(Constants, HistoryColors[Prev], HistoryMoments[Prev], Scene.HitPosition, Color, Scene.HitPosition, Normal, HistoryMoments[Current], Filtered[0]);
+		OutRun.TemporalMs = (EA::StdC::Stopwatch::GetCPUCycle() - BeginCycle) * 1000.0 / EA::StdC::Stopwatch::GetCPUFrequency();
+
+		for (uint32_t Iteration = 0; Iteration < NumIterations; ++Iteration)
+		{
+			const bool bIsLastIteration = Iteration + 1 == NumIterations;
+			const FDenoiseConstants DenoiseConstants = { 1u << Iteration, Iteration == 0 ? 1u : 0u, bIsLastIteration ? 1u : 0u, DENOISE_DEFAULT_LUMINANCE_PHI, DENOISE_DEFAULT_NORMAL_PHI, DENOISE_DEFAULT_DEPTH_PHI };
+			BeginCycle = EA::StdC::Stopwatch::GetCPUCycle();
+			DenoiseFilterImage(Constants, DenoiseConstants, Filtered[Iteration & 1], Scene.HitPosition, Normal, bIsLastIteration ? OutRun.Output : Filtered[(Iteration + 1) & 1], &HistoryColors[Current]);
+			OutRun.FilterMs[Iteration] = (EA::StdC::Stopwatch::GetCPUCycle() - BeginCycle) * 1000.0 / EA::StdC::Stopwatch::GetCPUFrequency();
+		}
+	}
+}
+
+TEST(DenoiseKeepsFlatColor)
+{
+	// Filter weights are normalized, a constant color comes out unchanged however the edge weights fall.
+	FGBufferDump Scene;
+	TraceDenoiseTestScene(kDenoiseTestWidth, kDenoiseTestHeight, Scene);
+	for (XMFLOAT4& Texel : Scene.Color.Texels)
+	{
+		Texel = XMFLOAT4(0.25f, 0.5f, 0.75f, 1.0f);
+	}
+
+	FDenoiseRun Run;
+	RunDenoiser(Scene, DENOISE_MAX_ITERATIONS, 3, false, Run);
+	CHECK(GetImageMaxError(Run.Output, Scene.Color) < 1.0e-5f);
+}
+
+TEST(DenoiseNormalsFaceCamera)
+{
+	// Normals derived from the hit positions match the surfaces: up on the ground in front of the camera, away from the
+	// center on the sphere at the origin, which is in the center of the image.
+	FGBufferDump Scene;
+	TraceDenoiseTestScene(kDenoiseTestWidth, kDenoiseTestHeight, Scene);
+	FImage Normal, Moments, Output, History;
+	InitImage(kDenoiseTestWidth, kDenoiseTestHeight, Normal);
+	InitImage(kDenoiseTestWidth, kDenoiseTestHeight, Moments);
+	InitImage(kDenoiseTestWidth, kDenoiseTestHeight, Output);
+	InitImage(kDenoiseTestWidth, kDenoiseTestHeight, History);
+
+	FPerFrameConstantData Constants = {};
+	Constants.CameraPosition = Scene.CameraPosition;
+	Constants.TraceWidth = kDenoiseTestWidth;
+	Constants.TraceHeight = kDenoiseTestHeight;
+	DenoiseTemporalImage(Constants, History, History, History, Scene.Color, Scene.HitPosition, Normal, Moments, Output);
+
+	const XMFLOAT4& GroundNormal = Normal.Texels[(kDenoiseTestHeight - 4) * kDenoiseTestWidth + kDenoiseTestWidth / 2];
+	CHECK_NEAR(GroundNormal.y, 1.0f, 1.0e-3f);
+	const size_t SpherePixel = (kDenoiseTestHeight / 2) * kDenoiseTestWidth + kDenoiseTestWidth / 2;
+	const XMVECTOR SphereNormal = XMVector3Normalize(XMVectorSubtract(XMLoadFloat4(&Scene.HitPosition.Texels[SpherePixel]), XMVectorSet(0.0f, 0.5f, 0.0f, 1.0f)));
+	CHECK(XMVectorGetX(XMVector3Dot(XMLoadFloat4(&Normal.Texels[SpherePixel]), SphereNormal)) > 0.99f);
+
+	// The first frame has no history, its variance is the 3x3 spatial one.
+	CHECK(Moments.Texels[SpherePixel].z == 1.0f);
+}
+
+TEST(DenoiseAccumulatesHistory)
+{
+	// With a static camera every hit finds its own history: the frame count goes up and color and moments move towards
+	// the new frame by the running average. Misses start over.
+	FGBufferDump Scene;
+	TraceDenoiseTestScene(kDenoiseTestWidth, kDenoiseTestHeight, Scene);
+	FImage HistoryColor, HistoryMoments, Normal, Moments, Output;
+	InitImage(kDenoiseTestWidth, kDenoiseTestHeight, HistoryColor);
+	InitImage(kDenoiseTestWidth, kDenoiseTestHeight, HistoryMoments);
+	InitImage(kDenoiseTestWidth, kDenoiseTestHeight, Normal);
+	InitImage(kDenoiseTestWidth, kDenoiseTestHeight, Moments);
+	InitImage(kDenoiseTestWidth, kDenoiseTestHeight, Output);
+	for (size_t Idx = 0; Idx < HistoryColor.Texels.size(); ++Idx)
+	{
+		HistoryColor.Texels[Idx] = XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f);
+		HistoryMoments.Texels[Idx] = XMFLOAT4(0.5f, 0.5f, 3.0f, 0.0f);
+	}
+
+	FPerFrameConstantData Constants = {};
+	Constants.PrevWorldToProjection = Scene.WorldToProjection;
+	Constants.CameraPosition = Scene.CameraPosition;
+	Constants.TraceWidth = Constants.PrevTraceWidth = kDenoiseTestWidth;
+	Constants.TraceHeight = Constants.PrevTraceHeight = kDenoiseTestHeight;
+	Constants.DisocclusionTolerance = 0.02f;
+	Constants.HasDenoiseHistory = 1;
+	DenoiseTemporalImage(Constants, HistoryColor, HistoryMoments, Scene.HitPosition, Scene.Color, Scene.HitPosition, Normal, Moments, Output);
+
+	bool bAccumulatesHits = true;
+	bool bRestartsMisses = true;
+	for (size_t Idx = 0; Idx < Scene.Color.Texels.size(); ++Idx)
+	{
+		const XMFLOAT4& Color = Scene.Color.Texels[Idx];
+		const float Luma = Color.x * 0.299f + Color.y * 0.587f + Color.z * 0.114f;
+		if (Scene.HitPosition.Texels[Idx].w > 0.0f)
+		{
+			bAccumulatesHits &= Moments.Texels[Idx].z == 4.0f;
+			bAccumulatesHits &= fabsf(Output.Texels[Idx].y - (0.75f + Color.y * 0.25f)) < 1.0e-5f;
+			bAccumulatesHits &= fabsf(Moments.Texels[Idx].x - (0.5f * 0.75f + Luma * 0.25f)) < 1.0e-5f;
+			bAccumulatesHits &= fabsf(Output.Texels[Idx].w - eastl::max(Moments.Texels[Idx].y - Moments.Texels[Idx].x * Moments.Texels[Idx].x, 0.0f)) < 1.0e-5f;
+		}
+		else
+		{
+			bRestartsMisses &= Moments.Texels[Idx].z == 1.0f && Output.Texels[Idx].y == Color.y;
+		}
+	}
+	CHECK(bAccumulatesHits);
+	CHECK(bRestartsMisses);
+}
+
+TEST(DenoiseReducesNoise)
+{
+	// Every iteration count gets much closer to the noiseless trace than the noisy input. Larger than the other tests, at
+	// 192x108 the checkerboard is too fine to survive blurring.
+	FGBufferDump Scene;
+	TraceDenoiseTestScene(480, 270, Scene);
+	FImage Noisy;
+	AddDenoiseTestNoise(Scene.Color, 0, Noisy);
+	const float NoisyPSNR = GetImagePSNR(Noisy, Scene.Color);
+	for (uint32_t NumIterations = 1; NumIterations <= DENOISE_MAX_ITERATIONS; ++NumIterations)
+	{
+		FDenoiseRun Run;
+		RunDenoiser(Scene, NumIterations, 4, true, Run);
+		CHECK(GetImagePSNR(Run.Output, Scene.Color) > NoisyPSNR + 6.0f);
+	}
+}
+
+TEST(DenoiseThreadsMatchOneThread)
+{
+	FGBufferDump Scene;
+	TraceDenoiseTestScene(kDenoiseTestWidth, kDenoiseTestHeight, Scene);
+	FDenoiseRun Run, OneThreadRun;
+	SetNumReferenceThreads(4);
+	RunDenoiser(Scene, 3, 2, true, Run);
+	SetNumReferenceThreads(1);
+	RunDenoiser(Scene, 3, 2, true, OneThreadRun);
+	SetNumReferenceThreads(0);
+	CHECK(memcmp(Run.Output.Texels.data(), OneThreadRun.Output.Texels.data(), Run.Output.Texels.size() * sizeof(XMFLOAT4)) == 0);
+}
+
+TEST(GBufferDumpRoundTrip)
+{
+	FGBufferDump Scene, ReadScene;
+	TraceDenoiseTestScene(kDenoiseTestWidth, kDenoiseTestHeight, Scene);
+	CHECK(WriteGBufferDump("GBufferDumpTest.bin", Scene));
+	CHECK(ReadGBufferDump("GBufferDumpTest.bin", ReadScene));
+	remove("GBufferDumpTest.bin");
+	CHECK(ReadScene.Color.Width == kDenoiseTestWidth && ReadScene.Color.Height == kDenoiseTestHeight);
+	CHECK(memcmp(&ReadScene.WorldToProjection, &Scene.WorldToProjection, sizeof(Scene.WorldToProjection)) == 0);
+	CHECK(memcmp(&ReadScene.CameraPosition, &Scene.CameraPosition, sizeof(Scene.CameraPosition)) == 0);
+	CHECK(memcmp(ReadScene.Color.Texels.data(), Scene.Color.Texels.data(), Scene.Color.Texels.size() * sizeof(XMFLOAT4)) == 0);
+	CHECK(memcmp(ReadScene.HitPosition.Texels.data(), Scene.HitPosition.Texels.data(), Scene.HitPosition.Texels.size() * sizeof(XMFLOAT4)) == 0);
+	CHECK(!ReadGBufferDump("GBufferDumpMissing.bin", ReadScene));
+}
+
+// Quality against the noiseless input per iteration count on the first frame and after 8, and cost with all processors
+// and with one.
+// The input is the test scene at 1920x1080 or, with DXRTEST_GBUFFER_DUMP=<file>, a frame of the application written
+// with --dump-gbuffer=<file>.
+BENCHMARK(DenoiseBenchmark)
+{
+	FGBufferDump Scene;
+	const char* DumpFileName = getenv("DXRTEST_GBUFFER_DUMP");
+	if (DumpFileName && DumpFileName[0])
+	{
+		if (!ReadGBufferDump(DumpFileName, Scene))
+		{
+			printf("Denoise: cannot read %s\n", DumpFileName);
+			GNumFailedChecks++;
+			return;
+		}
+		printf("Denoise: %s, %ux%u\n", DumpFileName, Scene.Color.Width, Scene.Color.Height);
+	}
+	else
+	{
+		TraceDenoiseTestScene(1920, 1080, Scene);
+	}
+
+	const uint32_t NumPixels = Scene.Color.Width * Scene.Color.Height;
+	FImage Noisy;
+	AddDenoiseTestNoise(Scene.Color, 7, Noisy);
+	printf("Denoise input: %.2f dB\n", GetImagePSNR(Noisy, Scene.Color));
+	for (uint32_t NumIterations = 1; NumIterations <= DENOISE_MAX_ITERATIONS; ++NumIterations)
+	{
+		FDenoiseRun FirstFrameRun, Run, OneThreadRun;
+		RunDenoiser(Scene, NumIterations, 1, true, FirstFrameRun);
+		RunDenoiser(Scene, NumIterations, 8, true, Run);
+		SetNumReferenceThreads(1);
+		RunDenoiser(Scene, NumIterations, 8, true, OneThreadRun);
+		SetNumReferenceThreads(0);
+
+		double FilterMs = 0.0;
+		double OneThreadMs = OneThreadRun.TemporalMs;
+		for (uint32_t Iteration = 0; Iteration < NumIterations; ++Iteration)
+		{
+			FilterMs += Run.FilterMs[Iteration];
+			OneThreadMs += OneThreadRun.FilterMs[Iteration];
+		}
+		const double Ms = Run.TemporalMs + FilterMs;
+		printf("Denoise %u iterations: %.2f dB (%.2f dB first frame), %.2f ms (temporal %.2f ms, %.2f ms per iteration, %.1f Mpixel/s), %.2f ms on one thread\n", NumIterations, GetImagePSNR(Run.Output, Scene.Color), GetImagePSNR(FirstFrameRun.Output, Scene.Color), Ms, Run.TemporalMs, FilterMs / NumIterations, NumPixels / (Ms * 1000.0), OneThreadMs);
+	}
+}
@@ -0,0 +1,93 @@
+#include "Test.h"
+#include "DynamicResolution.h"
+
+static const uint32_t kReplayFrames = 900;
+static const float kReplayTargetMs = 16.0f;
+static const float kReplayFixedMs = 2.0f; // Part of the frame that does not scale with the trace resolution.
+
+// "Frame" GPU times at native resolution with +-2% frame-to-frame noise: a view that needs a lower resolution, one
+// heavier than the minimum scale can compensate and one that fits at native resolution.
+static float GetNativeFrameMs(uint32_t Frame, uint32_t& Seed)
+{
+	Seed = Seed * 1664525u + 1013904223u;
+	const float Noise = 1.0f + 0.02f * ((float)(Seed >> 8) / (float)(1 << 24) * 2.0f - 1.0f);
+	const float BaseMs = Frame < 300 ? 20.0f : Frame < 600 ? 60.0f : 12.0f;
+	return BaseMs * Noise;
+}
+
+// Feeds the controller the way UpdateDynamicResolution does: the time of frame N reaches it in frame N + 2. Frame
+// time at Scale is the fixed part plus the rest of the native time times the traced pixel fraction (Scale^2).
+static void ReplayFrameTrace(float (&OutScales)[kReplayFrames], float (&OutMeasuredMs)[kReplayFrames])
+{
+	uint32_t Seed = 1;
+	float Scale = 1.0f;
+	for (uint32_t Frame = 0; Frame < kReplayFrames; ++Frame)
+	{
+		OutScales[Frame] = Scale;
+		OutMeasuredMs[Frame] = kReplayFixedMs + (GetNativeFrameMs(Frame, Seed) - kReplayFixedMs) * Scale * Scale;
+		Scale = GetDynamicResolutionScale(Scale, kReplayTargetMs, Frame >= 2 ? OutMeasuredMs[Frame - 2] : 0.0f);
+	}
+}
+
+TEST(DynamicResolutionConverges)
+{
+	static float Scales[kReplayFrames];
+	static float MeasuredMs[kReplayFrames];
+	ReplayFrameTrace(Scales, MeasuredMs);
+
+	// Settles within the deadband (plus noise) of the target well before the view changes.
+	for (uint32_t Frame = 150; Frame < 300; ++Frame)
+	{
+		CHECK_NEAR(MeasuredMs[Frame], kReplayTargetMs, kReplayTargetMs * (kDynamicResolutionDeadband + 0.03f));
+	}
+	const float IdealScale = sqrtf((kReplayTargetMs - kReplayFixedMs) / (20.0f - kReplayFixedMs));
+	CHECK_NEAR(Scales[299], IdealScale, 0.05);
+
+	// No step is larger than the limit.
+	for (uint32_t Frame = 1; Frame < kReplayFrames; ++Frame)
+	{
+		CHECK(fabsf(Scales[Frame] - Scales[Frame - 1]) <= kDynamicResolutionMaxStep + 1.0e-6f);
+	}
+}
+
+TEST(DynamicResolutionDeadbandIsStable)
+{
+	static float Scales[kReplayFrames];
+	static float MeasuredMs[kReplayFrames];
+	ReplayFrameTrace(Scales, MeasuredMs);
+
+	// Once converged, noise inside the deadband does not move the resolution.
+	uint32_t NumChanges = 0;
+	for (uint32_t Frame = 151; Frame < 300; ++Frame)
+	{
+		NumChanges += Scales[Frame] != Scales[Frame - 1] ? 1 : 0;
+	}
+	CHECK(NumChanges <= 2);
+
+	// Errors up to the deadband are left alone, larger ones are not.
+	const float Scale = 0.8f;
+	CHECK(GetDynamicResolutionScale(Scale, 16.0f, 16.0f * (1.0f + kDynamicResolutionDeadband * 0.99f)) == Scale);
+	CHECK(GetDynamicResolutionScale(Scale, 16.0f, 16.0f * (1.0f - kDynamicResolutionDeadband * 0.99f)) == Scale);
+	CHECK(GetDynamicResolutionScale(Scale, 16.0f, 16.0f * (1.0f + kDynamicResolutionDeadband * 1.5f)) < Scale);
+	CHECK(GetDynamicResolutionScale(Scale, 16.0f, 16.0f * (1.0f - kDynamicResolutionDeadband * 1.5f)) > Scale);
+
+	// No measurement yet.
+	CHECK(GetDynamicResolutionScale(Scale, 16.0f, 0.0f) == Scale);
+}
+
+TEST(DynamicResolutionClamps)
+{
+	static float Scales[kReplayFrames];
+	static float MeasuredMs[kReplayFrames];
+	ReplayFrameTrace(Scales, MeasuredMs);
+
+	for (uint32_t Frame = 0; Frame < kReplayFrames; ++Frame)
+	{
+		CHECK(Scales[Frame] >= kDynamicResolutionMinScale && Scales[Frame] <= 1.0f);
+	}
+
+	// The heavy view would need a scale below the minimum, the light one fits above native resolution.
+	CHECK(Scales[599] == kDynamicResolutionMinScale);
+	CHECK(MeasuredMs[599] > kReplayTargetMs);
+	CHECK(Scales[899] == 1.0f);
+}
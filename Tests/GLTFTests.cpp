@@ -0,0 +1,323 @@
+#include "Test.h"
+#include "GLTF.h"
+#include <stdlib.h>
+#include <string.h>
+#include "EASTL/string.h"
+#include "EAStdC/EASprintf.h"
+#include "EAStdC/EAStopwatch.h"
+
+// .glb with the given JSON chunk (padded with spaces) and BIN chunk (padded with zeros), BIN is left out when empty.
+static eastl::vector<uint8_t> MakeGLB(const eastl::string& JSON, const eastl::vector<uint8_t>& Bin)
+{
+	const uint32_t JSONLength = (uint32_t)(JSON.size() + 3) & ~3u;
+	const uint32_t BinLength = (uint32_t)(Bin.size() + 3) & ~3u;
+	const uint32_t Length = 20 + JSONLength + (Bin.empty() ? 0 : 8 + BinLength);
+
+	eastl::vector<uint8_t> GLB(Length, 0);
+	auto WriteU32 = [&GLB](uint32_t Offset, uint32_t Value) { memcpy(GLB.data() + Offset, &Value, sizeof(Value)); };
+	WriteU32(0, 0x46546C67);
+	WriteU32(4, 2);
+	WriteU32(8, Length);
+	WriteU32(12, JSONLength);
+	WriteU32(16, 0x4E4F534A);
+	memset(GLB.data() + 20, ' ', JSONLength);
+	memcpy(GLB.data() + 20, JSON.data(), JSON.size());
+	if (!Bin.empty())
+	{
+		WriteU32(20 + JSONLength, BinLength);
+		WriteU32(24 + JSONLength, 0x004E4942);
+		memcpy(GLB.data() + 28 + JSONLength, Bin.data(), Bin.size());
+	}
+	return GLB;
+}
+
+template<typename T>
+static void AppendBin(eastl::vector<uint8_t>& Bin, const T* Values, uint32_t Count)
+{
+	const size_t Offset = Bin.size();
+	Bin.resize(Offset + Count * sizeof(T));
+	memcpy(Bin.data() + Offset, Values, Count * sizeof(T));
+}
+
+// One triangle: 3 float3 positions (36 bytes) then 3 uint16 indices (6 bytes, 2 padding bytes).
+static eastl::vector<uint8_t> MakeTriangleBin(uint16_t LastIndex = 2)
+{
+	const float Positions[9] = { 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f };
+	const uint16_t Indices[4] = { 0, 1, LastIndex, 0 };
+	eastl::vector<uint8_t> Bin;
+	AppendBin(Bin, Positions, 9);
+	AppendBin(Bin, Indices, 4);
+	return Bin;
+}
+
+// Triangle mesh with the given accessors and nodes, %s are replaced in order: accessors, nodes, scenes.
+static eastl::string MakeTriangleJSON(const char* Accessors, const char* Nodes, const char* Scenes = "[{\"nodes\":[0]}]")
+{
+	eastl::string JSON;
+	JSON.sprintf("{\"asset\":{\"version\":\"2.0\"},\"scene\":0,\"scenes\":%s,\"nodes\":%s,"
+		"\"meshes\":[{\"primitives\":[{\"attributes\":{\"POSITION\":0},\"indices\":1}]}],"
+		"\"buffers\":[{\"byteLength\":44}],"
+		"\"bufferViews\":[{\"buffer\":0,\"byteOffset\":0,\"byteLength\":36},{\"buffer\":0,\"byteOffset\":36,\"byteLength\":6}],"
+		"\"accessors\":%s}", Scenes, Nodes, Accessors);
+	return JSON;
+}
+
+static const char* kTriangleAccessors =
+	"[{\"bufferView\":0,\"componentType\":5126,\"count\":3,\"type\":\"VEC3\"},"
+	"{\"bufferView\":1,\"componentType\":5123,\"count\":3,\"type\":\"SCALAR\"}]";
+
+static bool ParseGLBBuffer(const eastl::vector<uint8_t>& GLB, FGLBFile& OutFile)
+{
+	return ParseGLB(GLB.data(), GLB.size(), OutFile);
+}
+
+TEST(GLTFTriangle)
+{
+	const eastl::vector<uint8_t> GLB = MakeGLB(MakeTriangleJSON(kTriangleAccessors, "[{\"mesh\":0}]"), MakeTriangleBin());
+	FGLBFile File;
+	CHECK(ParseGLBBuffer(GLB, File));
+	CHECK(File.Primitives.size() == 1 && File.Instances.size() == 1 && File.MeshFirstPrimitive.size() == 2);
+	if (File.Primitives.size() == 1)
+	{
+		const FGLBPrimitive& Primitive = File.Primitives[0];
+		CHECK(Primitive.Positions.Data == GLB.data() + 28 + ((MakeTriangleJSON(kTriangleAccessors, "[{\"mesh\":0}]").size() + 3) & ~3u));
+		CHECK(Primitive.Positions.Count == 3 && Primitive.Positions.Stride == 12);
+		CHECK(Primitive.Indices.Count == 3 && Primitive.Indices.ComponentType == GLBComponent_UnsignedShort);
+		CHECK(Primitive.Normals.Data == nullptr);
+	}
+}
+
+// Every proper prefix of a valid file is rejected, and so are chunk lengths that run past the end.
+TEST(GLTFTruncatedChunks)
+{
+	const eastl::vector<uint8_t> GLB = MakeGLB(MakeTriangleJSON(kTriangleAccessors, "[{\"mesh\":0}]"), MakeTriangleBin());
+	FGLBFile File;
+	for (size_t Size = 0; Size < GLB.size(); ++Size)
+	{
+		CHECK(!ParseGLB(GLB.data(), Size, File));
+		CHECK(File.Primitives.empty() && File.Instances.empty());
+	}
+	CHECK(!ParseGLB(nullptr, 0, File));
+
+	// Header length matches the truncated size, the chunk lengths do not.
+	for (size_t Size : { (size_t)24, GLB.size() - 4 })
+	{
+		eastl::vector<uint8_t> Truncated(GLB.begin(), GLB.begin() + Size);
+		const uint32_t Length = (uint32_t)Size;
+		memcpy(Truncated.data() + 8, &Length, sizeof(Length));
+		CHECK(!ParseGLBBuffer(Truncated, File));
+	}
+
+	// JSON that ends early.
+	eastl::string JSON = MakeTriangleJSON(kTriangleAccessors, "[{\"mesh\":0}]");
+	JSON.pop_back();
+	CHECK(!ParseGLBBuffer(MakeGLB(JSON, MakeTriangleBin()), File));
+}
+
+TEST(GLTFOutOfRangeAccessors)
+{
+	FGLBFile File;
+	const eastl::vector<uint8_t> Bin = MakeTriangleBin();
+
+	// Index accessor that does not exist.
+	eastl::string JSON = MakeTriangleJSON("[{\"bufferView\":0,\"componentType\":5126,\"count\":3,\"type\":\"VEC3\"}]", "[{\"mesh\":0}]");
+	CHECK(!ParseGLBBuffer(MakeGLB(JSON, Bin), File));
+
+	// Accessors reading past the end of their buffer view: one element too many, an offset, and a huge count.
+	const char* kAccessors[] =
+	{
+		"[{\"bufferView\":0,\"componentType\":5126,\"count\":4,\"type\":\"VEC3\"},{\"bufferView\":1,\"componentType\":5123,\"count\":3,\"type\":\"SCALAR\"}]",
+		"[{\"bufferView\":0,\"byteOffset\":4,\"componentType\":5126,\"count\":3,\"type\":\"VEC3\"},{\"bufferView\":1,\"componentType\":5123,\"count\":3,\"type\":\"SCALAR\"}]",
+		"[{\"bufferView\":0,\"componentType\":5126,\"count\":4294967295,\"type\":\"VEC3\"},{\"bufferView\":1,\"componentType\":5123,\"count\":3,\"type\":\"SCALAR\"}]",
+		"[{\"bufferView\":2,\"componentType\":5126,\"count\":3,\"type\":\"VEC3\"},{\"bufferView\":1,\"componentType\":5123,\"count\":3,\"type\":\"SCALAR\"}]",
+		"[{\"bufferView\":0,\"componentType\":5126,\"count\":3,\"type\":\"VEC3\"},{\"bufferView\":1,\"byteOffset\":-2,\"componentType\":5123,\"count\":3,\"type\":\"SCALAR\"}]",
+	};
+	for (const char* Accessors : kAccessors)
+	{
+		CHECK(!ParseGLBBuffer(MakeGLB(MakeTriangleJSON(Accessors, "[{\"mesh\":0}]"), Bin), File));
+	}
+
+	// Buffer view past the end of the BIN chunk.
+	JSON = MakeTriangleJSON(kTriangleAccessors, "[{\"mesh\":0}]");
+	JSON.replace(JSON.find("\"byteLength\":6}"), 15, "\"byteLength\":16}");
+	CHECK(!ParseGLBBuffer(MakeGLB(JSON, Bin), File));
+}
+
+// Positions and normals interleaved in one buffer view (byteStride 24), and strides the reader does not accept.
+TEST(GLTFStrides)
+{
+	eastl::vector<uint8_t> Bin;
+	for (uint32_t Idx = 0; Idx < 3; ++Idx)
+	{
+		const float Vertex[6] = { (float)Idx, (float)(Idx * 2), 0.0f, 0.0f, 0.0f, 1.0f };
+		AppendBin(Bin, Vertex, 6);
+	}
+	const uint32_t Indices[3] = { 0, 1, 2 };
+	AppendBin(Bin, Indices, 3);
+
+	auto MakeJSON = [](uint32_t Stride, uint32_t ViewLength) -> eastl::string
+	{
+		eastl::string JSON;
+		JSON.sprintf("{\"nodes\":[{\"mesh\":0}],"
+			"\"meshes\":[{\"primitives\":[{\"attributes\":{\"POSITION\":0,\"NORMAL\":1},\"indices\":2}]}],"
+			"\"bufferViews\":[{\"buffer\":0,\"byteLength\":%u,\"byteStride\":%u},{\"buffer\":0,\"byteOffset\":72,\"byteLength\":12}],"
+			"\"accessors\":[{\"bufferView\":0,\"componentType\":5126,\"count\":3,\"type\":\"VEC3\"},"
+			"{\"bufferView\":0,\"byteOffset\":12,\"componentType\":5126,\"count\":3,\"type\":\"VEC3\"},"
+			"{\"bufferView\":1,\"componentType\":5125,\"count\":3,\"type\":\"SCALAR\"}]}", ViewLength, Stride);
+		return JSON;
+	};
+
+	FGLBFile File;
+	const eastl::vector<uint8_t> GLB = MakeGLB(MakeJSON(24, 72), Bin);
+	CHECK(ParseGLBBuffer(GLB, File));
+	CHECK(File.Primitives.size() == 1);
+	if (File.Primitives.size() == 1)
+	{
+		const FGLBPrimitive& Primitive = File.Primitives[0];
+		CHECK(Primitive.Positions.Stride == 24 && Primitive.Normals.Stride == 24);
+		CHECK(Primitive.Normals.Data == Primitive.Positions.Data + 12);
+		float Y;
+		memcpy(&Y, Primitive.Positions.Data + 2 * Primitive.Positions.Stride + 4, sizeof(Y));
+		CHECK(Y == 4.0f);
+	}
+
+	// Last normal ends at byte 72: a view one byte shorter is too short for stride 24.
+	CHECK(!ParseGLBBuffer(MakeGLB(MakeJSON(24, 71), Bin), File));
+	// Smaller than the element, not 4-byte aligned, above the glTF maximum.
+	for (uint32_t Stride : { 8u, 2u, 26u, 256u })
+	{
+		CHECK(!ParseGLBBuffer(MakeGLB(MakeJSON(Stride, 72), Bin), File));
+	}
+}
+
+TEST(GLTFOutOfRangeIndices)
+{
+	FGLBFile File;
+	CHECK(ParseGLBBuffer(MakeGLB(MakeTriangleJSON(kTriangleAccessors, "[{\"mesh\":0}]"), MakeTriangleBin(2)), File));
+	CHECK(!ParseGLBBuffer(MakeGLB(MakeTriangleJSON(kTriangleAccessors, "[{\"mesh\":0}]"), MakeTriangleBin(3)), File));
+	CHECK(!ParseGLBBuffer(MakeGLB(MakeTriangleJSON(kTriangleAccessors, "[{\"mesh\":0}]"), MakeTriangleBin(0xffff)), File));
+
+	// Scene and child nodes that do not exist.
+	CHECK(!ParseGLBBuffer(MakeGLB(MakeTriangleJSON(kTriangleAccessors, "[{\"mesh\":0}]", "[{\"nodes\":[1]}]"), MakeTriangleBin()), File));
+	CHECK(!ParseGLBBuffer(MakeGLB(MakeTriangleJSON(kTriangleAccessors, "[{\"mesh\":0,\"children\":[5]}]"), MakeTriangleBin()), File));
+}
+
+TEST(GLTFNodeCycles)
+{
+	FGLBFile File;
+	const eastl::vector<uint8_t> Bin = MakeTriangleBin();
+	CHECK(!ParseGLBBuffer(MakeGLB(MakeTriangleJSON(kTriangleAccessors, "[{\"mesh\":0,\"children\":[0]}]"), Bin), File));
+	CHECK(!ParseGLBBuffer(MakeGLB(MakeTriangleJSON(kTriangleAccessors, "[{\"children\":[1]},{\"children\":[2]},{\"mesh\":0,\"children\":[1]}]"), Bin), File));
+	// Node listed as a root twice is visited twice.
+	CHECK(!ParseGLBBuffer(MakeGLB(MakeTriangleJSON(kTriangleAccessors, "[{\"mesh\":0}]", "[{\"nodes\":[0,0]}]"), Bin), File));
+	// Without a scene every node is someone's child, there is no root and nothing is instanced.
+	CHECK(ParseGLBBuffer(MakeGLB(MakeTriangleJSON(kTriangleAccessors, "[{\"mesh\":0,\"children\":[1]},{\"children\":[0]}]", "[]"), Bin), File));
+	CHECK(File.Instances.empty());
+}
+
+// Two nodes place the same mesh under a translated parent, one of them with its own matrix.
+TEST(GLTFInstancing)
+{
+	const char* kNodes =
+		"[{\"translation\":[10,0,0],\"children\":[1,2]},"
+		"{\"mesh\":0,\"translation\":[0,5,0]},"
+		"{\"mesh\":0,\"matrix\":[2,0,0,0, 0,2,0,0, 0,0,2,0, 0,0,7,1]}]";
+	FGLBFile File;
+	CHECK(ParseGLBBuffer(MakeGLB(MakeTriangleJSON(kTriangleAccessors, kNodes), MakeTriangleBin()), File));
+	CHECK(File.Instances.size() == 2);
+	if (File.Instances.size() == 2)
+	{
+		// Children are pushed in order and popped in reverse.
+		const FGLBInstance& Scaled = File.Instances[0];
+		const FGLBInstance& Translated = File.Instances[1];
+		CHECK(Scaled.MeshIndex == 0 && Translated.MeshIndex == 0);
+		CHECK_NEAR(Translated.Transform._41, 10.0f, 1e-6f);
+		CHECK_NEAR(Translated.Transform._42, 5.0f, 1e-6f);
+		CHECK_NEAR(Translated.Transform._11, 1.0f, 1e-6f);
+		CHECK_NEAR(Scaled.Transform._11, 2.0f, 1e-6f);
+		CHECK_NEAR(Scaled.Transform._41, 10.0f, 1e-6f);
+		CHECK_NEAR(Scaled.Transform._43, 7.0f, 1e-6f);
+	}
+}
+
+// Scene of NumMeshes triangle meshes (one accessor pair each) placed by NumNodes nodes under one root.
+static eastl::vector<uint8_t> MakeBenchmarkGLB(uint32_t NumMeshes, uint32_t NumNodes)
+{
+	eastl::string JSON = "{\"scene\":0,\"scenes\":[{\"nodes\":[0]}],\"nodes\":[{\"children\":[";
+	char Text[256];
+	for (uint32_t Idx = 1; Idx <= NumNodes; ++Idx)
+	{
+		EA::StdC::Snprintf(Text, sizeof(Text), Idx > 1 ? ",%u" : "%u", Idx);
+		JSON += Text;
+	}
+	JSON += "]}";
+	for (uint32_t Idx = 0; Idx < NumNodes; ++Idx)
+	{
+		EA::StdC::Snprintf(Text, sizeof(Text), ",{\"mesh\":%u,\"translation\":[%u,0.5,-2.25],\"rotation\":[0,0.7071068,0,0.7071068]}", Idx % NumMeshes, Idx);
+		JSON += Text;
+	}
+	JSON += "],\"meshes\":[";
+	for (uint32_t Idx = 0; Idx < NumMeshes; ++Idx)
+	{
+		EA::StdC::Snprintf(Text, sizeof(Text), "%s{\"primitives\":[{\"attributes\":{\"POSITION\":%u},\"indices\":%u}]}", Idx ? "," : "", Idx * 2, Idx * 2 + 1);
+		JSON += Text;
+	}
+	JSON += "],\"bufferViews\":[{\"buffer\":0,\"byteLength\":36},{\"buffer\":0,\"byteOffset\":36,\"byteLength\":6}],\"accessors\":[";
+	for (uint32_t Idx = 0; Idx < NumMeshes; ++Idx)
+	{
+		JSON += Idx ? "," : "";
+		JSON += "{\"bufferView\":0,\"componentType\":5126,\"count\":3,\"type\":\"VEC3\"},{\"bufferView\":1,\"componentType\":5123,\"count\":3,\"type\":\"SCALAR\"}";
+	}
+	JSON += "]}";
+	return MakeGLB(JSON, MakeTriangleBin());
+}
+
+static void RunGLTFParseBenchmark(const char* Name, const eastl::vector<uint8_t>& GLB)
+{
+	const uint32_t kRuns = 5;
+	FGLBFile File;
+	bool bIsParsed = true;
+	EA::StdC::Stopwatch Stopwatch(EA::StdC::Stopwatch::kUnitsMicroseconds, true);
+	for (uint32_t Run = 0; Run < kRuns; ++Run)
+	{
+		bIsParsed = ParseGLBBuffer(GLB, File) && bIsParsed;
+	}
+	const double Ms = Stopwatch.GetElapsedTime() / 1000.0 / kRuns;
+	CHECK(bIsParsed);
+	printf("GLTF parse %s, %.1f MB, %u primitives, %u instances: %.2f ms (%.0f MB/s)\n", Name, GLB.size() / 1e6, (uint32_t)File.Primitives.size(), (uint32_t)File.Instances.size(), Ms, GLB.size() / (Ms * 1000.0));
+}
+
+// Parse time of synthetic scenes of growing size, doubling the scene should double the time (nodes, meshes and accessors
+// are looked up by index without walking their arrays).
+// With DXRTEST_GLB=<file> the file is parsed as well.
+BENCHMARK(GLTFParseBenchmark)
+{
+	for (uint32_t Scale : { 1u, 2u, 4u })
+	{
+		char Name[64];
+		EA::StdC::Snprintf(Name, sizeof(Name), "%u meshes, %u nodes", 5000 * Scale, 20000 * Scale);
+		RunGLTFParseBenchmark(Name, MakeBenchmarkGLB(5000 * Scale, 20000 * Scale));
+	}
+
+	const char* FileName = getenv("DXRTEST_GLB");
+	if (FileName && FileName[0])
+	{
+		eastl::vector<uint8_t> GLB;
+		FILE* File = fopen(FileName, "rb");
+		if (File)
+		{
+			fseek(File, 0, SEEK_END);
+			GLB.resize((size_t)ftell(File));
+			fseek(File, 0, SEEK_SET);
+			GLB.resize(fread(GLB.data(), 1, GLB.size(), File));
+			fclose(File);
+		}
+		if (GLB.empty())
+		{
+			printf("GLTF parse: cannot read %s\n", FileName);
+			GNumFailedChecks++;
+			return;
+		}
+		RunGLTFParseBenchmark(FileName, GLB);
+	}
+}
@@ -0,0 +1,166 @@
+#include "Test.h"
+#include "PLY.h"
+#include "EASTL/algorithm.h"
+#include "EASTL/string.h"
+#include "EASTL/vector.h"
+
+static XMFLOAT3 GetPLYTestPosition(uint32_t Idx)
+{
+	return XMFLOAT3((float)Idx, (float)Idx * 0.5f, -(float)Idx);
+}
+
+static XMFLOAT3 GetPLYTestNormal(uint32_t Idx)
+{
+	return XMFLOAT3(0.0f, (Idx & 1) ? 1.0f : -1.0f, 0.0f);
+}
+
+// Fan of triangles over the vertices in file order, every other line ends with "\r\n".
+static eastl::string MakePLY(uint32_t NumVertices, uint32_t NumTriangles)
+{
+	eastl::string PLY;
+	PLY.append_sprintf("ply\nformat ascii 1.0\ncomment generated\nelement vertex %u\n", NumVertices);
+	PLY += "property float x\nproperty float y\nproperty float z\nproperty float nx\nproperty float ny\nproperty float nz\n";
+	PLY.append_sprintf("element face %u\nproperty list uchar int vertex_indices\nend_header\n", NumTriangles);
+	for (uint32_t Idx = 0; Idx < NumVertices; ++Idx)
+	{
+		const XMFLOAT3 P = GetPLYTestPosition(Idx);
+		const XMFLOAT3 N = GetPLYTestNormal(Idx);
+		PLY.append_sprintf("%g %g %g %g %g %g%s", P.x, P.y, P.z, N.x, N.y, N.z, (Idx & 1) ? "\r\n" : "\n");
+	}
+	for (uint32_t Idx = 0; Idx < NumTriangles; ++Idx)
+	{
+		PLY.append_sprintf("3 0 %u %u%s", Idx % (NumVertices - 1) + 1, (Idx + 1) % (NumVertices - 1) + 1, (Idx & 1) ? "\r\n" : "\n");
+	}
+	return PLY;
+}
+
+struct FPLYReadResult
+{
+	bool bIsHeaderValid;
+	bool bIsCorrupt;
+	bool bIsMatching; // Everything read equals what MakePLY wrote.
+	uint32_t NumVertices;
+	uint32_t NumTriangles;
+};
+
+// Reads the whole file in windows of WindowSize elements the way the application does.
+static FPLYReadResult ReadPLY(const eastl::string& PLY, uint32_t WindowSize)
+{
+	FPLYReadResult Result = {};
+	FPLYFile File;
+	Result.bIsHeaderValid = ParsePLYHeader((const uint8_t*)PLY.data(), PLY.size(), File);
+	if (!Result.bIsHeaderValid)
+	{
+		return Result;
+	}
+
+	eastl::vector<XMFLOAT3> Positions(WindowSize);
+	eastl::vector<XMFLOAT3> Normals(WindowSize);
+	eastl::vector<uint32_t> Triangles(WindowSize * 3);
+	Result.bIsMatching = File.bHasNormals && !File.bHasTexcoords;
+	while (uint32_t Count = ReadPLYVertices(File, WindowSize, Positions.data(), Normals.data(), nullptr))
+	{
+		for (uint32_t Idx = 0; Idx < Count; ++Idx)
+		{
+			const XMFLOAT3 P = GetPLYTestPosition(Result.NumVertices + Idx);
+			const XMFLOAT3 N = GetPLYTestNormal(Result.NumVertices + Idx);
+			const XMFLOAT3& ReadP = Positions[Idx];
+			const XMFLOAT3& ReadN = Normals[Idx];
+			Result.bIsMatching = Result.bIsMatching && ReadP.x == P.x && ReadP.y == P.y && ReadP.z == P.z && ReadN.x == N.x && ReadN.y == N.y && ReadN.z == N.z;
+		}
+		Result.NumVertices += Count;
+	}
+	while (uint32_t Count = ReadPLYTriangles(File, WindowSize, Triangles.data()))
+	{
+		for (uint32_t Idx = 0; Idx < Count; ++Idx)
+		{
+			const uint32_t Triangle = Result.NumTriangles + Idx;
+			const uint32_t NumVertices = File.NumVertices;
+			Result.bIsMatching = Result.bIsMatching && Triangles[Idx * 3] == 0 && Triangles[Idx * 3 + 1] == Triangle % (NumVertices - 1) + 1 && Triangles[Idx * 3 + 2] == (Triangle + 1) % (NumVertices - 1) + 1;
+		}
+		Result.NumTriangles += Count;
+	}
+	Result.bIsCorrupt = File.bIsCorrupt;
+	return Result;
+}
+
+// Windows that do and do not divide the element counts read every element once, in order.
+TEST(PLYWindowedRead)
+{
+	const eastl::string PLY = MakePLY(10000, 19997);
+	for (uint32_t WindowSize : { 1u, 777u, 1000u, 65536u })
+	{
+		const FPLYReadResult Result = ReadPLY(PLY, WindowSize);
+		CHECK(Result.bIsHeaderValid && !Result.bIsCorrupt && Result.bIsMatching);
+		CHECK(Result.NumVertices == 10000 && Result.NumTriangles == 19997);
+	}
+}
+
+// A file cut short stops at the last complete element and marks the file corrupt instead of reading past the end. Few
+// faces, so that half of the vertices still pass the size check of the header.
+TEST(PLYTruncatedFile)
+{
+	const eastl::string PLY = MakePLY(1000, 200);
+	const size_t FirstVertex = PLY.find("end_header\n") + 11;
+	const size_t HalfVertices = PLY.find("500 250 -500");
+	const size_t FirstTriangle = PLY.find("3 0 1 2");
+	const size_t HalfTriangles = PLY.find("3 0 ", FirstTriangle + (PLY.size() - FirstTriangle) / 2);
+	const size_t LastTriangle = PLY.rfind("3 0 ");
+	const uint32_t NumHalfTriangles = (uint32_t)eastl::count(PLY.begin() + FirstTriangle, PLY.begin() + HalfTriangles, '\n');
+
+	struct FCut
+	{
+		size_t Size;
+		uint32_t NumVertices;
+		uint32_t NumTriangles;
+	} Cuts[] =
+	{
+		{ HalfVertices, 500, 0 },
+		{ HalfVertices + 4, 500, 0 }, // Inside a vertex line, after its first value.
+		{ FirstTriangle, 1000, 0 },
+		{ HalfTriangles, 1000, NumHalfTriangles },
+		{ HalfTriangles + 5, 1000, NumHalfTriangles }, // Inside a face line, after its first index.
+		{ LastTriangle, 1000, 199 },
+	};
+	for (const FCut& Cut : Cuts)
+	{
+		const FPLYReadResult Result = ReadPLY(PLY.substr(0, Cut.Size), 300);
+		CHECK(Result.bIsHeaderValid && Result.bIsCorrupt && Result.bIsMatching);
+		CHECK(Result.NumVertices == Cut.NumVertices && Result.NumTriangles == Cut.NumTriangles);
+	}
+
+	CHECK(!ReadPLY(PLY.substr(0, FirstVertex - 20), 300).bIsHeaderValid);
+	CHECK(!ReadPLY(PLY.substr(0, FirstVertex + 100), 300).bIsHeaderValid); // Cannot hold 1000 vertices.
+	CHECK(NumHalfTriangles > 0 && NumHalfTriangles < 199);
+}
+
+// Faces that are not triangles or index past the vertices stop the read at the face before.
+TEST(PLYFaceValidation)
+{
+	const char* const kBadFaces[] = { "4 0 1 2 3\n", "3 0 1 4\n", "3 0 1 99999999999\n", "3 0 1\n", "3 0 x 2\n" };
+	for (const char* BadFace : kBadFaces)
+	{
+		eastl::string PLY = MakePLY(4, 1);
+		PLY.replace(PLY.find("element face 1"), 14, "element face 3");
+		PLY += BadFace;
+		PLY += "3 0 1 2\n";
+		const FPLYReadResult Result = ReadPLY(PLY, 16);
+		CHECK(Result.bIsHeaderValid && Result.bIsCorrupt && Result.bIsMatching);
+		CHECK(Result.NumVertices == 4 && Result.NumTriangles == 1);
+	}
+}
+
+TEST(PLYHeader)
+{
+	eastl::string NoZ = MakePLY(4, 1);
+	NoZ.replace(NoZ.find("property float z"), 16, "property float w");
+	CHECK(!ReadPLY(NoZ, 16).bIsHeaderValid);
+
+	eastl::string NoEnd = MakePLY(4, 1);
+	NoEnd.replace(NoEnd.find("end_header"), 10, "end_headex");
+	CHECK(!ReadPLY(NoEnd, 16).bIsHeaderValid);
+
+	eastl::string TooManyFaces = MakePLY(4, 1);
+	TooManyFaces.replace(TooManyFaces.find("element face 1"), 14, "element face 2000000000");
+	CHECK(!ReadPLY(TooManyFaces, 16).bIsHeaderValid);
+}
@@ -0,0 +1,254 @@
+#include "Test.h"
+#include "PipelineCache.h"
+#include <string.h>
+#include "EASTL/vector.h"
+
+static eastl::vector<uint8_t> MakeCacheFile(uint32_t DataSize)
+{
+	eastl::vector<uint8_t> File(sizeof(FPipelineCacheHeader) + DataSize);
+	for (uint32_t Idx = 0; Idx < DataSize; ++Idx)
+	{
+		File[sizeof(FPipelineCacheHeader) + Idx] = (uint8_t)(Idx * 31 + 7);
+	}
+	const FPipelineCacheHeader Header = MakePipelineCacheHeader(File.data() + sizeof(FPipelineCacheHeader), DataSize);
+	memcpy(File.data(), &Header, sizeof(Header));
+	return File;
+}
+
+static bool IsCacheFileAccepted(const eastl::vector<uint8_t>& File)
+{
+	uint64_t DataSize = 0;
+	return GetPipelineCacheData(File.data(), File.size(), DataSize) != nullptr;
+}
+
+static void SetHeaderField(eastl::vector<uint8_t>& File, size_t Offset, uint64_t Value, size_t Size)
+{
+	memcpy(File.data() + Offset, &Value, Size);
+}
+
+TEST(PipelineCacheHeaderAccepted)
+{
+	const eastl::vector<uint8_t> File = MakeCacheFile(1000);
+	uint64_t DataSize = 0;
+	const uint8_t* Data = GetPipelineCacheData(File.data(), File.size(), DataSize);
+	CHECK(Data == File.data() + sizeof(FPipelineCacheHeader));
+	CHECK(DataSize == 1000);
+
+	// Empty library is still a library.
+	CHECK(IsCacheFileAccepted(MakeCacheFile(0)));
+}
+
+TEST(PipelineCacheHeaderRejected)
+{
+	const eastl::vector<uint8_t> Good = MakeCacheFile(1000);
+
+	eastl::vector<uint8_t> File = Good;
+	SetHeaderField(File, offsetof(FPipelineCacheHeader, Magic), kPipelineCacheMagic ^ 1, sizeof(uint32_t));
+	CHECK(!IsCacheFileAccepted(File));
+
+	File = Good;
+	SetHeaderField(File, offsetof(FPipelineCacheHeader, Version), kPipelineCacheVersion - 1, sizeof(uint32_t));
+	CHECK(!IsCacheFileAccepted(File));
+
+	// Truncated and extended files, and a header that claims a different size.
+	File = Good;
+	File.pop_back();
+	CHECK(!IsCacheFileAccepted(File));
+	File = Good;
+	File.push_back(0);
+	CHECK(!IsCacheFileAccepted(File));
+	File = Good;
+	SetHeaderField(File, offsetof(FPipelineCacheHeader, DataSize), 999, sizeof(uint64_t));
+	CHECK(!IsCacheFileAccepted(File));
+
+	File = Good;
+	File[sizeof(FPipelineCacheHeader) + 500] ^= 0x10;
+	CHECK(!IsCacheFileAccepted(File));
+
+	File.resize(sizeof(FPipelineCacheHeader) - 1);
+	CHECK(!IsCacheFileAccepted(File));
+	uint64_t DataSize = 1;
+	CHECK(!GetPipelineCacheData(nullptr, 0, DataSize) && DataSize == 0);
+}
+
+static const uint8_t kVertexShader[] = { 'D', 'X', 'B', 'C', 1, 2, 3, 4 };
+static const uint8_t kPixelShader[] = { 'D', 'X', 'B', 'C', 5, 6, 7, 8, 9 };
+
+// Fills every field of Desc that a pipeline of this project sets, Desc keeps whatever its padding bytes were.
+static void InitGraphicsDesc(D3D12_GRAPHICS_PIPELINE_STATE_DESC& Desc, const D3D12_INPUT_ELEMENT_DESC* Elements, uint32_t NumElements)
+{
+	Desc.pRootSignature = nullptr;
+	Desc.VS = { kVertexShader, sizeof(kVertexShader) };
+	Desc.PS = { kPixelShader, sizeof(kPixelShader) };
+	Desc.DS = Desc.HS = Desc.GS = { nullptr, 0 };
+	Desc.StreamOutput.pSODeclaration = nullptr;
+	Desc.StreamOutput.NumEntries = 0;
+	Desc.StreamOutput.pBufferStrides = nullptr;
+	Desc.StreamOutput.NumStrides = 0;
+	Desc.StreamOutput.RasterizedStream = 0;
+	Desc.BlendState.AlphaToCoverageEnable = 0;
+	Desc.BlendState.IndependentBlendEnable = 0;
+	for (D3D12_RENDER_TARGET_BLEND_DESC& Target : Desc.BlendState.RenderTarget)
+	{
+		Target.BlendEnable = 0;
+		Target.LogicOpEnable = 0;
+		Target.SrcBlend = D3D12_BLEND_ONE;
+		Target.DestBlend = D3D12_BLEND_ZERO;
+		Target.BlendOp = D3D12_BLEND_OP_ADD;
+		Target.SrcBlendAlpha = D3D12_BLEND_ONE;
+		Target.DestBlendAlpha = D3D12_BLEND_ZERO;
+		Target.BlendOpAlpha = D3D12_BLEND_OP_ADD;
+		Target.LogicOp = D3D12_LOGIC_OP_NOOP;
+		Target.RenderTargetWriteMask = D3D12_COLOR_WRITE_ENABLE_ALL;
+	}
+	Desc.SampleMask = 0xffffffff;
+	Desc.RasterizerState.FillMode = D3D12_FILL_MODE_SOLID;
+	Desc.RasterizerState.CullMode = D3D12_CULL_MODE_BACK;
+	Desc.RasterizerState.FrontCounterClockwise = 0;
+	Desc.RasterizerState.DepthBias = 0;
+	Desc.RasterizerState.DepthBiasClamp = 0.0f;
+	Desc.RasterizerState.SlopeScaledDepthBias = 0.0f;
+	Desc.RasterizerState.DepthClipEnable = 1;
+	Desc.RasterizerState.MultisampleEnable = 0;
+	Desc.RasterizerState.AntialiasedLineEnable = 0;
+	Desc.RasterizerState.ForcedSampleCount = 0;
+	Desc.RasterizerState.ConservativeRaster = D3D12_CONSERVATIVE_RASTERIZATION_MODE_OFF;
+	Desc.DepthStencilState.DepthEnable = 1;
+	Desc.DepthStencilState.DepthWriteMask = D3D12_DEPTH_WRITE_MASK_ALL;
+	Desc.DepthStencilState.DepthFunc = D3D12_COMPARISON_FUNC_LESS;
+	Desc.DepthStencilState.StencilEnable = 0;
+	Desc.DepthStencilState.StencilReadMask = 0xff;
+	Desc.DepthStencilState.StencilWriteMask = 0xff;
+	Desc.DepthStencilState.FrontFace = { D3D12_STENCIL_OP_KEEP, D3D12_STENCIL_OP_KEEP, D3D12_STENCIL_OP_KEEP, D3D12_COMPARISON_FUNC_ALWAYS };
+	Desc.DepthStencilState.BackFace = Desc.DepthStencilState.FrontFace;
+	Desc.InputLayout = { Elements, NumElements };
+	Desc.IBStripCutValue = D3D12_INDEX_BUFFER_STRIP_CUT_VALUE_DISABLED;
+	Desc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
+	Desc.NumRenderTargets = 1;
+	for (DXGI_FORMAT& Format : Desc.RTVFormats)
+	{
+		Format = DXGI_FORMAT_UNKNOWN;
+	}
+	Desc.RTVFormats[0] = DXGI_FORMAT_R8G8B8A8_UNORM;
+	Desc.DSVFormat = DXGI_FORMAT_D32_FLOAT;
+	Desc.SampleDesc = { 1, 0 };
+	Desc.NodeMask = 0;
+	Desc.CachedPSO = { nullptr, 0 };
+	Desc.Flags = D3D12_PIPELINE_STATE_FLAG_NONE;
+}
+
+static const D3D12_INPUT_ELEMENT_DESC kInputElements[] =
+{
+	{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+	{ "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 12, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+};
+
+// Same fields, different padding (and pointers the key ignores): same key.
+TEST(PipelineKeyIgnoresPadding)
+{
+	D3D12_GRAPHICS_PIPELINE_STATE_DESC Zeroed;
+	memset(&Zeroed, 0, sizeof(Zeroed));
+	InitGraphicsDesc(Zeroed, kInputElements, 2);
+
+	D3D12_GRAPHICS_PIPELINE_STATE_DESC Garbage;
+	memset(&Garbage, 0xcd, sizeof(Garbage));
+	InitGraphicsDesc(Garbage, kInputElements, 2);
+	CHECK(GetGraphicsPipelineKey(Zeroed) == GetGraphicsPipelineKey(Garbage));
+
+	// Equal contents at other addresses.
+	uint8_t VertexShaderCopy[sizeof(kVertexShader)];
+	memcpy(VertexShaderCopy, kVertexShader, sizeof(kVertexShader));
+	D3D12_INPUT_ELEMENT_DESC ElementsCopy[2];
+	memcpy(ElementsCopy, kInputElements, sizeof(ElementsCopy));
+	char SemanticName[] = "POSITION";
+	ElementsCopy[0].SemanticName = SemanticName;
+	InitGraphicsDesc(Garbage, ElementsCopy, 2);
+	Garbage.VS.pShaderBytecode = VertexShaderCopy;
+	Garbage.CachedPSO = { kPixelShader, sizeof(kPixelShader) };
+	CHECK(GetGraphicsPipelineKey(Zeroed) == GetGraphicsPipelineKey(Garbage));
+
+	D3D12_COMPUTE_PIPELINE_STATE_DESC Compute;
+	memset(&Compute, 0, sizeof(Compute));
+	Compute.CS = { kVertexShader, sizeof(kVertexShader) };
+	D3D12_COMPUTE_PIPELINE_STATE_DESC ComputeGarbage;
+	memset(&ComputeGarbage, 0xcd, sizeof(ComputeGarbage));
+	ComputeGarbage.pRootSignature = nullptr;
+	ComputeGarbage.CS = { VertexShaderCopy, sizeof(VertexShaderCopy) };
+	ComputeGarbage.NodeMask = 0;
+	ComputeGarbage.CachedPSO = { nullptr, 0 };
+	ComputeGarbage.Flags = D3D12_PIPELINE_STATE_FLAG_NONE;
+	CHECK(GetComputePipelineKey(Compute) == GetComputePipelineKey(ComputeGarbage));
+}
+
+TEST(PipelineKeyChanges)
+{
+	D3D12_GRAPHICS_PIPELINE_STATE_DESC Base;
+	memset(&Base, 0, sizeof(Base));
+	InitGraphicsDesc(Base, kInputElements, 2);
+	const uint64_t BaseKey = GetGraphicsPipelineKey(Base);
+
+	// Bytecode contents and length.
+	uint8_t ModifiedShader[sizeof(kPixelShader)];
+	memcpy(ModifiedShader, kPixelShader, sizeof(kPixelShader));
+	ModifiedShader[6] ^= 1;
+	D3D12_GRAPHICS_PIPELINE_STATE_DESC Desc = Base;
+	Desc.PS.pShaderBytecode = ModifiedShader;
+	CHECK(GetGraphicsPipelineKey(Desc) != BaseKey);
+	Desc = Base;
+	Desc.PS.BytecodeLength--;
+	CHECK(GetGraphicsPipelineKey(Desc) != BaseKey);
+	// Same bytes as pixel shader in another stage.
+	Desc = Base;
+	Desc.PS = { nullptr, 0 };
+	Desc.GS = Base.PS;
+	CHECK(GetGraphicsPipelineKey(Desc) != BaseKey);
+
+	// Input layout: element count, semantic name, format and offset.
+	Desc = Base;
+	Desc.InputLayout.NumElements = 1;
+	CHECK(GetGraphicsPipelineKey(Desc) != BaseKey);
+	D3D12_INPUT_ELEMENT_DESC Elements[2];
+	memcpy(Elements, kInputElements, sizeof(Elements));
+	Elements[1].SemanticName = "NORMAL";
+	Desc = Base;
+	Desc.InputLayout.pInputElementDescs = Elements;
+	CHECK(GetGraphicsPipelineKey(Desc) != BaseKey);
+	memcpy(Elements, kInputElements, sizeof(Elements));
+	Elements[1].Format = DXGI_FORMAT_R32G32B32A32_FLOAT;
+	CHECK(GetGraphicsPipelineKey(Desc) != BaseKey);
+	memcpy(Elements, kInputElements, sizeof(Elements));
+	Elements[1].AlignedByteOffset = 16;
+	CHECK(GetGraphicsPipelineKey(Desc) != BaseKey);
+	memcpy(Elements, kInputElements, sizeof(Elements));
+	CHECK(GetGraphicsPipelineKey(Desc) == BaseKey);
+
+	// Desc fields, including the last one of a render target blend desc (followed by padding) and of the desc.
+	Desc = Base;
+	Desc.RasterizerState.CullMode = D3D12_CULL_MODE_NONE;
+	CHECK(GetGraphicsPipelineKey(Desc) != BaseKey);
+	Desc = Base;
+	Desc.BlendState.RenderTarget[7].RenderTargetWriteMask = 0;
+	CHECK(GetGraphicsPipelineKey(Desc) != BaseKey);
+	Desc = Base;
+	Desc.DepthStencilState.StencilWriteMask = 0;
+	CHECK(GetGraphicsPipelineKey(Desc) != BaseKey);
+	Desc = Base;
+	Desc.RTVFormats[1] = DXGI_FORMAT_R8G8B8A8_UNORM;
+	CHECK(GetGraphicsPipelineKey(Desc) != BaseKey);
+	Desc = Base;
+	Desc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_LINE;
+	CHECK(GetGraphicsPipelineKey(Desc) != BaseKey);
+	Desc = Base;
+	Desc.Flags = (D3D12_PIPELINE_STATE_FLAGS)1;
+	CHECK(GetGraphicsPipelineKey(Desc) != BaseKey);
+
+	D3D12_COMPUTE_PIPELINE_STATE_DESC Compute;
+	memset(&Compute, 0, sizeof(Compute));
+	Compute.CS = { kVertexShader, sizeof(kVertexShader) };
+	const uint64_t ComputeKey = GetComputePipelineKey(Compute);
+	Compute.CS = { kPixelShader, sizeof(kPixelShader) };
+	CHECK(GetComputePipelineKey(Compute) != ComputeKey);
+	Compute.CS = { kVertexShader, sizeof(kVertexShader) };
+	Compute.NodeMask = 1;
+	CHECK(GetComputePipelineKey(Compute) != ComputeKey);
+}
@@ -0,0 +1,38 @@
+#include "Test.h"
+#include "RTPermutation.h"
+
+// Every combination of FRTSettings selects a distinct key that has exactly the features asked for, and the pipeline
+// payload size follows the payload layout of that key.
+TEST(RTPermutationSelection)
+{
+	bool bKeyUsed[RTPermutation_Count] = {};
+	for (uint32_t Bits = 0; Bits < 8; ++Bits)
+	{
+		FRTSettings Settings;
+		Settings.bLambertShading = (Bits & 0x1) != 0;
+		Settings.bCullBackFaces = (Bits & 0x2) != 0;
+		Settings.bNeedsFloatPayload = (Bits & 0x4) != 0;
+
+		const uint32_t Key = SelectRTPermutation(Settings);
+		CHECK(Key < RTPermutation_Count);
+		if (Key >= RTPermutation_Count)
+		{
+			continue;
+		}
+		CHECK(!bKeyUsed[Key]);
+		bKeyUsed[Key] = true;
+
+		CHECK(((Key & RTPermutation_LambertShading) != 0) == Settings.bLambertShading);
+		CHECK(((Key & RTPermutation_NoCulling) != 0) == !Settings.bCullBackFaces);
+		CHECK(((Key & RTPermutation_PackedPayload) != 0) == !Settings.bNeedsFloatPayload);
+		CHECK(GetRTPermutationPayloadSize(Key) ==
+			(Settings.bNeedsFloatPayload ? (uint32_t)RT_FLOAT_PAYLOAD_SIZE : (uint32_t)RT_PACKED_PAYLOAD_SIZE));
+	}
+}
+
+// FPayload in Raytracing.hlsl: float HitT after a uint (packed) or float4 color.
+TEST(RTPermutationPayloadSizes)
+{
+	CHECK(RT_PACKED_PAYLOAD_SIZE == sizeof(uint32_t) + sizeof(float));
+	CHECK(RT_FLOAT_PAYLOAD_SIZE == 4 * sizeof(float) + sizeof(float));
+}
@@ -0,0 +1,182 @@
+#include "Test.h"
+#include <string.h>
+#include "TestScene.h"
+#include "EASTL/vector.h"
+#include "EAStdC/EAStopwatch.h"
+
+TEST(InterleavePhasesCoverEveryPixelOnce)
+{
+	// Dispatches of all phases together trace every pixel exactly once and IsTracedPixel agrees with GetInterleavedPixel,
+	// also for odd sizes where the dispatch grid is larger than the image.
+	const uint32_t Sizes[4][2] = { { 8, 6 }, { 7, 5 }, { 1, 1 }, { 3, 8 } };
+	const uint32_t Interleaves[3] = { 1, 2, 4 };
+	for (const uint32_t (&Size)[2] : Sizes)
+	{
+		const uint32_t Width = Size[0];
+		const uint32_t Height = Size[1];
+		for (uint32_t Interleave : Interleaves)
+		{
+			eastl::vector<uint32_t> NumTraces(Width * Height, 0);
+			bool bAgreesWithIsTraced = true;
+			for (uint32_t Phase = 0; Phase < Interleave; ++Phase)
+			{
+				const uint2 DispatchSize = GetInterleavedDispatchSize(Interleave, uint2(Width, Height));
+				uint32_t NumPhasePixels = 0;
+				for (uint32_t Y = 0; Y < DispatchSize.y; ++Y)
+				{
+					for (uint32_t X = 0; X < DispatchSize.x; ++X)
+					{
+						const uint2 Pixel = GetInterleavedPixel(uint2(X, Y), Interleave, Phase);
+						if (Pixel.x >= Width || Pixel.y >= Height)
+						{
+							continue;
+						}
+						bAgreesWithIsTraced &= IsTracedPixel(Pixel, Interleave, Phase);
+						NumTraces[Pixel.y * Width + Pixel.x] += 1;
+						NumPhasePixels += 1;
+					}
+				}
+
+				uint32_t NumTracedPixels = 0;
+				for (uint32_t Y = 0; Y < Height; ++Y)
+				{
+					for (uint32_t X = 0; X < Width; ++X)
+					{
+						NumTracedPixels += IsTracedPixel(uint2(X, Y), Interleave, Phase) ? 1 : 0;
+					}
+				}
+				bAgreesWithIsTraced &= NumTracedPixels == NumPhasePixels;
+			}
+			CHECK(bAgreesWithIsTraced);
+			CHECK(eastl::count(NumTraces.begin(), NumTraces.end(), 1u) == Width * Height);
+		}
+	}
+}
+
+static const uint32_t kReconstructTestWidth = 192;
+static const uint32_t kReconstructTestHeight = 108;
+
+static void GetReconstructConstants(const FTestView& View, const FTestView& PrevView, uint32_t Width, uint32_t Height, uint32_t Interleave, uint32_t Phase, bool bHasHistory, FPerFrameConstantData& OutConstants)
+{
+	OutConstants = {};
+	OutConstants.PrevWorldToProjection = PrevView.WorldToProjection;
+	OutConstants.CameraPosition = View.CameraPosition;
+	OutConstants.TraceWidth = OutConstants.PrevTraceWidth = Width;
+	OutConstants.TraceHeight = OutConstants.PrevTraceHeight = Height;
+	OutConstants.DisocclusionTolerance = 0.02f;
+	OutConstants.TraceInterleave = Interleave;
+	OutConstants.InterleavePhase = Phase;
+	OutConstants.HasReconstructionHistory = bHasHistory ? 1 : 0;
+}
+
+TEST(ReconstructWithoutHistoryAveragesTracedNeighbors)
+{
+	FTestView View;
+	GetTestView(0.0f, View);
+	FImage Traced, Color, HitPosition, PrevColor, PrevHitPosition;
+	InitImage(kReconstructTestWidth, kReconstructTestHeight, Traced);
+	InitImage(kReconstructTestWidth, kReconstructTestHeight, HitPosition);
+	InitImage(kReconstructTestWidth, kReconstructTestHeight, PrevColor);
+	InitImage(kReconstructTestWidth, kReconstructTestHeight, PrevHitPosition);
+	TraceTestScene(View, float2(0.0f, 0.0f), 1, 0, Traced, HitPosition);
+	Color = Traced;
+
+	FPerFrameConstantData Constants;
+	GetReconstructConstants(View, View, kReconstructTestWidth, kReconstructTestHeight, 4, 0, false, Constants);
+	ReconstructImage(Constants, PrevColor, PrevHitPosition, Color, HitPosition);
+
+	bool bKeepsTracedPixels = true;
+	for (uint32_t Y = 0; Y < kReconstructTestHeight; ++Y)
+	{
+		for (uint32_t X = 0; X < kReconstructTestWidth; ++X)
+		{
+			const size_t Pixel = Y * kReconstructTestWidth + X;
+			if (IsTracedPixel(uint2(X, Y), 4, 0))
+			{
+				bKeepsTracedPixels &= memcmp(&Color.Texels[Pixel], &Traced.Texels[Pixel], sizeof(XMFLOAT4)) == 0;
+			}
+		}
+	}
+	CHECK(bKeepsTracedPixels);
+
+	// Phase 0 traces even columns of even rows, an odd pixel has four traced diagonal neighbours.
+	const uint32_t X = 97;
+	const uint32_t Y = 55;
+	const XMFLOAT4& A = Traced.Texels[(Y - 1) * kReconstructTestWidth + X - 1];
+	const XMFLOAT4& B = Traced.Texels[(Y - 1) * kReconstructTestWidth + X + 1];
+	const XMFLOAT4& C = Traced.Texels[(Y + 1) * kReconstructTestWidth + X - 1];
+	const XMFLOAT4& D = Traced.Texels[(Y + 1) * kReconstructTestWidth + X + 1];
+	const XMFLOAT4& Result = Color.Texels[Y * kReconstructTestWidth + X];
+	CHECK_NEAR(Result.x, (A.x + B.x + C.x + D.x) / 4.0f, 1.0e-6f);
+	CHECK_NEAR(Result.y, (A.y + B.y + C.y + D.y) / 4.0f, 1.0e-6f);
+	CHECK_NEAR(Result.z, (A.z + B.z + C.z + D.z) / 4.0f, 1.0e-6f);
+	CHECK(Result.w == 1.0f);
+}
+
+// Interleaved frames along the orbit, AngleStep apart, with the application's order of reconstruction and phase
+// advance. Returns the PSNR of the last frame against a full trace and the time of its reconstruction.
+static float RunReconstruction(uint32_t Width, uint32_t Height, uint32_t Interleave, uint32_t NumFrames, float AngleStep, bool bUsesHistory, double& OutMs)
+{
+	FImage Color, HitPosition, PrevColor, PrevHitPosition;
+	InitImage(Width, Height, Color);
+	InitImage(Width, Height, HitPosition);
+	InitImage(Width, Height, PrevColor);
+	InitImage(Width, Height, PrevHitPosition);
+
+	FTestView View, PrevView;
+	for (uint32_t Frame = 0; Frame < NumFrames; ++Frame)
+	{
+		GetTestView(Frame * AngleStep, View);
+		const uint32_t Phase = Frame % Interleave;
+		TraceTestScene(View, float2(0.0f, 0.0f), Interleave, Phase, Color, HitPosition);
+
+		FPerFrameConstantData Constants;
+		GetReconstructConstants(View, Frame > 0 ? PrevView : View, Width, Height, Interleave, Phase, bUsesHistory && Frame > 0, Constants);
+		const uint64_t BeginCycle = EA::StdC::Stopwatch::GetCPUCycle();
+		ReconstructImage(Constants, PrevColor, PrevHitPosition, Color, HitPosition);
+		OutMs = (EA::StdC::Stopwatch::GetCPUCycle() - BeginCycle) * 1000.0 / EA::StdC::Stopwatch::GetCPUFrequency();
+
+		PrevColor = Color;
+		PrevHitPosition = HitPosition;
+		PrevView = View;
+	}
+
+	FImage Reference, ReferenceHitPosition;
+	InitImage(Width, Height, Reference);
+	InitImage(Width, Height, ReferenceHitPosition);
+	TraceTestScene(View, float2(0.0f, 0.0f), 1, 0, Reference, ReferenceHitPosition);
+	return GetImagePSNR(Color, Reference);
+}
+
+TEST(ReconstructHistoryBeatsSpatialFill)
+{
+	// Static and at the orbit speed of --benchmark (0.25 radians per second at 60 Hz), reusing the previous frame has
+	// to be closer to the full trace than filling from traced neighbours alone.
+	const float AngleSteps[2] = { 0.0f, 0.25f / 60.0f };
+	for (float AngleStep : AngleSteps)
+	{
+		for (uint32_t Interleave = 2; Interleave <= 4; Interleave += 2)
+		{
+			double Ms;
+			const float HistoryPSNR = RunReconstruction(kReconstructTestWidth, kReconstructTestHeight, Interleave, 8, AngleStep, true, Ms);
+			const float SpatialPSNR = RunReconstruction(kReconstructTestWidth, kReconstructTestHeight, Interleave, 8, AngleStep, false, Ms);
+			CHECK(HistoryPSNR > SpatialPSNR);
+		}
+	}
+}
+
+// Quality against a full trace and cost of the reconstruction at 1920x1080, after 8 frames at the orbit speed of
+// --benchmark, with all processors and with one.
+BENCHMARK(ReconstructBenchmark)
+{
+	for (uint32_t Interleave = 2; Interleave <= 4; Interleave += 2)
+	{
+		double Ms, OneThreadMs;
+		const float SpatialPSNR = RunReconstruction(1920, 1080, Interleave, 8, 0.25f / 60.0f, false, Ms);
+		const float HistoryPSNR = RunReconstruction(1920, 1080, Interleave, 8, 0.25f / 60.0f, true, Ms);
+		SetNumReferenceThreads(1);
+		RunReconstruction(1920, 1080, Interleave, 8, 0.25f / 60.0f, true, OneThreadMs);
+		SetNumReferenceThreads(0);
+		printf("Reconstruct 1/%u: %.2f dB (%.2f dB without history), %.2f ms (%.1f Mpixel/s), %.2f ms on one thread\n", Interleave, HistoryPSNR, SpatialPSNR, Ms, 1920 * 1080 / (Ms * 1000.0), OneThreadMs);
+	}
+}
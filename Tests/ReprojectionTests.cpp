@@ -0,0 +1,112 @@
+#include "Test.h"
+#include "CPUAndGPUCommon.h"
+
+// Camera setup of Update in DXRTest.cpp.
+static XMMATRIX GetWorldToProjection(FXMVECTOR CameraPosition, FXMVECTOR FocusPosition)
+{
+	const XMMATRIX ViewTransform = XMMatrixLookAtLH(CameraPosition, FocusPosition, XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+	return XMMatrixMultiply(ViewTransform, XMMatrixPerspectiveFovLH(XM_PI / 3, 1.777f, 0.1f, 100.0f));
+}
+
+TEST(ReprojectionIdentityCamera)
+{
+	// With an identity matrix the position is its own clip space position.
+	float4x4 Identity;
+	XMStoreFloat4x4(&Identity, XMMatrixIdentity());
+	const float2 Dimensions(64.0f, 32.0f);
+	const float2 Center = GetReprojectedPixel(float3(0.0f, 0.0f, 0.5f), Identity, Dimensions);
+	CHECK(Center.x == 32.0f && Center.y == 16.0f);
+	const float2 Corner = GetReprojectedPixel(float3(-1.0f, 1.0f, 0.5f), Identity, Dimensions);
+	CHECK(Corner.x == 0.0f && Corner.y == 0.0f);
+}
+
+TEST(ReprojectionUnchangedCameraHitsOwnPixel)
+{
+	// Surface points seen through pixel centers reproject to the same pixel centers when the camera did not move.
+	const uint32_t Width = 1280;
+	const uint32_t Height = 720;
+	const XMMATRIX WorldToProjection = GetWorldToProjection(XMVectorSet(3.0f, 2.0f, -6.0f, 1.0f), XMVectorSet(0.0f, 0.5f, 0.0f, 1.0f));
+	const XMMATRIX ProjectionToWorld = XMMatrixInverse(nullptr, WorldToProjection);
+	float4x4 PrevWorldToProjection;
+	XMStoreFloat4x4(&PrevWorldToProjection, WorldToProjection);
+
+	const uint32_t Pixels[4][2] = { { 0, 0 }, { 640, 360 }, { 1279, 719 }, { 17, 500 } };
+	const float Depths[3] = { 0.1f, 0.9f, 0.999f };
+	for (uint32_t PixelIdx = 0; PixelIdx < 4; ++PixelIdx)
+	{
+		for (uint32_t DepthIdx = 0; DepthIdx < 3; ++DepthIdx)
+		{
+			const float NDCX = (Pixels[PixelIdx][0] + 0.5f) / Width * 2.0f - 1.0f;
+			const float NDCY = 1.0f - (Pixels[PixelIdx][1] + 0.5f) / Height * 2.0f;
+			float3 Position;
+			XMStoreFloat3(&Position, XMVector3TransformCoord(XMVectorSet(NDCX, NDCY, Depths[DepthIdx], 1.0f), ProjectionToWorld));
+
+			const float2 Pixel = GetReprojectedPixel(Position, PrevWorldToProjection, float2((float)Width, (float)Height));
+			CHECK_NEAR(Pixel.x, Pixels[PixelIdx][0] + 0.5f, 0.01);
+			CHECK_NEAR(Pixel.y, Pixels[PixelIdx][1] + 0.5f, 0.01);
+		}
+	}
+}
+
+TEST(ReprojectionRejectsPointsBehindCamera)
+{
+	float4x4 PrevWorldToProjection;
+	XMStoreFloat4x4(&PrevWorldToProjection, GetWorldToProjection(XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f), XMVectorSet(0.0f, 0.0f, 1.0f, 1.0f)));
+	const float2 Dimensions(1280.0f, 720.0f);
+
+	// W is the view space depth: zero at the camera, negative behind it.
+	const float2 AtCamera = GetReprojectedPixel(float3(0.0f, 0.0f, 0.0f), PrevWorldToProjection, Dimensions);
+	CHECK(AtCamera.x < 0.0f && AtCamera.y < 0.0f);
+	const float2 Behind = GetReprojectedPixel(float3(0.5f, 0.0f, -3.0f), PrevWorldToProjection, Dimensions);
+	CHECK(Behind.x < 0.0f && Behind.y < 0.0f);
+	const float2 InFront = GetReprojectedPixel(float3(0.0f, 0.0f, 3.0f), PrevWorldToProjection, Dimensions);
+	CHECK_NEAR(InFront.x, 640.0, 1.0e-3);
+	CHECK_NEAR(InFront.y, 360.0, 1.0e-3);
+}
+
+TEST(DisocclusionToleranceBoundary)
+{
+	// 8 units from the camera with a tolerance of 1/8: history up to 1 unit away is the same surface.
+	const float3 Camera(0.0f, 0.0f, 0.0f);
+	const float3 Position(0.0f, 0.0f, 8.0f);
+	const float Tolerance = 0.125f;
+	CHECK(!IsDisoccluded(Position, Position, Camera, Tolerance));
+	CHECK(!IsDisoccluded(Position, float3(0.0f, 1.0f, 8.0f), Camera, Tolerance));
+	CHECK(!IsDisoccluded(Position, float3(0.0f, 0.0f, 9.0f), Camera, Tolerance));
+	CHECK(!IsDisoccluded(Position, float3(0.5f, 0.5f, 8.5f), Camera, Tolerance));
+	CHECK(IsDisoccluded(Position, float3(0.0f, 1.001f, 8.0f), Camera, Tolerance));
+	CHECK(IsDisoccluded(Position, float3(0.0f, 0.0f, 9.01f), Camera, Tolerance));
+
+	// The same offset is fine further away.
+	CHECK(!IsDisoccluded(float3(0.0f, 0.0f, 16.0f), float3(0.0f, 1.5f, 16.0f), Camera, Tolerance));
+}
+
+TEST(HistoryBlendFactorTransition)
+{
+	const float MinBlendFactor = 0.2f;
+	CHECK(GetHistoryBlendFactor(1.0f, MinBlendFactor) == 1.0f);
+	CHECK(GetHistoryBlendFactor(2.0f, MinBlendFactor) == 0.5f);
+	CHECK(GetHistoryBlendFactor(4.0f, MinBlendFactor) == 0.25f);
+	CHECK(GetHistoryBlendFactor(5.0f, MinBlendFactor) == MinBlendFactor);
+	CHECK(GetHistoryBlendFactor(6.0f, MinBlendFactor) == MinBlendFactor);
+	CHECK(GetHistoryBlendFactor(256.0f, MinBlendFactor) == MinBlendFactor);
+
+	// Blending like Temporal.hlsl: the first 1 / MinBlendFactor frames average exactly, later frames decay
+	// exponentially.
+	float History = 0.0f;
+	float NumFrames = 0.0f;
+	for (uint32_t Frame = 1; Frame <= 5; ++Frame)
+	{
+		NumFrames += 1.0f;
+		const float Factor = GetHistoryBlendFactor(NumFrames, MinBlendFactor);
+		History += (Frame - History) * Factor;
+	}
+	CHECK_NEAR(History, 3.0, 1.0e-5);
+	for (uint32_t Frame = 1; Frame <= 10; ++Frame)
+	{
+		NumFrames += 1.0f;
+		const float Factor = GetHistoryBlendFactor(NumFrames, MinBlendFactor);
+		History += (10.0f - History) * Factor;
+		CHECK_NEAR(History, 10.0 - 7.0 * pow(0.8, Frame), 1.0e-4);
+	}
+}
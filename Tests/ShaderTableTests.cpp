@@ -0,0 +1,141 @@
+#include "Test.h"
+#include "ShaderTable.h"
+#include <string.h>
+
+struct FTestArgs
+{
+	uint32_t BaseVertex;
+	uint32_t BaseIndex;
+};
+
+typedef TShaderRecord<void> FTestRayGenRecord;
+typedef TShaderRecord<void> FTestMissRecord;
+typedef TShaderRecord<FTestArgs> FTestHitGroupRecord;
+
+static const FShaderTableLayout kTestLayout = GetShaderTableLayout<FTestRayGenRecord, FTestMissRecord, FTestHitGroupRecord>(2, 16);
+
+static FTestHitGroupRecord MakeHitGroupRecord(uint8_t Shader, uint32_t BaseVertex, uint32_t BaseIndex)
+{
+	FTestHitGroupRecord Record;
+	memset(Record.Identifier, Shader, sizeof(Record.Identifier));
+	Record.Args = { BaseVertex, BaseIndex };
+	return Record;
+}
+
+TEST(ShaderTableLayout)
+{
+	CHECK(kTestLayout.RayGenStride == 32);
+	CHECK(kTestLayout.HitGroupStride == 64); // 40 bytes rounded up to the record alignment.
+	CHECK(kTestLayout.MissOffset == kShaderTableAlignment);
+	CHECK(kTestLayout.HitGroupOffset == 2 * kShaderTableAlignment);
+	CHECK(kTestLayout.Size == kTestLayout.HitGroupOffset + 16 * 64);
+}
+
+TEST(ShaderTableSharesIdenticalHitGroupRecords)
+{
+	FShaderTable Table;
+	InitShaderTableRecords(kTestLayout, Table);
+
+	const FTestHitGroupRecord A[2] = { MakeHitGroupRecord(1, 0, 0), MakeHitGroupRecord(2, 0, 0) };
+	const FTestHitGroupRecord B[2] = { MakeHitGroupRecord(1, 100, 300), MakeHitGroupRecord(2, 100, 300) };
+	CHECK(AddHitGroupRecords(Table, A, 2) == 0);
+	CHECK(AddHitGroupRecords(Table, B, 2) == 2);
+	CHECK(AddHitGroupRecords(Table, A, 2) == 0);
+	CHECK(AddHitGroupRecords(Table, B, 2) == 2);
+	CHECK(Table.NumHitGroupRecords == 4);
+
+	// A shorter range with the same first record is a different range.
+	CHECK(AddHitGroupRecords(Table, A, 1) == 4);
+	CHECK(Table.NumHitGroupRecords == 5);
+
+	// Stride padding stays zero.
+	const uint8_t* Record = Table.CPUData.data() + kTestLayout.HitGroupOffset + 2 * kTestLayout.HitGroupStride;
+	CHECK(memcmp(Record, &B[0], sizeof(B[0])) == 0);
+	bool bIsPaddingZero = true;
+	for (uint32_t Idx = sizeof(FTestHitGroupRecord); Idx < kTestLayout.HitGroupStride; ++Idx)
+	{
+		bIsPaddingZero = bIsPaddingZero && Record[Idx] == 0;
+	}
+	CHECK(bIsPaddingZero);
+}
+
+TEST(ShaderTableConfirmsHashMatchWithRecords)
+{
+	FShaderTable Table;
+	InitShaderTableRecords(kTestLayout, Table);
+
+	const FTestHitGroupRecord A = MakeHitGroupRecord(1, 5, 6);
+	CHECK(AddHitGroupRecords(Table, &A, 1) == 0);
+
+	// The records behind the hash changed, so the hash match alone must not reuse them.
+	SetHitGroupRecord(Table, 0, MakeHitGroupRecord(7, 5, 6));
+	CHECK(AddHitGroupRecords(Table, &A, 1) == 1);
+	CHECK(Table.NumHitGroupRecords == 2);
+}
+
+TEST(ShaderTableResetKeepsUploadedRecords)
+{
+	FShaderTable Table;
+	InitShaderTableRecords(kTestLayout, Table);
+
+	const FTestHitGroupRecord A[2] = { MakeHitGroupRecord(1, 0, 0), MakeHitGroupRecord(1, 10, 20) };
+	AddHitGroupRecords(Table, A, 2);
+	CHECK(Table.DirtyRanges.size() == 2);
+	Table.DirtyRanges.clear(); // Uploaded.
+
+	// The same records after a reset land in the same place and upload nothing.
+	ResetHitGroupRecords(Table);
+	CHECK(Table.NumHitGroupRecords == 0);
+	CHECK(AddHitGroupRecords(Table, A, 2) == 0);
+	CHECK(Table.NumHitGroupRecords == 2);
+	CHECK(Table.DirtyRanges.empty());
+
+	// Writing a record with its current contents does not dirty it either.
+	SetHitGroupRecord(Table, 1, A[1]);
+	CHECK(Table.DirtyRanges.empty());
+}
+
+TEST(ShaderTableMergesDirtyRanges)
+{
+	FShaderTable Table;
+	InitShaderTableRecords(kTestLayout, Table);
+
+	// Unsorted, adjacent, overlapping, contained and separate ranges.
+	Table.DirtyRanges = { { 128, 32 }, { 0, 32 }, { 32, 32 }, { 200, 10 }, { 96, 40 }, { 100, 8 } };
+	MergeShaderTableDirtyRanges(Table);
+	CHECK(Table.DirtyRanges.size() == 3);
+	if (Table.DirtyRanges.size() == 3)
+	{
+		CHECK(Table.DirtyRanges[0].first == 0 && Table.DirtyRanges[0].second == 64);
+		CHECK(Table.DirtyRanges[1].first == 96 && Table.DirtyRanges[1].second == 64);
+		CHECK(Table.DirtyRanges[2].first == 200 && Table.DirtyRanges[2].second == 10);
+	}
+
+	Table.DirtyRanges.clear();
+	MergeShaderTableDirtyRanges(Table);
+	CHECK(Table.DirtyRanges.empty());
+}
+
+TEST(ShaderTableMergesRecordWrites)
+{
+	FShaderTable Table;
+	InitShaderTableRecords(kTestLayout, Table);
+
+	FTestRayGenRecord RayGen;
+	memset(RayGen.Identifier, 3, sizeof(RayGen.Identifier));
+	SetRayGenRecord(Table, RayGen);
+	const FTestHitGroupRecord Records[3] = { MakeHitGroupRecord(1, 0, 0), MakeHitGroupRecord(1, 1, 1), MakeHitGroupRecord(1, 2, 2) };
+	AddHitGroupRecords(Table, Records, 3);
+	SetMissRecord(Table, 1, RayGen);
+
+	// The unused first miss record separates the ray generation record from the second one, which ends where the hit
+	// group section starts.
+	MergeShaderTableDirtyRanges(Table);
+	CHECK(kTestLayout.MissOffset + 2 * kTestLayout.MissStride == kTestLayout.HitGroupOffset);
+	CHECK(Table.DirtyRanges.size() == 2);
+	if (Table.DirtyRanges.size() == 2)
+	{
+		CHECK(Table.DirtyRanges[0].first == 0 && Table.DirtyRanges[0].second == kTestLayout.RayGenStride);
+		CHECK(Table.DirtyRanges[1].first == kTestLayout.MissOffset + kTestLayout.MissStride && Table.DirtyRanges[1].second == kTestLayout.MissStride + 3 * kTestLayout.HitGroupStride);
+	}
+}
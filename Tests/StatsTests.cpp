@@ -0,0 +1,238 @@
+#include "Test.h"
+#include "Stats.h"
+
+TEST(GPUScopeSampleStats)
+{
+	FGPUScopeStats Stats = {};
+	AddGPUScopeSample(Stats, 2.0f);
+	AddGPUScopeSample(Stats, 4.0f);
+	AddGPUScopeSample(Stats, 3.0f);
+	CHECK(Stats.NumSamples == 3);
+	CHECK(Stats.LastMs == 3.0f);
+	CHECK(Stats.MinMs == 2.0f);
+	CHECK(Stats.MaxMs == 4.0f);
+	CHECK_NEAR(Stats.AvgMs, 3.0, 1.0e-6);
+}
+
+TEST(GPUScopeHistoryWraps)
+{
+	FGPUScopeStats Stats = {};
+	for (uint32_t Idx = 0; Idx < kGPUScopeHistorySize; ++Idx)
+	{
+		AddGPUScopeSample(Stats, 1.0f);
+	}
+	for (uint32_t Idx = 0; Idx < 10; ++Idx)
+	{
+		AddGPUScopeSample(Stats, 5.0f);
+	}
+	CHECK(Stats.NumSamples == kGPUScopeHistorySize + 10);
+	CHECK(Stats.MinMs == 1.0f);
+	CHECK(Stats.MaxMs == 5.0f);
+	CHECK_NEAR(Stats.AvgMs, (kGPUScopeHistorySize - 10 + 50.0) / kGPUScopeHistorySize, 1.0e-5);
+
+	// A full history later the old samples are gone.
+	for (uint32_t Idx = 0; Idx < kGPUScopeHistorySize; ++Idx)
+	{
+		AddGPUScopeSample(Stats, 2.0f);
+	}
+	CHECK(Stats.MinMs == 2.0f);
+	CHECK(Stats.MaxMs == 2.0f);
+	CHECK_NEAR(Stats.AvgMs, 2.0, 1.0e-6);
+}
+
+TEST(GPUScopeFrameSumsSameName)
+{
+	FGPUScopeStats Scopes[3] = { { "Frame" }, { "Trace" }, { "Upscale" } };
+	const uint32_t FrameScopes[4] = { 0, 1, 1, 2 };
+	const uint64_t Timestamps[8] =
+	{
+		100, 1100, // Frame, 1000 ticks.
+		200, 300, // Trace, 100 ticks.
+		400, 650, // Trace again, 250 ticks.
+		900, 800, // Upscale, end before begin counts as zero.
+	};
+	AddGPUScopeFrame(Scopes, 3, FrameScopes, Timestamps, 4, 0.001);
+	CHECK(Scopes[0].NumSamples == 1);
+	CHECK_NEAR(Scopes[0].LastMs, 1.0, 1.0e-6);
+	CHECK(Scopes[1].NumSamples == 1);
+	CHECK_NEAR(Scopes[1].LastMs, 0.35, 1.0e-6);
+	CHECK(Scopes[2].NumSamples == 1);
+	CHECK(Scopes[2].LastMs == 0.0f);
+
+	// Scopes not recorded in a frame get no sample.
+	AddGPUScopeFrame(Scopes, 3, FrameScopes, Timestamps, 1, 0.001);
+	CHECK(Scopes[0].NumSamples == 2);
+	CHECK(Scopes[1].NumSamples == 1);
+	CHECK(Scopes[2].NumSamples == 1);
+}
+
+static void AddFrameMs(FFrameStats& Stats, float FrameMs)
+{
+	const float Ms[FrameMetric_Count] = { FrameMs, FrameMs * 0.5f, 0.0f, 0.0f };
+	AddFrameTiming(Stats, Ms);
+}
+
+TEST(FrameStatsEmpty)
+{
+	static FFrameStats Stats = {};
+	FFrameStatsSummary Summary;
+	GetFrameStatsSummary(Stats, Summary);
+	CHECK(Summary.NumFrames == 0);
+	CHECK(Summary.NumHitches == 0);
+	CHECK(Summary.Metrics[FrameMetric_Frame].P50Ms == 0.0f);
+	CHECK(Summary.Metrics[FrameMetric_Frame].MaxMs == 0.0f);
+}
+
+TEST(FrameStatsNearestRankPercentiles)
+{
+	// 1..100 ms in a scrambled order, nearest rank makes the percentiles exact.
+	static FFrameStats Stats = {};
+	for (uint32_t Idx = 0; Idx < 100; ++Idx)
+	{
+		AddFrameMs(Stats, (float)((Idx * 37) % 100 + 1));
+	}
+	FFrameStatsSummary Summary;
+	GetFrameStatsSummary(Stats, Summary);
+	const FFrameMetricSummary& Frame = Summary.Metrics[FrameMetric_Frame];
+	CHECK(Summary.NumFrames == 100);
+	CHECK(Frame.P50Ms == 50.0f);
+	CHECK(Frame.P95Ms == 95.0f);
+	CHECK(Frame.P99Ms == 99.0f);
+	CHECK(Frame.MaxMs == 100.0f);
+	CHECK_NEAR(Frame.AvgMs, 50.5, 1.0e-4);
+	CHECK(Summary.Metrics[FrameMetric_CPU].P50Ms == 25.0f);
+
+	// Ranks round up: the 95th percentile of ten frames is the largest one.
+	static FFrameStats Small = {};
+	for (uint32_t Idx = 10; Idx > 0; --Idx)
+	{
+		AddFrameMs(Small, (float)Idx);
+	}
+	GetFrameStatsSummary(Small, Summary);
+	CHECK(Summary.Metrics[FrameMetric_Frame].P50Ms == 5.0f);
+	CHECK(Summary.Metrics[FrameMetric_Frame].P95Ms == 10.0f);
+}
+
+TEST(FrameStatsWrappedRing)
+{
+	static FFrameStats Stats = {};
+	for (uint32_t Idx = 0; Idx < 100; ++Idx)
+	{
+		AddFrameMs(Stats, 1000.0f);
+	}
+	for (uint32_t Idx = 0; Idx < kFrameStatsHistorySize; ++Idx)
+	{
+		AddFrameMs(Stats, Idx % 2 ? 4.0f : 2.0f);
+	}
+	CHECK(Stats.NumFrames == kFrameStatsHistorySize + 100);
+
+	// The slow frames were overwritten.
+	FFrameStatsSummary Summary;
+	GetFrameStatsSummary(Stats, Summary);
+	const FFrameMetricSummary& Frame = Summary.Metrics[FrameMetric_Frame];
+	CHECK(Summary.NumFrames == kFrameStatsHistorySize);
+	CHECK(Frame.MaxMs == 4.0f);
+	CHECK(Frame.P50Ms == 2.0f);
+	CHECK(Frame.P95Ms == 4.0f);
+	CHECK_NEAR(Frame.AvgMs, 3.0, 1.0e-4);
+	CHECK(Summary.NumHitches == 0);
+}
+
+TEST(FrameStatsHitches)
+{
+	// Hitches are frames longer than kFrameHitchFactor times the median, a frame of exactly twice the median is not.
+	static FFrameStats Stats = {};
+	for (uint32_t Idx = 0; Idx < 97; ++Idx)
+	{
+		AddFrameMs(Stats, 10.0f);
+	}
+	AddFrameMs(Stats, 10.0f * kFrameHitchFactor);
+	AddFrameMs(Stats, 10.0f * kFrameHitchFactor + 0.5f);
+	AddFrameMs(Stats, 100.0f);
+
+	FFrameStatsSummary Summary;
+	GetFrameStatsSummary(Stats, Summary);
+	CHECK(Summary.Metrics[FrameMetric_Frame].P50Ms == 10.0f);
+	CHECK(Summary.NumHitches == 2);
+}
+
+TEST(RayCounterDeltasWrapAround)
+{
+	uint32_t Previous[kNumRayCounters] = {};
+	uint32_t Current[kNumRayCounters] = {};
+	Previous[RAY_COUNTER_RAYS] = 100;
+	Current[RAY_COUNTER_RAYS] = 1100;
+	Previous[RAY_COUNTER_HITS] = UINT32_MAX - 9; // Wraps during the frame.
+	Current[RAY_COUNTER_HITS] = 20;
+	Previous[RAY_COUNTER_MISSES] = 7;
+	Current[RAY_COUNTER_MISSES] = 7;
+
+	uint64_t Counts[kNumRayCounters];
+	GetRayCounterDeltas(Previous, Current, Counts);
+	CHECK(Counts[RAY_COUNTER_RAYS] == 1000);
+	CHECK(Counts[RAY_COUNTER_HITS] == 30);
+	CHECK(Counts[RAY_COUNTER_MISSES] == 0);
+
+	// A whole wrap minus one is the largest count one frame can report.
+	Previous[RAY_COUNTER_RAYS] = 5;
+	Current[RAY_COUNTER_RAYS] = 4;
+	GetRayCounterDeltas(Previous, Current, Counts);
+	CHECK(Counts[RAY_COUNTER_RAYS] == UINT32_MAX);
+}
+
+// D3D12_HEAP_TYPE values.
+static const uint32_t kHeapTypeDefault = 1;
+static const uint32_t kHeapTypeUpload = 2;
+
+TEST(GPUMemoryCategoryTotals)
+{
+	FGPUMemoryTracker Tracker = {};
+	AddGPUMemory(Tracker, GPUMemory_Texture, kHeapTypeDefault, 1000);
+	AddGPUMemory(Tracker, GPUMemory_Texture, kHeapTypeDefault, 500);
+	AddGPUMemory(Tracker, GPUMemory_Upload, kHeapTypeUpload, 200);
+	CHECK(Tracker.Categories[GPUMemory_Texture].Bytes == 1500);
+	CHECK(Tracker.Categories[GPUMemory_Texture].NumResources == 2);
+	CHECK(Tracker.Categories[GPUMemory_Upload].Bytes == 200);
+	CHECK(Tracker.HeapTypeBytes[kHeapTypeDefault] == 1500);
+	CHECK(Tracker.HeapTypeBytes[kHeapTypeUpload] == 200);
+	CHECK(Tracker.Bytes == 1700);
+
+	// Peaks stay, counts of created resources only grow.
+	RemoveGPUMemory(Tracker, GPUMemory_Texture, kHeapTypeDefault, 1000);
+	AddGPUMemory(Tracker, GPUMemory_Texture, kHeapTypeDefault, 100);
+	const FGPUMemoryCategoryStats& Texture = Tracker.Categories[GPUMemory_Texture];
+	CHECK(Texture.Bytes == 600);
+	CHECK(Texture.HighWaterBytes == 1500);
+	CHECK(Texture.NumResources == 2);
+	CHECK(Texture.NumCreated == 3);
+	CHECK(Tracker.HeapTypeBytes[kHeapTypeDefault] == 600);
+	CHECK(Tracker.Bytes == 800);
+	CHECK(Tracker.HighWaterBytes == 1700);
+}
+
+TEST(GPUMemoryDestructionCallback)
+{
+	// CreateGPUResource registers the allocation as the context of the resource's destruction callback, which hands
+	// it to ReleaseGPUMemoryAllocation.
+	FGPUMemoryTracker Tracker = {};
+	void (*const OnDestroyed)(void*) = ReleaseGPUMemoryAllocation;
+	FGPUMemoryAllocation* Scratch = AddGPUMemoryAllocation(Tracker, GPUMemory_Scratch, kHeapTypeDefault, 4096);
+	FGPUMemoryAllocation* Readback = AddGPUMemoryAllocation(Tracker, GPUMemory_Readback, 3, 256);
+	CHECK(Tracker.Categories[GPUMemory_Scratch].Bytes == 4096);
+	CHECK(Tracker.Bytes == 4096 + 256);
+
+	OnDestroyed(Scratch);
+	CHECK(Tracker.Categories[GPUMemory_Scratch].Bytes == 0);
+	CHECK(Tracker.Categories[GPUMemory_Scratch].NumResources == 0);
+	CHECK(Tracker.Categories[GPUMemory_Scratch].HighWaterBytes == 4096);
+	CHECK(Tracker.HeapTypeBytes[kHeapTypeDefault] == 0);
+	CHECK(Tracker.Bytes == 256);
+
+	OnDestroyed(Readback);
+	CHECK(Tracker.Bytes == 0);
+	CHECK(Tracker.HighWaterBytes == 4096 + 256);
+	for (uint32_t Category = 0; Category < GPUMemory_Count; ++Category)
+	{
+		CHECK(Tracker.Categories[Category].NumResources == 0);
+	}
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Minimal test runner (TestMain.cpp). TEST registers a function, CHECK reports a failed condition and keeps going.
+// BENCHMARK registers a function that only runs with --benchmark and prints its measurements.
+
+struct FTestCase
+{
+	const char* Name;
+	void (*Function)();
+	FTestCase* Next;
+};
+
+extern FTestCase* GTestCases;
+extern FTestCase* GBenchmarks;
+extern uint32_t GNumFailedChecks;
+
+struct FTestRegistration
+{
+	FTestRegistration(FTestCase& Case, FTestCase*& List)
+	{
+		// Appended, tests of a file run in the order they are written.
+		FTestCase** Last = &List;
+		while (*Last)
+		{
+			Last = &(*Last)->Next;
+		}
+		*Last = &Case;
+	}
+};
+
+#define TEST(Name) \
+	static void Name(); \
+	static FTestCase Name##Case = { #Name, Name, nullptr }; \
+	static FTestRegistration Name##Registration(Name##Case, GTestCases); \
+	static void Name()
+
+#define BENCHMARK(Name) \
+	static void Name(); \
+	static FTestCase Name##Case = { #Name, Name, nullptr }; \
+	static FTestRegistration Name##Registration(Name##Case, GBenchmarks); \
+	static void Name()
+
+#define CHECK(Condition) \
+	do \
+	{ \
+		if (!(Condition)) \
+		{ \
+			printf("%s(%d): CHECK(%s) failed\n", __FILE__, __LINE__, #Condition); \
+			GNumFailedChecks++; \
+		} \
+	} while (0)
+
+#define CHECK_NEAR(Value, Expected, Tolerance) \
+	do \
+	{ \
+		const double CheckValue = (double)(Value); \
+		const double CheckExpected = (double)(Expected); \
+		if (!(fabs(CheckValue - CheckExpected) <= (double)(Tolerance))) \
+		{ \
+			printf("%s(%d): CHECK_NEAR(%s, %s) failed, %g vs %g\n", __FILE__, __LINE__, #Value, #Expected, CheckValue, CheckExpected); \
+			GNumFailedChecks++; \
+		} \
+	} while (0)
@@ -0,0 +1,45 @@
+#include "Test.h"
+#include <stdlib.h>
+#include <string.h>
+
+FTestCase* GTestCases;
+FTestCase* GBenchmarks;
+uint32_t GNumFailedChecks;
+
+// EASTL allocates through these, the application routes them to Allocator.cpp.
+void* operator new[](size_t Size, const char* /*Name*/, int /*Flags*/, unsigned /*DebugFlags*/, const char* /*File*/, int /*Line*/)
+{
+	return malloc(Size);
+}
+
+void* operator new[](size_t Size, size_t Alignment, size_t /*AlignmentOffset*/, const char* /*Name*/, int /*Flags*/, unsigned /*DebugFlags*/, const char* /*File*/, int /*Line*/)
+{
+	void* Pointer = nullptr;
+	return posix_memalign(&Pointer, Alignment < sizeof(void*) ? sizeof(void*) : Alignment, Size) == 0 ? Pointer : nullptr;
+}
+
+// Runs every test, or only those whose name contains the first argument. Exit code is the number of failed tests.
+// "--benchmark [filter]" runs the benchmarks instead.
+int main(int Argc, char** Argv)
+{
+	const bool bRunsBenchmarks = Argc > 1 && strcmp(Argv[1], "--benchmark") == 0;
+	const int32_t FilterArg = bRunsBenchmarks ? 2 : 1;
+	const char* Filter = Argc > FilterArg ? Argv[FilterArg] : "";
+	uint32_t NumTests = 0;
+	uint32_t NumFailedTests = 0;
+	for (FTestCase* Case = bRunsBenchmarks ? GBenchmarks : GTestCases; Case; Case = Case->Next)
+	{
+		if (!strstr(Case->Name, Filter))
+		{
+			continue;
+		}
+		const uint32_t NumFailedChecks = GNumFailedChecks;
+		Case->Function();
+		const bool bHasFailed = GNumFailedChecks != NumFailedChecks;
+		printf("%s %s\n", bHasFailed ? "FAIL" : "ok  ", Case->Name);
+		NumTests++;
+		NumFailedTests += bHasFailed ? 1 : 0;
+	}
+	printf("%u of %u %s failed\n", NumFailedTests, NumTests, bRunsBenchmarks ? "benchmarks" : "tests");
+	return (int)NumFailedTests;
+}
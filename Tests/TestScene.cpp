@@ -0,0 +1,157 @@
+#include "TestScene.h"
+#include <math.h>
+#include "EASTL/algorithm.h"
+
+static XMFLOAT3 GetTestImageColor(float U, float V)
+{
+	// Thin line across the lower left.
+	if (U < 0.5f && V > 0.5f && fabsf(U - (V - 0.5f) * 0.8f - 0.05f) < 0.004f)
+	{
+		return XMFLOAT3(0.02f, 0.02f, 0.02f);
+	}
+	// Disc.
+	const float DiscU = U - 0.3f;
+	const float DiscV = (V - 0.35f) * 0.75f;
+	if (DiscU * DiscU + DiscV * DiscV < 0.2f * 0.2f)
+	{
+		return XMFLOAT3(0.9f, 0.75f, 0.2f);
+	}
+	// Stripes at 20 degrees.
+	if (U > 0.55f && V < 0.5f)
+	{
+		const float Stripe = (U * 0.9397f + V * 0.3420f) * 20.0f;
+		return Stripe - floorf(Stripe) < 0.3f ? XMFLOAT3(0.95f, 0.95f, 0.9f) : XMFLOAT3(0.15f, 0.25f, 0.45f);
+	}
+	// Checkerboard.
+	if (U > 0.5f && V > 0.6f)
+	{
+		return (((int32_t)(U * 24.0f) + (int32_t)(V * 24.0f)) & 1) ? XMFLOAT3(0.05f, 0.05f, 0.1f) : XMFLOAT3(0.8f, 0.8f, 0.75f);
+	}
+	return XMFLOAT3(0.2f + 0.5f * U, 0.3f, 0.6f - 0.4f * V);
+}
+
+void RenderTestImage(uint32_t Width, uint32_t Height, uint32_t SamplesPerAxis, FImage& OutImage)
+{
+	InitImage(Width, Height, OutImage);
+	const float Weight = 1.0f / (SamplesPerAxis * SamplesPerAxis);
+	for (uint32_t Y = 0; Y < Height; ++Y)
+	{
+		for (uint32_t X = 0; X < Width; ++X)
+		{
+			XMVECTOR Sum = XMVectorZero();
+			for (uint32_t SampleY = 0; SampleY < SamplesPerAxis; ++SampleY)
+			{
+				for (uint32_t SampleX = 0; SampleX < SamplesPerAxis; ++SampleX)
+				{
+					const float U = (X + (SampleX + 0.5f) / SamplesPerAxis) / Width;
+					const float V = (Y + (SampleY + 0.5f) / SamplesPerAxis) / Height;
+					const XMFLOAT3 Color = GetTestImageColor(U, V);
+					Sum = XMVectorAdd(Sum, XMLoadFloat3(&Color));
+				}
+			}
+			XMStoreFloat4(&OutImage.Texels[(size_t)Y * Width + X], XMVectorSetW(XMVectorScale(Sum, Weight), 1.0f));
+		}
+	}
+}
+
+void GetTestView(float Angle, FTestView& OutView)
+{
+	const XMVECTOR Position = XMVectorSet(2.5f * cosf(Angle), 2.0f, 2.5f * sinf(Angle), 1.0f);
+	const XMMATRIX ViewTransform = XMMatrixLookAtLH(Position, XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+	const XMMATRIX WorldToProjection = XMMatrixMultiply(ViewTransform, XMMatrixPerspectiveFovLH(XM_PI / 3, 1.777f, 0.1f, 100.0f));
+	XMStoreFloat4x4(&OutView.WorldToProjection, WorldToProjection);
+	XMStoreFloat4x4(&OutView.ProjectionToWorld, XMMatrixInverse(nullptr, WorldToProjection));
+	XMStoreFloat4(&OutView.CameraPosition, Position);
+}
+
+struct FTestSphere
+{
+	float Center[3];
+	float Radius;
+	float Albedo[3];
+};
+
+static const FTestSphere kTestSpheres[3] =
+{
+	{ { 0.0f, 0.5f, 0.0f }, 0.5f, { 0.9f, 0.3f, 0.2f } },
+	{ { 1.1f, 0.35f, 0.6f }, 0.35f, { 0.2f, 0.8f, 0.3f } },
+	{ { -0.9f, 0.6f, -0.8f }, 0.6f, { 0.3f, 0.4f, 0.9f } },
+};
+static const float kTestGroundRadius = 4.0f;
+
+// Nearest hit along a normalized direction, false for a miss.
+static bool TraceTestRay(FXMVECTOR Origin, FXMVECTOR Direction, float& OutT, XMVECTOR& OutNormal, XMVECTOR& OutAlbedo)
+{
+	OutT = 1000.0f;
+	const float DirectionY = XMVectorGetY(Direction);
+	if (DirectionY < 0.0f)
+	{
+		const float T = -XMVectorGetY(Origin) / DirectionY;
+		const XMVECTOR Position = XMVectorMultiplyAdd(Direction, XMVectorReplicate(T), Origin);
+		const float X = XMVectorGetX(Position);
+		const float Z = XMVectorGetZ(Position);
+		if (X * X + Z * Z < kTestGroundRadius * kTestGroundRadius)
+		{
+			OutT = T;
+			OutNormal = XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f);
+			OutAlbedo = (((int32_t)floorf(X * 2.0f) + (int32_t)floorf(Z * 2.0f)) & 1) ? XMVectorReplicate(0.3f) : XMVectorReplicate(0.8f);
+		}
+	}
+	for (const FTestSphere& Sphere : kTestSpheres)
+	{
+		const XMVECTOR ToOrigin = XMVectorSubtract(Origin, XMVectorSet(Sphere.Center[0], Sphere.Center[1], Sphere.Center[2], 1.0f));
+		const float B = XMVectorGetX(XMVector3Dot(ToOrigin, Direction));
+		const float C = XMVectorGetX(XMVector3Dot(ToOrigin, ToOrigin)) - Sphere.Radius * Sphere.Radius;
+		const float Discriminant = B * B - C;
+		if (Discriminant < 0.0f)
+		{
+			continue;
+		}
+		const float T = -B - sqrtf(Discriminant);
+		if (T > 0.001f && T < OutT)
+		{
+			OutT = T;
+			OutNormal = XMVector3Normalize(XMVectorMultiplyAdd(Direction, XMVectorReplicate(T), ToOrigin));
+			OutAlbedo = XMVectorSet(Sphere.Albedo[0], Sphere.Albedo[1], Sphere.Albedo[2], 1.0f);
+		}
+	}
+	return OutT < 1000.0f;
+}
+
+void TraceTestScene(const FTestView& View, float2 Jitter, uint32_t Interleave, uint32_t Phase, FImage& Color, FImage& HitPosition)
+{
+	const XMMATRIX ProjectionToWorld = XMLoadFloat4x4(&View.ProjectionToWorld);
+	const XMVECTOR Origin = XMLoadFloat4(&View.CameraPosition);
+	const XMVECTOR Light = XMVector3Normalize(XMVectorSet(0.5f, 1.0f, -0.25f, 0.0f));
+	for (uint32_t Y = 0; Y < Color.Height; ++Y)
+	{
+		for (uint32_t X = 0; X < Color.Width; ++X)
+		{
+			if (!IsTracedPixel(uint2(X, Y), Interleave, Phase))
+			{
+				continue;
+			}
+
+			// GenerateCameraRay of RaytracingCommon.hlsli.
+			const float ScreenX = (X + 0.5f + Jitter.x) / Color.Width * 2.0f - 1.0f;
+			const float ScreenY = -((Y + 0.5f + Jitter.y) / Color.Height * 2.0f - 1.0f);
+			const XMVECTOR World = XMVector3TransformCoord(XMVectorSet(ScreenX, ScreenY, 0.0f, 1.0f), ProjectionToWorld);
+			const XMVECTOR Direction = XMVector3Normalize(XMVectorSubtract(World, Origin));
+
+			float T;
+			XMVECTOR Normal, Albedo;
+			const size_t Pixel = (size_t)Y * Color.Width + X;
+			if (TraceTestRay(Origin, Direction, T, Normal, Albedo))
+			{
+				const float Lambert = 0.1f + 0.9f * eastl::min(eastl::max(XMVectorGetX(XMVector3Dot(Normal, Light)), 0.0f), 1.0f);
+				XMStoreFloat4(&Color.Texels[Pixel], XMVectorSetW(XMVectorScale(Albedo, Lambert), 1.0f));
+				XMStoreFloat4(&HitPosition.Texels[Pixel], XMVectorSetW(XMVectorMultiplyAdd(Direction, XMVectorReplicate(T), Origin), 1.0f));
+			}
+			else
+			{
+				Color.Texels[Pixel] = XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f);
+				XMStoreFloat4(&HitPosition.Texels[Pixel], XMVectorSetW(Origin, 0.0f));
+			}
+		}
+	}
+}
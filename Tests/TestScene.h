@@ -0,0 +1,25 @@
+#pragma once
+
+#include "Reference.h"
+
+// Synthetic inputs for the tests and benchmarks of the CPU references (Reference.h).
+
+// A smooth gradient with a disc, slanted stripes, a checkerboard and a thin line, box filtered over SamplesPerAxis^2
+// samples per pixel. Shapes are placed relative to the image size, so every resolution shows the same picture and a
+// supersampled render at the output size is the ground truth of an upscale.
+void RenderTestImage(uint32_t Width, uint32_t Height, uint32_t SamplesPerAxis, FImage& OutImage);
+
+// Camera of the application's orbit (SetOrbitCamera) at Angle, looking at the origin with the same projection.
+struct FTestView
+{
+	XMFLOAT4X4 WorldToProjection; // Not transposed, as GetReprojectedPixel takes it.
+	XMFLOAT4X4 ProjectionToWorld;
+	XMFLOAT4 CameraPosition;
+};
+
+void GetTestView(float Angle, FTestView& OutView);
+
+// Traces the pixels of one interleave phase like Raytracing.hlsl with Lambert shading: rays through pixel centers offset
+// by Jitter, misses are black and have w = 0 in HitPosition. The scene is a checkered ground disc with three spheres,
+// Color and HitPosition have to be initialized to the trace size.
+void TraceTestScene(const FTestView& View, float2 Jitter, uint32_t Interleave, uint32_t Phase, FImage& Color, FImage& HitPosition);
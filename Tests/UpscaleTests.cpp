@@ -0,0 +1,134 @@
+#include "Test.h"
+#include "TestScene.h"
+#include "EAStdC/EAStopwatch.h"
+
+TEST(Lanczos2WeightsMatchScalar)
+{
+	CHECK(GetLanczos2Weight(0.0f, 0.5f, 2.0f) == 1.0f);
+	CHECK_NEAR(GetLanczos2Weight(1.0f, 0.5f, 2.0f), 0.0f, 1.0e-6f);
+	CHECK_NEAR(GetLanczos2Weight(4.0f, 0.5f, 2.0f), 0.0f, 1.0e-6f);
+
+	const float Lobes[3] = { 0.5f, 0.36f, 0.21f };
+	for (float Lobe : Lobes)
+	{
+		for (uint32_t Idx = 0; Idx < 48; Idx += 4)
+		{
+			XMFLOAT4 Weights;
+			XMStoreFloat4(&Weights, GetLanczos2Weights(XMVectorSet(Idx * 0.125f, (Idx + 1) * 0.125f, (Idx + 2) * 0.125f, (Idx + 3) * 0.125f), Lobe, 1.0f / Lobe));
+			CHECK_NEAR(Weights.x, GetLanczos2Weight(Idx * 0.125f, Lobe, 1.0f / Lobe), 1.0e-6f);
+			CHECK_NEAR(Weights.y, GetLanczos2Weight((Idx + 1) * 0.125f, Lobe, 1.0f / Lobe), 1.0e-6f);
+			CHECK_NEAR(Weights.z, GetLanczos2Weight((Idx + 2) * 0.125f, Lobe, 1.0f / Lobe), 1.0e-6f);
+			CHECK_NEAR(Weights.w, GetLanczos2Weight((Idx + 3) * 0.125f, Lobe, 1.0f / Lobe), 1.0e-6f);
+		}
+	}
+}
+
+TEST(UpscaleStaysInTracedRectangle)
+{
+	// A flat traced rectangle in a white texture stays flat, nothing outside of it is sampled.
+	FImage Input;
+	InitImage(40, 30, Input);
+	for (uint32_t Y = 0; Y < Input.Height; ++Y)
+	{
+		for (uint32_t X = 0; X < Input.Width; ++X)
+		{
+			Input.Texels[Y * Input.Width + X] = X < 32 && Y < 24 ? XMFLOAT4(0.25f, 0.5f, 0.75f, 1.0f) : XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f);
+		}
+	}
+
+	for (uint32_t Filter = 0; Filter < UPSCALE_FILTER_COUNT; ++Filter)
+	{
+		FImage Output;
+		InitImage(61, 47, Output);
+		UpscaleImage(Input, 32, 24, Filter, 0.5f, Output);
+		float MaxError = 0.0f;
+		for (const XMFLOAT4& Texel : Output.Texels)
+		{
+			MaxError = fmaxf(MaxError, fmaxf(fabsf(Texel.x - 0.25f), fmaxf(fabsf(Texel.y - 0.5f), fabsf(Texel.z - 0.75f))));
+		}
+		CHECK_NEAR(MaxError, 0.0f, 1.0e-6f);
+	}
+}
+
+TEST(UpscaleBilinearAtNativeSizeIsIdentity)
+{
+	FImage Input, Output;
+	RenderTestImage(64, 48, 2, Input);
+	InitImage(64, 48, Output);
+	UpscaleImage(Input, 64, 48, UPSCALE_FILTER_BILINEAR, 0.0f, Output);
+	CHECK_NEAR(GetImageMaxError(Output, Input), 0.0f, 1.0e-5f);
+}
+
+TEST(UpscaleEdgeAdaptiveBeatsBilinear)
+{
+	// Against a supersampled render at the output size, the edge adaptive filter has to be closer than bilinear at the
+	// upscale factors of the application. Sharpening trades PSNR for contrast, it is off here.
+	const uint32_t Width = 384;
+	const uint32_t Height = 216;
+	FImage Reference;
+	RenderTestImage(Width, Height, 4, Reference);
+
+	const float Factors[3] = { 1.3f, 1.5f, 2.0f };
+	for (float Factor : Factors)
+	{
+		const uint32_t InputWidth = (uint32_t)(Width / Factor + 0.5f);
+		const uint32_t InputHeight = (uint32_t)(Height / Factor + 0.5f);
+		FImage Input, Bilinear, EdgeAdaptive;
+		RenderTestImage(InputWidth, InputHeight, 4, Input);
+		InitImage(Width, Height, Bilinear);
+		InitImage(Width, Height, EdgeAdaptive);
+		UpscaleImage(Input, InputWidth, InputHeight, UPSCALE_FILTER_BILINEAR, 0.0f, Bilinear);
+		UpscaleImage(Input, InputWidth, InputHeight, UPSCALE_FILTER_EDGE_ADAPTIVE, 0.0f, EdgeAdaptive);
+		CHECK(GetImagePSNR(EdgeAdaptive, Reference) > GetImagePSNR(Bilinear, Reference));
+		CHECK(GetImagePSNR(EdgeAdaptive, Reference) > 20.0f);
+	}
+}
+
+TEST(UpscaleThreadsMatchOneThread)
+{
+	FImage Input, OneThread, Threads;
+	RenderTestImage(100, 60, 2, Input);
+	InitImage(173, 101, OneThread);
+	InitImage(173, 101, Threads);
+	SetNumReferenceThreads(1);
+	UpscaleImage(Input, 90, 55, UPSCALE_FILTER_EDGE_ADAPTIVE, 0.25f, OneThread);
+	SetNumReferenceThreads(7);
+	UpscaleImage(Input, 90, 55, UPSCALE_FILTER_EDGE_ADAPTIVE, 0.25f, Threads);
+	SetNumReferenceThreads(0);
+	CHECK(GetImageMaxError(Threads, OneThread) == 0.0f);
+}
+
+// Quality against a supersampled 1920x1080 render and throughput, at the upscale factors and with the sharpness of the
+// application, with all processors and with one.
+BENCHMARK(UpscaleBenchmark)
+{
+	const uint32_t Width = 1920;
+	const uint32_t Height = 1080;
+	FImage Reference, Output;
+	RenderTestImage(Width, Height, 4, Reference);
+	InitImage(Width, Height, Output);
+
+	const float Factors[4] = { 1.3f, 1.5f, 1.7f, 2.0f };
+	const char* const FilterNames[UPSCALE_FILTER_COUNT] = { "Bilinear", "Edge adaptive" };
+	for (float Factor : Factors)
+	{
+		const uint32_t InputWidth = (uint32_t)(Width / Factor + 0.5f);
+		const uint32_t InputHeight = (uint32_t)(Height / Factor + 0.5f);
+		FImage Input;
+		RenderTestImage(InputWidth, InputHeight, 4, Input);
+		for (uint32_t Filter = 0; Filter < UPSCALE_FILTER_COUNT; ++Filter)
+		{
+			const float Sharpness = Filter == UPSCALE_FILTER_EDGE_ADAPTIVE ? 0.25f : 0.0f;
+			double Ms[2];
+			for (uint32_t Pass = 0; Pass < 2; ++Pass)
+			{
+				SetNumReferenceThreads(Pass == 0 ? 0 : 1);
+				const uint64_t BeginCycle = EA::StdC::Stopwatch::GetCPUCycle();
+				UpscaleImage(Input, InputWidth, InputHeight, Filter, Sharpness, Output);
+				Ms[Pass] = (EA::StdC::Stopwatch::GetCPUCycle() - BeginCycle) * 1000.0 / EA::StdC::Stopwatch::GetCPUFrequency();
+			}
+			SetNumReferenceThreads(0);
+			printf("Upscale %.1fx %s: %.2f dB, %.2f ms (%.1f Mpixel/s), %.2f ms on one thread\n", Factor, FilterNames[Filter], GetImagePSNR(Output, Reference), Ms[0], Width * Height / (Ms[0] * 1000.0), Ms[1]);
+		}
+	}
+}
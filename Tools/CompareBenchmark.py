@@ -0,0 +1,87 @@
+#!/usr/bin/env python3
+# Compares a report written by "DXRTest.exe --benchmark" against a stored baseline report.
+#
+# Usage (exit code is 1 when any metric got slower than the threshold allows, when measured frames allocated or when the
+# upscale check failed):
+#   python3 Tools/CompareBenchmark.py Baseline.json BenchmarkReport.json --threshold 5
+
+import argparse
+import json
+import sys
+
+# (label, path in the report, True when higher is better)
+METRICS = [
+    ('Frame p50 ms', ('frameTime', 'Frame', 'p50'), False),
+    ('Frame p95 ms', ('frameTime', 'Frame', 'p95'), False),
+    ('Frame p99 ms', ('frameTime', 'Frame', 'p99'), False),
+    ('CPU p50 ms', ('frameTime', 'CPU', 'p50'), False),
+    ('GPU p50 ms', ('frameTime', 'GPU', 'p50'), False),
+    ('Trace avg ms', ('trace', 'avgMs'), False),
+    ('Rays/s', ('trace', 'raysPerSecond'), True),
+    ('Upscale avg ms', ('upscale', 'avgMs'), False),
+    ('Reconstruct ms', ('reconstructPass', 'avgMs'), False),
+    ('Denoise avg ms', ('denoisePass', 'avgMs'), False),
+    ('Temporal avg ms', ('temporalPass', 'avgMs'), False),
+    ('Hitches', ('hitches',), False),
+    ('GPU mem peak', ('gpuMemory', 'trackedPeak'), False),
+    ('Allocs/frame', ('allocationsPerFrame',), False),
+]
+
+# Reports are only comparable when these match.
+SETUP_KEYS = ['resolution', 'traceResolution', 'upscaleFilter', 'traceInterleave', 'denoiseIterations', 'temporal', 'tracePath', 'permutation', 'frames', 'timeStep']
+
+
+def get_value(report, path):
+    for key in path:
+        report = report[key]
+    return float(report)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Compares DXRTest benchmark reports.')
+    parser.add_argument('baseline', help='stored baseline report')
+    parser.add_argument('report', help='report to check')
+    parser.add_argument('--threshold', type=float, default=5.0, help='allowed regression in percent')
+    args = parser.parse_args()
+
+    with open(args.baseline) as f:
+        baseline = json.load(f)
+    with open(args.report) as f:
+        report = json.load(f)
+
+    for key in SETUP_KEYS:
+        if baseline.get(key) != report.get(key):
+            sys.exit('error: %s differs (%s vs %s), reports are not comparable' % (key, baseline.get(key), report.get(key)))
+
+    num_regressions = 0
+    for label, path, higher_is_better in METRICS:
+        old = get_value(baseline, path)
+        new = get_value(report, path)
+        change = (new - old) / old * 100.0 if old != 0.0 else (100.0 if new > old else 0.0)
+        is_regression = (-change if higher_is_better else change) > args.threshold
+        num_regressions += is_regression
+        print('%-15s %14.3f %14.3f %+8.2f%%%s' % (label, old, new, change, '  REGRESSION' if is_regression else ''))
+
+    # Steady state frames must not allocate regardless of the baseline, transient data goes to the frame arena.
+    allocating_frames = report.get('allocatingFrames', 0)
+    if allocating_frames > 0:
+        num_regressions += 1
+        print('%d of %d measured frames allocated (at most %d allocations)  REGRESSION' % (allocating_frames, report['frames'], report['maxFrameAllocations']))
+
+    # The GPU upscale has to match its CPU version (Source/Reference.cpp) regardless of the baseline.
+    upscale_check = report.get('upscaleCheck')
+    if upscale_check and not upscale_check['passed']:
+        num_regressions += 1
+        print('Upscale output differs from the CPU version by up to %.4f (%.2f dB)  REGRESSION' % (upscale_check['maxError'], upscale_check['psnr']))
+
+    # Informational only, the microbenchmark is too noisy to gate on. The cost on whole frames shows when a report written
+    # with DXRTEST_TRACK_ALLOCATIONS=1 is compared against an untracked baseline.
+    tracking = report.get('allocationTracking')
+    if tracking:
+        print('Allocation tracking %s: %.1f ns per allocation (%.1f ns untracked)' % ('on' if tracking['enabled'] else 'off', tracking['nsPerAllocation'], tracking['untrackedNsPerAllocation']))
+
+    sys.exit(1 if num_regressions else 0)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,200 @@
+#!/usr/bin/env python3
+# Packs files into a single archive read by MountArchive() (Source/Library.cpp).
+#
+# Usage (from the repository root, names are stored relative to the current directory):
+#   python3 Tools/PackArchive.py Data.pak Data/Shaders Data/Roboto-Medium.ttf Data/Meshes --compress .ply .ttf
+#
+# Layout: FArchiveHeader, FArchiveEntry[NumEntries] sorted by NameHash, zero-terminated names, entry data. Each entry
+# starts at a 512-byte boundary (D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT) so uncompressed data can be uploaded directly.
+
+import argparse
+import os
+import struct
+import sys
+
+ARCHIVE_MAGIC = 0x41525844  # 'DXRA'
+ARCHIVE_VERSION = 1
+ENTRY_ALIGNMENT = 512
+COMPRESSION_NONE = 0
+COMPRESSION_LZ4 = 1
+
+HEADER_FORMAT = '<IIII'
+ENTRY_FORMAT = '<QQQQII'
+
+
+def normalize_name(name):
+    name = name.replace('\\', '/')
+    while name.startswith('./'):
+        name = name[2:]
+    return name.lower()
+
+
+def hash_name(name):
+    # 64-bit FNV-1a, must match NormalizeArchiveName().
+    h = 0xcbf29ce484222325
+    for c in name.encode('utf-8'):
+        h = ((h ^ c) * 0x100000001b3) & 0xffffffffffffffff
+    return h
+
+
+def write_length(out, length):
+    while length >= 255:
+        out.append(255)
+        length -= 255
+    out.append(length)
+
+
+def lz4_compress(src):
+    # Greedy LZ4 block compressor. Follows the end-of-block rules: the last match starts at least 12 bytes before the
+    # end and the last 5 bytes are always literals.
+    n = len(src)
+    out = bytearray()
+    table = {}
+    anchor = 0
+    i = 0
+    while i < n - 12:
+        key = src[i:i + 4]
+        candidate = table.get(key)
+        table[key] = i
+        if candidate is None or i - candidate > 65535:
+            i += 1
+            continue
+
+        match_length = 4
+        max_length = n - 5 - i
+        while match_length < max_length and src[candidate + match_length] == src[i + match_length]:
+            match_length += 1
+
+        num_literals = i - anchor
+        out.append((min(num_literals, 15) << 4) | min(match_length - 4, 15))
+        if num_literals >= 15:
+            write_length(out, num_literals - 15)
+        out += src[anchor:i]
+        out += struct.pack('<H', i - candidate)
+        if match_length - 4 >= 15:
+            write_length(out, match_length - 4 - 15)
+
+        i += match_length
+        anchor = i
+
+    num_literals = n - anchor
+    out.append(min(num_literals, 15) << 4)
+    if num_literals >= 15:
+        write_length(out, num_literals - 15)
+    out += src[anchor:]
+    return bytes(out)
+
+
+def lz4_decompress(src, size):
+    out = bytearray()
+    i = 0
+    while True:
+        token = src[i]
+        i += 1
+        num_literals = token >> 4
+        if num_literals == 15:
+            while True:
+                b = src[i]
+                i += 1
+                num_literals += b
+                if b != 255:
+                    break
+        out += src[i:i + num_literals]
+        i += num_literals
+        if i == len(src):
+            break
+        offset = src[i] | (src[i + 1] << 8)
+        i += 2
+        match_length = token & 15
+        if match_length == 15:
+            while True:
+                b = src[i]
+                i += 1
+                match_length += b
+                if b != 255:
+                    break
+        match_length += 4
+        start = len(out) - offset
+        for k in range(match_length):
+            out.append(out[start + k])
+    if len(out) != size:
+        raise ValueError('size mismatch')
+    return bytes(out)
+
+
+def collect_files(inputs):
+    files = []
+    for path in inputs:
+        if os.path.isdir(path):
+            for root, _, names in os.walk(path):
+                for name in sorted(names):
+                    files.append(os.path.join(root, name))
+        elif os.path.isfile(path):
+            files.append(path)
+        else:
+            sys.exit('error: %s does not exist' % path)
+    return files
+
+
+def align(value, alignment):
+    return (value + alignment - 1) // alignment * alignment
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Packs files into a DXRTest archive.')
+    parser.add_argument('output', help='archive to write')
+    parser.add_argument('inputs', nargs='+', help='files or directories to pack')
+    parser.add_argument('--compress', nargs='*', default=[], metavar='EXT',
+                        help='extensions to LZ4 compress (entries that do not shrink are stored as is)')
+    args = parser.parse_args()
+
+    compress_extensions = {e.lower() if e.startswith('.') else '.' + e.lower() for e in args.compress}
+
+    entries = {}
+    for path in collect_files(args.inputs):
+        name = normalize_name(os.path.relpath(path))
+        if name.startswith('../'):
+            sys.exit('error: %s is outside of the current directory' % path)
+        with open(path, 'rb') as f:
+            data = f.read()
+
+        stored, compression = data, COMPRESSION_NONE
+        if os.path.splitext(name)[1] in compress_extensions and len(data) > 0:
+            compressed = lz4_compress(data)
+            assert lz4_decompress(compressed, len(data)) == data
+            if len(compressed) < len(data):
+                stored, compression = compressed, COMPRESSION_LZ4
+
+        entries[name] = (hash_name(name), stored, len(data), compression)
+
+    ordered = sorted(entries.items(), key=lambda item: (item[1][0], item[0]))
+
+    names = bytearray()
+    name_offsets = []
+    names_start = struct.calcsize(HEADER_FORMAT) + len(ordered) * struct.calcsize(ENTRY_FORMAT)
+    for name, _ in ordered:
+        name_offsets.append(names_start + len(names))
+        names += name.encode('utf-8') + b'\0'
+
+    offset = align(names_start + len(names), ENTRY_ALIGNMENT)
+    table = bytearray(struct.pack(HEADER_FORMAT, ARCHIVE_MAGIC, ARCHIVE_VERSION, len(ordered), 0))
+    data_offsets = []
+    for (name, (name_hash, stored, size, compression)), name_offset in zip(ordered, name_offsets):
+        data_offsets.append(offset)
+        table += struct.pack(ENTRY_FORMAT, name_hash, offset, len(stored), size, name_offset, compression)
+        offset = align(offset + len(stored), ENTRY_ALIGNMENT)
+
+    with open(args.output, 'wb') as f:
+        f.write(table)
+        f.write(names)
+        for (_, (_, stored, _, _)), data_offset in zip(ordered, data_offsets):
+            f.seek(data_offset)
+            f.write(stored)
+
+    total_size = sum(size for _, (_, _, size, _) in ordered)
+    stored_size = sum(len(stored) for _, (_, stored, _, _) in ordered)
+    print('%s: %d entries, %d bytes (%d bytes stored)' % (args.output, len(ordered), total_size, stored_size))
+
+
+if __name__ == '__main__':
+    main()